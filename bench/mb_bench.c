@@ -0,0 +1,606 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                      MODBUS HOST BENCHMARK
+*
+* Filename : mb_bench.c
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) Measures the hot paths of the stack on a host (see CMakeLists.txt), with pre-built frames
+*                fed in memory to a slave channel that isn't bound to any serial port:
+*
+*                    crc        MB_RTU_RxCalcCRC()  on the request
+*                    rtu_rx     MB_RTU_Rx()         on the request
+*                    fcxx       MBS_FCxx_Handler()  on the request
+*                    rtu_tx     MB_RTU_Tx()         on the response
+*                    ascii_rx   MB_ASCII_Rx()       on the request
+*                    ascii_tx   MB_ASCII_Tx()       on the response
+*
+*                for each function code and a small, medium and maximum quantity.  MB_Tx() returns at once
+*                as the port isn't open, so the Tx figures are those of the framing.
+*
+*            (2) Each case runs for a fixed time (-t, 200 ms by default) after a warm-up, and reports:
+*
+*                    frames/s   frames processed per second
+*                    ns/byte    time per frame divided by the length of the frame processed (request or
+*                               response, RTU or ASCII)
+*                    cyc/frame  time stamp counter ticks per frame, on x86 only.  The TSC counts at the
+*                               nominal frequency of the CPU, not the boosted one.
+*
+*            (3) The application callbacks are those of mb_data.c.  The requests address registers 100 and
+*                up, where they neither take a critical section nor fail.
+*
+*            (4) A frame whose ASCII form exceeds MODBUS_CFG_BUF_SIZE isn't valid in ASCII mode, its ASCII
+*                cases are skipped.
+*
+*            (5) Usage:  mb_bench [-t <ms>] [-f <fc>] [-c]
+*
+*                    -t   duration of each case in milliseconds
+*                    -f   run the cases of one function code only
+*                    -c   print comma separated values
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#include  "mb.h"
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include  <x86intrin.h>
+#define   MB_BENCH_TSC_EN                       DEF_ENABLED
+#else
+#define   MB_BENCH_TSC_EN                       DEF_DISABLED
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  MB_BENCH_NODE_ADDR                         1
+#define  MB_BENCH_ADDR_START                      100    /* See Note #3                               */
+#define  MB_BENCH_PORT_NONE                       255    /* No serial port behind the channel         */
+
+#define  MB_BENCH_DUR_MS_DFLT                     200    /* See Note #2                               */
+#define  MB_BENCH_BATCH                           256    /* Frames between two clock reads            */
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+typedef  struct  mb_bench_case {                         /* Request of a benchmark case               */
+    CPU_INT08U   FC;
+    CPU_INT16U   Qty;                                    /* Nbr of coils/registers, 0 if not relevant */
+} MB_BENCH_CASE;
+
+typedef  struct  mb_bench_frame {
+    CPU_INT08U   RTU[MODBUS_CFG_BUF_SIZE];               /* Request, RTU framing                      */
+    CPU_INT16U   RTU_Len;
+    CPU_INT08U   ASCII[2 * MODBUS_CFG_BUF_SIZE + 8];     /* Request, ASCII framing                    */
+    CPU_INT16U   ASCII_Len;
+} MB_BENCH_FRAME;
+
+typedef  void  (*MB_BENCH_FNCT)(MODBUS_CH *pch);
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+static  const  MB_BENCH_CASE  MB_BenchCaseTbl[] = {
+    { MODBUS_FC01_COIL_RD,                    8 },
+    { MODBUS_FC01_COIL_RD,                  256 },
+    { MODBUS_FC01_COIL_RD,                 2000 },
+    { MODBUS_FC02_DI_RD,                      8 },
+    { MODBUS_FC02_DI_RD,                    256 },
+    { MODBUS_FC02_DI_RD,                   2000 },
+    { MODBUS_FC03_HOLDING_REG_RD,             1 },
+    { MODBUS_FC03_HOLDING_REG_RD,            16 },
+    { MODBUS_FC03_HOLDING_REG_RD,           125 },
+    { MODBUS_FC04_IN_REG_RD,                  1 },
+    { MODBUS_FC04_IN_REG_RD,                 16 },
+    { MODBUS_FC04_IN_REG_RD,                125 },
+    { MODBUS_FC05_COIL_WR,                    1 },
+    { MODBUS_FC06_HOLDING_REG_WR,             1 },
+    { MODBUS_FC08_LOOPBACK,                   0 },
+    { MODBUS_FC15_COIL_WR_MULTIPLE,           8 },
+    { MODBUS_FC15_COIL_WR_MULTIPLE,         256 },
+    { MODBUS_FC15_COIL_WR_MULTIPLE,        1968 },
+    { MODBUS_FC16_HOLDING_REG_WR_MULTIPLE,    1 },
+    { MODBUS_FC16_HOLDING_REG_WR_MULTIPLE,   16 },
+    { MODBUS_FC16_HOLDING_REG_WR_MULTIPLE,  123 },
+};
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+static  CPU_INT32U            MB_BenchDurMs = MB_BENCH_DUR_MS_DFLT;
+static  CPU_BOOLEAN           MB_BenchCSV   = DEF_FALSE;
+static  volatile  CPU_INT32U  MB_BenchSink;              /* Keeps the results alive                   */
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  void        MB_BenchFrameBuild(const MB_BENCH_CASE  *pcase,
+                                       MB_BENCH_FRAME       *pframe);
+
+static  CPU_INT16U  MB_BenchASCII     (const CPU_INT08U     *pbin,
+                                       CPU_INT16U            len,
+                                       CPU_INT08U           *pascii);
+
+static  void        MB_BenchRun       (const MB_BENCH_CASE  *pcase,
+                                       const CPU_CHAR       *pname,
+                                       MB_BENCH_FNCT         fnct,
+                                       MODBUS_CH            *pch,
+                                       CPU_INT16U            nbr_bytes);
+
+static  void        MB_BenchCRC       (MODBUS_CH  *pch);
+static  void        MB_BenchRTU_Rx    (MODBUS_CH  *pch);
+static  void        MB_BenchFCxx      (MODBUS_CH  *pch);
+static  void        MB_BenchRTU_Tx    (MODBUS_CH  *pch);
+static  void        MB_BenchASCII_Rx  (MODBUS_CH  *pch);
+static  void        MB_BenchASCII_Tx  (MODBUS_CH  *pch);
+
+static  CPU_INT64U  MB_BenchNs        (void);
+static  CPU_INT64U  MB_BenchTSC       (void);
+
+
+/*
+*********************************************************************************************************
+*                                               main()
+*
+* Description : Runs the benchmark cases (see Note #5).
+*
+* Argument(s) : argc, argv   command line.
+*
+* Return(s)   : 0, 1 on a command line error.
+*
+* Caller(s)   : none.
+*
+* Note(s)     : (1) Each case is first checked to produce a response of the expected function code, so that
+*                   an exception path is never measured by mistake.
+*********************************************************************************************************
+*/
+
+int  main (int    argc,
+           char  *argv[])
+{
+    MODBUS_CH            *pch;
+    const MB_BENCH_CASE  *pcase;
+    MB_BENCH_FRAME        frame;
+    CPU_INT16U            rsp_rtu_len;
+    CPU_INT16U            rsp_ascii_len;
+    CPU_INT16S            fc_sel;
+    CPU_INT16U            i;
+    int                   arg;
+
+
+    fc_sel = -1;
+    for (arg = 1; arg < argc; arg++) {
+        if ((strcmp(argv[arg], "-t") == 0) && (arg + 1 < argc)) {
+            MB_BenchDurMs = (CPU_INT32U)strtoul(argv[++arg], (char **)0, 0);
+        } else if ((strcmp(argv[arg], "-f") == 0) && (arg + 1 < argc)) {
+            fc_sel = (CPU_INT16S)strtol(argv[++arg], (char **)0, 0);
+        } else if (strcmp(argv[arg], "-c") == 0) {
+            MB_BenchCSV = DEF_TRUE;
+        } else {
+            fprintf(stderr, "usage: %s [-t <ms>] [-f <fc>] [-c]\n", argv[0]);
+            return (1);
+        }
+    }
+
+    MB_Init(0);                                          /* No RTU timer, frames are fed in memory    */
+    pch = MB_CfgCh(MB_BENCH_NODE_ADDR,
+                   MODBUS_SLAVE,
+                   0,
+                   MODBUS_MODE_RTU,
+                   MB_BENCH_PORT_NONE,
+                   115200,
+                   8,
+                   MODBUS_PARITY_NONE,
+                   1,
+                   MODBUS_WR_EN);
+    if (pch == (MODBUS_CH *)0) {
+        fprintf(stderr, "mb_bench: no channel available\n");
+        return (1);
+    }
+
+    if (MB_BenchCSV == DEF_TRUE) {
+        printf("fc,qty,bench,bytes,frames_s,ns_frame,ns_byte,cyc_frame\n");
+    } else {
+        printf("%-4s %5s  %-9s %5s %12s %10s %9s %10s\n",
+               "FC", "qty", "bench", "bytes", "frames/s", "ns/frame", "ns/byte", "cyc/frame");
+    }
+
+    for (i = 0; i < sizeof(MB_BenchCaseTbl) / sizeof(MB_BenchCaseTbl[0]); i++) {
+        pcase = &MB_BenchCaseTbl[i];
+        if ((fc_sel >= 0) && (pcase->FC != (CPU_INT08U)fc_sel)) {
+            continue;
+        }
+        MB_BenchFrameBuild(pcase, &frame);
+
+        memcpy(pch->RxBuf, frame.RTU, frame.RTU_Len);    /* Check the request (see Note #1)           */
+        pch->RxBufByteCtr = frame.RTU_Len;
+        if ((MB_RTU_Rx(pch)        == DEF_FALSE) ||
+            (MB_RTU_RxCalcCRC(pch) != pch->RxFrameCRC) ||
+            (MBS_FCxx_Handler(pch) == DEF_FALSE) ||
+            (pch->TxFrameData[1]   != pcase->FC)) {
+            fprintf(stderr, "mb_bench: FC%02u qty %u not processed (err %u)\n",
+                    pcase->FC, pcase->Qty, pch->Err);
+            continue;
+        }
+        rsp_rtu_len   = pch->TxFrameNDataBytes + 4;
+        rsp_ascii_len = pch->TxFrameNDataBytes * 2 + 9;
+
+        MB_BenchRun(pcase, "crc",    MB_BenchCRC,    pch, frame.RTU_Len);
+        MB_BenchRun(pcase, "rtu_rx", MB_BenchRTU_Rx, pch, frame.RTU_Len);
+        MB_BenchRun(pcase, "fcxx",   MB_BenchFCxx,   pch, frame.RTU_Len);
+        MB_BenchRun(pcase, "rtu_tx", MB_BenchRTU_Tx, pch, rsp_rtu_len);
+
+        if ((frame.ASCII_Len <= MODBUS_CFG_BUF_SIZE) &&  /* See Note #4                               */
+            (rsp_ascii_len   <= MODBUS_CFG_BUF_SIZE)) {
+            MB_BenchRun(pcase, "ascii_tx", MB_BenchASCII_Tx, pch, rsp_ascii_len);
+            memcpy(pch->RxBuf, frame.ASCII, frame.ASCII_Len);
+            pch->RxBufByteCtr = frame.ASCII_Len;
+            MB_BenchRun(pcase, "ascii_rx", MB_BenchASCII_Rx, pch, frame.ASCII_Len);
+        }
+    }
+
+    MB_Exit();
+    return (0);
+}
+
+
+/*
+*********************************************************************************************************
+*                                        MB_BenchFrameBuild()
+*
+* Description : Builds the request of a benchmark case in RTU and ASCII framing.
+*
+* Argument(s) : pcase      is the benchmark case.
+*
+*               pframe     is a pointer to the frame to build.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : main().
+*
+* Note(s)     : (1) The values written alternate so that every bit and register of the frame is exercised.
+*********************************************************************************************************
+*/
+
+static  void  MB_BenchFrameBuild (const MB_BENCH_CASE  *pcase,
+                                  MB_BENCH_FRAME       *pframe)
+{
+    CPU_INT08U  *p;
+    CPU_INT16U   nbr_bytes;
+    CPU_INT16U   crc;
+    CPU_INT16U   i;
+
+
+    p    = &pframe->RTU[0];
+    *p++ = MB_BENCH_NODE_ADDR;
+    *p++ = pcase->FC;
+    switch (pcase->FC) {
+        case MODBUS_FC05_COIL_WR:
+             *p++ = (CPU_INT08U)(MB_BENCH_ADDR_START >> 8);
+             *p++ = (CPU_INT08U)(MB_BENCH_ADDR_START & 0xFF);
+             *p++ = 0xFF;                                /* ON                                        */
+             *p++ = 0x00;
+             break;
+
+        case MODBUS_FC06_HOLDING_REG_WR:
+             *p++ = (CPU_INT08U)(MB_BENCH_ADDR_START >> 8);
+             *p++ = (CPU_INT08U)(MB_BENCH_ADDR_START & 0xFF);
+             *p++ = 0x12;
+             *p++ = 0x34;
+             break;
+
+        case MODBUS_FC08_LOOPBACK:
+             *p++ = 0x00;                                /* Return query data                         */
+             *p++ = MODBUS_FC08_LOOPBACK_QUERY;
+             *p++ = 0xA5;
+             *p++ = 0x5A;
+             break;
+
+        case MODBUS_FC15_COIL_WR_MULTIPLE:
+        case MODBUS_FC16_HOLDING_REG_WR_MULTIPLE:
+             nbr_bytes = (pcase->FC == MODBUS_FC15_COIL_WR_MULTIPLE) ? ((pcase->Qty + 7) / 8)
+                                                                     : (pcase->Qty * 2);
+             *p++ = (CPU_INT08U)(MB_BENCH_ADDR_START >> 8);
+             *p++ = (CPU_INT08U)(MB_BENCH_ADDR_START & 0xFF);
+             *p++ = (CPU_INT08U)(pcase->Qty >> 8);
+             *p++ = (CPU_INT08U)(pcase->Qty & 0xFF);
+             *p++ = (CPU_INT08U)nbr_bytes;
+             for (i = 0; i < nbr_bytes; i++) {           /* See Note #1                               */
+                 *p++ = (i & 1) ? 0x5A : 0xA5;
+             }
+             break;
+
+        default:                                         /* FC01 to FC04                              */
+             *p++ = (CPU_INT08U)(MB_BENCH_ADDR_START >> 8);
+             *p++ = (CPU_INT08U)(MB_BENCH_ADDR_START & 0xFF);
+             *p++ = (CPU_INT08U)(pcase->Qty >> 8);
+             *p++ = (CPU_INT08U)(pcase->Qty & 0xFF);
+             break;
+    }
+
+    crc = 0xFFFF;
+    for (i = 0; i < (CPU_INT16U)(p - &pframe->RTU[0]); i++) {
+        crc = MB_RTU_CRC_Upd(crc, pframe->RTU[i]);
+    }
+    pframe->ASCII_Len = MB_BenchASCII(&pframe->RTU[0],
+                                      (CPU_INT16U)(p - &pframe->RTU[0]),
+                                      &pframe->ASCII[0]);
+    *p++            = (CPU_INT08U)(crc & 0xFF);          /* CRC, low byte first                       */
+    *p++            = (CPU_INT08U)(crc >> 8);
+    pframe->RTU_Len = (CPU_INT16U)(p - &pframe->RTU[0]);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_BenchASCII()
+*
+* Description : Encodes a frame, address to data, in ASCII framing.
+*
+* Argument(s) : pbin       is a pointer to the frame.
+*
+*               len        is the length of the frame, without CRC.
+*
+*               pascii     is a pointer to the buffer receiving the ASCII frame.
+*
+* Return(s)   : The length of the ASCII frame.
+*
+* Caller(s)   : MB_BenchFrameBuild().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_INT16U  MB_BenchASCII (const CPU_INT08U  *pbin,
+                                   CPU_INT16U         len,
+                                   CPU_INT08U        *pascii)
+{
+    static  const  CPU_CHAR   hex[] = "0123456789ABCDEF";
+    CPU_INT08U                lrc;
+    CPU_INT08U               *p;
+    CPU_INT16U                i;
+
+
+    p    = pascii;
+    lrc  = 0;
+    *p++ = MODBUS_ASCII_START_FRAME_CHAR;
+    for (i = 0; i < len; i++) {
+        *p++  = hex[pbin[i] >> 4];
+        *p++  = hex[pbin[i] & 0x0F];
+        lrc  += pbin[i];
+    }
+    lrc  = (CPU_INT08U)(-lrc);                           /* Two's complement of the sum               */
+    *p++ = hex[lrc >> 4];
+    *p++ = hex[lrc & 0x0F];
+    *p++ = MODBUS_ASCII_END_FRAME_CHAR1;
+    *p++ = MODBUS_ASCII_END_FRAME_CHAR2;
+    return ((CPU_INT16U)(p - pascii));
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_BenchRun()
+*
+* Description : Runs a function of a benchmark case for MB_BenchDurMs and prints its figures.
+*
+* Argument(s) : pcase      is the benchmark case.
+*
+*               pname      is the name of the function measured.
+*
+*               fnct       is the function measured.
+*
+*               pch        is the channel the function is given.
+*
+*               nbr_bytes  is the length of the frame processed by the function.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : main().
+*
+* Note(s)     : (1) The clock is read every MB_BENCH_BATCH frames, so that its cost doesn't show.  The
+*                   warm-up lasts a tenth of the run.
+*********************************************************************************************************
+*/
+
+static  void  MB_BenchRun (const MB_BENCH_CASE  *pcase,
+                           const CPU_CHAR       *pname,
+                           MB_BENCH_FNCT         fnct,
+                           MODBUS_CH            *pch,
+                           CPU_INT16U            nbr_bytes)
+{
+    CPU_INT64U  dur_ns;
+    CPU_INT64U  start_ns;
+    CPU_INT64U  end_ns;
+    CPU_INT64U  start_tsc;
+    CPU_INT64U  end_tsc;
+    CPU_INT64U  nbr_frames;
+    CPU_INT16U  i;
+    double      ns_frame;
+    double      cyc_frame;
+
+
+    dur_ns   = (CPU_INT64U)MB_BenchDurMs * 1000000u;
+    start_ns = MB_BenchNs();                             /* Warm-up (see Note #1)                     */
+    do {
+        for (i = 0; i < MB_BENCH_BATCH; i++) {
+            fnct(pch);
+        }
+    } while (MB_BenchNs() - start_ns < dur_ns / 10);
+
+    nbr_frames = 0;
+    start_tsc  = MB_BenchTSC();
+    start_ns   = MB_BenchNs();
+    do {
+        for (i = 0; i < MB_BENCH_BATCH; i++) {
+            fnct(pch);
+        }
+        nbr_frames += MB_BENCH_BATCH;
+        end_ns      = MB_BenchNs();
+    } while (end_ns - start_ns < dur_ns);
+    end_tsc = MB_BenchTSC();
+
+    ns_frame  = (double)(end_ns  - start_ns ) / (double)nbr_frames;
+    cyc_frame = (double)(end_tsc - start_tsc) / (double)nbr_frames;
+    if (MB_BenchCSV == DEF_TRUE) {
+        printf("%u,%u,%s,%u,%.0f,%.1f,%.3f,",
+               pcase->FC, pcase->Qty, pname, nbr_bytes,
+               1e9 / ns_frame, ns_frame, ns_frame / nbr_bytes);
+        if (MB_BENCH_TSC_EN == DEF_ENABLED) {
+            printf("%.0f\n", cyc_frame);
+        } else {
+            printf("\n");
+        }
+    } else {
+        printf("%02u   %5u  %-9s %5u %12.0f %10.1f %9.3f ",
+               pcase->FC, pcase->Qty, pname, nbr_bytes,
+               1e9 / ns_frame, ns_frame, ns_frame / nbr_bytes);
+        if (MB_BENCH_TSC_EN == DEF_ENABLED) {
+            printf("%10.0f\n", cyc_frame);
+        } else {
+            printf("%10s\n", "-");
+        }
+    }
+    fflush(stdout);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         BENCHMARKED FUNCTIONS
+*
+* Description : Wrappers calling the functions measured (see Note #1).
+*
+* Argument(s) : pch        is the channel.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_BenchRun().
+*
+* Note(s)     : (1) MB_RTU_Rx() and MB_ASCII_Rx() leave .RxBuf[] unchanged, MBS_FCxx_Handler() leaves
+*                   .RxFrameData[] unchanged, MB_RTU_Tx() and MB_ASCII_Tx() leave .TxFrameData[] unchanged:
+*                   each call processes the same frame.
+*********************************************************************************************************
+*/
+
+static  void  MB_BenchCRC (MODBUS_CH  *pch)
+{
+    MB_BenchSink += MB_RTU_RxCalcCRC(pch);
+}
+
+
+static  void  MB_BenchRTU_Rx (MODBUS_CH  *pch)
+{
+    MB_BenchSink += MB_RTU_Rx(pch);
+}
+
+
+static  void  MB_BenchFCxx (MODBUS_CH  *pch)
+{
+    MB_BenchSink += MBS_FCxx_Handler(pch);
+}
+
+
+static  void  MB_BenchRTU_Tx (MODBUS_CH  *pch)
+{
+    MB_RTU_Tx(pch);
+    MB_BenchSink += pch->TxBufByteCtr;
+}
+
+
+static  void  MB_BenchASCII_Rx (MODBUS_CH  *pch)
+{
+    MB_BenchSink += MB_ASCII_Rx(pch);
+}
+
+
+static  void  MB_BenchASCII_Tx (MODBUS_CH  *pch)
+{
+    MB_ASCII_Tx(pch);
+    MB_BenchSink += pch->TxBufByteCtr;
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_BenchNs()
+*                                            MB_BenchTSC()
+*
+* Description : Read the monotonic clock in nanoseconds, and the time stamp counter.
+*
+* Argument(s) : none.
+*
+* Return(s)   : The clock, the counter (0 when there is none, see Note #2 at the top of this file).
+*
+* Caller(s)   : MB_BenchRun().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_INT64U  MB_BenchNs (void)
+{
+    struct timespec  ts;
+
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((CPU_INT64U)ts.tv_sec * 1000000000u + (CPU_INT64U)ts.tv_nsec);
+}
+
+
+static  CPU_INT64U  MB_BenchTSC (void)
+{
+#if (MB_BENCH_TSC_EN == DEF_ENABLED)
+    return ((CPU_INT64U)__rdtsc());
+#else
+    return (0u);
+#endif
+}
@@ -0,0 +1,510 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                   MODBUS HOST LOOPBACK HARNESS
+*
+* Filename : mb_loop.c
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) Connects a master channel and a slave channel of the same process through a pseudo-terminal
+*                (see mb_bsp_posix.c Note #1) and runs transactions from the master, one at a time, through
+*                the whole stack: framing, Rx threads, RTU timer, slave task and master wait.
+*
+*            (2) For each function code served by both the master and the slave, and a small, medium and
+*                maximum quantity, it reports:
+*
+*                    req/rsp    length of the request and of the response on the line
+*                    trans/s    transactions completed per second
+*                    p50..p999  round trip latency percentiles in microseconds, from the call of MBM_FCxx()
+*                               to its return
+*
+*                FC20 and FC21 have no master function, FC22 and FC23 aren't implemented by the stack: they
+*                aren't run.
+*
+*            (3) A pseudo-terminal transfers a frame at once.  With -p both channels hold each frame for its
+*                time on a line at the baud rate (see mb_bsp_posix.c Note #3), so that the figures include
+*                the transfer times.  The RTU end of frame is detected by the RTU timer in both cases, its
+*                frequency is set by -r.
+*
+*            (4) Usage:  mb_loop [-n <count>] [-b <baud>] [-p] [-a] [-r <Hz>] [-f <fc>] [-c]
+*
+*                    -n   transactions per case (1000 by default)
+*                    -b   baud rate of both channels (115200 by default)
+*                    -p   pace the frames at the baud rate
+*                    -a   ASCII mode instead of RTU
+*                    -r   frequency of the RTU timer (10000 Hz by default, 65535 at most)
+*                    -f   run the cases of one function code only
+*                    -c   print comma separated values
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#include  "mb.h"
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <time.h>
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  MB_LOOP_NODE_ADDR                          1
+#define  MB_LOOP_ADDR_START                       100    /* See mb_bench.c Note #3                    */
+#define  MB_LOOP_PORT_MASTER                        0    /* Master side of the pseudo-terminal ...    */
+#define  MB_LOOP_PORT_SLAVE                         1    /* ... and its slave side                    */
+
+#define  MB_LOOP_NBR_DFLT                        1000
+#define  MB_LOOP_BAUD_DFLT                     115200
+#define  MB_LOOP_RTU_FREQ_DFLT                  10000
+#define  MB_LOOP_TIMEOUT_MS                      2000    /* Master timeout, a paced 255 byte frame ...*/
+                                                         /* ... takes 266 ms at 9600 baud             */
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+typedef  struct  mb_loop_case {                          /* Transaction of a case                     */
+    CPU_INT08U   FC;
+    CPU_INT16U   Qty;                                    /* Nbr of coils/registers, 0 if not relevant */
+} MB_LOOP_CASE;
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+static  const  MB_LOOP_CASE  MB_LoopCaseTbl[] = {
+    { MODBUS_FC01_COIL_RD,                    8 },
+    { MODBUS_FC01_COIL_RD,                  256 },
+    { MODBUS_FC01_COIL_RD,                 2000 },
+    { MODBUS_FC02_DI_RD,                      8 },
+    { MODBUS_FC02_DI_RD,                    256 },
+    { MODBUS_FC02_DI_RD,                   2000 },
+    { MODBUS_FC03_HOLDING_REG_RD,             1 },
+    { MODBUS_FC03_HOLDING_REG_RD,            16 },
+    { MODBUS_FC03_HOLDING_REG_RD,           125 },
+    { MODBUS_FC04_IN_REG_RD,                  1 },
+    { MODBUS_FC04_IN_REG_RD,                 16 },
+    { MODBUS_FC04_IN_REG_RD,                125 },
+    { MODBUS_FC05_COIL_WR,                    1 },
+    { MODBUS_FC06_HOLDING_REG_WR,             1 },
+    { MODBUS_FC08_LOOPBACK,                   0 },
+    { MODBUS_FC15_COIL_WR_MULTIPLE,           8 },
+    { MODBUS_FC15_COIL_WR_MULTIPLE,         256 },
+    { MODBUS_FC15_COIL_WR_MULTIPLE,        1968 },
+    { MODBUS_FC16_HOLDING_REG_WR_MULTIPLE,    1 },
+    { MODBUS_FC16_HOLDING_REG_WR_MULTIPLE,   16 },
+    { MODBUS_FC16_HOLDING_REG_WR_MULTIPLE,  123 },
+};
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U   MB_LoopCoilTbl[256];                /* Coils/DIs read or written                 */
+static  CPU_INT16U   MB_LoopRegTbl[125];                 /* Registers read or written                 */
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  CPU_INT16U  MB_LoopTrans  (MODBUS_CH           *pch,
+                                   const MB_LOOP_CASE  *pcase);
+
+static  void        MB_LoopLenGet (const MB_LOOP_CASE  *pcase,
+                                   CPU_BOOLEAN          ascii,
+                                   CPU_INT16U          *preq_len,
+                                   CPU_INT16U          *prsp_len);
+
+static  int         MB_LoopCmp    (const void          *pa,
+                                   const void          *pb);
+
+static  CPU_INT64U  MB_LoopNs     (void);
+
+
+/*
+*********************************************************************************************************
+*                                               main()
+*
+* Description : Runs the loopback cases (see Note #4).
+*
+* Argument(s) : argc, argv   command line.
+*
+* Return(s)   : 0, 1 on an error.
+*
+* Caller(s)   : none.
+*
+* Note(s)     : (1) The percentiles are taken on the transactions that succeeded, a failed transaction is
+*                   counted in the 'err' column only.
+*********************************************************************************************************
+*/
+
+int  main (int    argc,
+           char  *argv[])
+{
+    MODBUS_CH           *pch_m;
+    MODBUS_CH           *pch_s;
+    const MB_LOOP_CASE  *pcase;
+    CPU_CHAR             pts_name[64];
+    CPU_INT64U          *plat_tbl;
+    CPU_INT64U           start_ns;
+    CPU_INT64U           trans_ns;
+    CPU_INT64U           total_ns;
+    double               p50_us;
+    double               p99_us;
+    double               p999_us;
+    double               max_us;
+    CPU_INT32U           nbr_trans;
+    CPU_INT32U           nbr_ok;
+    CPU_INT32U           nbr_err;
+    CPU_INT32U           rtu_freq;
+    CPU_INT32U           baud;
+    CPU_INT32U           n;
+    CPU_INT16U           req_len;
+    CPU_INT16U           rsp_len;
+    CPU_INT16U           err;
+    CPU_INT16U           i;
+    CPU_INT16S           fc_sel;
+    CPU_INT08U           mode;
+    CPU_BOOLEAN          pace;
+    CPU_BOOLEAN          csv;
+    int                  arg;
+
+
+    nbr_trans = MB_LOOP_NBR_DFLT;
+    baud      = MB_LOOP_BAUD_DFLT;
+    rtu_freq  = MB_LOOP_RTU_FREQ_DFLT;
+    mode      = MODBUS_MODE_RTU;
+    pace      = DEF_FALSE;
+    csv       = DEF_FALSE;
+    fc_sel    = -1;
+    for (arg = 1; arg < argc; arg++) {
+        if ((strcmp(argv[arg], "-n") == 0) && (arg + 1 < argc)) {
+            nbr_trans = (CPU_INT32U)strtoul(argv[++arg], (char **)0, 0);
+        } else if ((strcmp(argv[arg], "-b") == 0) && (arg + 1 < argc)) {
+            baud      = (CPU_INT32U)strtoul(argv[++arg], (char **)0, 0);
+        } else if ((strcmp(argv[arg], "-r") == 0) && (arg + 1 < argc)) {
+            rtu_freq  = (CPU_INT32U)strtoul(argv[++arg], (char **)0, 0);
+        } else if ((strcmp(argv[arg], "-f") == 0) && (arg + 1 < argc)) {
+            fc_sel    = (CPU_INT16S)strtol(argv[++arg], (char **)0, 0);
+        } else if (strcmp(argv[arg], "-p") == 0) {
+            pace      = DEF_TRUE;
+        } else if (strcmp(argv[arg], "-a") == 0) {
+            mode      = MODBUS_MODE_ASCII;
+        } else if (strcmp(argv[arg], "-c") == 0) {
+            csv       = DEF_TRUE;
+        } else {
+            fprintf(stderr, "usage: %s [-n <count>] [-b <baud>] [-p] [-a] [-r <Hz>] [-f <fc>] [-c]\n", argv[0]);
+            return (1);
+        }
+    }
+    if ((nbr_trans == 0) ||
+        (baud      == 0) ||
+        (rtu_freq  == 0) ||
+        (rtu_freq  >  65535u)) {                         /* MB_RTU_Freq is 16 bits                    */
+        fprintf(stderr, "mb_loop: -n and -b must be > 0, -r within 1..65535\n");
+        return (1);
+    }
+
+    plat_tbl = (CPU_INT64U *)malloc(nbr_trans * sizeof(CPU_INT64U));
+    if (plat_tbl == (CPU_INT64U *)0) {
+        fprintf(stderr, "mb_loop: out of memory\n");
+        return (1);
+    }
+
+    MB_Init(rtu_freq);
+    err = MB_CommPtyOpen(MB_LOOP_PORT_MASTER, pts_name, sizeof(pts_name));
+    if (err != MODBUS_ERR_NONE) {
+        fprintf(stderr, "mb_loop: can't open a pseudo-terminal (err %u)\n", err);
+        return (1);
+    }
+    (void)MB_CommPortPathSet(MB_LOOP_PORT_SLAVE, pts_name);
+    (void)MB_CommPortPaceSet(MB_LOOP_PORT_MASTER, pace);
+    (void)MB_CommPortPaceSet(MB_LOOP_PORT_SLAVE,  pace);
+
+    pch_m = MB_CfgCh(MB_LOOP_NODE_ADDR, MODBUS_MASTER, MB_LOOP_TIMEOUT_MS, mode,
+                     MB_LOOP_PORT_MASTER, baud, 8, MODBUS_PARITY_NONE, 1, MODBUS_WR_EN);
+    pch_s = MB_CfgCh(MB_LOOP_NODE_ADDR, MODBUS_SLAVE,  0,                  mode,
+                     MB_LOOP_PORT_SLAVE,  baud, 8, MODBUS_PARITY_NONE, 1, MODBUS_WR_EN);
+    if ((pch_m == (MODBUS_CH *)0) ||
+        (pch_s == (MODBUS_CH *)0)) {
+        fprintf(stderr, "mb_loop: no channel available\n");
+        return (1);
+    }
+
+    if (csv == DEF_TRUE) {
+        printf("fc,qty,req,rsp,n,err,trans_s,p50_us,p99_us,p999_us,max_us\n");
+    } else {
+        printf("%s %u baud%s, %u transactions per case\n",
+               (mode == MODBUS_MODE_RTU) ? "RTU" : "ASCII", baud, (pace == DEF_TRUE) ? " paced" : "",
+               nbr_trans);
+        printf("%-4s %5s %5s %5s %6s %10s %10s %10s %10s %10s\n",
+               "FC", "qty", "req", "rsp", "err", "trans/s", "p50 us", "p99 us", "p999 us", "max us");
+    }
+
+    for (i = 0; i < sizeof(MB_LoopCaseTbl) / sizeof(MB_LoopCaseTbl[0]); i++) {
+        pcase = &MB_LoopCaseTbl[i];
+        if ((fc_sel >= 0) && (pcase->FC != (CPU_INT08U)fc_sel)) {
+            continue;
+        }
+        MB_LoopLenGet(pcase, (mode == MODBUS_MODE_ASCII) ? DEF_TRUE : DEF_FALSE, &req_len, &rsp_len);
+        if ((req_len > MODBUS_CFG_BUF_SIZE) ||           /* Frame too long for ASCII mode             */
+            (rsp_len > MODBUS_CFG_BUF_SIZE)) {
+            continue;
+        }
+
+        nbr_ok   = 0;
+        nbr_err  = 0;
+        start_ns = MB_LoopNs();
+        for (n = 0; n < nbr_trans; n++) {
+            trans_ns = MB_LoopNs();
+            err      = MB_LoopTrans(pch_m, pcase);
+            trans_ns = MB_LoopNs() - trans_ns;
+            if (err == MODBUS_ERR_NONE) {                /* See Note #1                               */
+                plat_tbl[nbr_ok++] = trans_ns;
+            } else {
+                nbr_err++;
+            }
+        }
+        total_ns = MB_LoopNs() - start_ns;
+
+        if (nbr_ok == 0) {
+            fprintf(stderr, "mb_loop: FC%02u qty %u, all transactions failed (err %u)\n",
+                    pcase->FC, pcase->Qty, err);
+            continue;
+        }
+        qsort(plat_tbl, nbr_ok, sizeof(CPU_INT64U), MB_LoopCmp);
+        p50_us  = plat_tbl[(nbr_ok *  50u +  99u) /  100u - 1u] / 1e3;
+        p99_us  = plat_tbl[(nbr_ok *  99u +  99u) /  100u - 1u] / 1e3;
+        p999_us = plat_tbl[(nbr_ok * 999u + 999u) / 1000u - 1u] / 1e3;
+        max_us  = plat_tbl[nbr_ok - 1u] / 1e3;
+        if (csv == DEF_TRUE) {
+            printf("%u,%u,%u,%u,%u,%u,%.0f,%.1f,%.1f,%.1f,%.1f\n",
+                   pcase->FC, pcase->Qty, req_len, rsp_len, nbr_trans, nbr_err,
+                   (double)nbr_ok * 1e9 / (double)total_ns, p50_us, p99_us, p999_us, max_us);
+        } else {
+            printf("%02u   %5u %5u %5u %6u %10.0f %10.1f %10.1f %10.1f %10.1f\n",
+                   pcase->FC, pcase->Qty, req_len, rsp_len, nbr_err,
+                   (double)nbr_ok * 1e9 / (double)total_ns, p50_us, p99_us, p999_us, max_us);
+        }
+        fflush(stdout);
+    }
+
+    MB_Exit();
+    free(plat_tbl);
+    return (0);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_LoopTrans()
+*
+* Description : Runs the transaction of a case from the master channel.
+*
+* Argument(s) : pch        is a pointer to the master channel.
+*
+*               pcase      is the case.
+*
+* Return(s)   : The error code returned by the master function.
+*
+* Caller(s)   : main().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_INT16U  MB_LoopTrans (MODBUS_CH           *pch,
+                                  const MB_LOOP_CASE  *pcase)
+{
+    CPU_INT16U  val;
+
+
+    switch (pcase->FC) {
+        case MODBUS_FC01_COIL_RD:
+             return (MBM_FC01_CoilRd(pch, MB_LOOP_NODE_ADDR, MB_LOOP_ADDR_START, MB_LoopCoilTbl, pcase->Qty));
+
+        case MODBUS_FC02_DI_RD:
+             return (MBM_FC02_DIRd(pch, MB_LOOP_NODE_ADDR, MB_LOOP_ADDR_START, MB_LoopCoilTbl, pcase->Qty));
+
+        case MODBUS_FC03_HOLDING_REG_RD:
+             return (MBM_FC03_HoldingRegRd(pch, MB_LOOP_NODE_ADDR, MB_LOOP_ADDR_START, MB_LoopRegTbl, pcase->Qty));
+
+        case MODBUS_FC04_IN_REG_RD:
+             return (MBM_FC04_InRegRd(pch, MB_LOOP_NODE_ADDR, MB_LOOP_ADDR_START, MB_LoopRegTbl, pcase->Qty));
+
+        case MODBUS_FC05_COIL_WR:
+             return (MBM_FC05_CoilWr(pch, MB_LOOP_NODE_ADDR, MB_LOOP_ADDR_START, DEF_TRUE));
+
+        case MODBUS_FC06_HOLDING_REG_WR:
+             return (MBM_FC06_HoldingRegWr(pch, MB_LOOP_NODE_ADDR, MB_LOOP_ADDR_START, 0x1234));
+
+        case MODBUS_FC08_LOOPBACK:
+             return (MBM_FC08_Diag(pch, MB_LOOP_NODE_ADDR, MODBUS_FC08_LOOPBACK_QUERY, 0xA55A, &val));
+
+        case MODBUS_FC15_COIL_WR_MULTIPLE:
+             return (MBM_FC15_CoilWr(pch, MB_LOOP_NODE_ADDR, MB_LOOP_ADDR_START, MB_LoopCoilTbl, pcase->Qty));
+
+        case MODBUS_FC16_HOLDING_REG_WR_MULTIPLE:
+             return (MBM_FC16_HoldingRegWrN(pch, MB_LOOP_NODE_ADDR, MB_LOOP_ADDR_START, MB_LoopRegTbl, pcase->Qty));
+
+        default:
+             return (MODBUS_ERR_ILLEGAL_FC);
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_LoopLenGet()
+*
+* Description : Computes the length on the line of the request and of the response of a case.
+*
+* Argument(s) : pcase      is the case.
+*
+*               ascii      DEF_TRUE for ASCII framing, DEF_FALSE for RTU framing.
+*
+*               preq_len   is a pointer to a variable that will receive the length of the request.
+*
+*               prsp_len   is a pointer to a variable that will receive the length of the response.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : main().
+*
+* Note(s)     : (1) An RTU frame of N bytes, CRC included, takes 2 x N + 1 characters in ASCII: ':', two per
+*                   byte of address, function code and data, two for the LRC, CR and LF.
+*********************************************************************************************************
+*/
+
+static  void  MB_LoopLenGet (const MB_LOOP_CASE  *pcase,
+                             CPU_BOOLEAN          ascii,
+                             CPU_INT16U          *preq_len,
+                             CPU_INT16U          *prsp_len)
+{
+    switch (pcase->FC) {
+        case MODBUS_FC01_COIL_RD:
+        case MODBUS_FC02_DI_RD:
+             *preq_len = 8;
+             *prsp_len = 5 + (pcase->Qty + 7) / 8;
+             break;
+
+        case MODBUS_FC03_HOLDING_REG_RD:
+        case MODBUS_FC04_IN_REG_RD:
+             *preq_len = 8;
+             *prsp_len = 5 + pcase->Qty * 2;
+             break;
+
+        case MODBUS_FC15_COIL_WR_MULTIPLE:
+             *preq_len = 9 + (pcase->Qty + 7) / 8;
+             *prsp_len = 8;
+             break;
+
+        case MODBUS_FC16_HOLDING_REG_WR_MULTIPLE:
+             *preq_len = 9 + pcase->Qty * 2;
+             *prsp_len = 8;
+             break;
+
+        default:                                         /* FC05, FC06 and FC08                       */
+             *preq_len = 8;
+             *prsp_len = 8;
+             break;
+    }
+    if (ascii == DEF_TRUE) {                             /* See Note #1                               */
+        *preq_len = *preq_len * 2 + 1;
+        *prsp_len = *prsp_len * 2 + 1;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_LoopCmp()
+*
+* Description : Compares two latencies for qsort().
+*
+* Argument(s) : pa, pb     are pointers to the latencies.
+*
+* Return(s)   : -1, 0 or 1 as *pa is lower than, equal to or greater than *pb.
+*
+* Caller(s)   : qsort().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  int  MB_LoopCmp (const void  *pa,
+                         const void  *pb)
+{
+    CPU_INT64U  a;
+    CPU_INT64U  b;
+
+
+    a = *(const CPU_INT64U *)pa;
+    b = *(const CPU_INT64U *)pb;
+    return ((a > b) - (a < b));
+}
+
+
+/*
+*********************************************************************************************************
+*                                             MB_LoopNs()
+*
+* Description : Reads the monotonic clock in nanoseconds.
+*
+* Argument(s) : none.
+*
+* Return(s)   : The clock.
+*
+* Caller(s)   : main().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_INT64U  MB_LoopNs (void)
+{
+    struct timespec  ts;
+
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((CPU_INT64U)ts.tv_sec * 1000000000u + (CPU_INT64U)ts.tv_nsec);
+}
@@ -113,6 +113,10 @@ void  MB_Init (CPU_INT32U freq)
 {
     CPU_INT08U   ch;
     MODBUS_CH   *pch;
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED) || \
+    (MODBUS_CFG_MBM_REQ_EN    == DEF_ENABLED)
+    CPU_INT16U   i;
+#endif
 
 #if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
     MB_RTU_Freq = freq;                                         /* Save the RTU frequency                             */
@@ -122,14 +126,67 @@ void  MB_Init (CPU_INT32U freq)
     for (ch = 0; ch < MODBUS_CFG_MAX_CH; ch++) {                /* Initialize default values                          */
         pch->Ch            = ch;
         pch->NodeAddr      = 1;
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+        for (i = 0; i < 256; i++) {                             /* Channel only answers its node address ...          */
+            pch->NodeAddrTbl[i] = 0;
+        }
+        pch->NodeAddrTbl[pch->NodeAddr] = 1;                    /* ... served by the default data model               */
+        for (i = 0; i < MODBUS_CFG_DATA_MODEL_MAX; i++) {
+            pch->DataModelTbl[i] = (MODBUS_DATA_MODEL const *)0;
+        }
+        pch->DataModelTbl[0] = &MBS_DataModelDflt;              /* Entry 0 always holds the mb_data.c data model      */
+        pch->DataModelPtr    = &MBS_DataModelDflt;
+#endif
+#if (MODBUS_CFG_IMG_EN == DEF_ENABLED)
+        pch->HoldingRegImgPtr = (MODBUS_IMG *)0;
+        pch->InRegImgPtr      = (MODBUS_IMG *)0;
+#endif
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+        for (i = 0; i < MODBUS_MBM_PRIO_NBR; i++) {
+            pch->MBM_ReqHeadPtr[i] = (MODBUS_MBM_REQ *)0;
+            pch->MBM_ReqTailPtr[i] = (MODBUS_MBM_REQ *)0;
+        }
+        pch->MBM_ReqCtr       = 0;
+#if (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)
+        pch->MBM_PipeHeadPtr  = (MODBUS_MBM_REQ *)0;
+        pch->MBM_PipeTailPtr  = (MODBUS_MBM_REQ *)0;
+        pch->MBM_PipeCtr      = 0;
+        pch->MBM_PipeWin      = MODBUS_CFG_MBM_PIPE_WIN;
+#endif
+#endif
+#if (MODBUS_CFG_MBM_RTO_EN    == DEF_ENABLED) || \
+    (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+        MBM_SlaveInit(pch);
+#endif
         pch->MasterSlave   = MODBUS_SLAVE;                      /* Channel defaults to MODBUS_SLAVE mode              */
         pch->Mode          = MODBUS_MODE_ASCII;
         pch->RxBufByteCtr  = 0;
         pch->RxBufPtr      = &pch->RxBuf[0];
         pch->WrEn          = MODBUS_WR_EN;
         pch->WrCtr         = 0;
+#if (MODBUS_CFG_MBM_RETRY_EN == DEF_ENABLED)
+        pch->RetryNbr      = MODBUS_CFG_MBM_RETRY_NBR;
+        pch->RetryOpt      = MODBUS_CFG_MBM_RETRY_OPT;
+        pch->RetryDeadline = MODBUS_CFG_MBM_RETRY_DEADLINE;
+        pch->RetryCtr      = 0;
+#endif
 #if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
         pch->RTU_TimeoutEn = DEF_TRUE;
+#if (MODBUS_CFG_MBM_RX_EARLY_EN == DEF_ENABLED)
+        pch->RTU_RxLenExp  = 0;
+#endif
+#endif
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+        pch->TCP_Mode       = MODBUS_MODE_TCP;
+        pch->TCP_Sock       = -1;
+        pch->TCP_ListenSock = -1;
+        pch->TCP_Addr       = 0;
+        pch->TCP_Port       = 0;
+        pch->TCP_TID        = 0;
+        pch->TCP_Unit       = 0;
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+        pch->TCP_ConnPtr    = (struct modbus_tcp_conn *)0;
+#endif
 #endif
 
 #if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)  && \
@@ -141,6 +198,18 @@ void  MB_Init (CPU_INT32U freq)
 
     MB_ChCtr = 0;
 
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+    MBM_CacheClr();
+#endif
+
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+    MB_TCP_Init();                                              /* Free the Modbus/TCP connections                    */
+#endif
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+    MB_GW_Init();                                               /* Clear the gateway's routes and requests            */
+#endif
+
     MB_OS_Init();                                               /* Initialize OS interface functions                  */
 
 
@@ -174,6 +243,9 @@ void  MB_Exit (void)
 #endif
 
     MB_CommExit();                                              /* Disable all communications                         */
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+    MB_TCP_Exit();                                              /* Close all Modbus/TCP connections                   */
+#endif
 
     MB_OS_Exit();                                               /* Stop RTOS services                                 */
 }
@@ -195,6 +267,9 @@ void  MB_Exit (void)
 *               modbus_mode   specifies the type of modbus channel.  The choices are:
 *                             MODBUS_MODE_ASCII
 *                             MODBUS_MODE_RTU
+*                             MODBUS_MODE_TCP
+*                             MODBUS_MODE_RTU_TCP
+*                             MODBUS_MODE_UDP
 *
 *               port_nbr      is the UART port number associated with the channel
 *
@@ -218,7 +293,8 @@ void  MB_Exit (void)
 *
 * Caller(s)   : Application.
 *
-* Note(s)     : none.
+* Note(s)     : (1) A MODBUS_MODE_TCP, _RTU_TCP or _UDP channel has no UART: 'baud', 'bits', 'parity' and
+*                   'stops' are ignored.  The connection is set up with MB_TCP_Listen() or MB_TCP_Connect().
 *********************************************************************************************************
 */
 
@@ -245,6 +321,12 @@ MODBUS_CH  *MB_CfgCh (CPU_INT08U  node_addr,
         MB_ModeSet(pch, master_slave, modbus_mode);
         MB_WrEnSet(pch, wr_en);
         MB_ChToPortMap(pch, port_nbr);
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+        if (pch->Mode == MODBUS_MODE_TCP) {                     /* See Note #1                                        */
+            MB_ChCtr++;
+            return (pch);
+        }
+#endif
         MB_CommPortCfg(pch, port_nbr, baud, bits, parity, stops);
 #if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
         if (pch->MasterSlave == MODBUS_MASTER) {
@@ -289,9 +371,50 @@ void  MB_MasterTimeoutSet (MODBUS_CH  *pch,
                            CPU_INT32U  timeout)
 {
     if (pch != (MODBUS_CH *)0) {
-        pch->RxTimeout = timeout;
+        pch->RxTimeout    = timeout;
+        pch->RxTimeoutCur = timeout;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_MasterRetrySet()
+*
+* Description : This function is called to change the retry policy of a master channel.
+*
+* Argument(s) : pch          is a pointer to the Modbus channel to change
+*
+*               retry_nbr    is the maximum number of times a failed request is sent again
+*
+*               retry_opt    specifies the failures that trigger a retry, any combination of:
+*                            MODBUS_MBM_RETRY_TIMEOUT     the slave didn't answer
+*                            MODBUS_MBM_RETRY_RX          the reply is invalid (CRC/LRC or frame error)
+*                            MODBUS_MBM_RETRY_BUSY        the slave answered with a 'slave device busy' exception
+*
+*               deadline     is the time allowed for all the attempts of a request, in ticks (0 for no deadline)
+*
+* Return(s)   : none.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) The channel's defaults are MODBUS_CFG_MBM_RETRY_NBR, _OPT and _DEADLINE.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_RETRY_EN == DEF_ENABLED)
+void  MB_MasterRetrySet (MODBUS_CH  *pch,
+                         CPU_INT08U  retry_nbr,
+                         CPU_INT08U  retry_opt,
+                         CPU_INT32U  deadline)
+{
+    if (pch != (MODBUS_CH *)0) {
+        pch->RetryNbr      = retry_nbr;
+        pch->RetryOpt      = retry_opt;
+        pch->RetryDeadline = deadline;
     }
 }
+#endif
 
 /*
 *********************************************************************************************************
@@ -304,12 +427,16 @@ void  MB_MasterTimeoutSet (MODBUS_CH  *pch,
 *               modbus_mode  specifies the type of modbus channel.  The choices are:
 *                            MODBUS_MODE_ASCII
 *                            MODBUS_MODE_RTU
+*                            MODBUS_MODE_TCP
+*                            MODBUS_MODE_RTU_TCP
+*                            MODBUS_MODE_UDP
 *
 * Return(s)   : none.
 *
 * Caller(s)   : Application.
 *
-* Note(s)     : none.
+* Note(s)     : (1) MODBUS_MODE_RTU_TCP and MODBUS_MODE_UDP are Modbus/TCP channels with another framing
+*                   (see mb_cfg.h, MODBUS TCP CONFIGURATION Note #7).
 *********************************************************************************************************
 */
 
@@ -343,6 +470,27 @@ void  MB_ModeSet (MODBUS_CH  *pch,
                  break;
 #endif
 
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+            case MODBUS_MODE_TCP:
+                 pch->Mode     = MODBUS_MODE_TCP;
+                 pch->TCP_Mode = MODBUS_MODE_TCP;
+                 break;
+#endif
+
+#if (MODBUS_CFG_RTU_TCP_EN == DEF_ENABLED)
+            case MODBUS_MODE_RTU_TCP:                           /* See Note #1                                        */
+                 pch->Mode     = MODBUS_MODE_TCP;
+                 pch->TCP_Mode = MODBUS_MODE_RTU_TCP;
+                 break;
+#endif
+
+#if (MODBUS_CFG_UDP_EN == DEF_ENABLED)
+            case MODBUS_MODE_UDP:
+                 pch->Mode     = MODBUS_MODE_TCP;
+                 pch->TCP_Mode = MODBUS_MODE_UDP;
+                 break;
+#endif
+
             default:
 #if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
                  pch->Mode = MODBUS_MODE_RTU;
@@ -376,10 +524,187 @@ void  MB_NodeAddrSet (MODBUS_CH  *pch,
                       CPU_INT08U  node_addr)
 {
     if (pch != (MODBUS_CH *)0) {
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+        if (pch->NodeAddrTbl[pch->NodeAddr] == 1) {             /* Unmap the previous address from the dflt model     */
+            pch->NodeAddrTbl[pch->NodeAddr]  = 0;
+        }
+        if (node_addr != 0) {                                   /* Map the new address onto the default data model    */
+            pch->NodeAddrTbl[node_addr]      = 1;
+        }
+#endif
         pch->NodeAddr = node_addr;
     }
 }
 
+
+/*
+*********************************************************************************************************
+*                                           MB_NodeAddrChk()
+*
+* Description : This function is called to determine whether the channel answers a Modbus node address.
+*
+* Argument(s) : pch          is a pointer to the Modbus channel
+*
+*               node_addr    is the node address found in the received frame.
+*
+* Return(s)   : DEF_TRUE     if the channel answers 'node_addr'
+*               DEF_FALSE    otherwise
+*
+* Caller(s)   : MB_ASCII_RxByte(),
+*               MBS_FCxx_Handler().
+*
+* Note(s)     : (1) The broadcast address (0) is NOT reported by this function, callers test for it
+*                   separately since broadcasts are never answered.
+*
+*               (2) When MODBUS_CFG_MULTI_ADDR_EN is DEF_ENABLED, the check is a single lookup in
+*                   .NodeAddrTbl[] regardless of the number of addresses answered by the channel.
+*********************************************************************************************************
+*/
+
+CPU_BOOLEAN  MB_NodeAddrChk (MODBUS_CH  *pch,
+                             CPU_INT08U  node_addr)
+{
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+    if (pch->NodeAddrTbl[node_addr] != 0) {
+        return (DEF_TRUE);
+    }
+#else
+    if (pch->NodeAddr == node_addr) {
+        return (DEF_TRUE);
+    }
+#endif
+    return (DEF_FALSE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_NodeAddrAdd()
+*
+* Description : This function is called to make a slave channel answer an additional Modbus node address.
+*
+* Argument(s) : pch          is a pointer to the Modbus channel to change
+*
+*               node_addr    is the Modbus node address to answer (1 to 255).
+*
+*               pmodel       is a pointer to the data model serving requests sent to 'node_addr'.  A NULL
+*                            pointer selects the data model built from the functions in mb_data.c.
+*
+* Return(s)   : MODBUS_ERR_NONE          the channel now answers 'node_addr'
+*               MODBUS_ERR_NULLPTR       'pch' is a NULL pointer
+*               MODBUS_ERR_SLAVE_ADDR    'node_addr' is the broadcast address
+*               MODBUS_ERR_FULL          MODBUS_CFG_DATA_MODEL_MAX different data models are already in use
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) Several node addresses may share the same data model, the model only takes one entry
+*                   in .DataModelTbl[].
+*
+*               (2) A data model member left NULL makes the slave answer the function codes that need it
+*                   with an 'Illegal Function' exception.
+*
+*               (3) Broadcast requests are served by the default data model (see MB_Init()).
+*
+*               (4) This function must not be called while the channel is processing requests.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+CPU_INT16U  MB_NodeAddrAdd (MODBUS_CH                *pch,
+                            CPU_INT08U                node_addr,
+                            MODBUS_DATA_MODEL const  *pmodel)
+{
+    CPU_INT08U  ix;
+    CPU_INT08U  ix_free;
+
+
+    if (pch == (MODBUS_CH *)0) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+    if (node_addr == 0) {                                       /* The broadcast address can't be assigned            */
+        return (MODBUS_ERR_SLAVE_ADDR);
+    }
+    if (pmodel == (MODBUS_DATA_MODEL const *)0) {
+        pmodel = &MBS_DataModelDflt;
+    }
+
+    ix_free = MODBUS_CFG_DATA_MODEL_MAX;
+    for (ix = 0; ix < MODBUS_CFG_DATA_MODEL_MAX; ix++) {        /* Find the model or else a free entry                */
+        if (pch->DataModelTbl[ix] == pmodel) {
+            break;
+        }
+        if ((pch->DataModelTbl[ix] == (MODBUS_DATA_MODEL const *)0) &&
+            (ix_free               == MODBUS_CFG_DATA_MODEL_MAX)) {
+            ix_free = ix;
+        }
+    }
+    if (ix == MODBUS_CFG_DATA_MODEL_MAX) {                      /* Model not in use yet                               */
+        if (ix_free == MODBUS_CFG_DATA_MODEL_MAX) {
+            return (MODBUS_ERR_FULL);
+        }
+        ix                     = ix_free;
+        pch->DataModelTbl[ix]  = pmodel;
+    }
+    pch->NodeAddrTbl[node_addr] = ix + 1;
+    return (MODBUS_ERR_NONE);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          MB_NodeAddrRemove()
+*
+* Description : This function is called to stop a slave channel from answering a Modbus node address.
+*
+* Argument(s) : pch          is a pointer to the Modbus channel to change
+*
+*               node_addr    is the Modbus node address to remove.
+*
+* Return(s)   : MODBUS_ERR_NONE          the channel no longer answers 'node_addr'
+*               MODBUS_ERR_NULLPTR       'pch' is a NULL pointer
+*               MODBUS_ERR_SLAVE_ADDR    the channel did not answer 'node_addr'
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) The data model entry is released once no node address refers to it anymore, except for
+*                   the default data model which is always kept.
+*
+*               (2) This function must not be called while the channel is processing requests.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+CPU_INT16U  MB_NodeAddrRemove (MODBUS_CH   *pch,
+                               CPU_INT08U   node_addr)
+{
+    CPU_INT08U  model_ix;
+    CPU_INT16U  addr;
+
+
+    if (pch == (MODBUS_CH *)0) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+    model_ix = pch->NodeAddrTbl[node_addr];
+    if (model_ix == 0) {
+        return (MODBUS_ERR_SLAVE_ADDR);
+    }
+    pch->NodeAddrTbl[node_addr] = 0;
+
+    if (model_ix > 1) {                                         /* Release the model if no longer referenced          */
+        for (addr = 1; addr < 256; addr++) {
+            if (pch->NodeAddrTbl[addr] == model_ix) {
+                break;
+            }
+        }
+        if (addr == 256) {
+            pch->DataModelTbl[model_ix - 1] = (MODBUS_DATA_MODEL const *)0;
+        }
+    }
+    return (MODBUS_ERR_NONE);
+}
+#endif
+
 /*
 *********************************************************************************************************
 *                                             MB_WrEnSet()
@@ -546,9 +871,12 @@ void  MB_ASCII_RxByte (MODBUS_CH  *pch,
     if (rx_byte == MODBUS_ASCII_END_FRAME_CHAR2) {              /* See if we received a complete ASCII frame          */
         phex      = &pch->RxBuf[1];
         node_addr = MB_ASCII_HexToBin(phex);
-        if ((node_addr == pch->NodeAddr) ||                     /* Is the address for us?                             */
+        if ((MB_NodeAddrChk(pch, node_addr) == DEF_TRUE) ||     /* Is the address for us?                             */
             (node_addr == 0)) {                                 /* ... or a 'broadcast'?                              */
-            MB_OS_RxSignal(pch);                                /* Yes, Let task handle reply                         */
+#if (MODBUS_CFG_HIST_EN == DEF_ENABLED)
+            MB_HistRxEnd(pch);                                  /* Yes, Timestamp the end of the request              */
+#endif
+            MB_OS_RxSignal(pch);                                /* ... Let task handle reply                          */
         } else {
             pch->RxBufPtr     = &pch->RxBuf[0];                 /* No,  Wipe out anything, we have to re-synchronize. */
             pch->RxBufByteCtr = 0;
@@ -587,6 +915,12 @@ CPU_BOOLEAN  MB_ASCII_Rx (MODBUS_CH  *pch)
     pmsg      = &pch->RxBuf[0];
     rx_size   =  pch->RxBufByteCtr;
     prx_data  = &pch->RxFrameData[0];
+#if (MODBUS_CFG_TRACE_EN == DEF_ENABLED)
+    MB_TraceFrame(pch,                                                 /* Record the frame (see mb_trace.c)               */
+                  MODBUS_TRACE_RX,
+                  pmsg,
+                  rx_size);
+#endif
     if ((rx_size & 0x01)                                     &&        /* Message should have an ODD nbr of bytes.        */
         (rx_size            > MODBUS_ASCII_MIN_MSG_SIZE)     &&        /* Check if message is long enough                 */
         (pmsg[0]           == MODBUS_ASCII_START_FRAME_CHAR) &&        /* Check the first char.                           */
@@ -663,6 +997,15 @@ void  MB_ASCII_Tx (MODBUS_CH  *pch)
     tx_bytes         += 4;
     pch->TxFrameCRC   = (CPU_INT16U)lrc;                        /* Save the computed LRC into the channel                 */
     pch->TxBufByteCtr = tx_bytes;                               /* Update the total number of bytes to send               */
+#if (MODBUS_CFG_HIST_EN == DEF_ENABLED)
+    MB_HistTx(pch);                                             /* Timestamp the reply (see mb_hist.c)                    */
+#endif
+#if (MODBUS_CFG_TRACE_EN == DEF_ENABLED)
+    MB_TraceFrame(pch,                                          /* Record the frame (see mb_trace.c)                      */
+                  MODBUS_TRACE_TX,
+                  &pch->TxBuf[0],
+                  tx_bytes);
+#endif
     MB_Tx(pch);                                                 /* Send it out the communication driver.                  */
 }
 #endif
@@ -683,7 +1026,11 @@ void  MB_ASCII_Tx (MODBUS_CH  *pch)
 *
 * Caller(s)   : MB_RxByte().
 *
-* Note(s)     : none.
+* Note(s)     : (1) When the master knows the length of the reply it's waiting for (see MBM_TxCmd()), the
+*                   reply is handed over as soon as that many bytes are received with a valid CRC instead of
+*                   after the 3.5 character silence.  The length of a read response (FC01 to FC04) is taken
+*                   from its byte count and an exception response is always 5 bytes long.  Any other frame
+*                   still ends on the RTU timer.
 *********************************************************************************************************
 */
 
@@ -701,6 +1048,26 @@ void  MB_RTU_RxByte (MODBUS_CH  *pch,
         pch->RxCtr++;                                           /* Increment the number of bytes received                 */
         *pch->RxBufPtr++ = rx_byte;
         pch->RxBufByteCtr++;                                    /* Increment byte counter to see if we have Rx activity   */
+#if (MODBUS_CFG_MBM_RX_EARLY_EN == DEF_ENABLED)
+        if ((pch->MasterSlave  == MODBUS_MASTER) &&
+            (pch->RTU_RxLenExp >  0)) {                         /* See Note #1                                            */
+            pch->RTU_RxCRC = MB_RTU_CRC_Upd(pch->RTU_RxCRC, rx_byte);
+            if ((pch->RxBufByteCtr == 2) &&
+                ((rx_byte & 0x80)  != 0)) {
+                pch->RTU_RxLenExp = 5;                          /* Exception response                                     */
+            } else if ((pch->RxBufByteCtr == 3) &&
+                       (pch->RxBuf[1]     <= MODBUS_FC04_IN_REG_RD)) {
+                pch->RTU_RxLenExp = 5 + rx_byte;                /* Read response, length follows from the byte count      */
+            }
+            if (pch->RxBufByteCtr == pch->RTU_RxLenExp) {
+                pch->RTU_RxLenExp = 0;
+                if (pch->RTU_RxCRC == 0) {                      /* Complete frame, don't wait for the RTU timer           */
+                    pch->RTU_TimeoutEn = DEF_FALSE;
+                    MB_OS_RxSignal(pch);
+                }
+            }
+        }
+#endif
     }
 }
 #endif
@@ -735,6 +1102,12 @@ CPU_BOOLEAN  MB_RTU_Rx (MODBUS_CH  *pch)
 
     pmsg    = &pch->RxBuf[0];
     rx_size =  pch->RxBufByteCtr;
+#if (MODBUS_CFG_TRACE_EN == DEF_ENABLED)
+    MB_TraceFrame(pch,                                /* Record the frame (see mb_trace.c)                  */
+                  MODBUS_TRACE_RX,
+                  pmsg,
+                  rx_size);
+#endif
     if (rx_size >= MODBUS_RTU_MIN_MSG_SIZE) {         /* Is the message long enough?                        */
         if (rx_size <= MODBUS_CFG_BUF_SIZE) {
             prx_data    = &pch->RxFrameData[0];
@@ -785,6 +1158,41 @@ CPU_BOOLEAN  MB_RTU_Rx (MODBUS_CH  *pch)
 
 #if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
 void  MB_RTU_Tx (MODBUS_CH  *pch)
+{
+    MB_RTU_TxFrame(pch);
+#if (MODBUS_CFG_HIST_EN == DEF_ENABLED)
+    MB_HistTx(pch);                                                /* Timestamp the reply (see mb_hist.c)                      */
+#endif
+#if (MODBUS_CFG_TRACE_EN == DEF_ENABLED)
+    MB_TraceFrame(pch,                                             /* Record the frame (see mb_trace.c)                        */
+                  MODBUS_TRACE_TX,
+                  &pch->TxBuf[0],
+                  pch->TxBufByteCtr);
+#endif
+    MB_Tx(pch);                                                    /* Send it out the communication driver.                    */
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_RTU_TxFrame()
+*
+* Description : Forms the RTU frame, CRC included, of the MODBUS Frame in .TxBuf[].
+*
+* Argument(s) : pch      Is a pointer to the Modbus channel's data structure.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_RTU_Tx(),
+*               MB_TCP_Tx().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
+void  MB_RTU_TxFrame (MODBUS_CH  *pch)
 {
     CPU_INT08U  *ptx_data;
     CPU_INT08U  *pbuf;
@@ -808,8 +1216,6 @@ void  MB_RTU_Tx (MODBUS_CH  *pch)
     tx_bytes         += 2;
     pch->TxFrameCRC   = crc;                                       /* Save the calculated CRC in the channel                   */
     pch->TxBufByteCtr = tx_bytes;
-
-    MB_Tx(pch);                                                    /* Send it out the communication driver.                    */
 }
 #endif
 
@@ -907,6 +1313,9 @@ void  MB_RTU_TmrUpdate (void)
                         if (pch->MasterSlave == MODBUS_MASTER) {
                             pch->RTU_TimeoutEn = DEF_FALSE;
                         }
+#endif
+#if (MODBUS_CFG_HIST_EN == DEF_ENABLED)
+                        MB_HistRxEnd(pch);            /* Timestamp the end of the request (see mb_hist.c)  */
 #endif
                         MB_OS_RxSignal(pch);          /* RTU Timer expired for this Modbus channel         */
                     }
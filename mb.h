@@ -94,13 +94,28 @@
 *               (b) \<Modbus Protocol Suite>\Source\mb.h
 *                                                  \mb.c
 *                                                  \mb_def.c
+*                                                  \mb_gw.c
+*                                                  \mb_hist.c
+*                                                  \mb_img.c
+*                                                  \mb_tcp.c
+*                                                  \mb_trace.c
 *                                                  \mb_util.c
+*                                                  \mbm_bulk.c
+*                                                  \mbm_cache.c
 *                                                  \mbm_core.c
+*                                                  \mbm_req.c
+*                                                  \mbm_scan.c
+*                                                  \mbm_slave.c
 *                                                  \mbs_core.c
 *
 *               (c) \<Modbus Protocol Suite>\Ports\<cpu>\mb_bsp.*
+*                                                  \mb_bsp_posix.c
 *
 *               (d) \<Modbus Protocol Suite>\OS\<os>\mb_os.*
+*                                                  \mb_os_iii.c
+*                                                  \mb_os_rtthread.c
+*                                                  \mb_os_posix.c
+*                                                  \mb_cpu.h
 *
 *                       where
 *                               <Your Product Application>      directory path for Your Product's Application
@@ -136,8 +151,7 @@
 **********************************************************************************************************
 */
 
-#include  <cpu.h>
-#include  <lib_def.h>
+#include  "mb_cpu.h"
 
 #include  "mb_cfg.h"
 #include  "mb_def.h"
@@ -152,6 +166,133 @@
 *********************************************************************************************************
 */
 
+#if (MODBUS_CFG_IMG_EN == DEF_ENABLED)
+typedef  struct  modbus_img {                          /* Register image, see mb_img.c                                     */
+    volatile  CPU_INT32U   Seq;                        /* Sequence counter, odd while the image is being updated           */
+    CPU_INT16U             StartAddr;                  /* Number of the first register held by the image                   */
+    CPU_INT16U             NbrRegs;                    /* Number of registers held by the image                            */
+    volatile  CPU_INT16U  *RegTbl;                     /* Register values, provided by the application                     */
+} MODBUS_IMG;
+#endif
+
+
+#if (MODBUS_CFG_HIST_EN == DEF_ENABLED)
+typedef  struct  modbus_hist {                         /* Latency histogram, see mb_hist.c                                 */
+    CPU_INT32U       BucketTbl[MODBUS_HIST_BUCKET_NBR];  /* Nbr of samples per bucket (see mb_hist.c Note #2)              */
+    CPU_INT32U       Max;                              /* Longest sample (us)                                              */
+} MODBUS_HIST;
+#endif
+
+
+#if (MODBUS_CFG_TRACE_EN == DEF_ENABLED)
+typedef  struct  modbus_trace_rec {                    /* Frame recorded in a channel's trace ring, see mb_trace.c         */
+    volatile  CPU_INT32U   Seq;                        /* Record number + 1, the record number while written               */
+    CPU_INT32U             Ts;                         /* Time the frame was received or sent (us)                         */
+    CPU_INT16U             Len;                        /* Length of the frame, may exceed MODBUS_CFG_TRACE_CAPTURE         */
+    CPU_INT08U             Dir;                        /* MODBUS_TRACE_RX or MODBUS_TRACE_TX                               */
+    CPU_INT08U             Data[MODBUS_CFG_TRACE_CAPTURE]; /* First bytes of the frame                                     */
+} MODBUS_TRACE_REC;
+
+typedef  void  (*MODBUS_TRACE_OUT)(void              *parg,
+                                   CPU_INT08U const  *pbuf,
+                                   CPU_INT16U         len);
+#endif
+
+
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+typedef  struct  modbus_data_model {                   /* Application data accessed for a set of node addresses            */
+    CPU_BOOLEAN    (*CoilRd)        (CPU_INT16U   coil,
+                                     CPU_INT16U  *perr);
+    void           (*CoilWr)        (CPU_INT16U   coil,
+                                     CPU_BOOLEAN  coil_val,
+                                     CPU_INT16U  *perr);
+    CPU_BOOLEAN    (*DIRd)          (CPU_INT16U   di,
+                                     CPU_INT16U  *perr);
+    CPU_INT16U     (*InRegRd)       (CPU_INT16U   reg,
+                                     CPU_INT16U  *perr);
+    CPU_FP32       (*InRegRdFP)     (CPU_INT16U   reg,
+                                     CPU_INT16U  *perr);
+    CPU_INT16U     (*HoldingRegRd)  (CPU_INT16U   reg,
+                                     CPU_INT16U  *perr);
+    CPU_FP32       (*HoldingRegRdFP)(CPU_INT16U   reg,
+                                     CPU_INT16U  *perr);
+    void           (*HoldingRegWr)  (CPU_INT16U   reg,
+                                     CPU_INT16U   reg_val_16,
+                                     CPU_INT16U  *perr);
+    void           (*HoldingRegWrFP)(CPU_INT16U   reg,
+                                     CPU_FP32     reg_val_fp,
+                                     CPU_INT16U  *perr);
+    CPU_INT16U     (*FileRd)        (CPU_INT16U   file_nbr,
+                                     CPU_INT16U   record_nbr,
+                                     CPU_INT16U   ix,
+                                     CPU_INT08U   record_len,
+                                     CPU_INT16U  *perr);
+    void           (*FileWr)        (CPU_INT16U   file_nbr,
+                                     CPU_INT16U   record_nbr,
+                                     CPU_INT16U   ix,
+                                     CPU_INT08U   record_len,
+                                     CPU_INT16U   value,
+                                     CPU_INT16U  *perr);
+#if (MODBUS_CFG_WR_NOTIFY_EN == DEF_ENABLED)
+    void           (*WrNotify)      (CPU_INT08U   fc,   /* Optional, may be NULL                                      */
+                                     CPU_INT16U   start,
+                                     CPU_INT16U   nbr);
+#endif
+#if (MODBUS_CFG_IMG_EN == DEF_ENABLED)
+    MODBUS_IMG      *HoldingRegImgPtr;                 /* Holding register image, NULL if none                             */
+    MODBUS_IMG      *InRegImgPtr;                      /* Input   register image, NULL if none                             */
+#endif
+} MODBUS_DATA_MODEL;
+#endif
+
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+typedef  struct  modbus_mbm_req  MODBUS_MBM_REQ;
+
+typedef  void  (*MODBUS_MBM_REQ_CALLBACK)(MODBUS_MBM_REQ  *preq);
+
+struct  modbus_mbm_req {                               /* Master request descriptor, see mbm_req.c                         */
+    struct modbus_ch        *ChPtr;                    /* Channel the request was submitted to                             */
+    CPU_INT08U               SlaveAddr;                /* Node address of the slave                                        */
+    CPU_INT08U               FC;                       /* Function code                                                    */
+    CPU_INT08U               Prio;                     /* MODBUS_MBM_PRIO_xxx                                              */
+    CPU_INT16U               StartAddr;                /* First coil/DI/register (FC08: sub-function)                      */
+    CPU_INT16U               NbrPoints;                /* Number of coils/DIs/registers                                    */
+    CPU_INT16U               Val;                      /* FC05 coil value, FC06 register value or FC08 data                */
+    void                    *DataPtr;                  /* Data read or to write (see MBM_ReqExec())                        */
+    MODBUS_MBM_REQ_CALLBACK  Callback;                 /* Called on completion, NULL to use the completion queue           */
+    void                    *ArgPtr;                   /* Application argument, not used by uC/Modbus                      */
+    volatile  CPU_INT08U     State;                    /* MODBUS_MBM_REQ_STATE_xxx                                         */
+    CPU_INT16U               Err;                      /* Result, valid once .State is MODBUS_MBM_REQ_STATE_DONE(_Q)       */
+    MODBUS_MBM_REQ          *NextPtr;                  /* Link in the request or completion queue                          */
+#if (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)
+    CPU_INT16U               TID;                      /* MBAP transaction identifier while in flight                      */
+    CPU_INT32U               TxTs;                     /* Time the request was sent (ticks)                                */
+    CPU_INT32U               Timeout;                  /* Response timeout (ticks), 0 to wait forever                      */
+#endif
+};
+#endif
+
+
+#if (MODBUS_CFG_MBM_RTO_EN    == DEF_ENABLED) || \
+    (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+typedef  struct  modbus_mbm_slave {                    /* Slave tracked by a master channel, see mbm_slave.c               */
+    CPU_INT08U       SlaveAddr;                        /* Node address of the slave, 0 if the entry is free                */
+#if (MODBUS_CFG_MBM_RTO_EN == DEF_ENABLED)
+    CPU_INT32U       SRTT;                             /* Smoothed round-trip time x 8 (ticks), 0 until the first reply    */
+    CPU_INT32U       RTTVAR;                           /* Round-trip time variation x 4 (ticks)                            */
+    CPU_INT32U       RTO;                              /* Response timeout of the next request (ticks)                     */
+#endif
+#if (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+    CPU_INT08U       State;                            /* MODBUS_MBM_SLAVE_STATE_xxx                                       */
+    CPU_INT16U       FailCtr;                          /* Number of requests missed in a row                               */
+    CPU_INT32U       Backoff;                          /* Delay between probes while offline (ticks)                       */
+    CPU_INT32U       ProbeTime;                        /* Time of the next probe while offline (ticks)                     */
+#endif
+} MODBUS_MBM_SLAVE;
+#endif
+
+
 typedef  struct  modbus_ch {
     CPU_INT08U       Ch;                               /* Channel number                                                   */
     CPU_BOOLEAN      WrEn;                             /* Indicates whether MODBUS writes are enabled for the channel      */
@@ -159,13 +300,36 @@ typedef  struct  modbus_ch {
 
     CPU_INT08U       NodeAddr;                         /* Modbus node address of the channel                               */
 
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+    CPU_INT08U       NodeAddrTbl[256];                 /* Data model of each node address (ix + 1), 0 if not answered      */
+    MODBUS_DATA_MODEL const *DataModelTbl[MODBUS_CFG_DATA_MODEL_MAX];  /* Data models in use, [0] is MBS_DataModelDflt     */
+    MODBUS_DATA_MODEL const *DataModelPtr;             /* Data model of the node addressed by the current request          */
+#endif
+
+#if (MODBUS_CFG_IMG_EN == DEF_ENABLED)
+    MODBUS_IMG      *HoldingRegImgPtr;                 /* Holding register image of the default data model, NULL if none   */
+    MODBUS_IMG      *InRegImgPtr;                      /* Input   register image of the default data model, NULL if none   */
+#endif
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+    MODBUS_MBM_REQ  *MBM_ReqHeadPtr[MODBUS_MBM_PRIO_NBR];  /* Master requests waiting to be executed, one FIFO per priority */
+    MODBUS_MBM_REQ  *MBM_ReqTailPtr[MODBUS_MBM_PRIO_NBR];
+    CPU_INT16U       MBM_ReqCtr;                       /* Number of master requests queued, all priorities                 */
+#if (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)
+    MODBUS_MBM_REQ  *MBM_PipeHeadPtr;                  /* Requests in flight on a Modbus/TCP channel, oldest first         */
+    MODBUS_MBM_REQ  *MBM_PipeTailPtr;
+    CPU_INT08U       MBM_PipeCtr;                      /* Number of requests in flight                                     */
+    CPU_INT08U       MBM_PipeWin;                      /* Max. nbr of requests in flight, see MBM_ReqWinSet()              */
+#endif
+#endif
+
     CPU_INT08U       PortNbr;                          /* UART port number                                                 */
     CPU_INT32U       BaudRate;                         /* Baud Rate                                                        */
     CPU_INT08U       Parity;                           /* UART's parity settings (MODBUS_PARITY_NONE, _ODD or _EVEN)       */
     CPU_INT08U       Bits;                             /* UART's number of bits (7 or 8)                                   */
     CPU_INT08U       Stops;                            /* UART's number of stop bits (1 or 2)                              */
 
-    CPU_INT08U       Mode;                             /* Modbus mode: MODBUS_MODE_ASCII or MODBUS_MODE_RTU                */
+    CPU_INT08U       Mode;                             /* Modbus mode: MODBUS_MODE_ASCII, _RTU or _TCP                     */
 
     CPU_INT08U       MasterSlave;                      /* Slave when set to MODBUS_SLAVE, Master when set to MODBUS_MASTER */
 
@@ -175,6 +339,23 @@ typedef  struct  modbus_ch {
     CPU_INT16U       RTU_TimeoutCnts;                  /* Counts to reload in .RTU_TimeoutCtr when byte received           */
     CPU_INT16U       RTU_TimeoutCtr;                   /* Counts left before RTU timer times out for the channel           */
     CPU_BOOLEAN      RTU_TimeoutEn;                    /* Enable (when TRUE) or Disable (when FALSE) RTU timer             */
+#if (MODBUS_CFG_MBM_RX_EARLY_EN == DEF_ENABLED)
+    CPU_INT16U       RTU_RxLenExp;                     /* Length of the master's expected reply, 0 if unknown              */
+    CPU_INT16U       RTU_RxCRC;                        /* CRC-16 of the reply bytes received so far                        */
+#endif
+#endif
+
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+    CPU_INT08U       TCP_Mode;                         /* Framing: MODBUS_MODE_TCP, MODBUS_MODE_RTU_TCP or MODBUS_MODE_UDP */
+    CPU_INT32S       TCP_Sock;                         /* Connected socket of a master channel, -1 if none                 */
+    CPU_INT32S       TCP_ListenSock;                   /* Listening (or UDP) socket of a slave channel, -1 if none         */
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    struct modbus_tcp_conn  *TCP_ConnPtr;              /* Connection of the request being processed by a slave channel     */
+#endif
+    CPU_INT32U       TCP_Addr;                         /* IPv4 address of the peer (see mb_tcp.c Note #6), network order   */
+    CPU_INT16U       TCP_Port;                         /* Port of the peer, 0 if a master channel isn't connected          */
+    CPU_INT16U       TCP_TID;                          /* MBAP transaction identifier of the current transaction           */
+    CPU_INT08U       TCP_Unit;                         /* MBAP unit identifier of the current transaction                  */
 #endif
 
 #if (MODBUS_CFG_FC08_EN == DEF_ENABLED)
@@ -186,6 +367,32 @@ typedef  struct  modbus_ch {
 #endif
 
     CPU_INT32U       RxTimeout;                        /* Amount of time Master is willing to wait for response from slave */
+    CPU_INT32U       RxTimeoutCur;                     /* Timeout of the request in progress (see MB_OS_RxWait())          */
+#if (MODBUS_CFG_MBM_RETRY_EN == DEF_ENABLED)
+    CPU_INT08U       RetryNbr;                         /* Max. nbr of retries of a master request                          */
+    CPU_INT08U       RetryOpt;                         /* Conditions that trigger a retry, MODBUS_MBM_RETRY_xxx            */
+    CPU_INT32U       RetryDeadline;                    /* Time allowed for all the attempts of a request, 0 = none         */
+    CPU_INT32U       RetryCtr;                         /* Nbr of retries sent                                              */
+#endif
+#if (MODBUS_CFG_MBM_RTO_EN    == DEF_ENABLED) || \
+    (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+    MODBUS_MBM_SLAVE MBM_SlaveTbl[MODBUS_CFG_MBM_SLAVE_MAX];  /* Slaves addressed by the channel (see mbm_slave.c)      */
+#endif
+
+#if (MODBUS_CFG_HIST_EN == DEF_ENABLED)
+    CPU_INT32U       HistRxTs;                         /* End of reception of the request being processed (us)             */
+    CPU_INT32U       HistFcTs;                         /* Start of its processing (us)                                     */
+    CPU_INT08U       HistState;                        /* Progress of the request, see mb_hist.c                           */
+    CPU_INT08U       HistFcIx;                         /* Histogram of its function code in .HistTurnTbl[]                 */
+    MODBUS_HIST      HistWait;                         /* End of reception to start of processing                          */
+    MODBUS_HIST      HistProc;                         /* Start of processing to reply handed to MB_Tx()                   */
+    MODBUS_HIST      HistTurnTbl[MODBUS_HIST_FC_NBR];  /* End of reception to reply handed to MB_Tx(), per function code   */
+#endif
+
+#if (MODBUS_CFG_TRACE_EN == DEF_ENABLED)
+    volatile  CPU_INT32U  TraceCtr;                    /* Number of frames recorded                                        */
+    MODBUS_TRACE_REC TraceTbl[MODBUS_CFG_TRACE_NBR];   /* Last frames received and sent (see mb_trace.c)                   */
+#endif
 
     CPU_INT32U       RxCtr;                            /* Incremented every time a character is received                   */
     CPU_INT16U       RxBufByteCtr;                     /* Number of bytes received or to send                              */
@@ -256,6 +463,13 @@ MODBUS_CH    *MB_CfgCh                  (CPU_INT08U  node_addr,
 void          MB_MasterTimeoutSet       (MODBUS_CH  *pch,
                                          CPU_INT32U  timeout);
 
+#if (MODBUS_CFG_MBM_RETRY_EN == DEF_ENABLED)
+void          MB_MasterRetrySet         (MODBUS_CH  *pch,
+                                         CPU_INT08U  retry_nbr,
+                                         CPU_INT08U  retry_opt,
+                                         CPU_INT32U  deadline);
+#endif
+
 void          MB_ModeSet                (MODBUS_CH  *pch,
                                          CPU_INT08U  master_slave,
                                          CPU_INT08U  mode);
@@ -263,6 +477,18 @@ void          MB_ModeSet                (MODBUS_CH  *pch,
 void          MB_NodeAddrSet            (MODBUS_CH  *pch,
                                          CPU_INT08U  addr);
 
+CPU_BOOLEAN   MB_NodeAddrChk            (MODBUS_CH  *pch,
+                                         CPU_INT08U  addr);
+
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+CPU_INT16U    MB_NodeAddrAdd            (MODBUS_CH                *pch,
+                                         CPU_INT08U                addr,
+                                         MODBUS_DATA_MODEL const  *pmodel);
+
+CPU_INT16U    MB_NodeAddrRemove         (MODBUS_CH                *pch,
+                                         CPU_INT08U                addr);
+#endif
+
 void          MB_WrEnSet                (MODBUS_CH  *pch,
                                          CPU_INT08U  wr_en);
 
@@ -303,6 +529,75 @@ void         MB_ASCII_Tx                (MODBUS_CH   *pch);
 #if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
 CPU_BOOLEAN  MB_RTU_Rx                  (MODBUS_CH   *pch);
 void         MB_RTU_Tx                  (MODBUS_CH   *pch);
+void         MB_RTU_TxFrame             (MODBUS_CH   *pch);
+#endif
+
+/*
+*********************************************************************************************************
+*                                 MODBUS TCP INTERFACE FUNCTION PROTOTYPES
+*                                          (defined in mb_tcp.c)
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+void         MB_TCP_Init                (void);
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+CPU_INT16U   MB_TCP_Listen              (MODBUS_CH   *pch,
+                                         CPU_INT16U   port);
+
+void         MB_TCP_SrvPoll             (void);
+#endif
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+CPU_INT16U   MB_TCP_Connect             (MODBUS_CH   *pch,
+                                         CPU_CHAR    *ip_addr,
+                                         CPU_INT16U   port);
+
+void         MB_TCP_RxWait              (MODBUS_CH   *pch,
+                                         CPU_INT16U  *perr);
+
+CPU_INT16U   MB_TCP_RxNext              (MODBUS_CH   *pch,
+                                         CPU_INT32U   timeout,
+                                         CPU_INT16U  *perr);
+#endif
+
+void         MB_TCP_Close               (MODBUS_CH   *pch);
+
+void         MB_TCP_Exit                (void);
+
+CPU_BOOLEAN  MB_TCP_Rx                  (MODBUS_CH   *pch);
+
+void         MB_TCP_Tx                  (MODBUS_CH   *pch);
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+void         MB_TCP_ConnReply           (CPU_INT32U   conn_id,
+                                         CPU_INT08U  *pbuf,
+                                         CPU_INT16U   nbr_bytes);
+#endif
+#endif
+
+/*
+*********************************************************************************************************
+*                                   MODBUS GATEWAY FUNCTION PROTOTYPES
+*                                          (defined in mb_gw.c)
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+void         MB_GW_Init                 (void);
+
+CPU_INT16U   MB_GW_RouteAdd             (CPU_INT08U   unit_first,
+                                         CPU_INT08U   unit_last,
+                                         MODBUS_CH   *pch);
+
+void         MB_GW_RouteClr             (void);
+
+MODBUS_CH   *MB_GW_RouteGet             (CPU_INT08U   unit);
+
+CPU_INT08U   MB_GW_Rx                   (CPU_INT08U  *pframe,
+                                         CPU_INT16U   nbr_bytes,
+                                         CPU_INT32U   conn_id);
 #endif
 
 /*
@@ -321,6 +616,42 @@ void          MB_OS_RxSignal            (MODBUS_CH   *pch);
 void          MB_OS_RxWait              (MODBUS_CH   *pch,
                                          CPU_INT16U  *perr);
 
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+void          MB_OS_ChLock              (MODBUS_CH   *pch,
+                                         CPU_INT16U  *perr);
+
+void          MB_OS_ChUnlock            (MODBUS_CH   *pch);
+#endif
+
+CPU_INT32U    MB_OS_TimeGet             (void);
+
+CPU_INT32U    MB_OS_TickRateGet         (void);
+
+#if (MODBUS_CFG_HIST_EN  == DEF_ENABLED) || \
+    (MODBUS_CFG_TRACE_EN == DEF_ENABLED)
+CPU_INT32U    MB_OS_TS_Get              (void);
+#endif
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+void          MB_OS_RxTaskPrioSet       (MODBUS_CH   *pch,
+                                         CPU_INT08U   prio);
+#endif
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+void          MB_OS_TCP_Lock            (void);
+
+void          MB_OS_TCP_Unlock          (void);
+#endif
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+void          MB_OS_MBM_ReqSignal       (MODBUS_CH   *pch);
+
+void          MB_OS_MBM_DoneSignal      (void);
+
+void          MB_OS_MBM_DoneWait        (CPU_INT32U   timeout,
+                                         CPU_INT16U  *perr);
+#endif
+
 /*
 *********************************************************************************************************
 *                            COMMON MODBUS ASCII INTERFACE FUNCTION PROTOTYPES
@@ -353,6 +684,26 @@ CPU_INT16U   MB_RTU_CalcCRC             (MODBUS_CH  *pch);
 CPU_INT16U   MB_RTU_TxCalcCRC           (MODBUS_CH  *pch);
 
 CPU_INT16U   MB_RTU_RxCalcCRC           (MODBUS_CH  *pch);
+
+CPU_INT16U   MB_RTU_CRC_Upd             (CPU_INT16U  crc,
+                                         CPU_INT08U  data);
+#endif
+
+/*
+*********************************************************************************************************
+*                                  REGISTER DATA CONVERSION FUNCTIONS
+*                                       (defined in mb_util.c)
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+CPU_INT08U   MB_RegTypeSize             (CPU_INT08U   type);
+
+void         MB_RegDecode               (CPU_INT08U  *psrc,
+                                         void        *pdest,
+                                         CPU_INT16U   nbr_vals,
+                                         CPU_INT08U   type,
+                                         CPU_INT08U   order);
 #endif
 
 /*
@@ -367,7 +718,8 @@ CPU_BOOLEAN  MB_CoilRd                  (CPU_INT16U   coil,
                                          CPU_INT16U  *perr);
 #endif
 
-#if (MODBUS_CFG_FC05_EN == DEF_ENABLED)
+#if (MODBUS_CFG_FC05_EN == DEF_ENABLED) || \
+    (MODBUS_CFG_FC15_EN == DEF_ENABLED)
 void         MB_CoilWr                  (CPU_INT16U   coil,
                                          CPU_BOOLEAN  coil_val,
                                          CPU_INT16U  *perr);
@@ -422,6 +774,108 @@ void         MB_FileWr                  (CPU_INT16U   file_nbr,
                                          CPU_INT16U  *perr);
 #endif
 
+#if (MODBUS_CFG_WR_NOTIFY_EN == DEF_ENABLED)
+void         MB_WrNotify                (CPU_INT08U   fc,
+                                         CPU_INT16U   start,
+                                         CPU_INT16U   nbr);
+#endif
+
+/*
+*********************************************************************************************************
+*                                 REGISTER IMAGE FUNCTION PROTOTYPES
+*                                        (defined in mb_img.c)
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_IMG_EN == DEF_ENABLED)
+void         MB_ImgInit                 (MODBUS_IMG  *pimg,
+                                         CPU_INT16U   start_addr,
+                                         CPU_INT16U  *preg_tbl,
+                                         CPU_INT16U   nbr_regs);
+
+void         MB_ImgWrBegin              (MODBUS_IMG  *pimg);
+
+void         MB_ImgWrEnd                (MODBUS_IMG  *pimg);
+
+CPU_INT16U   MB_ImgRegWrN               (MODBUS_IMG  *pimg,
+                                         CPU_INT16U   reg,
+                                         CPU_INT16U  *pval_tbl,
+                                         CPU_INT16U   nbr_regs);
+
+CPU_INT16U   MB_ImgRd                   (MODBUS_IMG  *pimg,
+                                         CPU_INT16U   reg,
+                                         CPU_INT16U  *pval_tbl,
+                                         CPU_INT16U   nbr_regs);
+
+CPU_INT16U   MB_ImgRdFrame              (MODBUS_IMG  *pimg,
+                                         CPU_INT16U   reg,
+                                         CPU_INT08U  *pdest,
+                                         CPU_INT16U   nbr_regs);
+
+void         MB_HoldingRegImgSet        (MODBUS_CH   *pch,
+                                         MODBUS_IMG  *pimg);
+
+void         MB_InRegImgSet             (MODBUS_CH   *pch,
+                                         MODBUS_IMG  *pimg);
+#endif
+
+/*
+*********************************************************************************************************
+*                                SLAVE TURNAROUND HISTOGRAM FUNCTION PROTOTYPES
+*                                        (defined in mb_hist.c)
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_HIST_EN == DEF_ENABLED)
+CPU_INT16U   MB_HistGet                 (MODBUS_CH   *pch,
+                                         CPU_INT08U   hist,
+                                         CPU_INT08U   fc,
+                                         MODBUS_HIST *phist);
+
+void         MB_HistClr                 (MODBUS_CH   *pch);
+
+CPU_INT32U   MB_HistPctGet              (MODBUS_HIST *phist,
+                                         CPU_INT08U   pct);
+
+CPU_INT08U   MB_HistFcGet               (CPU_INT08U   fc_ix);
+
+void         MB_HistRxEnd               (MODBUS_CH   *pch);
+
+void         MB_HistFcStart             (MODBUS_CH   *pch);
+
+void         MB_HistTx                  (MODBUS_CH   *pch);
+
+#if (MODBUS_CFG_HIST_REG_EN == DEF_ENABLED)
+CPU_INT16U   MB_HistRdFrame             (MODBUS_CH   *pch,
+                                         CPU_INT16U   reg,
+                                         CPU_INT08U  *pdest,
+                                         CPU_INT16U   nbr_regs);
+#endif
+#endif
+
+/*
+*********************************************************************************************************
+*                                     FRAME TRACE FUNCTION PROTOTYPES
+*                                        (defined in mb_trace.c)
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_TRACE_EN == DEF_ENABLED)
+void         MB_TraceFrame              (MODBUS_CH         *pch,
+                                         CPU_INT08U         dir,
+                                         CPU_INT08U const  *pframe,
+                                         CPU_INT16U         len);
+
+CPU_INT16U   MB_TraceRd                 (MODBUS_CH         *pch,
+                                         CPU_INT32U        *pseq,
+                                         MODBUS_TRACE_REC  *prec);
+
+CPU_INT32U   MB_TraceDump               (MODBUS_CH         *pch,
+                                         CPU_INT08U         fmt,
+                                         MODBUS_TRACE_OUT   out,
+                                         void              *parg);
+#endif
+
 /*
 *********************************************************************************************************
 *                                        BSP FUNCTION PROTOTYPES
@@ -437,6 +891,18 @@ void         MB_CommPortCfg             (MODBUS_CH   *pch,
                                          CPU_INT08U   parity,
                                          CPU_INT08U   stops);
 
+#if (MB_OS_CFG_PORT == MB_OS_PORT_POSIX)
+CPU_INT16U   MB_CommPortPathSet         (CPU_INT08U   port_nbr,       /* Set the device of a serial port (see mb_bsp_posix.c)         */
+                                         CPU_CHAR    *path);
+
+CPU_INT16U   MB_CommPtyOpen             (CPU_INT08U   port_nbr,       /* Open a pseudo-terminal as a serial port                      */
+                                         CPU_CHAR    *pname,
+                                         CPU_INT16U   name_len);
+
+CPU_INT16U   MB_CommPortPaceSet         (CPU_INT08U   port_nbr,       /* Pace the frames sent at the baud rate                        */
+                                         CPU_BOOLEAN  en);
+#endif
+
 #if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
 void         MB_RTU_TmrInit             (void);                       /* Initialize the timer used for RTU framing                    */
 
@@ -460,6 +926,10 @@ void         MBS_RxTask                 (MODBUS_CH   *pch);
 #if (MODBUS_CFG_FC08_EN == DEF_ENABLED)
 void         MBS_StatInit               (MODBUS_CH   *pch);
 #endif
+
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+extern  MODBUS_DATA_MODEL  const  MBS_DataModelDflt;    /* Data model built from the mb_data.c functions                */
+#endif
 #endif
 
 /*
@@ -512,6 +982,26 @@ CPU_INT16U  MBM_FC04_InRegRd         (MODBUS_CH   *pch,
                                       CPU_INT16U   nbr_regs);
 #endif
 
+#if (MODBUS_CFG_FC03_EN == DEF_ENABLED)
+CPU_INT16U  MBM_FC03_HoldingRegRdT   (MODBUS_CH   *pch,
+                                      CPU_INT08U   slave_node,
+                                      CPU_INT16U   slave_addr,
+                                      void        *p_val_tbl,
+                                      CPU_INT16U   nbr_vals,
+                                      CPU_INT08U   type,
+                                      CPU_INT08U   order);
+#endif
+
+#if (MODBUS_CFG_FC04_EN == DEF_ENABLED)
+CPU_INT16U  MBM_FC04_InRegRdT        (MODBUS_CH   *pch,
+                                      CPU_INT08U   slave_node,
+                                      CPU_INT16U   slave_addr,
+                                      void        *p_val_tbl,
+                                      CPU_INT16U   nbr_vals,
+                                      CPU_INT08U   type,
+                                      CPU_INT08U   order);
+#endif
+
 #if (MODBUS_CFG_FC05_EN == DEF_ENABLED)
 CPU_INT16U  MBM_FC05_CoilWr          (MODBUS_CH   *pch,
                                       CPU_INT08U   slave_node,
@@ -567,6 +1057,180 @@ CPU_INT16U  MBM_FC16_HoldingRegWrNFP (MODBUS_CH   *pch,
                                       CPU_INT16U   nbr_regs);
 #endif
 
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+CPU_INT16U  MBM_PDU_Xfer             (MODBUS_CH   *pch,
+                                      CPU_INT08U   slave_node,
+                                      CPU_INT08U  *p_pdu,
+                                      CPU_INT16U  *p_pdu_len,
+                                      CPU_INT16U   pdu_size);
+#endif
+
+#if (MODBUS_CFG_MBM_BULK_EN == DEF_ENABLED) || \
+    (MODBUS_CFG_MBM_SCAN_EN == DEF_ENABLED)
+CPU_INT16U  MBM_NbrMax               (MODBUS_CH   *pch,
+                                      CPU_INT08U   fc);
+#endif
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)                        /* Asynchronous requests (defined in mbm_req.c)     */
+void             MBM_ReqInit         (MODBUS_MBM_REQ  *preq);
+
+CPU_INT16U       MBM_ReqSubmit       (MODBUS_CH       *pch,
+                                      MODBUS_MBM_REQ  *preq);
+
+MODBUS_MBM_REQ  *MBM_ReqDoneWait     (CPU_INT32U       timeout,
+                                      CPU_INT16U      *perr);
+
+CPU_INT16U       MBM_ReqExec         (MODBUS_CH       *pch,
+                                      MODBUS_MBM_REQ  *preq);
+
+void             MBM_ReqTask         (CPU_INT08U       task_ix);
+
+#if (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)
+CPU_INT16U       MBM_ReqWinSet       (MODBUS_CH       *pch,
+                                      CPU_INT08U       win);
+#endif
+#endif
+
+#if (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)                       /* Pipelined requests (defined in mbm_core.c)       */
+CPU_INT16U       MBM_ReqTx           (MODBUS_CH       *pch,
+                                      MODBUS_MBM_REQ  *preq);
+
+CPU_INT16U       MBM_ReqRx           (MODBUS_CH       *pch,
+                                      MODBUS_MBM_REQ  *preq,
+                                      CPU_INT16U       err);
+#endif
+
+#if (MODBUS_CFG_MBM_SCAN_EN == DEF_ENABLED)                       /* Cyclic poll scheduler (defined in mbm_scan.c)    */
+CPU_INT16U       MBM_ScanTagAdd      (MODBUS_CH       *pch,
+                                      CPU_INT08U       slave_addr,
+                                      CPU_INT08U       fc,
+                                      CPU_INT16U       addr,
+                                      CPU_INT32U       period,
+                                      CPU_INT16U      *perr);
+
+CPU_INT16U       MBM_ScanTagRd       (CPU_INT16U       tag,
+                                      CPU_INT16U      *pval,
+                                      CPU_INT32U      *pts);
+
+void             MBM_ScanClr         (void);
+
+CPU_INT16U       MBM_ScanBlkNbrGet   (void);
+
+CPU_INT32U       MBM_ScanExec        (void);
+#endif
+
+#if (MODBUS_CFG_MBM_BULK_EN == DEF_ENABLED)                       /* Bulk transfers (defined in mbm_bulk.c)           */
+#if (MODBUS_CFG_FC01_EN == DEF_ENABLED)
+CPU_INT16U       MBM_BulkCoilRd      (MODBUS_CH       *pch,
+                                      CPU_INT08U       slave_node,
+                                      CPU_INT16U       slave_addr,
+                                      CPU_INT08U      *p_coil_tbl,
+                                      CPU_INT16U       nbr_coils);
+#endif
+
+#if (MODBUS_CFG_FC02_EN == DEF_ENABLED)
+CPU_INT16U       MBM_BulkDIRd        (MODBUS_CH       *pch,
+                                      CPU_INT08U       slave_node,
+                                      CPU_INT16U       slave_addr,
+                                      CPU_INT08U      *p_di_tbl,
+                                      CPU_INT16U       nbr_di);
+#endif
+
+#if (MODBUS_CFG_FC03_EN == DEF_ENABLED)
+CPU_INT16U       MBM_BulkHoldingRegRd(MODBUS_CH       *pch,
+                                      CPU_INT08U       slave_node,
+                                      CPU_INT16U       slave_addr,
+                                      CPU_INT16U      *p_reg_tbl,
+                                      CPU_INT16U       nbr_regs);
+#endif
+
+#if (MODBUS_CFG_FC04_EN == DEF_ENABLED)
+CPU_INT16U       MBM_BulkInRegRd     (MODBUS_CH       *pch,
+                                      CPU_INT08U       slave_node,
+                                      CPU_INT16U       slave_addr,
+                                      CPU_INT16U      *p_reg_tbl,
+                                      CPU_INT16U       nbr_regs);
+#endif
+
+#if (MODBUS_CFG_FC15_EN == DEF_ENABLED)
+CPU_INT16U       MBM_BulkCoilWr      (MODBUS_CH       *pch,
+                                      CPU_INT08U       slave_node,
+                                      CPU_INT16U       slave_addr,
+                                      CPU_INT08U      *p_coil_tbl,
+                                      CPU_INT16U       nbr_coils);
+#endif
+
+#if (MODBUS_CFG_FC16_EN == DEF_ENABLED)
+CPU_INT16U       MBM_BulkHoldingRegWr(MODBUS_CH       *pch,
+                                      CPU_INT08U       slave_node,
+                                      CPU_INT16U       slave_addr,
+                                      CPU_INT16U      *p_reg_tbl,
+                                      CPU_INT16U       nbr_regs);
+#endif
+#endif
+
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)                      /* Value cache (defined in mbm_cache.c)             */
+void             MBM_CacheClr        (void);
+
+CPU_INT16U       MBM_CacheValGet     (MODBUS_CH       *pch,
+                                      CPU_INT08U       slave_addr,
+                                      CPU_INT08U       fc,
+                                      CPU_INT16U       addr,
+                                      CPU_INT16U      *pval,
+                                      CPU_INT32U      *pts,
+                                      CPU_INT08U      *pquality);
+
+CPU_INT16U       MBM_CacheRegRd      (MODBUS_CH       *pch,
+                                      CPU_INT08U       slave_node,
+                                      CPU_INT08U       fc,
+                                      CPU_INT16U       slave_addr,
+                                      CPU_INT16U      *p_reg_tbl,
+                                      CPU_INT16U       nbr_regs,
+                                      CPU_INT32U       age_max);
+
+CPU_INT16U       MBM_CacheBitRd      (MODBUS_CH       *pch,
+                                      CPU_INT08U       slave_node,
+                                      CPU_INT08U       fc,
+                                      CPU_INT16U       slave_addr,
+                                      CPU_INT08U      *p_bit_tbl,
+                                      CPU_INT16U       nbr_bits,
+                                      CPU_INT32U       age_max);
+
+void             MBM_CacheUpd        (MODBUS_CH       *pch,
+                                      CPU_INT08U       slave_addr,
+                                      CPU_INT08U       fc,
+                                      CPU_INT16U       addr,
+                                      CPU_INT16U       nbr,
+                                      CPU_INT08U      *p_bit_tbl,
+                                      CPU_INT16U      *p_reg_tbl,
+                                      CPU_INT16U       err);
+#endif
+
+#if (MODBUS_CFG_MBM_RTO_EN    == DEF_ENABLED) || \
+    (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)                     /* Per-slave tracking (defined in mbm_slave.c)      */
+void             MBM_SlaveInit       (MODBUS_CH       *pch);
+
+CPU_INT16U       MBM_SlaveTxStart    (MODBUS_CH       *pch,
+                                      CPU_INT08U       slave_addr);
+
+void             MBM_SlaveRxDone     (MODBUS_CH       *pch,
+                                      CPU_INT08U       slave_addr,
+                                      CPU_INT16U       err,
+                                      CPU_INT32U       rtt);
+#endif
+
+#if (MODBUS_CFG_MBM_RTO_EN == DEF_ENABLED)
+CPU_INT16U       MBM_SlaveRTT_Get    (MODBUS_CH       *pch,
+                                      CPU_INT08U       slave_addr,
+                                      CPU_INT32U      *psrtt,
+                                      CPU_INT32U      *prto);
+#endif
+
+#if (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+CPU_INT08U       MBM_SlaveStateGet   (MODBUS_CH       *pch,
+                                      CPU_INT08U       slave_addr);
+#endif
+
 #endif
 /*
 *********************************************************************************************************
@@ -610,6 +1274,153 @@ CPU_INT16U  MBM_FC16_HoldingRegWrNFP (MODBUS_CH   *pch,
 #error  "... Defines whether your product will support Modbus RTU.                                      "
 #endif
 
+#ifndef  MODBUS_CFG_MBM_RX_EARLY_EN
+#error  "MODBUS_CFG_MBM_RX_EARLY_EN              not #defined                                            "
+#error  "... Defines whether the RTU master completes a reply as soon as its expected length is received."
+#elif   (MODBUS_CFG_MBM_RX_EARLY_EN == DEF_ENABLED)
+#if     (MODBUS_CFG_MASTER_EN       != DEF_ENABLED) || \
+        (MODBUS_CFG_RTU_EN          != DEF_ENABLED)
+#error  "MODBUS_CFG_MBM_RX_EARLY_EN              requires MODBUS_CFG_MASTER_EN and MODBUS_CFG_RTU_EN     "
+#endif
+#endif
+
+#ifndef  MODBUS_CFG_TCP_EN
+#error  "MODBUS_CFG_TCP_EN                       not #defined                                            "
+#error  "... Defines whether your product will support Modbus/TCP.                                       "
+#endif
+
+#if     (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+        (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+#ifndef  MODBUS_CFG_TCP_CONN_MAX
+#error  "MODBUS_CFG_TCP_CONN_MAX                 not #defined                                            "
+#error  "... Defines the max. number of Modbus/TCP client connections.  Should be 1 to 255.              "
+#elif   (MODBUS_CFG_TCP_CONN_MAX <   1) || \
+        (MODBUS_CFG_TCP_CONN_MAX > 255)
+#error  "MODBUS_CFG_TCP_CONN_MAX                 illegally #defined                                      "
+#error  "... Should be 1 to 255.                                                                         "
+#endif
+#endif
+
+#ifndef  MODBUS_CFG_RTU_TCP_EN
+#error  "MODBUS_CFG_RTU_TCP_EN                   not #defined                                            "
+#error  "... Defines whether RTU frames are supported over TCP connections.                              "
+#elif   (MODBUS_CFG_RTU_TCP_EN  == DEF_ENABLED)
+#if     (MODBUS_CFG_TCP_EN      != DEF_ENABLED) || \
+        (MODBUS_CFG_RTU_EN      != DEF_ENABLED)
+#error  "MODBUS_CFG_RTU_TCP_EN                   requires MODBUS_CFG_TCP_EN and MODBUS_CFG_RTU_EN        "
+#endif
+#endif
+
+#ifndef  MODBUS_CFG_UDP_EN
+#error  "MODBUS_CFG_UDP_EN                       not #defined                                            "
+#error  "... Defines whether Modbus/TCP frames are supported over UDP.                                   "
+#elif   (MODBUS_CFG_UDP_EN      == DEF_ENABLED) && \
+        (MODBUS_CFG_TCP_EN      != DEF_ENABLED)
+#error  "MODBUS_CFG_UDP_EN                       requires MODBUS_CFG_TCP_EN                              "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_PIPE_EN
+#error  "MODBUS_CFG_MBM_PIPE_EN                  not #defined                                            "
+#error  "... Defines whether a Modbus/TCP master keeps several requests in flight.                        "
+#elif   (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)
+#if     (MODBUS_CFG_TCP_EN      != DEF_ENABLED) || \
+        (MODBUS_CFG_MBM_REQ_EN  != DEF_ENABLED)
+#error  "MODBUS_CFG_MBM_PIPE_EN                  requires MODBUS_CFG_TCP_EN and MODBUS_CFG_MBM_REQ_EN    "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_PIPE_WIN
+#error  "MODBUS_CFG_MBM_PIPE_WIN                 not #defined                                            "
+#error  "... Defines the max. number of requests in flight per channel.  Should be 2 to 255.             "
+#elif   (MODBUS_CFG_MBM_PIPE_WIN <   2) || \
+        (MODBUS_CFG_MBM_PIPE_WIN > 255)
+#error  "MODBUS_CFG_MBM_PIPE_WIN                 illegally #defined                                      "
+#error  "... Should be 2 to 255.                                                                         "
+#endif
+#endif
+
+#ifndef  MODBUS_CFG_MULTI_ADDR_EN
+#error  "MODBUS_CFG_MULTI_ADDR_EN                not #defined                                           "
+#error  "... Defines whether a slave channel can answer more than one node address.                     "
+#endif
+
+#if     (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+#if     (MODBUS_CFG_SLAVE_EN      != DEF_ENABLED)
+#error  "MODBUS_CFG_MULTI_ADDR_EN                requires MODBUS_CFG_SLAVE_EN                           "
+#endif
+
+#ifndef  MODBUS_CFG_DATA_MODEL_MAX
+#error  "MODBUS_CFG_DATA_MODEL_MAX               not #defined                                           "
+#error  "... Defines the number of data models per channel.  Should be 1 to 255.                        "
+#elif   (MODBUS_CFG_DATA_MODEL_MAX <   1) || \
+        (MODBUS_CFG_DATA_MODEL_MAX > 255)
+#error  "MODBUS_CFG_DATA_MODEL_MAX               illegally #defined                                     "
+#error  "... Should be 1 to 255.                                                                        "
+#endif
+#endif
+
+#ifndef  MODBUS_CFG_IMG_EN
+#error  "MODBUS_CFG_IMG_EN                       not #defined                                           "
+#error  "... Defines whether FC03/FC04 can be answered from register images.                            "
+#endif
+
+#if     (MODBUS_CFG_IMG_EN == DEF_ENABLED)
+#ifndef  MODBUS_CFG_IMG_RETRY_MAX
+#error  "MODBUS_CFG_IMG_RETRY_MAX                not #defined                                           "
+#error  "... Defines the number of snapshot attempts per request.  Should be 1 to N.                    "
+#elif   (MODBUS_CFG_IMG_RETRY_MAX < 1)
+#error  "MODBUS_CFG_IMG_RETRY_MAX                illegally #defined                                     "
+#error  "... Should be 1 to N.                                                                          "
+#endif
+#endif
+
+#ifndef  MODBUS_CFG_HIST_EN
+#error  "MODBUS_CFG_HIST_EN                      not #defined                                           "
+#error  "... Defines whether slave channels keep turnaround latency histograms.                         "
+#endif
+
+#if     (MODBUS_CFG_HIST_EN == DEF_ENABLED)
+#ifndef  MODBUS_CFG_HIST_REG_EN
+#error  "MODBUS_CFG_HIST_REG_EN                  not #defined                                           "
+#error  "... Defines whether the histograms can be read as input registers.                             "
+#elif   (MODBUS_CFG_HIST_REG_EN == DEF_ENABLED)
+#ifndef  MODBUS_CFG_HIST_REG_START
+#error  "MODBUS_CFG_HIST_REG_START               not #defined                                           "
+#error  "... Defines the first input register of the histograms.                                        "
+#elif   (MODBUS_CFG_HIST_REG_START > 65536 - MODBUS_HIST_REG_NBR)
+#error  "MODBUS_CFG_HIST_REG_START               illegally #defined                                     "
+#error  "... Should be 0 to 64948.                                                                      "
+#endif
+#if     (MODBUS_CFG_SLAVE_EN   != DEF_ENABLED) || \
+        (MODBUS_CFG_FC04_EN    != DEF_ENABLED)
+#error  "MODBUS_CFG_HIST_REG_EN                  requires MODBUS_CFG_SLAVE_EN and MODBUS_CFG_FC04_EN     "
+#endif
+#endif
+#endif
+
+#ifndef  MODBUS_CFG_TRACE_EN
+#error  "MODBUS_CFG_TRACE_EN                     not #defined                                           "
+#error  "... Defines whether channels keep a trace ring of the raw frames.                              "
+#endif
+
+#if     (MODBUS_CFG_TRACE_EN == DEF_ENABLED)
+#ifndef  MODBUS_CFG_TRACE_NBR
+#error  "MODBUS_CFG_TRACE_NBR                    not #defined                                           "
+#error  "... Defines the number of frames kept per channel.                                             "
+#elif   (MODBUS_CFG_TRACE_NBR < 2) || \
+        ((MODBUS_CFG_TRACE_NBR & (MODBUS_CFG_TRACE_NBR - 1)) != 0)
+#error  "MODBUS_CFG_TRACE_NBR                    illegally #defined                                     "
+#error  "... Should be a power of 2, at least 2.                                                        "
+#endif
+#ifndef  MODBUS_CFG_TRACE_CAPTURE
+#error  "MODBUS_CFG_TRACE_CAPTURE                not #defined                                           "
+#error  "... Defines the number of bytes kept per frame.                                                "
+#elif   (MODBUS_CFG_TRACE_CAPTURE < 1) || \
+        (MODBUS_CFG_TRACE_CAPTURE > MODBUS_CFG_BUF_SIZE)
+#error  "MODBUS_CFG_TRACE_CAPTURE                illegally #defined                                     "
+#error  "... Should be 1 to MODBUS_CFG_BUF_SIZE.                                                        "
+#endif
+#endif
+
 #ifndef  MODBUS_CFG_FP_EN
 #error  "MODBUS_CFG_FP_EN                        not #defined                                           "
 #error  "... Defines whether your product will support Daniels Flow Meter Floating-Point extensions.    "
@@ -664,6 +1475,236 @@ CPU_INT16U  MBM_FC16_HoldingRegWrNFP (MODBUS_CH   *pch,
 #error  "MODBUS_CFG_FC21_EN                      not #defined                                            "
 #endif
 
+#ifndef  MODBUS_CFG_WR_NOTIFY_EN
+#error  "MODBUS_CFG_WR_NOTIFY_EN                 not #defined                                            "
+#error  "... Defines whether MB_WrNotify() is called once per write request.                             "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_REQ_EN
+#error  "MODBUS_CFG_MBM_REQ_EN                   not #defined                                            "
+#error  "... Defines whether master requests can be submitted asynchronously.                            "
+#endif
+
+#if     (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+#if     (MODBUS_CFG_MASTER_EN  != DEF_ENABLED)
+#error  "MODBUS_CFG_MBM_REQ_EN                   requires MODBUS_CFG_MASTER_EN                           "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_Q_SIZE
+#error  "MODBUS_CFG_MBM_Q_SIZE                   not #defined                                            "
+#error  "... Defines the number of requests queued per master channel.  Should be 2 to 65535.            "
+#elif   (MODBUS_CFG_MBM_Q_SIZE <     2) || \
+        (MODBUS_CFG_MBM_Q_SIZE > 65535)
+#error  "MODBUS_CFG_MBM_Q_SIZE                   illegally #defined                                      "
+#error  "... Should be 2 to 65535.                                                                       "
+#endif
+#endif
+
+#ifndef  MODBUS_CFG_MBM_BULK_EN
+#error  "MODBUS_CFG_MBM_BULK_EN                  not #defined                                            "
+#error  "... Defines whether the master bulk read/write functions are included.                          "
+#elif   (MODBUS_CFG_MBM_BULK_EN == DEF_ENABLED)
+#if     (MODBUS_CFG_MASTER_EN   != DEF_ENABLED)
+#error  "MODBUS_CFG_MBM_BULK_EN                  requires MODBUS_CFG_MASTER_EN                           "
+#endif
+#endif
+
+#ifndef  MODBUS_CFG_GW_EN
+#error  "MODBUS_CFG_GW_EN                        not #defined                                            "
+#error  "... Defines whether the Modbus/TCP to serial gateway is included.                               "
+#elif   (MODBUS_CFG_GW_EN       == DEF_ENABLED)
+#if     (MODBUS_CFG_TCP_EN      != DEF_ENABLED) || \
+        (MODBUS_CFG_SLAVE_EN    != DEF_ENABLED) || \
+        (MODBUS_CFG_MASTER_EN   != DEF_ENABLED) || \
+        (MODBUS_CFG_MBM_REQ_EN  != DEF_ENABLED)
+#error  "MODBUS_CFG_GW_EN                        requires TCP_EN, SLAVE_EN, MASTER_EN and MBM_REQ_EN     "
+#endif
+
+#ifndef  MODBUS_CFG_GW_ROUTE_MAX
+#error  "MODBUS_CFG_GW_ROUTE_MAX                 not #defined                                            "
+#error  "... Defines the number of gateway routes.  Should be 1 to 255.                                  "
+#elif   (MODBUS_CFG_GW_ROUTE_MAX <   1) || \
+        (MODBUS_CFG_GW_ROUTE_MAX > 255)
+#error  "MODBUS_CFG_GW_ROUTE_MAX                 illegally #defined                                      "
+#error  "... Should be 1 to 255.                                                                         "
+#endif
+
+#ifndef  MODBUS_CFG_GW_Q_SIZE
+#error  "MODBUS_CFG_GW_Q_SIZE                    not #defined                                            "
+#error  "... Defines the number of requests held by the gateway.  Should be 1 to 255.                    "
+#elif   (MODBUS_CFG_GW_Q_SIZE <   1) || \
+        (MODBUS_CFG_GW_Q_SIZE > 255)
+#error  "MODBUS_CFG_GW_Q_SIZE                    illegally #defined                                      "
+#error  "... Should be 1 to 255.                                                                         "
+#endif
+
+#ifndef  MODBUS_CFG_GW_CLIENT_Q
+#error  "MODBUS_CFG_GW_CLIENT_Q                  not #defined                                            "
+#error  "... Defines the number of gateway requests per client.  Should be 1 to MODBUS_CFG_GW_Q_SIZE.    "
+#elif   (MODBUS_CFG_GW_CLIENT_Q <                    1) || \
+        (MODBUS_CFG_GW_CLIENT_Q > MODBUS_CFG_GW_Q_SIZE)
+#error  "MODBUS_CFG_GW_CLIENT_Q                  illegally #defined                                      "
+#error  "... Should be 1 to MODBUS_CFG_GW_Q_SIZE.                                                        "
+#endif
+#endif
+
+#ifndef  MODBUS_CFG_MBM_RETRY_EN
+#error  "MODBUS_CFG_MBM_RETRY_EN                 not #defined                                            "
+#error  "... Defines whether the master retries failed requests.                                         "
+#elif   (MODBUS_CFG_MBM_RETRY_EN == DEF_ENABLED)
+#if     (MODBUS_CFG_MASTER_EN    != DEF_ENABLED)
+#error  "MODBUS_CFG_MBM_RETRY_EN                 requires MODBUS_CFG_MASTER_EN                           "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_RETRY_NBR
+#error  "MODBUS_CFG_MBM_RETRY_NBR                not #defined                                            "
+#error  "... Defines the max. number of retries of a master request.  Should be 0 to 255.                "
+#elif   (MODBUS_CFG_MBM_RETRY_NBR <   0) || \
+        (MODBUS_CFG_MBM_RETRY_NBR > 255)
+#error  "MODBUS_CFG_MBM_RETRY_NBR                illegally #defined                                      "
+#error  "... Should be 0 to 255.                                                                         "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_RETRY_OPT
+#error  "MODBUS_CFG_MBM_RETRY_OPT                not #defined                                            "
+#error  "... Defines the conditions that trigger a retry, MODBUS_MBM_RETRY_xxx.                          "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_RETRY_DEADLINE
+#error  "MODBUS_CFG_MBM_RETRY_DEADLINE           not #defined                                            "
+#error  "... Defines the time allowed for all the attempts of a master request, 0 for no deadline.       "
+#endif
+#endif
+
+#ifndef  MODBUS_CFG_MBM_CACHE_EN
+#error  "MODBUS_CFG_MBM_CACHE_EN                 not #defined                                            "
+#error  "... Defines whether the master value cache is included.                                         "
+#elif   (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+#if     (MODBUS_CFG_MASTER_EN    != DEF_ENABLED)
+#error  "MODBUS_CFG_MBM_CACHE_EN                 requires MODBUS_CFG_MASTER_EN                           "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_CACHE_SIZE
+#error  "MODBUS_CFG_MBM_CACHE_SIZE               not #defined                                            "
+#error  "... Defines the number of points cached.  Should be 1 to 65535.                                 "
+#elif   (MODBUS_CFG_MBM_CACHE_SIZE <     1) || \
+        (MODBUS_CFG_MBM_CACHE_SIZE > 65535)
+#error  "MODBUS_CFG_MBM_CACHE_SIZE               illegally #defined                                      "
+#error  "... Should be 1 to 65535.                                                                       "
+#endif
+#endif
+
+#ifndef  MODBUS_CFG_MBM_SCAN_EN
+#error  "MODBUS_CFG_MBM_SCAN_EN                  not #defined                                            "
+#error  "... Defines whether the master cyclic poll scheduler is included.                               "
+#endif
+
+#if     (MODBUS_CFG_MBM_SCAN_EN == DEF_ENABLED)
+#if     (MODBUS_CFG_MASTER_EN   != DEF_ENABLED)
+#error  "MODBUS_CFG_MBM_SCAN_EN                  requires MODBUS_CFG_MASTER_EN                           "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_SCAN_TAG_MAX
+#error  "MODBUS_CFG_MBM_SCAN_TAG_MAX             not #defined                                            "
+#error  "... Defines the number of tags in the scan list.  Should be 1 to 65534.                         "
+#elif   (MODBUS_CFG_MBM_SCAN_TAG_MAX <     1) || \
+        (MODBUS_CFG_MBM_SCAN_TAG_MAX > 65534)
+#error  "MODBUS_CFG_MBM_SCAN_TAG_MAX             illegally #defined                                      "
+#error  "... Should be 1 to 65534.                                                                       "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_SCAN_BLK_MAX
+#error  "MODBUS_CFG_MBM_SCAN_BLK_MAX             not #defined                                            "
+#error  "... Defines the number of read requests the tags are merged into.  Should be 1 to 65534.        "
+#elif   (MODBUS_CFG_MBM_SCAN_BLK_MAX <     1) || \
+        (MODBUS_CFG_MBM_SCAN_BLK_MAX > 65534)
+#error  "MODBUS_CFG_MBM_SCAN_BLK_MAX             illegally #defined                                      "
+#error  "... Should be 1 to 65534.                                                                       "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_SCAN_GAP_REG
+#error  "MODBUS_CFG_MBM_SCAN_GAP_REG             not #defined                                            "
+#error  "... Defines the number of unused registers read to merge two tags.  Should be 0 to 124.         "
+#elif   (MODBUS_CFG_MBM_SCAN_GAP_REG < 0) || \
+        (MODBUS_CFG_MBM_SCAN_GAP_REG > 124)
+#error  "MODBUS_CFG_MBM_SCAN_GAP_REG             illegally #defined                                      "
+#error  "... Should be 0 to 124.                                                                         "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_SCAN_GAP_BIT
+#error  "MODBUS_CFG_MBM_SCAN_GAP_BIT             not #defined                                            "
+#error  "... Defines the number of unused coils/DIs read to merge two tags.  Should be 0 to 1999.        "
+#elif   (MODBUS_CFG_MBM_SCAN_GAP_BIT <    0) || \
+        (MODBUS_CFG_MBM_SCAN_GAP_BIT > 1999)
+#error  "MODBUS_CFG_MBM_SCAN_GAP_BIT             illegally #defined                                      "
+#error  "... Should be 0 to 1999.                                                                        "
+#endif
+#endif
+
+#ifndef  MODBUS_CFG_MBM_RTO_EN
+#error  "MODBUS_CFG_MBM_RTO_EN                   not #defined                                            "
+#error  "... Defines whether the master adapts its response timeout to each slave.                       "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_HEALTH_EN
+#error  "MODBUS_CFG_MBM_HEALTH_EN                not #defined                                            "
+#error  "... Defines whether the master detects dead slaves.                                             "
+#endif
+
+#if     (MODBUS_CFG_MBM_RTO_EN    == DEF_ENABLED) || \
+        (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+#if     (MODBUS_CFG_MASTER_EN     != DEF_ENABLED)
+#error  "MODBUS_CFG_MBM_RTO_EN/_HEALTH_EN        requires MODBUS_CFG_MASTER_EN                           "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_SLAVE_MAX
+#error  "MODBUS_CFG_MBM_SLAVE_MAX                not #defined                                            "
+#error  "... Defines the number of slaves tracked per master channel.  Should be 1 to 247.               "
+#elif   (MODBUS_CFG_MBM_SLAVE_MAX <   1) || \
+        (MODBUS_CFG_MBM_SLAVE_MAX > 247)
+#error  "MODBUS_CFG_MBM_SLAVE_MAX                illegally #defined                                      "
+#error  "... Should be 1 to 247.                                                                         "
+#endif
+#endif
+
+#if     (MODBUS_CFG_MBM_RTO_EN == DEF_ENABLED)
+
+#ifndef  MODBUS_CFG_MBM_RTO_MIN
+#error  "MODBUS_CFG_MBM_RTO_MIN                  not #defined                                            "
+#error  "... Defines the minimum response timeout, in ticks.  Should be at least 1.                      "
+#elif   (MODBUS_CFG_MBM_RTO_MIN < 1)
+#error  "MODBUS_CFG_MBM_RTO_MIN                  illegally #defined                                      "
+#error  "... Should be at least 1.                                                                       "
+#endif
+#endif
+
+#if     (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+#ifndef  MODBUS_CFG_MBM_OFFLINE_CNT
+#error  "MODBUS_CFG_MBM_OFFLINE_CNT              not #defined                                            "
+#error  "... Defines the number of missed requests to declare a slave offline.  Should be 1 to 65535.    "
+#elif   (MODBUS_CFG_MBM_OFFLINE_CNT <     1) || \
+        (MODBUS_CFG_MBM_OFFLINE_CNT > 65535)
+#error  "MODBUS_CFG_MBM_OFFLINE_CNT              illegally #defined                                      "
+#error  "... Should be 1 to 65535.                                                                       "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_BACKOFF_MIN
+#error  "MODBUS_CFG_MBM_BACKOFF_MIN              not #defined                                            "
+#error  "... Defines the delay before probing an offline slave, in ticks.  Should be at least 1.         "
+#elif   (MODBUS_CFG_MBM_BACKOFF_MIN < 1)
+#error  "MODBUS_CFG_MBM_BACKOFF_MIN              illegally #defined                                      "
+#error  "... Should be at least 1.                                                                       "
+#endif
+
+#ifndef  MODBUS_CFG_MBM_BACKOFF_MAX
+#error  "MODBUS_CFG_MBM_BACKOFF_MAX              not #defined                                            "
+#error  "... Defines the max. delay between probes, in ticks.  Should be >= MODBUS_CFG_MBM_BACKOFF_MIN.  "
+#elif   (MODBUS_CFG_MBM_BACKOFF_MAX < MODBUS_CFG_MBM_BACKOFF_MIN)
+#error  "MODBUS_CFG_MBM_BACKOFF_MAX              illegally #defined                                      "
+#error  "... Should be >= MODBUS_CFG_MBM_BACKOFF_MIN.                                                    "
+#endif
+#endif
+
 
 
 /*
@@ -44,7 +44,6 @@
 */
 
 #include "mb.h"
-#include <os.h>
 #include <rtdevice.h>
 #include <stdlib.h>
 
@@ -85,6 +84,12 @@ CPU_VOID  MB_CommExit (CPU_VOID)
             pch++;
             continue;
         }
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+        if(pch->Mode == MODBUS_MODE_TCP){ /* no UART behind a Modbus/TCP channel */
+            pch++;
+            continue;
+        }
+#endif
 
         rt_snprintf(uart_dev_name, RT_NAME_MAX, "uart%d", pch->PortNbr);
         uart_dev = rt_device_find(uart_dev_name);
@@ -112,9 +117,15 @@ static rt_err_t mb_rx_handler(rt_device_t dev, rt_size_t size)
 
     pch = &MB_ChTbl[0];
     for (ch = 0; ch < MODBUS_CFG_MAX_CH; ch++) {
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+        if((pch->PortNbr == id) && (pch->Mode != MODBUS_MODE_TCP)){
+            break;
+        }
+#else
         if(pch->PortNbr == id){
             break;
         }
+#endif
         pch++;
     }
 
@@ -0,0 +1,780 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                              uC/Modbus
+*
+*                                     MODBUS BOARD SUPPORT PACKAGE
+*                                     POSIX termios / pseudo-terminal
+*
+*
+* Filename : mb_bsp_posix.c
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) This BSP goes with mb_os_posix.c.  Serial port N is the device set by MB_CommPortPathSet(),
+*                "/dev/ttyS<N>" by default, or the master side of a pseudo-terminal opened by
+*                MB_CommPtyOpen().  A master channel and a slave channel can thus be connected on one host:
+*
+*                    MB_CommPtyOpen(0, name, sizeof(name));     port 0 is the pty master ...
+*                    MB_CommPortPathSet(1, name);               ... port 1 its slave device
+*
+*            (2) A thread per open port reads the bytes received and feeds them to MB_RxByte(), as the
+*                UART Rx interrupt would.  A thread ticking at MB_RTU_Freq stands in for the RTU timer
+*                interrupt.  Both run inside CPU_CRITICAL_ENTER()/CPU_CRITICAL_EXIT().
+*
+*            (3) A pseudo-terminal transfers a frame at once, whatever its baud rate.  MB_CommPortPaceSet()
+*                makes MB_Tx() hold each frame for the time it takes on a line at the baud rate of the
+*                channel, to measure the stack at realistic transfer rates.
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#ifndef  _GNU_SOURCE
+#define  _GNU_SOURCE                                     /* posix_openpt(), ptsname_r(), cfmakeraw()  */
+#endif
+
+#include "mb.h"
+
+#if (MB_OS_CFG_PORT == MB_OS_PORT_POSIX)
+
+#include  <pthread.h>
+#include  <termios.h>
+#include  <fcntl.h>
+#include  <unistd.h>
+#include  <poll.h>
+#include  <errno.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <time.h>
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  MB_BSP_PORT_MAX                            8    /* Nbr of serial ports, 0..MB_BSP_PORT_MAX-1 */
+#define  MB_BSP_PATH_LEN                           64    /* Max. length of a device path              */
+#define  MB_BSP_RX_POLL_MS                        100    /* Period at which an Rx thread checks Run   */
+#define  MB_BSP_RX_BUF_SIZE                        64    /* Bytes read at once by an Rx thread        */
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+typedef  struct  mb_bsp_port {
+    CPU_BOOLEAN           Open;                          /* Device is open                            */
+    CPU_BOOLEAN           Pty;                           /* Device is the master side of a pty        */
+    CPU_BOOLEAN           Pace;                          /* Tx paced at the baud rate (see Note #3)   */
+    int                   Fd;
+    CPU_CHAR              Path[MB_BSP_PATH_LEN];         /* Device, empty for "/dev/ttyS<N>"          */
+    MODBUS_CH            *ChPtr;                         /* Channel the bytes received are fed to     */
+    pthread_t             RxThread;
+    volatile  CPU_BOOLEAN RxRun;                         /* Rx thread is running                      */
+} MB_BSP_PORT;
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+static  MB_BSP_PORT           MB_BSP_PortTbl[MB_BSP_PORT_MAX];
+
+#if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
+static  pthread_t             MB_BSP_TmrThread;
+static  volatile  CPU_BOOLEAN MB_BSP_TmrRun;
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  void     MB_BSP_PortClose(MB_BSP_PORT  *pport);
+
+static  speed_t  MB_BSP_BaudGet  (CPU_INT32U    baud);
+
+static  void     MB_BSP_TxPace   (MODBUS_CH    *pch,
+                                  CPU_INT16U    nbr_bytes);
+
+static  void    *MB_BSP_RxTask   (void         *p_arg);
+
+#if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
+static  void    *MB_BSP_TmrTask  (void         *p_arg);
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        MB_CommPortPathSet()
+*
+* Description : This function sets the device opened as a serial port by MB_CommPortCfg().
+*
+* Argument(s) : port_nbr   is the serial port number.
+*
+*               path       is the path of the device, e.g. "/dev/ttyUSB0".  NULL restores the default,
+*                          "/dev/ttyS<port_nbr>".
+*
+* Return(s)   : MODBUS_ERR_NONE      the path is set,
+*               MODBUS_ERR_RANGE     'port_nbr' is out of range or 'path' is too long.
+*               MODBUS_ERR_BUSY      the port is open.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) The path is used by the next MB_CfgCh() on the port.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MB_CommPortPathSet (CPU_INT08U   port_nbr,
+                                CPU_CHAR    *path)
+{
+    MB_BSP_PORT  *pport;
+
+
+    if (port_nbr >= MB_BSP_PORT_MAX) {
+        return (MODBUS_ERR_RANGE);
+    }
+    pport = &MB_BSP_PortTbl[port_nbr];
+    if (pport->Open == DEF_TRUE) {
+        return (MODBUS_ERR_BUSY);
+    }
+    if (path == (CPU_CHAR *)0) {
+        pport->Path[0] = '\0';
+        return (MODBUS_ERR_NONE);
+    }
+    if (strlen(path) >= MB_BSP_PATH_LEN) {
+        return (MODBUS_ERR_RANGE);
+    }
+    strcpy(pport->Path, path);
+    return (MODBUS_ERR_NONE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_CommPtyOpen()
+*
+* Description : This function opens a pseudo-terminal and makes its master side the serial port 'port_nbr'.
+*
+* Argument(s) : port_nbr   is the serial port number.
+*
+*               pname      is a pointer to a buffer that will receive the path of the slave side, e.g.
+*                          "/dev/pts/3", to be opened by the peer.
+*
+*               name_len   is the size of the buffer.
+*
+* Return(s)   : MODBUS_ERR_NONE      the pseudo-terminal is open,
+*               MODBUS_ERR_RANGE     'port_nbr' is out of range or the buffer too small.
+*               MODBUS_ERR_BUSY      the port is open.
+*               MODBUS_ERR_FILE      the pseudo-terminal couldn't be opened.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) The port is configured, and its Rx thread started, by the next MB_CfgCh() on the port.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MB_CommPtyOpen (CPU_INT08U   port_nbr,
+                            CPU_CHAR    *pname,
+                            CPU_INT16U   name_len)
+{
+    MB_BSP_PORT  *pport;
+    int           fd;
+
+
+    if (port_nbr >= MB_BSP_PORT_MAX) {
+        return (MODBUS_ERR_RANGE);
+    }
+    pport = &MB_BSP_PortTbl[port_nbr];
+    if (pport->Open == DEF_TRUE) {
+        return (MODBUS_ERR_BUSY);
+    }
+
+    fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        return (MODBUS_ERR_FILE);
+    }
+    if ((grantpt(fd)  != 0) ||
+        (unlockpt(fd) != 0)) {
+        (void)close(fd);
+        return (MODBUS_ERR_FILE);
+    }
+    if (ptsname_r(fd, pname, name_len) != 0) {
+        (void)close(fd);
+        return (MODBUS_ERR_RANGE);
+    }
+
+    pport->Open  = DEF_TRUE;
+    pport->Pty   = DEF_TRUE;
+    pport->Fd    = fd;
+    pport->ChPtr = (MODBUS_CH *)0;
+    return (MODBUS_ERR_NONE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                        MB_CommPortPaceSet()
+*
+* Description : This function enables or disables the pacing of the frames sent on a serial port at its baud
+*               rate (see Note #3).
+*
+* Argument(s) : port_nbr   is the serial port number.
+*
+*               en         DEF_ENABLED to pace the frames sent, DEF_DISABLED to send them at once.
+*
+* Return(s)   : MODBUS_ERR_NONE      the pacing is set,
+*               MODBUS_ERR_RANGE     'port_nbr' is out of range.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MB_CommPortPaceSet (CPU_INT08U   port_nbr,
+                                CPU_BOOLEAN  en)
+{
+    if (port_nbr >= MB_BSP_PORT_MAX) {
+        return (MODBUS_ERR_RANGE);
+    }
+    MB_BSP_PortTbl[port_nbr].Pace = (en == DEF_ENABLED) ? DEF_TRUE : DEF_FALSE;
+    return (MODBUS_ERR_NONE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                             MB_CommExit()
+*
+* Description : This function is called to terminate Modbus communications.  All serial ports are closed.
+*
+* Argument(s) : none
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_Exit()
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_CommExit (void)
+{
+    CPU_INT08U  i;
+
+
+    for (i = 0; i < MB_BSP_PORT_MAX; i++) {
+        MB_BSP_PortClose(&MB_BSP_PortTbl[i]);
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_CommPortCfg()
+*
+* Description : This function opens a serial port and configures it with the desired baud rate, number of
+*               bits, parity and number of stop bits.
+*
+* Argument(s) : pch        is a pointer to the Modbus channel
+*               port_nbr   is the desired serial port number.  This argument allows you to assign a
+*                          specific serial port to a sepcific Modbus channel.
+*               baud       is the desired baud rate for the serial port.
+*               parity     is the desired parity and can be either:
+*
+*                          MODBUS_PARITY_NONE
+*                          MODBUS_PARITY_ODD
+*                          MODBUS_PARITY_EVEN
+*
+*               bits       specifies the number of bit and can be either 7 or 8.
+*               stops      specifies the number of stop bits and can either be 1 or 2
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_CfgCh()
+*
+* Note(s)     : (1) The device is left closed when it can't be opened, as the RT-Thread BSP leaves a UART it
+*                   can't find.  The channel then never receives.
+*
+*               (2) The settings of the master side of a pseudo-terminal apply to the pair, the baud rate has
+*                   no effect on the transfer rate.
+*********************************************************************************************************
+*/
+
+void  MB_CommPortCfg (MODBUS_CH  *pch,
+                      CPU_INT08U  port_nbr,
+                      CPU_INT32U  baud,
+                      CPU_INT08U  bits,
+                      CPU_INT08U  parity,
+                      CPU_INT08U  stops)
+{
+    MB_BSP_PORT     *pport;
+    CPU_CHAR         path[MB_BSP_PATH_LEN];
+    struct termios   tio;
+
+
+    if (pch == (MODBUS_CH *)0) {
+        return;
+    }
+    pch->PortNbr  = port_nbr;                            /* Store configuration in channel            */
+    pch->BaudRate = baud;
+    pch->Parity   = parity;
+    pch->Bits     = bits;
+    pch->Stops    = stops;
+
+    if (port_nbr >= MB_BSP_PORT_MAX) {
+        return;
+    }
+    pport = &MB_BSP_PortTbl[port_nbr];
+    if (pport->RxRun == DEF_TRUE) {                      /* Reconfigured: stop the Rx thread first    */
+        pport->RxRun = DEF_FALSE;
+        (void)pthread_join(pport->RxThread, (void **)0);
+    }
+
+    if (pport->Open == DEF_FALSE) {
+        if (pport->Path[0] == '\0') {
+            (void)snprintf(path, sizeof(path), "/dev/ttyS%u", (unsigned)port_nbr);
+        } else {
+            (void)strcpy(path, pport->Path);
+        }
+        pport->Fd = open(path, O_RDWR | O_NOCTTY);
+        if (pport->Fd < 0) {                             /* See Note #1                               */
+            return;
+        }
+        pport->Open = DEF_TRUE;
+        pport->Pty  = DEF_FALSE;
+    }
+
+    if (tcgetattr(pport->Fd, &tio) == 0) {               /* See Note #2                               */
+        cfmakeraw(&tio);
+        (void)cfsetispeed(&tio, MB_BSP_BaudGet(baud));
+        (void)cfsetospeed(&tio, MB_BSP_BaudGet(baud));
+
+        tio.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB);
+        tio.c_cflag |=  (bits  == 7) ? CS7 : CS8;
+        tio.c_cflag |=  (stops == 2) ? CSTOPB : 0;
+        switch (parity) {
+            case MODBUS_PARITY_ODD:
+                 tio.c_cflag |= PARENB | PARODD;
+                 break;
+
+            case MODBUS_PARITY_EVEN:
+                 tio.c_cflag |= PARENB;
+                 break;
+
+            case MODBUS_PARITY_NONE:
+            default:
+                 break;
+        }
+        tio.c_cflag     |= CLOCAL | CREAD;
+        tio.c_cc[VMIN]   = 1;
+        tio.c_cc[VTIME]  = 0;
+        (void)tcsetattr(pport->Fd, TCSANOW, &tio);
+    }
+    (void)tcflush(pport->Fd, TCIOFLUSH);
+
+    pport->ChPtr = pch;
+    pport->RxRun = DEF_TRUE;
+    if (pthread_create(&pport->RxThread, (pthread_attr_t *)0, MB_BSP_RxTask, (void *)pport) != 0) {
+        pport->RxRun = DEF_FALSE;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                                MB_Tx()
+*
+* Description : This function is called to start transmitting a packet to a modbus channel.
+*
+* Argument(s) : pch      Is a pointer to the Modbus channel's data structure.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_ASCII_Tx(),
+*               MB_RTU_Tx().
+*
+* Note(s)     : (1) The packet is written at once, the write returns when the driver has taken it.  A paced
+*                   port first holds it for its transfer time (see Note #3 at the top of the file).
+*********************************************************************************************************
+*/
+
+void  MB_Tx (MODBUS_CH  *pch)
+{
+    MB_BSP_PORT  *pport;
+    CPU_INT08U   *pbuf;
+    CPU_INT16U    nbr;
+    ssize_t       rtn;
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+    CPU_SR_ALLOC();
+#endif
+
+
+    pch->TxBufPtr = &pch->TxBuf[0];
+    if (pch->TxBufByteCtr > 0) {
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+        if (pch->MasterSlave == MODBUS_MASTER) {
+            CPU_CRITICAL_ENTER();
+#if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
+            pch->RTU_TimeoutEn = MODBUS_FALSE;           /* Disable RTU timeout timer until we start receiving */
+#endif
+            pch->RxBufByteCtr  = 0;                      /* Flush Rx buffer                           */
+            CPU_CRITICAL_EXIT();
+        }
+#endif
+        if (pch->PortNbr >= MB_BSP_PORT_MAX) {
+            return;
+        }
+        pport = &MB_BSP_PortTbl[pch->PortNbr];
+        if (pport->Open == DEF_FALSE) {
+            return;
+        }
+
+        pbuf = pch->TxBufPtr;                            /* See Note #1                               */
+        nbr  = pch->TxBufByteCtr;
+        if (pport->Pace == DEF_TRUE) {
+            MB_BSP_TxPace(pch, nbr);
+        }
+        while (nbr > 0) {
+            rtn = write(pport->Fd, pbuf, nbr);
+            if (rtn < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            pbuf += rtn;
+            nbr  -= (CPU_INT16U)rtn;
+        }
+
+        pch->TxCtr        = pch->TxBufByteCtr;           /* End of transmission                       */
+        pch->TxBufByteCtr = 0;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_RTU_TmrInit()
+*
+* Description : This function is called to initialize the RTU timeout timer.  A thread calls
+*               MB_RTU_TmrISR_Handler() MB_RTU_Freq times per second.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_Init().
+*
+* Note(s)     : (1) The timer isn't started when MB_Init() is given a frequency of 0.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
+void  MB_RTU_TmrInit (void)
+{
+    if (MB_RTU_Freq == 0) {                              /* See Note #1                               */
+        return;
+    }
+    MB_BSP_TmrRun = DEF_TRUE;
+    if (pthread_create(&MB_BSP_TmrThread, (pthread_attr_t *)0, MB_BSP_TmrTask, (void *)0) != 0) {
+        MB_BSP_TmrRun = DEF_FALSE;
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_RTU_TmrExit()
+*
+* Description : This function is called to disable the RTU timeout timer.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_Exit()
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
+void  MB_RTU_TmrExit (void)
+{
+    if (MB_BSP_TmrRun == DEF_TRUE) {
+        MB_BSP_TmrRun = DEF_FALSE;
+        (void)pthread_join(MB_BSP_TmrThread, (void **)0);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       MB_RTU_TmrISR_Handler()
+*
+* Description : This function handles the case when the RTU timeout timer expires.
+*
+* Arguments   : none.
+*
+* Returns     : none.
+*
+* Caller(s)   : MB_BSP_TmrTask().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
+void  MB_RTU_TmrISR_Handler (void)
+{
+    CPU_SR_ALLOC();
+
+
+    MB_RTU_TmrCtr++;                                     /* Indicate that we had activities on this interrupt. */
+    CPU_CRITICAL_ENTER();
+    MB_RTU_TmrUpdate();                                  /* Check for RTU timers that have expired    */
+    CPU_CRITICAL_EXIT();
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          MB_BSP_PortClose()
+*
+* Description : This function stops the Rx thread of a serial port and closes its device.
+*
+* Argument(s) : pport      is a pointer to the serial port.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_CommExit().
+*
+* Note(s)     : (1) The path set by MB_CommPortPathSet() is kept, the pacing is disabled.
+*********************************************************************************************************
+*/
+
+static  void  MB_BSP_PortClose (MB_BSP_PORT  *pport)
+{
+    if (pport->RxRun == DEF_TRUE) {
+        pport->RxRun = DEF_FALSE;
+        (void)pthread_join(pport->RxThread, (void **)0);
+    }
+    if (pport->Open == DEF_TRUE) {
+        (void)close(pport->Fd);
+        pport->Open = DEF_FALSE;
+        pport->Pty  = DEF_FALSE;
+    }
+    pport->Pace  = DEF_FALSE;
+    pport->ChPtr = (MODBUS_CH *)0;                       /* See Note #1                               */
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_BSP_BaudGet()
+*
+* Description : This function converts a baud rate to its termios speed.
+*
+* Argument(s) : baud       is the baud rate.
+*
+* Return(s)   : The termios speed, B115200 for a rate that isn't supported (as the RT-Thread BSP).
+*
+* Caller(s)   : MB_CommPortCfg().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  speed_t  MB_BSP_BaudGet (CPU_INT32U  baud)
+{
+    switch (baud) {
+        case 1200:    return (B1200);
+        case 2400:    return (B2400);
+        case 4800:    return (B4800);
+        case 9600:    return (B9600);
+        case 19200:   return (B19200);
+        case 38400:   return (B38400);
+        case 57600:   return (B57600);
+        case 230400:  return (B230400);
+        case 460800:  return (B460800);
+        case 921600:  return (B921600);
+        case 115200:
+        default:      return (B115200);
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_BSP_TxPace()
+*
+* Description : This function waits for the time a frame takes on a line at the baud rate of its channel.
+*
+* Argument(s) : pch        is a pointer to the Modbus channel.
+*
+*               nbr_bytes  is the length of the frame.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_Tx().
+*
+* Note(s)     : (1) A character is a start bit, the data bits, the parity bit if any and the stop bits.
+*********************************************************************************************************
+*/
+
+static  void  MB_BSP_TxPace (MODBUS_CH   *pch,
+                             CPU_INT16U   nbr_bytes)
+{
+    struct timespec  ts;
+    CPU_INT64U       bits;
+    CPU_INT64U       ns;
+
+
+    if (pch->BaudRate == 0) {
+        return;
+    }
+    bits = 1u + pch->Bits + pch->Stops;                  /* See Note #1                               */
+    if (pch->Parity != MODBUS_PARITY_NONE) {
+        bits++;
+    }
+    ns         = (bits * nbr_bytes * 1000000000u) / pch->BaudRate;
+    ts.tv_sec  = (time_t)(ns / 1000000000u);
+    ts.tv_nsec = (long)(ns % 1000000000u);
+    while (nanosleep(&ts, &ts) != 0) {
+        if (errno != EINTR) {
+            break;
+        }
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_BSP_RxTask()
+*
+* Description : This thread is created by MB_CommPortCfg() and feeds the bytes received on a serial port to
+*               its channel, as the UART Rx interrupt would.
+*
+* Argument(s) : p_arg      is a pointer to the serial port.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : This is a Task.
+*
+* Note(s)     : (1) The master side of a pseudo-terminal reads EIO while the slave side isn't open.
+*********************************************************************************************************
+*/
+
+static  void  *MB_BSP_RxTask (void *p_arg)
+{
+    MB_BSP_PORT      *pport;
+    struct pollfd     pfd;
+    struct timespec   ts;
+    CPU_INT08U        buf[MB_BSP_RX_BUF_SIZE];
+    ssize_t           nbr;
+    ssize_t           i;
+    CPU_SR_ALLOC();
+
+
+    pport      = (MB_BSP_PORT *)p_arg;
+    pfd.fd     = pport->Fd;
+    pfd.events = POLLIN;
+
+    while (pport->RxRun == DEF_TRUE) {
+        if (poll(&pfd, 1, MB_BSP_RX_POLL_MS) <= 0) {
+            continue;
+        }
+        nbr = read(pport->Fd, buf, sizeof(buf));
+        if (nbr <= 0) {                                  /* See Note #1                               */
+            ts.tv_sec  = 0;
+            ts.tv_nsec = MB_BSP_RX_POLL_MS * 1000000L;
+            (void)nanosleep(&ts, (struct timespec *)0);
+            continue;
+        }
+        CPU_CRITICAL_ENTER();
+        for (i = 0; i < nbr; i++) {
+            MB_RxByte(pport->ChPtr, buf[i]);
+        }
+        CPU_CRITICAL_EXIT();
+    }
+    return ((void *)0);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_BSP_TmrTask()
+*
+* Description : This thread is created by MB_RTU_TmrInit() and calls MB_RTU_TmrISR_Handler() at
+*               MB_RTU_Freq.
+*
+* Argument(s) : p_arg      is not used.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : This is a Task.
+*
+* Note(s)     : (1) The ticks are on absolute deadlines, so that they don't drift with the time spent in the
+*                   handler.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
+static  void  *MB_BSP_TmrTask (void *p_arg)
+{
+    struct timespec  ts;
+    long             period_ns;
+
+
+    (void)p_arg;
+    period_ns = 1000000000L / (long)MB_RTU_Freq;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    while (MB_BSP_TmrRun == DEF_TRUE) {
+        ts.tv_nsec += period_ns;                         /* See Note #1                               */
+        while (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        (void)clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, (struct timespec *)0);
+        MB_RTU_TmrISR_Handler();
+    }
+    return ((void *)0);
+}
+#endif
+
+#endif                                                   /* End of POSIX port                         */
@@ -46,6 +46,48 @@
 #define  MB_OS_CFG_RX_TASK_STK_SIZE       512
 #endif
 
+#ifdef PKG_USING_UC_MODBUS_RX_TASK_NBR                          /* Nbr of slave Rx tasks, channel N served by ...     */
+#define  MB_OS_CFG_RX_TASK_NBR            PKG_USING_UC_MODBUS_RX_TASK_NBR
+#else                                                           /* ... task (N % MB_OS_CFG_RX_TASK_NBR)               */
+#define  MB_OS_CFG_RX_TASK_NBR            1
+#endif
+
+#ifdef PKG_USING_UC_MODBUS_MBM_TASK_PRIO
+#define  MB_OS_CFG_MBM_TASK_PRIO          PKG_USING_UC_MODBUS_MBM_TASK_PRIO
+#else
+#define  MB_OS_CFG_MBM_TASK_PRIO          11
+#endif
+
+#ifdef PKG_USING_UC_MODBUS_MBM_TASK_STK_SIZE
+#define  MB_OS_CFG_MBM_TASK_STK_SIZE      PKG_USING_UC_MODBUS_MBM_TASK_STK_SIZE
+#else
+#define  MB_OS_CFG_MBM_TASK_STK_SIZE      512
+#endif
+
+#ifdef PKG_USING_UC_MODBUS_MBM_TASK_NBR                         /* Nbr of master request tasks, channel N served ...  */
+#define  MB_OS_CFG_MBM_TASK_NBR           PKG_USING_UC_MODBUS_MBM_TASK_NBR
+#else                                                           /* ... by task (N % MB_OS_CFG_MBM_TASK_NBR)           */
+#define  MB_OS_CFG_MBM_TASK_NBR           1
+#endif
+
+#ifdef PKG_USING_UC_MODBUS_TCP_TASK_PRIO                        /* Modbus/TCP server task (see mb_tcp.c)              */
+#define  MB_OS_CFG_TCP_TASK_PRIO          PKG_USING_UC_MODBUS_TCP_TASK_PRIO
+#else
+#define  MB_OS_CFG_TCP_TASK_PRIO          10
+#endif
+
+#ifdef PKG_USING_UC_MODBUS_TCP_TASK_STK_SIZE
+#define  MB_OS_CFG_TCP_TASK_STK_SIZE      PKG_USING_UC_MODBUS_TCP_TASK_STK_SIZE
+#else
+#define  MB_OS_CFG_TCP_TASK_STK_SIZE      1024
+#endif
+
+#ifdef PKG_USING_UC_MODBUS_CPUTIME_BITS                         /* Width of the RT-Thread CPU time counter, see ...   */
+#define  MB_OS_CFG_CPUTIME_BITS           PKG_USING_UC_MODBUS_CPUTIME_BITS
+#else                                                           /* ... MB_OS_TS_Get() in mb_os_rtthread.c             */
+#define  MB_OS_CFG_CPUTIME_BITS           32
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -54,7 +96,131 @@
 */
 
 #define  MODBUS_CFG_SLAVE_EN              DEF_ENABLED           /* Enable or Disable  Modbus Slave                    */
-#define  MODBUS_CFG_MASTER_EN             DEF_DISABLED          /* Enable or Disable  Modbus Master                   */
+#ifdef PKG_USING_UC_MODBUS_MASTER
+#define  MODBUS_CFG_MASTER_EN             DEF_ENABLED           /* Enable or Disable  Modbus Master                   */
+#else
+#define  MODBUS_CFG_MASTER_EN             DEF_DISABLED
+#endif
+
+/*
+*********************************************************************************************************
+*                                 MODBUS MASTER REQUEST CONFIGURATION
+*
+* Note(s) : (1) When MODBUS_CFG_MBM_REQ_EN is DEF_ENABLED, master requests can be submitted without blocking
+*               with MBM_ReqSubmit() (see mbm_req.c).  They are executed by MB_OS_CFG_MBM_TASK_NBR master
+*               tasks, which costs one task per MB_OS_CFG_MBM_TASK_NBR.
+*
+*           (2) MODBUS_CFG_MBM_Q_SIZE is the maximum number of requests queued on a master channel, all
+*               priorities included.  The last entry is reserved for MODBUS_MBM_PRIO_HIGH requests.
+*********************************************************************************************************
+*/
+
+#define  MODBUS_CFG_MBM_REQ_EN            DEF_DISABLED          /* Asynchronous master requests                       */
+
+#define  MODBUS_CFG_MBM_Q_SIZE                      8           /* Max. nbr of requests queued per master channel     */
+
+
+/*
+*********************************************************************************************************
+*                                    MODBUS MASTER SCAN LIST CONFIGURATION
+*
+* Note(s) : (1) When MODBUS_CFG_MBM_SCAN_EN is DEF_ENABLED, the master polls a list of tags cyclically (see
+*               mbm_scan.c).  Tags of the same slave and table are merged into as few read requests as the
+*               frame limits allow.
+*
+*           (2) Two tags are merged in the same request when they are at most MODBUS_CFG_MBM_SCAN_GAP_REG
+*               registers (or MODBUS_CFG_MBM_SCAN_GAP_BIT coils/DIs) apart.  Reading a few unused points is
+*               much cheaper than an extra transaction.  Set to 0 to only merge contiguous tags.
+*********************************************************************************************************
+*/
+
+#define  MODBUS_CFG_MBM_SCAN_EN           DEF_DISABLED          /* Cyclic poll scheduler                              */
+
+#define  MODBUS_CFG_MBM_SCAN_TAG_MAX               64           /* Max. nbr of tags in the scan list                  */
+#define  MODBUS_CFG_MBM_SCAN_BLK_MAX               16           /* Max. nbr of read requests the tags are merged into */
+
+#define  MODBUS_CFG_MBM_SCAN_GAP_REG                8           /* Max. nbr of unused registers read between two tags */
+#define  MODBUS_CFG_MBM_SCAN_GAP_BIT               64           /* Max. nbr of unused coils/DIs read between two tags */
+
+
+/*
+*********************************************************************************************************
+*                                  MODBUS MASTER BULK TRANSFER CONFIGURATION
+*
+* Note(s) : (1) When MODBUS_CFG_MBM_BULK_EN is DEF_ENABLED, the MBM_Bulkxxx() functions read or write ranges
+*               of any length, split into as many requests as needed (see mbm_bulk.c).
+*********************************************************************************************************
+*/
+
+#define  MODBUS_CFG_MBM_BULK_EN           DEF_DISABLED          /* Bulk reads and writes                              */
+
+
+/*
+*********************************************************************************************************
+*                                      MODBUS MASTER CACHE CONFIGURATION
+*
+* Note(s) : (1) When MODBUS_CFG_MBM_CACHE_EN is DEF_ENABLED, the values read by the master are kept with the
+*               time they were acquired (see mbm_cache.c).  Tasks that accept values of a given age read them
+*               from memory instead of the bus.
+*
+*           (2) MODBUS_CFG_MBM_CACHE_SIZE is the number of coils, DIs and registers cached, all channels and
+*               slaves included.  Each entry takes 16 bytes on a 32-bit CPU.
+*********************************************************************************************************
+*/
+
+#define  MODBUS_CFG_MBM_CACHE_EN          DEF_DISABLED          /* Master value cache                                 */
+
+#define  MODBUS_CFG_MBM_CACHE_SIZE                256           /* Max. nbr of points cached                          */
+
+
+/*
+*********************************************************************************************************
+*                                     MODBUS MASTER RETRY CONFIGURATION
+*
+* Note(s) : (1) When MODBUS_CFG_MBM_RETRY_EN is DEF_ENABLED, a master request that fails is sent again right
+*               away, up to MODBUS_CFG_MBM_RETRY_NBR times, on the conditions in MODBUS_CFG_MBM_RETRY_OPT
+*               (MODBUS_MBM_RETRY_xxx, see mb_def.h).  All the attempts of a request must complete within
+*               MODBUS_CFG_MBM_RETRY_DEADLINE ticks (0 for no deadline).
+*
+*           (2) These are the defaults of every channel, MB_MasterRetrySet() changes them per channel.
+*********************************************************************************************************
+*/
+
+#define  MODBUS_CFG_MBM_RETRY_EN          DEF_DISABLED          /* Master retries                                     */
+
+#define  MODBUS_CFG_MBM_RETRY_NBR                   2           /* Max. nbr of retries per request                    */
+#define  MODBUS_CFG_MBM_RETRY_OPT   MODBUS_MBM_RETRY_ALL        /* Conditions that trigger a retry                    */
+#define  MODBUS_CFG_MBM_RETRY_DEADLINE              0           /* Time allowed for all attempts (ticks), 0 = none    */
+
+
+/*
+*********************************************************************************************************
+*                                   MODBUS MASTER PER-SLAVE TRACKING CONFIGURATION
+*
+* Note(s) : (1) When MODBUS_CFG_MBM_RTO_EN is DEF_ENABLED, the master measures the round-trip time of each
+*               slave and waits for a reply for no longer than the slave needs (see mbm_slave.c).  The
+*               timeout set with MB_MasterTimeoutSet() becomes the ceiling, MODBUS_CFG_MBM_RTO_MIN the floor.
+*
+*           (2) When MODBUS_CFG_MBM_HEALTH_EN is DEF_ENABLED, a slave that misses MODBUS_CFG_MBM_OFFLINE_CNT
+*               requests in a row is declared offline.  Requests to an offline slave fail right away with
+*               MODBUS_ERR_SLAVE_OFFLINE, except for a probe sent after a backoff delay that doubles from
+*               MODBUS_CFG_MBM_BACKOFF_MIN to MODBUS_CFG_MBM_BACKOFF_MAX ticks while the slave stays silent.
+*
+*           (3) Up to MODBUS_CFG_MBM_SLAVE_MAX slaves are tracked per master channel.  Other slaves use the
+*               channel's timeout and are never declared offline.
+*********************************************************************************************************
+*/
+
+#define  MODBUS_CFG_MBM_RTO_EN            DEF_DISABLED          /* Adaptive per-slave response timeouts               */
+#define  MODBUS_CFG_MBM_HEALTH_EN         DEF_DISABLED          /* Dead slave detection                               */
+
+#define  MODBUS_CFG_MBM_SLAVE_MAX                   8           /* Max. nbr of slaves tracked per master channel      */
+
+#define  MODBUS_CFG_MBM_RTO_MIN                     2           /* Min. response timeout (ticks)                      */
+
+#define  MODBUS_CFG_MBM_OFFLINE_CNT                 3           /* Nbr of missed requests to declare a slave offline  */
+#define  MODBUS_CFG_MBM_BACKOFF_MIN              1000           /* Delay before the first probe (ticks)               */
+#define  MODBUS_CFG_MBM_BACKOFF_MAX             60000           /* Max. delay between probes (ticks)                  */
 
 /*
 *********************************************************************************************************
@@ -65,6 +231,88 @@
 #define  MODBUS_CFG_ASCII_EN               DEF_ENABLED          /* Modbus ASCII is supported when DEF_ENABLED         */
 #define  MODBUS_CFG_RTU_EN                 DEF_ENABLED          /* Modbus RTU   is supported when DEF_ENABLED         */
 
+                                                                /* RTU master: complete the reply as soon as its      */
+#define  MODBUS_CFG_MBM_RX_EARLY_EN       DEF_DISABLED          /* ... expected length is received with a valid CRC   */
+
+/*
+*********************************************************************************************************
+*                                    MODBUS TCP CONFIGURATION
+*
+* Note(s) : (1) When MODBUS_CFG_TCP_EN is DEF_ENABLED, channels configured with MODBUS_MODE_TCP exchange
+*               MBAP framed requests over BSD sockets (see mb_tcp.c): SAL on RT-Thread, the host's own
+*               sockets otherwise.  A slave channel listens with MB_TCP_Listen() and is served by the
+*               Modbus/TCP server task.  A master channel connects with MB_TCP_Connect() and receives its
+*               replies in the calling task.
+*
+*           (2) An MBAP header is 7 bytes against 3 for the RTU address and CRC.  MODBUS_CFG_BUF_SIZE must
+*               be 260 for a TCP channel to carry full-size frames, longer frames are rejected.
+*
+*           (3) When MODBUS_CFG_MBM_PIPE_EN is DEF_ENABLED, the requests submitted with MBM_ReqSubmit()
+*               to a Modbus/TCP master channel are pipelined: up to MODBUS_CFG_MBM_PIPE_WIN requests are
+*               in flight on the connection and complete in the order the slave answers them.  The window
+*               of a channel can be lowered with MBM_ReqWinSet(), for slaves that serve one request at a
+*               time.  Requires MODBUS_CFG_MBM_REQ_EN.
+*
+*           (4) The slave channels share a pool of MODBUS_CFG_TCP_CONN_MAX client connections, all served
+*               by the Modbus/TCP server task.  Each connection takes 2 x MODBUS_CFG_BUF_SIZE bytes of RAM
+*               for its receive and transmit buffers, no task or stack.  A client connecting while the
+*               pool is full takes the place of the least recently active connection.
+*
+*           (5) When MODBUS_CFG_RTU_TCP_EN is DEF_ENABLED, channels configured with MODBUS_MODE_RTU_TCP
+*               exchange RTU frames, address and CRC included, over TCP connections, as serial device
+*               servers do.  Requires MODBUS_CFG_RTU_EN.
+*
+*           (6) When MODBUS_CFG_UDP_EN is DEF_ENABLED, channels configured with MODBUS_MODE_UDP exchange
+*               MBAP framed requests as UDP datagrams.  A slave channel keeps no connection per client,
+*               a master channel polling many slaves is pointed at each in turn with MB_TCP_Connect(),
+*               which only sets the destination of the datagrams.
+*
+*           (7) MODBUS_MODE_RTU_TCP and MODBUS_MODE_UDP channels are Modbus/TCP channels: their .Mode is
+*               MODBUS_MODE_TCP, the framing is told by .TCP_Mode.  Neither is pipelined nor routed by the
+*               gateway.
+*********************************************************************************************************
+*/
+
+#ifdef PKG_USING_UC_MODBUS_TCP
+#define  MODBUS_CFG_TCP_EN                DEF_ENABLED           /* Modbus/TCP is supported when DEF_ENABLED           */
+#else
+#define  MODBUS_CFG_TCP_EN                DEF_DISABLED
+#endif
+
+#define  MODBUS_CFG_TCP_CONN_MAX                    8           /* Max. nbr of client connections, all slave channels */
+
+#define  MODBUS_CFG_RTU_TCP_EN            DEF_DISABLED          /* RTU framing over TCP (MODBUS_MODE_RTU_TCP)         */
+
+#define  MODBUS_CFG_UDP_EN                DEF_DISABLED          /* MBAP framing over UDP (MODBUS_MODE_UDP)            */
+
+#define  MODBUS_CFG_MBM_PIPE_EN           DEF_DISABLED          /* Pipelined Modbus/TCP master requests               */
+
+#define  MODBUS_CFG_MBM_PIPE_WIN                    4           /* Max. nbr of requests in flight per channel         */
+
+/*
+*********************************************************************************************************
+*                                    MODBUS GATEWAY CONFIGURATION
+*
+* Note(s) : (1) When MODBUS_CFG_GW_EN is DEF_ENABLED, the requests received by the Modbus/TCP slave channels
+*               for a unit identifier routed with MB_GW_RouteAdd() are forwarded to the master channel of
+*               the route, e.g. an RS-485 bus, and the replies are returned to the clients (see mb_gw.c).
+*               Requires MODBUS_CFG_TCP_EN, MODBUS_CFG_SLAVE_EN, MODBUS_CFG_MASTER_EN and
+*               MODBUS_CFG_MBM_REQ_EN.
+*
+*           (2) The requests waiting for a master channel are held in a pool of MODBUS_CFG_GW_Q_SIZE
+*               entries, each taking about MODBUS_CFG_BUF_SIZE bytes of RAM.  A client may hold at most
+*               MODBUS_CFG_GW_CLIENT_Q of them, so one client can't fill the pool.
+*********************************************************************************************************
+*/
+
+#define  MODBUS_CFG_GW_EN                 DEF_DISABLED          /* Modbus/TCP to serial gateway                       */
+
+#define  MODBUS_CFG_GW_ROUTE_MAX                    8           /* Max. nbr of routes (unit id. ranges)               */
+
+#define  MODBUS_CFG_GW_Q_SIZE                      32           /* Max. nbr of requests in the gateway                */
+
+#define  MODBUS_CFG_GW_CLIENT_Q                     8           /* Max. nbr of requests in the gateway per client     */
+
 /*
 *********************************************************************************************************
 *                               MODBUS COMMUNICATION CONFIGURATION
@@ -75,6 +323,77 @@
 
 #define  MODBUS_CFG_BUF_SIZE                       255           /* Maximum outgoing message size.                     */
 
+/*
+*********************************************************************************************************
+*                                 MODBUS SLAVE ADDRESSING CONFIGURATION
+*
+* Note(s) : (1) When MODBUS_CFG_MULTI_ADDR_EN is DEF_ENABLED, a slave channel answers every node address
+*               added with MB_NodeAddrAdd(), and each address can be mapped onto its own data model.  This
+*               costs 256 bytes plus MODBUS_CFG_DATA_MODEL_MAX pointers of RAM per channel.
+*********************************************************************************************************
+*/
+
+#define  MODBUS_CFG_MULTI_ADDR_EN         DEF_DISABLED          /* Answer several node addresses per channel          */
+
+#define  MODBUS_CFG_DATA_MODEL_MAX                   4          /* Max. nbr of distinct data models per channel       */
+
+/*
+*********************************************************************************************************
+*                                 MODBUS REGISTER IMAGE CONFIGURATION
+*
+* Note(s) : (1) When MODBUS_CFG_IMG_EN is DEF_ENABLED, FC03 and FC04 requests falling entirely within a
+*               register image (see mb_img.c) are answered from a consistent snapshot of the image instead
+*               of calling MB_HoldingRegRd() or MB_InRegRd() for each register.
+*
+*           (2) MODBUS_CFG_IMG_RETRY_MAX is the number of times a snapshot is retried while the image is
+*               being updated before the request is answered with a 'Slave Device Busy' exception.
+*********************************************************************************************************
+*/
+
+#define  MODBUS_CFG_IMG_EN                DEF_DISABLED          /* Serve FC03/FC04 from register images               */
+
+#define  MODBUS_CFG_IMG_RETRY_MAX                   8           /* Max. nbr of snapshot attempts per request          */
+
+/*
+*********************************************************************************************************
+*                                MODBUS SLAVE TURNAROUND HISTOGRAM CONFIGURATION
+*
+* Note(s) : (1) When MODBUS_CFG_HIST_EN is DEF_ENABLED, each slave channel timestamps the end of reception of
+*               a request, the start of its processing and the moment its reply is handed to the driver,
+*               and keeps log2 histograms of the intervals, per function code (see mb_hist.c).  They're
+*               read with MB_HistGet() or, on RT-Thread, the 'mb_hist' shell command.  Each channel takes
+*               about 1.2 Kbytes of RAM more.
+*
+*           (2) When MODBUS_CFG_HIST_REG_EN is also DEF_ENABLED, the histograms of a channel can be read by
+*               its masters with FC04 from input register MODBUS_CFG_HIST_REG_START on.  These registers
+*               are never passed to MB_InRegRd().
+*********************************************************************************************************
+*/
+
+#define  MODBUS_CFG_HIST_EN               DEF_DISABLED          /* Slave turnaround latency histograms                */
+
+#define  MODBUS_CFG_HIST_REG_EN           DEF_DISABLED          /* ... readable as input registers                    */
+#define  MODBUS_CFG_HIST_REG_START              60000           /* First input register of the histograms             */
+
+/*
+*********************************************************************************************************
+*                                       MODBUS FRAME TRACE CONFIGURATION
+*
+* Note(s) : (1) When MODBUS_CFG_TRACE_EN is DEF_ENABLED, each channel records the raw frames it receives and
+*               sends, with a microsecond timestamp, in a ring of the last MODBUS_CFG_TRACE_NBR frames (see
+*               mb_trace.c).  The ring is read with MB_TraceRd(), dumped as text or pcap with MB_TraceDump()
+*               or, on RT-Thread, printed with the 'mb_trace' shell command.
+*
+*           (2) Only the first MODBUS_CFG_TRACE_CAPTURE bytes of a frame are kept.  Each channel takes
+*               MODBUS_CFG_TRACE_NBR x (MODBUS_CFG_TRACE_CAPTURE + 12) bytes of RAM more.
+*********************************************************************************************************
+*/
+
+#define  MODBUS_CFG_TRACE_EN              DEF_DISABLED          /* Trace ring of the raw frames                       */
+
+#define  MODBUS_CFG_TRACE_NBR                      32           /* Nbr of frames kept per channel, a power of 2       */
+#define  MODBUS_CFG_TRACE_CAPTURE                  32           /* Nbr of bytes kept per frame                        */
+
 /*
 *********************************************************************************************************
 *                                  MODBUS FLOATING POINT SUPPORT
@@ -108,3 +427,5 @@
 #define  MODBUS_CFG_FC16_EN                DEF_ENABLED
 #define  MODBUS_CFG_FC20_EN                DEF_DISABLED
 #define  MODBUS_CFG_FC21_EN                DEF_DISABLED
+
+#define  MODBUS_CFG_WR_NOTIFY_EN           DEF_DISABLED         /* Call MB_WrNotify() once per write request          */
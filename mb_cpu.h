@@ -0,0 +1,200 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                   MODBUS CPU & KERNEL PORT SELECTION
+*
+* Filename : mb_cpu.h
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) uC/Modbus is built on top of one of the following kernel ports:
+*
+*                  MB_OS_PORT_UCOS3      uC/OS-III (or the RT-Thread uC/OS-III compatibility layer),
+*                                        see mb_os_iii.c.  This is the default.
+*
+*                  MB_OS_PORT_RTTHREAD   native RT-Thread kernel objects, see mb_os_rtthread.c.  Selected
+*                                        when PKG_USING_UC_MODBUS_OS_RTTHREAD is defined.
+*
+*                  MB_OS_PORT_POSIX      POSIX threads on a Linux host, see mb_os_posix.c and
+*                                        mb_bsp_posix.c.  Selected when PKG_USING_UC_MODBUS_OS_POSIX is
+*                                        defined, by the rtconfig.h the host build generates (see
+*                                        CMakeLists.txt).
+*
+*            (2) The uC/OS-III port takes the CPU_xxx data types, the critical section macros and the
+*                DEF_xxx constants from uC/CPU and uC/LIB.  The native ports don't depend on these
+*                modules, so the few definitions used by uC/Modbus are provided here instead.
+*
+*            (3) On a host, the critical sections of the RTU receive and timer paths are serialized by a
+*                recursive mutex, taken by CPU_SR_Save() and released by CPU_SR_Restore() (see
+*                mb_os_posix.c).
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                               MODULE
+*********************************************************************************************************
+*/
+
+#ifndef  MB_CPU_MODULE_PRESENT
+#define  MB_CPU_MODULE_PRESENT
+
+
+/*
+*********************************************************************************************************
+*                                          KERNEL PORT SELECTION
+*********************************************************************************************************
+*/
+
+#include  <rtconfig.h>
+
+#define  MB_OS_PORT_UCOS3                           1
+#define  MB_OS_PORT_RTTHREAD                        2
+#define  MB_OS_PORT_POSIX                           3
+
+#ifndef  MB_OS_CFG_PORT
+#if      defined(PKG_USING_UC_MODBUS_OS_POSIX)
+#define  MB_OS_CFG_PORT                  MB_OS_PORT_POSIX
+#elif    defined(PKG_USING_UC_MODBUS_OS_RTTHREAD)
+#define  MB_OS_CFG_PORT                  MB_OS_PORT_RTTHREAD
+#else
+#define  MB_OS_CFG_PORT                  MB_OS_PORT_UCOS3
+#endif
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#if     (MB_OS_CFG_PORT == MB_OS_PORT_UCOS3)
+#include  <cpu.h>
+#include  <lib_def.h>
+#elif   (MB_OS_CFG_PORT == MB_OS_PORT_RTTHREAD)
+#include  <rtthread.h>
+#else
+#include  <stdint.h>
+#endif
+
+#if     (MB_OS_CFG_PORT != MB_OS_PORT_UCOS3)
+
+
+/*
+*********************************************************************************************************
+*                                             DATA TYPES
+*                                           (see Note #2)
+*********************************************************************************************************
+*/
+
+#if     (MB_OS_CFG_PORT == MB_OS_PORT_RTTHREAD)
+typedef  void          CPU_VOID;
+typedef  char          CPU_CHAR;
+typedef  rt_uint8_t    CPU_BOOLEAN;
+typedef  rt_uint8_t    CPU_INT08U;
+typedef  rt_int8_t     CPU_INT08S;
+typedef  rt_uint16_t   CPU_INT16U;
+typedef  rt_int16_t    CPU_INT16S;
+typedef  rt_uint32_t   CPU_INT32U;
+typedef  rt_int32_t    CPU_INT32S;
+typedef  rt_uint64_t   CPU_INT64U;
+typedef  float         CPU_FP32;
+typedef  double        CPU_FP64;
+typedef  rt_uint32_t   CPU_STK;
+typedef  rt_uint32_t   CPU_TS;
+typedef  rt_ubase_t    CPU_ADDR;
+typedef  rt_base_t     CPU_SR;
+#else
+typedef  void          CPU_VOID;
+typedef  char          CPU_CHAR;
+typedef  uint8_t       CPU_BOOLEAN;
+typedef  uint8_t       CPU_INT08U;
+typedef  int8_t        CPU_INT08S;
+typedef  uint16_t      CPU_INT16U;
+typedef  int16_t       CPU_INT16S;
+typedef  uint32_t      CPU_INT32U;
+typedef  int32_t       CPU_INT32S;
+typedef  uint64_t      CPU_INT64U;
+typedef  float         CPU_FP32;
+typedef  double        CPU_FP64;
+typedef  uint32_t      CPU_STK;
+typedef  uint32_t      CPU_TS;
+typedef  uintptr_t     CPU_ADDR;
+typedef  int           CPU_SR;
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                              CONSTANTS
+*                                           (see Note #2)
+*********************************************************************************************************
+*/
+
+#define  DEF_DISABLED                               0u
+#define  DEF_ENABLED                                1u
+
+#define  DEF_FALSE                                  0u
+#define  DEF_TRUE                                   1u
+
+#define  CPU_ENDIAN_TYPE_BIG                        1u
+#define  CPU_ENDIAN_TYPE_LITTLE                     2u
+
+#if      defined(ARCH_CPU_BIG_ENDIAN) || \
+        (defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__))
+#define  CPU_CFG_ENDIAN_TYPE             CPU_ENDIAN_TYPE_BIG
+#else
+#define  CPU_CFG_ENDIAN_TYPE             CPU_ENDIAN_TYPE_LITTLE
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                              MACRO'S
+*                                           (see Note #2)
+*
+* Note(s) : (1) As with uC/CPU, the caller declares 'cpu_sr' (see CPU_SR_ALLOC()) before entering a
+*               critical section.
+*********************************************************************************************************
+*/
+
+#define  CPU_SR_ALLOC()                  CPU_SR  cpu_sr = (CPU_SR)0
+
+#if     (MB_OS_CFG_PORT == MB_OS_PORT_RTTHREAD)
+#define  CPU_CRITICAL_ENTER()            do { cpu_sr = rt_hw_interrupt_disable(); } while (0)
+#define  CPU_CRITICAL_EXIT()             do { rt_hw_interrupt_enable(cpu_sr);     } while (0)
+#else                                                           /* See Note #3                                        */
+#define  CPU_CRITICAL_ENTER()            do { cpu_sr = CPU_SR_Save();  } while (0)
+#define  CPU_CRITICAL_EXIT()             do { CPU_SR_Restore(cpu_sr);  } while (0)
+
+CPU_SR   CPU_SR_Save   (void);
+void     CPU_SR_Restore(CPU_SR  cpu_sr);
+#endif
+
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                             MODULE END
+*********************************************************************************************************
+*/
+
+#endif                                                          /* End of MB_CPU module                               */
@@ -188,7 +188,6 @@ CPU_INT16U  MB_InRegRd (CPU_INT16U   reg,
 {
     CPU_INT16U  val;
     CPU_SR      cpu_sr;
-    OS_ERR      err;
 
     switch (reg) {
         case 10:
@@ -213,13 +212,13 @@ CPU_INT16U  MB_InRegRd (CPU_INT16U   reg,
 
         case 12:
              CPU_CRITICAL_ENTER();
-             val = (CPU_INT16U)(OSTimeGet(&err) >> 16);
+             val = (CPU_INT16U)(MB_OS_TimeGet() >> 16);
              CPU_CRITICAL_EXIT();
              break;
 
         case 13:
              CPU_CRITICAL_ENTER();
-             val = (CPU_INT16U)(OSTimeGet(&err) & 0x0000FFFF);
+             val = (CPU_INT16U)(MB_OS_TimeGet() & 0x0000FFFF);
              CPU_CRITICAL_EXIT();
              break;
 
@@ -317,7 +316,6 @@ CPU_INT16U  MB_HoldingRegRd (CPU_INT16U   reg,
 {
     CPU_INT16U  val;
     CPU_SR      cpu_sr;
-    OS_ERR      err;
 
     switch (reg) {
         case 0:
@@ -341,13 +339,13 @@ CPU_INT16U  MB_HoldingRegRd (CPU_INT16U   reg,
 
         case 2:
              CPU_CRITICAL_ENTER();
-             val = (CPU_INT16U)(OSTimeGet(&err) >> 16);
+             val = (CPU_INT16U)(MB_OS_TimeGet() >> 16);
              CPU_CRITICAL_EXIT();
              break;
 
         case 3:
              CPU_CRITICAL_ENTER();
-             val = (CPU_INT16U)(OSTimeGet(&err) & 0x0000FFFF);
+             val = (CPU_INT16U)(MB_OS_TimeGet() & 0x0000FFFF);
              CPU_CRITICAL_EXIT();
              break;
 
@@ -633,3 +631,38 @@ void  MB_FileWr (CPU_INT16U   file_nbr,
     *perr = MODBUS_ERR_NONE;
 }
 #endif
+
+/*
+*********************************************************************************************************
+*                                   NOTIFICATION OF A WRITE REQUEST
+*
+* Description: This function is called once all the coils or registers of a write request have been
+*              written.  It is called by 'MBS_FC05_CoilWr()', 'MBS_FC06_HoldingRegWr()',
+*              'MBS_FC15_CoilWrMultiple()' and 'MBS_FC16_HoldingRegWrMultiple()'.
+*              This is where derived data (e.g. control gains or tables computed from several registers)
+*              should be recomputed, once per request instead of once per register.
+*
+* Arguments  : fc        is the function code of the request (MODBUS_FC05_COIL_WR, MODBUS_FC06_HOLDING_REG_WR,
+*                        MODBUS_FC15_COIL_WR_MULTIPLE or MODBUS_FC16_HOLDING_REG_WR_MULTIPLE).
+*
+*              start     is the number of the first coil or register written.
+*
+*              nbr       is the number of coils or registers written.
+*
+* Note(s)    : 1) If MB_CoilWr(), MB_HoldingRegWr() or MB_HoldingRegWrFP() returned an error in the middle of
+*                 a request, 'nbr' only counts the coils or registers written before the error.  Nothing is
+*                 notified if none was written.
+*              2) The reply to the request is sent after this function returns.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_WR_NOTIFY_EN == DEF_ENABLED)
+void  MB_WrNotify (CPU_INT08U   fc,
+                   CPU_INT16U   start,
+                   CPU_INT16U   nbr)
+{
+    (void)fc;
+    (void)start;
+    (void)nbr;
+}
+#endif
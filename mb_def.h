@@ -32,6 +32,9 @@
 
 #define  MODBUS_MODE_ASCII                          1
 #define  MODBUS_MODE_RTU                            0
+#define  MODBUS_MODE_TCP                            2
+#define  MODBUS_MODE_RTU_TCP                        3
+#define  MODBUS_MODE_UDP                            4
 
 
 #define  MODBUS_WR_EN                               1
@@ -53,6 +56,63 @@
 #define  MODBUS_MASTER_STATE_TX                     1
 #define  MODBUS_MASTER_STATE_WAITING                2
 
+#define  MODBUS_MBM_REQ_STATE_IDLE                  0       /* Master request not submitted                */
+#define  MODBUS_MBM_REQ_STATE_PEND                  1       /* Waiting in the channel's request queue      */
+#define  MODBUS_MBM_REQ_STATE_ACTIVE                2       /* Being executed on the bus                   */
+#define  MODBUS_MBM_REQ_STATE_DONE_Q                3       /* Completed, waiting in the completion queue  */
+#define  MODBUS_MBM_REQ_STATE_DONE                  4       /* Completed, .Err holds the result            */
+
+#define  MODBUS_MBM_FC_PDU                          0       /* Master request carrying a raw PDU           */
+
+#define  MODBUS_MBM_PRIO_HIGH                       0       /* Master request priority classes             */
+#define  MODBUS_MBM_PRIO_NORMAL                     1
+#define  MODBUS_MBM_PRIO_LOW                        2
+#define  MODBUS_MBM_PRIO_NBR                        3
+
+#define  MODBUS_MBM_SLAVE_STATE_UNKNOWN             0       /* Slave not tracked or never addressed        */
+#define  MODBUS_MBM_SLAVE_STATE_ONLINE              1       /* Slave answered the last request             */
+#define  MODBUS_MBM_SLAVE_STATE_SUSPECT             2       /* Slave missed the last request(s)            */
+#define  MODBUS_MBM_SLAVE_STATE_OFFLINE             3       /* Slave skipped, only probed now and then     */
+
+#define  MODBUS_MBM_RETRY_TIMEOUT                0x01       /* Master retries: request not answered        */
+#define  MODBUS_MBM_RETRY_RX                     0x02       /* ... invalid reply (CRC/LRC or frame error)  */
+#define  MODBUS_MBM_RETRY_BUSY                   0x04       /* ... 'slave device busy' exception           */
+#define  MODBUS_MBM_RETRY_ALL                    0x07
+
+#define  MODBUS_MBM_RTT_NONE               0xFFFFFFFFu      /* No round-trip time sample                   */
+
+#define  MODBUS_MBM_CACHE_GOOD                      0       /* Cached value read by the last request       */
+#define  MODBUS_MBM_CACHE_BAD                       1       /* Last request failed, value read before      */
+
+#define  MODBUS_HIST_WAIT                           0       /* Slave histograms: end of Rx to processing   */
+#define  MODBUS_HIST_PROC                           1       /* ... processing to reply handed to MB_Tx()   */
+#define  MODBUS_HIST_TURN                           2       /* ... end of Rx to reply, per function code   */
+#define  MODBUS_HIST_NBR                            3
+
+#define  MODBUS_HIST_BUCKET_NBR                    20       /* Log2 buckets, see mb_hist.c Note #2         */
+#define  MODBUS_HIST_FC_NBR                        12       /* Function codes with their own histogram     */
+#define  MODBUS_HIST_REG_NBR                      588       /* Input registers of a channel's histograms   */
+
+#define  MODBUS_TRACE_RX                            0       /* Trace ring: frame received                  */
+#define  MODBUS_TRACE_TX                            1       /* ... frame sent                              */
+
+#define  MODBUS_TRACE_FMT_TEXT                      0       /* MB_TraceDump() formats                      */
+#define  MODBUS_TRACE_FMT_PCAP                      1
+
+#define  MODBUS_TYPE_U16                            0       /* Register value types for MB_RegDecode()     */
+#define  MODBUS_TYPE_S16                            1
+#define  MODBUS_TYPE_U32                            2
+#define  MODBUS_TYPE_S32                            3
+#define  MODBUS_TYPE_FP32                           4
+#define  MODBUS_TYPE_FP64                           5
+
+#define  MODBUS_ORDER_BYTE_SWAP                  0x01       /* Bytes swapped within each register          */
+#define  MODBUS_ORDER_WORD_SWAP                  0x02       /* Least significant register first            */
+#define  MODBUS_ORDER_ABCD                       0x00       /* Big endian, as in the Modbus spec.          */
+#define  MODBUS_ORDER_BADC                       0x01
+#define  MODBUS_ORDER_CDAB                       0x02
+#define  MODBUS_ORDER_DCBA                       0x03
+
 #define  MODBUS_FALSE                               0
 #define  MODBUS_TRUE                                1
 
@@ -98,6 +158,9 @@
 #define  MODBUS_ERR_ILLEGAL_DATA_ADDR               2
 #define  MODBUS_ERR_ILLEGAL_DATA_QTY                3
 #define  MODBUS_ERR_ILLEGAL_DATA_VAL                4
+#define  MODBUS_ERR_SLAVE_DEVICE_BUSY               6
+#define  MODBUS_ERR_GW_PATH                        10       /* Gateway path unavailable                */
+#define  MODBUS_ERR_GW_TARGET                      11       /* Gateway target device failed to respond */
 
 #define  MODBUS_ERR_FC01_01                       101
 #define  MODBUS_ERR_FC01_02                       102
@@ -110,11 +173,13 @@
 #define  MODBUS_ERR_FC03_02                       302
 #define  MODBUS_ERR_FC03_03                       303
 #define  MODBUS_ERR_FC03_04                       304
+#define  MODBUS_ERR_FC03_05                       305
 
 #define  MODBUS_ERR_FC04_01                       401
 #define  MODBUS_ERR_FC04_02                       402
 #define  MODBUS_ERR_FC04_03                       403
 #define  MODBUS_ERR_FC04_04                       404
+#define  MODBUS_ERR_FC04_05                       405
 
 #define  MODBUS_ERR_FC05_01                       501
 #define  MODBUS_ERR_FC05_02                       502
@@ -149,6 +214,11 @@
 #define  MODBUS_ERR_NOT_MASTER                   3001
 #define  MODBUS_ERR_INVALID                      3002
 #define  MODBUS_ERR_NULLPTR                      3003
+#define  MODBUS_ERR_FULL                         3004
+#define  MODBUS_ERR_BUSY                         3005
+#define  MODBUS_ERR_NO_DATA                      3006
+#define  MODBUS_ERR_SLAVE_OFFLINE                3007
+#define  MODBUS_ERR_TCP                          3008
 
 #define  MODBUS_ERR_RANGE                        4000
 #define  MODBUS_ERR_FILE                         4001
@@ -193,5 +263,18 @@
 #define  MODBUS_RTU_MIN_MSG_SIZE                    4
 #endif
 
+/*
+*********************************************************************************************************
+*                                         MODBUS TCP CONSTANTS
+*********************************************************************************************************
+*/
+
+#if     (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+#define  MODBUS_TCP_PORT                          502       /* Registered Modbus/TCP port              */
+#define  MODBUS_TCP_PROTOCOL_ID                     0       /* MBAP protocol identifier                */
+#define  MODBUS_TCP_MBAP_SIZE                       7       /* MBAP header size, unit identifier incl. */
+#define  MODBUS_TCP_MIN_MSG_SIZE                    8       /* MBAP header + function code             */
+#endif
+
 #define  MODBUS_CRC16_POLY                     0xA001       /* CRC-16 Generation Polynomial value.     */
 
@@ -0,0 +1,645 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                  uC/MODBUS TCP TO SERIAL GATEWAY
+*
+* Filename : mb_gw.c
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) The gateway forwards the requests received by the Modbus/TCP slave channels to master
+*                channels, typically RS-485 buses, by unit identifier.  A route maps a range of unit
+*                identifiers to a master channel (see MB_GW_RouteAdd()).  The requests for a unit identifier
+*                without a route are processed by the slave channel as before.
+*
+*            (2) A request is held in an entry of MB_GW_Tbl[] from its reception by the server task (see
+*                MB_GW_Rx()) to its reply.  It's forwarded as is, whatever its function code, with
+*                MBM_ReqSubmit() (MODBUS_MBM_FC_PDU), and the reply of the slave is returned with the
+*                transaction identifier and the unit identifier of the request.
+*
+*            (3) A master channel carries one forwarded request at a time.  When it completes, the next one
+*                is taken from the client following the one served last, so a client polling hard gets the
+*                same share of the bus as any other.  The requests of a client are forwarded in the order
+*                received.
+*
+*            (4) A read (FC01 to FC04) identical to one waiting for, or being carried by, the same master
+*                channel isn't forwarded: it gets the reply of the other.  Clients polling the same values
+*                then cost a single transaction on the bus.  The reply may date from slightly before the
+*                request, as when the read of the other client is already on the bus.
+*
+*            (5) The exceptions returned by the gateway itself are:
+*
+*                    MODBUS_ERR_SLAVE_DEVICE_BUSY   MB_GW_Tbl[] is full, or the client has MODBUS_CFG_GW_CLIENT_Q
+*                                                   requests in it already
+*                    MODBUS_ERR_GW_PATH             No route, or the master channel rejected the request
+*                    MODBUS_ERR_GW_TARGET           The slave didn't answer, or its reply was invalid
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define    MB_GW_MODULE
+#include  "mb.h"
+
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+
+#include  <string.h>
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  MB_GW_HDR_SIZE                                 7       /* MBAP header, unit id. included                     */
+
+#define  MB_GW_PDU_SIZE        (MODBUS_CFG_BUF_SIZE - MB_GW_HDR_SIZE)
+
+#define  MB_GW_RD_SIZE                                  6       /* Unit id. and PDU of a read (FC01 to FC04)          */
+
+#define  MB_GW_STATE_FREE                               0       /* Entry not in use                                   */
+#define  MB_GW_STATE_NEW                                1       /* Request being stored by MB_GW_Rx()                 */
+#define  MB_GW_STATE_PEND                               2       /* Waiting for its master channel                     */
+#define  MB_GW_STATE_ACTIVE                             3       /* Submitted to its master channel                    */
+#define  MB_GW_STATE_FOLLOW                             4       /* Waiting for the reply to an identical read         */
+#define  MB_GW_STATE_REPLY                              5       /* Reply being sent                                   */
+
+
+/*
+*********************************************************************************************************
+*                                           LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+typedef  struct  mb_gw_route {                         /* Unit identifiers served by a master channel                      */
+    CPU_INT08U       UnitFirst;
+    CPU_INT08U       UnitLast;
+    MODBUS_CH       *ChPtr;
+} MB_GW_ROUTE;
+
+
+typedef  struct  mb_gw_entry  MB_GW_ENTRY;
+
+struct  mb_gw_entry {                                  /* Request received from a Modbus/TCP client                        */
+    CPU_INT08U       State;                            /* MB_GW_STATE_xxx                                                  */
+    CPU_INT08U       FC;                               /* Function code of the request                                     */
+    MODBUS_CH       *ChPtr;                            /* Master channel the request is forwarded to                       */
+    CPU_INT32U       ConnId;                           /* Client connection, see MB_TCP_ConnReply()                        */
+    CPU_INT32U       Seq;                              /* Order of reception                                               */
+    MB_GW_ENTRY     *FollowPtr;                        /* Requests answered with the reply to this one (see Note #4)       */
+    CPU_INT16U       FrameLen;                         /* Length of .Frame[]                                               */
+    CPU_INT08U       Frame[MODBUS_CFG_BUF_SIZE];       /* Request, MBAP header included, replaced by the reply             */
+    CPU_INT08U       Rd[MB_GW_RD_SIZE];                /* Unit id. and PDU of a read, kept for the lookup of Note #4       */
+    MODBUS_MBM_REQ   Req;                              /* Master request carrying the PDU of .Frame[]                      */
+};
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+static  MB_GW_ROUTE   MB_GW_RouteTbl[MODBUS_CFG_GW_ROUTE_MAX];
+static  CPU_INT08U    MB_GW_RouteCtr;
+
+static  MB_GW_ENTRY   MB_GW_Tbl[MODBUS_CFG_GW_Q_SIZE];
+static  CPU_INT32U    MB_GW_SeqCtr;
+
+static  CPU_INT08U    MB_GW_ConnLast[MODBUS_CFG_MAX_CH];        /* Client served last on each master channel          */
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  void          MB_GW_Dispatch  (MODBUS_CH       *pch);
+
+static  void          MB_GW_Done      (MODBUS_MBM_REQ  *preq);
+
+static  void          MB_GW_Reply     (MB_GW_ENTRY     *pentry,
+                                       CPU_INT08U       except);
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            MB_GW_Init()
+*
+* Description : Clears the routes and the requests of the gateway.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_Init().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_GW_Init (void)
+{
+    CPU_INT16U   i;
+    MB_GW_ENTRY *pentry;
+
+
+    MB_GW_RouteCtr = 0;
+    MB_GW_SeqCtr   = 0;
+    pentry         = &MB_GW_Tbl[0];
+    for (i = 0; i < MODBUS_CFG_GW_Q_SIZE; i++) {
+        pentry->State     = MB_GW_STATE_FREE;
+        pentry->FollowPtr = (MB_GW_ENTRY *)0;
+        pentry++;
+    }
+    for (i = 0; i < MODBUS_CFG_MAX_CH; i++) {
+        MB_GW_ConnLast[i] = 0;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_GW_RouteAdd()
+*
+* Description : Routes a range of unit identifiers to a master channel.
+*
+* Argument(s) : unit_first   Is the first unit identifier of the range (1 to 255).
+*
+*               unit_last    Is the last unit identifier of the range.
+*
+*               pch          Is a pointer to the master channel, e.g. an RTU channel on an RS-485 bus.
+*
+* Return(s)   : MODBUS_ERR_NONE          If the route was added.
+*               MODBUS_ERR_NULLPTR       If 'pch' is a NULL pointer.
+*               MODBUS_ERR_NOT_MASTER    If the channel is not a master.
+*               MODBUS_ERR_INVALID       If the range is empty or includes unit identifier 0.
+*               MODBUS_ERR_FULL          If MODBUS_CFG_GW_ROUTE_MAX routes are defined already.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) Unit identifier 0 would be a broadcast on the bus, which the slaves don't answer.  It's
+*                   answered by the slave channel itself.
+*
+*               (2) The routes are looked up in the order they were added, the first one matching is used.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MB_GW_RouteAdd (CPU_INT08U   unit_first,
+                            CPU_INT08U   unit_last,
+                            MODBUS_CH   *pch)
+{
+    MB_GW_ROUTE  *proute;
+    CPU_SR        cpu_sr;
+
+
+    if (pch == (MODBUS_CH *)0) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+
+    if (pch->MasterSlave != MODBUS_MASTER) {
+        return (MODBUS_ERR_NOT_MASTER);
+    }
+
+    if ((unit_first == 0) ||                                    /* See Note #1                                        */
+        (unit_first >  unit_last)) {
+        return (MODBUS_ERR_INVALID);
+    }
+
+    CPU_CRITICAL_ENTER();
+    if (MB_GW_RouteCtr >= MODBUS_CFG_GW_ROUTE_MAX) {
+        CPU_CRITICAL_EXIT();
+        return (MODBUS_ERR_FULL);
+    }
+    proute            = &MB_GW_RouteTbl[MB_GW_RouteCtr];
+    proute->UnitFirst = unit_first;
+    proute->UnitLast  = unit_last;
+    proute->ChPtr     = pch;
+    MB_GW_RouteCtr++;
+    CPU_CRITICAL_EXIT();
+
+    return (MODBUS_ERR_NONE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_GW_RouteClr()
+*
+* Description : Removes all the routes of the gateway.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) The requests already received are still forwarded.
+*********************************************************************************************************
+*/
+
+void  MB_GW_RouteClr (void)
+{
+    MB_GW_RouteCtr = 0;
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_GW_RouteGet()
+*
+* Description : Looks up the master channel a unit identifier is routed to.
+*
+* Argument(s) : unit         Is the unit identifier.
+*
+* Return(s)   : A pointer to the master channel, or NULL if the unit identifier has no route.
+*
+* Caller(s)   : MB_GW_Rx(),
+*               MB_TCP_ConnRx().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+MODBUS_CH  *MB_GW_RouteGet (CPU_INT08U  unit)
+{
+    CPU_INT08U    i;
+    CPU_INT08U    nbr;
+    MB_GW_ROUTE  *proute;
+
+
+    nbr    = MB_GW_RouteCtr;
+    proute = &MB_GW_RouteTbl[0];
+    for (i = 0; i < nbr; i++) {
+        if ((unit >= proute->UnitFirst) &&
+            (unit <= proute->UnitLast)) {
+            return (proute->ChPtr);
+        }
+        proute++;
+    }
+    return ((MODBUS_CH *)0);
+}
+
+
+/*
+*********************************************************************************************************
+*                                              MB_GW_Rx()
+*
+* Description : Queues a request received by a Modbus/TCP slave channel for the master channel of its unit
+*               identifier.
+*
+* Argument(s) : pframe       Is a pointer to the request, MBAP header included.
+*
+*               nbr_bytes    Is the length of the request.
+*
+*               conn_id      Is the identifier of the client connection, passed back to MB_TCP_ConnReply().
+*
+* Return(s)   : MODBUS_ERR_NONE          If the request was queued, the reply is sent when it completes.
+*               Exception code           To answer the request with, see Note #5 of this file.
+*
+* Caller(s)   : MB_TCP_ConnRx().
+*
+* Note(s)     : (1) The entry is taken in one critical section and linked in another, the request is copied
+*                   in between.  A new entry is counted for its client but can't be dispatched.
+*
+*               (2) The reply of an active request is written over its .Frame[] by the master task, outside
+*                   of any critical section, before the entry leaves MB_GW_STATE_ACTIVE.  The identical
+*                   reads are looked up in .Rd[] instead, a copy of the request that's never overwritten.
+*                   Only a well-formed read, unit id. and 5-byte PDU, may lead or follow another.
+*********************************************************************************************************
+*/
+
+CPU_INT08U  MB_GW_Rx (CPU_INT08U  *pframe,
+                      CPU_INT16U   nbr_bytes,
+                      CPU_INT32U   conn_id)
+{
+    MODBUS_CH    *pch;
+    MB_GW_ENTRY  *pentry;
+    MB_GW_ENTRY  *pentry_new;
+    MB_GW_ENTRY  *pentry_lead;
+    CPU_INT16U    i;
+    CPU_INT16U    nbr_client;
+    CPU_INT08U    fc;
+    CPU_BOOLEAN   rd;
+    CPU_SR        cpu_sr;
+
+
+    pch = MB_GW_RouteGet(pframe[MB_GW_HDR_SIZE - 1]);
+    if (pch == (MODBUS_CH *)0) {                                /* Route removed meanwhile                            */
+        return (MODBUS_ERR_GW_PATH);
+    }
+
+    pentry_new = (MB_GW_ENTRY *)0;                              /* Take an entry, see Note #1                         */
+    nbr_client = 0;
+    CPU_CRITICAL_ENTER();
+    pentry     = &MB_GW_Tbl[0];
+    for (i = 0; i < MODBUS_CFG_GW_Q_SIZE; i++) {
+        if (pentry->State == MB_GW_STATE_FREE) {
+            if (pentry_new == (MB_GW_ENTRY *)0) {
+                pentry_new = pentry;
+            }
+        } else if (pentry->ConnId == conn_id) {
+            nbr_client++;
+        }
+        pentry++;
+    }
+    if ((pentry_new == (MB_GW_ENTRY *)0) ||
+        (nbr_client >= MODBUS_CFG_GW_CLIENT_Q)) {
+        CPU_CRITICAL_EXIT();
+        return (MODBUS_ERR_SLAVE_DEVICE_BUSY);
+    }
+    pentry_new->State  = MB_GW_STATE_NEW;
+    pentry_new->ConnId = conn_id;
+    CPU_CRITICAL_EXIT();
+
+    fc                    = pframe[MB_GW_HDR_SIZE];
+    pentry_new->FC        = fc;
+    pentry_new->ChPtr     = pch;
+    pentry_new->FollowPtr = (MB_GW_ENTRY *)0;
+    pentry_new->FrameLen  = nbr_bytes;
+    memcpy(&pentry_new->Frame[0], pframe, nbr_bytes);
+    rd                    = DEF_FALSE;
+    if ((fc        >= MODBUS_FC01_COIL_RD) &&                   /* See Note #2                                        */
+        (fc        <= MODBUS_FC04_IN_REG_RD) &&
+        (nbr_bytes == MB_GW_HDR_SIZE - 1 + MB_GW_RD_SIZE)) {
+        memcpy(&pentry_new->Rd[0], &pframe[MB_GW_HDR_SIZE - 1], MB_GW_RD_SIZE);
+        rd = DEF_TRUE;
+    }
+
+    pentry_lead = (MB_GW_ENTRY *)0;
+    CPU_CRITICAL_ENTER();
+    if (rd == DEF_TRUE) {                                       /* Look for an identical read, see Note #4            */
+        pentry = &MB_GW_Tbl[0];
+        for (i = 0; i < MODBUS_CFG_GW_Q_SIZE; i++) {
+            if (((pentry->State    == MB_GW_STATE_PEND) ||
+                 (pentry->State    == MB_GW_STATE_ACTIVE)) &&
+                 (pentry->ChPtr    == pch) &&
+                 (pentry->FC       == fc) &&                    /* .Rd[] of a read only                               */
+                 (pentry->FrameLen == nbr_bytes) &&
+                 (memcmp(&pentry->Rd[0],                        /* Same unit id. and PDU                              */
+                         &pentry_new->Rd[0],
+                         MB_GW_RD_SIZE) == 0)) {
+                pentry_lead = pentry;
+                break;
+            }
+            pentry++;
+        }
+    }
+    if (pentry_lead != (MB_GW_ENTRY *)0) {
+        pentry_new->State      = MB_GW_STATE_FOLLOW;
+        pentry_new->FollowPtr  = pentry_lead->FollowPtr;
+        pentry_lead->FollowPtr = pentry_new;
+    } else {
+        pentry_new->State      = MB_GW_STATE_PEND;
+        pentry_new->Seq        = MB_GW_SeqCtr++;
+    }
+    CPU_CRITICAL_EXIT();
+
+    if (pentry_lead == (MB_GW_ENTRY *)0) {
+        MB_GW_Dispatch(pch);
+    }
+
+    return (MODBUS_ERR_NONE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_GW_Dispatch()
+*
+* Description : Submits the next request waiting for a master channel, unless the channel carries one already.
+*
+* Argument(s) : pch          Is a pointer to the master channel.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_GW_Done(),
+*               MB_GW_Rx().
+*
+* Note(s)     : (1) The request taken is the oldest of the first client after the one served last, in the
+*                   order of the connections (see this file's Note #3).  The server task and the master task
+*                   may both dispatch, the entry is made active in the same critical section that checks
+*                   the channel is idle.
+*
+*               (2) The master channel accepts the request unless its own queue is full, e.g. with requests
+*                   of the application.  The request is then answered with an exception and the next one is
+*                   tried.
+*********************************************************************************************************
+*/
+
+static  void  MB_GW_Dispatch (MODBUS_CH  *pch)
+{
+    MB_GW_ENTRY     *pentry;
+    MB_GW_ENTRY     *pentry_next;
+    MODBUS_MBM_REQ  *preq;
+    CPU_INT16U       i;
+    CPU_INT08U       dist;
+    CPU_INT08U       dist_next;
+    CPU_INT08U       conn_last;
+    CPU_INT16U       err;
+    CPU_SR           cpu_sr;
+
+
+    do {
+        pentry_next = (MB_GW_ENTRY *)0;                         /* See Note #1                                        */
+        dist_next   = 0;
+        CPU_CRITICAL_ENTER();
+        conn_last   = MB_GW_ConnLast[pch->Ch];
+        pentry      = &MB_GW_Tbl[0];
+        for (i = 0; i < MODBUS_CFG_GW_Q_SIZE; i++) {
+            if (pentry->ChPtr == pch) {
+                if (pentry->State == MB_GW_STATE_ACTIVE) {      /* Channel busy                                       */
+                    pentry_next = (MB_GW_ENTRY *)0;
+                    break;
+                }
+                if (pentry->State == MB_GW_STATE_PEND) {
+                    dist = (CPU_INT08U)((CPU_INT08U)pentry->ConnId - conn_last - 1);
+                    if ((pentry_next == (MB_GW_ENTRY *)0) ||
+                        (dist        <  dist_next)            ||
+                        ((dist == dist_next) && ((CPU_INT32S)(pentry->Seq - pentry_next->Seq) < 0))) {
+                        pentry_next = pentry;
+                        dist_next   = dist;
+                    }
+                }
+            }
+            pentry++;
+        }
+        if (pentry_next == (MB_GW_ENTRY *)0) {
+            CPU_CRITICAL_EXIT();
+            return;
+        }
+        pentry_next->State      = MB_GW_STATE_ACTIVE;
+        MB_GW_ConnLast[pch->Ch] = (CPU_INT08U)pentry_next->ConnId;
+        CPU_CRITICAL_EXIT();
+
+        preq            = &pentry_next->Req;
+        MBM_ReqInit(preq);
+        preq->SlaveAddr = pentry_next->Frame[MB_GW_HDR_SIZE - 1];
+        preq->FC        = MODBUS_MBM_FC_PDU;
+        preq->Prio      = MODBUS_MBM_PRIO_NORMAL;
+        preq->StartAddr = 0;
+        preq->NbrPoints = pentry_next->FrameLen - MB_GW_HDR_SIZE;
+        preq->Val       = MB_GW_PDU_SIZE;
+        preq->DataPtr   = (void *)&pentry_next->Frame[MB_GW_HDR_SIZE];
+        preq->Callback  = MB_GW_Done;
+        preq->ArgPtr    = (void *)pentry_next;
+        err = MBM_ReqSubmit(pch, preq);
+        if (err != MODBUS_ERR_NONE) {                           /* See Note #2                                        */
+            MB_GW_Reply(pentry_next, MODBUS_ERR_GW_PATH);
+        }
+    } while (err != MODBUS_ERR_NONE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_GW_Done()
+*
+* Description : Returns the reply to a forwarded request and dispatches the next request of the channel.
+*
+* Argument(s) : preq         Is a pointer to the master request of the entry.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_ReqDone(), from the master task serving the channel.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  MB_GW_Done (MODBUS_MBM_REQ  *preq)
+{
+    MB_GW_ENTRY  *pentry;
+    MODBUS_CH    *pch;
+
+
+    pentry = (MB_GW_ENTRY *)preq->ArgPtr;
+    pch    = pentry->ChPtr;
+    if (preq->Err == MODBUS_ERR_NONE) {
+        MB_GW_Reply(pentry, MODBUS_ERR_NONE);
+    } else {
+        MB_GW_Reply(pentry, MODBUS_ERR_GW_TARGET);
+    }
+    MB_GW_Dispatch(pch);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_GW_Reply()
+*
+* Description : Sends the reply to a request and to the identical reads that followed it, and frees their
+*               entries.
+*
+* Argument(s) : pentry       Is a pointer to the entry of the request.
+*
+*               except       Is MODBUS_ERR_NONE to send the reply of the slave, found in .Frame[], or the code
+*                            of the exception response to send instead.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_GW_Dispatch(),
+*               MB_GW_Done().
+*
+* Note(s)     : (1) Once out of MB_GW_STATE_PEND and MB_GW_STATE_ACTIVE, no request can follow this one, the
+*                   list of followers is stable.
+*
+*               (2) Each reply carries the transaction identifier and the unit identifier of its request,
+*                   still in the MBAP header of .Frame[].
+*********************************************************************************************************
+*/
+
+static  void  MB_GW_Reply (MB_GW_ENTRY  *pentry,
+                           CPU_INT08U    except)
+{
+    MB_GW_ENTRY  *pentry_follow;
+    MB_GW_ENTRY  *pentry_next;
+    CPU_INT08U   *ppdu;
+    CPU_INT16U    pdu_len;
+    CPU_INT16U    len;
+    CPU_SR        cpu_sr;
+
+
+    CPU_CRITICAL_ENTER();
+    pentry->State = MB_GW_STATE_REPLY;                          /* See Note #1                                        */
+    CPU_CRITICAL_EXIT();
+
+    ppdu = &pentry->Frame[MB_GW_HDR_SIZE];
+    if (except == MODBUS_ERR_NONE) {
+        pdu_len = pentry->Req.NbrPoints;
+    } else {
+        ppdu[0] = pentry->FC | 0x80;
+        ppdu[1] = except;
+        pdu_len = 2;
+    }
+
+    pentry_follow = pentry;
+    while (pentry_follow != (MB_GW_ENTRY *)0) {
+        if (pentry_follow != pentry) {
+            memcpy(&pentry_follow->Frame[MB_GW_HDR_SIZE], ppdu, pdu_len);
+        }
+        len                     = pdu_len + 1;                  /* See Note #2                                        */
+        pentry_follow->Frame[4] = (CPU_INT08U)(len >> 8);
+        pentry_follow->Frame[5] = (CPU_INT08U)(len & 0x00FF);
+        MB_TCP_ConnReply(pentry_follow->ConnId,
+                         &pentry_follow->Frame[0],
+                         MB_GW_HDR_SIZE + pdu_len);
+        pentry_follow = pentry_follow->FollowPtr;
+    }
+
+    pentry_follow = pentry;                                     /* Free the entries                                   */
+    CPU_CRITICAL_ENTER();
+    while (pentry_follow != (MB_GW_ENTRY *)0) {
+        pentry_next              = pentry_follow->FollowPtr;
+        pentry_follow->FollowPtr = (MB_GW_ENTRY *)0;
+        pentry_follow->ChPtr     = (MODBUS_CH *)0;
+        pentry_follow->State     = MB_GW_STATE_FREE;
+        pentry_follow            = pentry_next;
+    }
+    CPU_CRITICAL_EXIT();
+}
+
+#endif
@@ -0,0 +1,765 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                 uC/MODBUS SLAVE TURNAROUND HISTOGRAMS
+*
+* Filename : mb_hist.c
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) A slave channel timestamps each request three times :
+*
+*                (a) At the end of its reception: expiry of the RTU timer (MB_RTU_TmrUpdate()), LF of an
+*                    ASCII frame (MB_ASCII_RxByte()), or frame taken from its socket by the Modbus/TCP
+*                    server task.
+*
+*                (b) At the start of its processing, in MBS_FCxx_Handler().
+*
+*                (c) When its reply is handed to MB_Tx(), or queued on its connection for Modbus/TCP.
+*
+*                (a) to (b) is the time the request waits for the Rx task (MODBUS_HIST_WAIT), (b) to (c)
+*                the time spent processing it (MODBUS_HIST_PROC) and (a) to (c) the turnaround seen by the
+*                master, transmission times excluded (MODBUS_HIST_TURN, kept per function code).  Requests
+*                left unanswered (broadcasts, other node addresses) only count in MODBUS_HIST_WAIT.
+*
+*            (2) Bucket 0 counts the samples under 1 us, bucket n those from 2^(n-1) to 2^n - 1 us and the
+*                last bucket those of 2^(MODBUS_HIST_BUCKET_NBR - 2) us (262 ms) or more.  Counters stop
+*                at 0xFFFFFFFF.
+*
+*            (3) Timestamps are read with MB_OS_TS_Get(), a free running microsecond counter.  Its
+*                resolution depends on the port, down to the kernel tick, samples shorter than that may
+*                land in bucket 0.
+*
+*            (4) The histograms of a channel are updated by the task serving it, within a critical section
+*                so that MB_HistGet() returns a consistent copy.
+*
+*            (5) With MODBUS_CFG_HIST_REG_EN, the MODBUS_HIST_REG_NBR input registers starting at
+*                MODBUS_CFG_HIST_REG_START hold the histograms of the channel the request is received on:
+*                MODBUS_HIST_WAIT, MODBUS_HIST_PROC, then MODBUS_HIST_TURN for each function code in the
+*                order of MB_HistFcTbl[].  Each takes MB_HIST_REG_PER_HIST registers: the bucket counters,
+*                then .Max, as 32-bit values with the most significant register first.
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                             INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define   MB_HIST_MODULE
+#include "mb.h"
+
+#if (MODBUS_CFG_HIST_EN == DEF_ENABLED)
+
+#ifdef   RT_USING_FINSH
+#include <rtthread.h>
+#include <finsh.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  MB_HIST_STATE_IDLE                         0           /* No request in progress                             */
+#define  MB_HIST_STATE_RX                           1           /* Request received, .HistRxTs valid                  */
+#define  MB_HIST_STATE_FC                           2           /* Request being processed, .HistFcTs valid           */
+
+#define  MB_HIST_REG_PER_HIST   (2 * (MODBUS_HIST_BUCKET_NBR + 1))  /* Registers per histogram (see Note #5)          */
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+                                                                /* Function codes with a MODBUS_HIST_TURN histogram   */
+static  CPU_INT08U  const  MB_HistFcTbl[MODBUS_HIST_FC_NBR - 1] = {
+    MODBUS_FC01_COIL_RD,
+    MODBUS_FC02_DI_RD,
+    MODBUS_FC03_HOLDING_REG_RD,
+    MODBUS_FC04_IN_REG_RD,
+    MODBUS_FC05_COIL_WR,
+    MODBUS_FC06_HOLDING_REG_WR,
+    MODBUS_FC08_LOOPBACK,
+    MODBUS_FC15_COIL_WR_MULTIPLE,
+    MODBUS_FC16_HOLDING_REG_WR_MULTIPLE,
+    MODBUS_FC20_FILE_RD,
+    MODBUS_FC21_FILE_WR
+};
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U  MB_HistFcIx (CPU_INT08U    fc);
+
+static  void        MB_HistAdd  (MODBUS_HIST  *phist,
+                                 CPU_INT32U    us);
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+#if (MODBUS_HIST_REG_NBR != (2 + MODBUS_HIST_FC_NBR) * MB_HIST_REG_PER_HIST)
+#error  "MODBUS_HIST_REG_NBR                     doesn't match the histograms of a channel              "
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                             MB_HistGet()
+*
+* Description : This function copies a turnaround histogram of a slave channel.
+*
+* Argument(s) : pch          is a pointer to the Modbus channel.
+*
+*               hist         selects the histogram:
+*                            MODBUS_HIST_WAIT     end of reception to start of processing
+*                            MODBUS_HIST_PROC     start of processing to reply handed to MB_Tx()
+*                            MODBUS_HIST_TURN     end of reception to reply handed to MB_Tx()
+*
+*               fc           is the function code of the MODBUS_HIST_TURN histogram, 0 for all function codes
+*                            together.  Function codes without a histogram of their own share one.
+*
+*               phist        is a pointer to where the histogram will be copied.
+*
+* Return(s)   : MODBUS_ERR_NONE       the histogram was copied
+*               MODBUS_ERR_NULLPTR    'pch' or 'phist' is a NULL pointer
+*               MODBUS_ERR_RANGE      'hist' is invalid
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MB_HistGet (MODBUS_CH    *pch,
+                        CPU_INT08U    hist,
+                        CPU_INT08U    fc,
+                        MODBUS_HIST  *phist)
+{
+    MODBUS_HIST  *psrc;
+    MODBUS_HIST   tmp;
+    CPU_INT08U    fc_ix;
+    CPU_INT08U    ix;
+    CPU_SR_ALLOC();
+
+
+    if ((pch   == (MODBUS_CH   *)0) ||
+        (phist == (MODBUS_HIST *)0)) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+    switch (hist) {
+        case MODBUS_HIST_WAIT:
+             psrc = &pch->HistWait;
+             break;
+
+        case MODBUS_HIST_PROC:
+             psrc = &pch->HistProc;
+             break;
+
+        case MODBUS_HIST_TURN:
+             if (fc != 0) {
+                 psrc = &pch->HistTurnTbl[MB_HistFcIx(fc)];
+             } else {
+                 psrc = (MODBUS_HIST *)0;
+             }
+             break;
+
+        default:
+             return (MODBUS_ERR_RANGE);
+    }
+
+    if (psrc != (MODBUS_HIST *)0) {
+        CPU_CRITICAL_ENTER();
+        *phist = *psrc;
+        CPU_CRITICAL_EXIT();
+        return (MODBUS_ERR_NONE);
+    }
+
+    for (ix = 0; ix < MODBUS_HIST_BUCKET_NBR; ix++) {           /* Sum the histograms of all function codes           */
+        phist->BucketTbl[ix] = 0;
+    }
+    phist->Max = 0;
+    for (fc_ix = 0; fc_ix < MODBUS_HIST_FC_NBR; fc_ix++) {
+        CPU_CRITICAL_ENTER();                                   /* One at a time, not to mask interrupts for long     */
+        tmp = pch->HistTurnTbl[fc_ix];
+        CPU_CRITICAL_EXIT();
+        for (ix = 0; ix < MODBUS_HIST_BUCKET_NBR; ix++) {
+            phist->BucketTbl[ix] += tmp.BucketTbl[ix];
+        }
+        if (tmp.Max > phist->Max) {
+            phist->Max = tmp.Max;
+        }
+    }
+    return (MODBUS_ERR_NONE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                             MB_HistClr()
+*
+* Description : This function clears the turnaround histograms of a slave channel.
+*
+* Argument(s) : pch          is a pointer to the Modbus channel.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_HistClr (MODBUS_CH  *pch)
+{
+    MODBUS_HIST  *phist;
+    CPU_INT08U    hist_ix;
+    CPU_INT08U    ix;
+    CPU_SR_ALLOC();
+
+
+    if (pch == (MODBUS_CH *)0) {
+        return;
+    }
+    for (hist_ix = 0; hist_ix < 2 + MODBUS_HIST_FC_NBR; hist_ix++) {
+        switch (hist_ix) {
+            case 0:
+                 phist = &pch->HistWait;
+                 break;
+
+            case 1:
+                 phist = &pch->HistProc;
+                 break;
+
+            default:
+                 phist = &pch->HistTurnTbl[hist_ix - 2];
+                 break;
+        }
+        CPU_CRITICAL_ENTER();
+        for (ix = 0; ix < MODBUS_HIST_BUCKET_NBR; ix++) {
+            phist->BucketTbl[ix] = 0;
+        }
+        phist->Max = 0;
+        CPU_CRITICAL_EXIT();
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_HistPctGet()
+*
+* Description : This function returns a percentile of the samples of a histogram.
+*
+* Argument(s) : phist        is a pointer to the histogram, as returned by MB_HistGet().
+*
+*               pct          is the percentile to find, 1 to 100.
+*
+* Return(s)   : The upper bound of the bucket holding the percentile, in us, at most the longest sample.
+*               0 if the histogram is empty.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_INT32U  MB_HistPctGet (MODBUS_HIST  *phist,
+                           CPU_INT08U    pct)
+{
+    CPU_INT64U  nbr;
+    CPU_INT64U  rank;
+    CPU_INT64U  sum;
+    CPU_INT08U  ix;
+    CPU_INT32U  bound;
+
+
+    if (phist == (MODBUS_HIST *)0) {
+        return (0);
+    }
+    if (pct > 100) {
+        pct = 100;
+    }
+    nbr = 0;
+    for (ix = 0; ix < MODBUS_HIST_BUCKET_NBR; ix++) {
+        nbr += phist->BucketTbl[ix];
+    }
+    if (nbr == 0) {
+        return (0);
+    }
+    rank = (nbr * pct + 99) / 100;                              /* Rank of the sample, 1 to 'nbr'                     */
+    if (rank == 0) {
+        rank = 1;
+    }
+    sum  = 0;
+    for (ix = 0; ix < MODBUS_HIST_BUCKET_NBR - 1; ix++) {
+        sum += phist->BucketTbl[ix];
+        if (sum >= rank) {
+            break;
+        }
+    }
+    bound = ((CPU_INT32U)1 << ix) - 1;                          /* See Note #2                                        */
+    if ((ix    == MODBUS_HIST_BUCKET_NBR - 1) ||
+        (bound >  phist->Max)) {
+        bound = phist->Max;
+    }
+    return (bound);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_HistFcGet()
+*
+* Description : This function returns the function code of a MODBUS_HIST_TURN histogram.
+*
+* Argument(s) : fc_ix        is the index of the histogram, 0 to MODBUS_HIST_FC_NBR - 1.
+*
+* Return(s)   : The function code, 0 for the histogram shared by the other function codes.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) The histograms are also read as input registers in this order (see Note #5 at the top
+*                   of the file).
+*********************************************************************************************************
+*/
+
+CPU_INT08U  MB_HistFcGet (CPU_INT08U  fc_ix)
+{
+    if (fc_ix >= MODBUS_HIST_FC_NBR - 1) {
+        return (0);
+    }
+    return (MB_HistFcTbl[fc_ix]);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_HistRxEnd()
+*
+* Description : This function timestamps the end of reception of a request.
+*
+* Argument(s) : pch          is a pointer to the Modbus channel.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_ASCII_RxByte(),
+*               MB_RTU_TmrUpdate(),
+*               MB_TCP_ConnRx(),
+*               MB_TCP_DgramRx().
+*
+* Note(s)     : (1) Called from the receive ISR for a serial channel.
+*********************************************************************************************************
+*/
+
+void  MB_HistRxEnd (MODBUS_CH  *pch)
+{
+    if (pch->MasterSlave == MODBUS_SLAVE) {
+        pch->HistRxTs  = MB_OS_TS_Get();
+        pch->HistState = MB_HIST_STATE_RX;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_HistFcStart()
+*
+* Description : This function timestamps the start of the processing of a request and records the time it
+*               waited for the Rx task.
+*
+* Argument(s) : pch          is a pointer to the Modbus channel.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBS_FCxx_Handler().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_HistFcStart (MODBUS_CH  *pch)
+{
+    CPU_INT32U  ts;
+
+
+    if (pch->HistState == MB_HIST_STATE_IDLE) {                 /* Reception not timestamped                          */
+        return;
+    }
+    ts = MB_OS_TS_Get();
+    MB_HistAdd(&pch->HistWait, ts - pch->HistRxTs);
+    pch->HistFcTs  = ts;
+    pch->HistFcIx  = MB_HistFcIx(pch->RxFrameData[1]);
+    pch->HistState = MB_HIST_STATE_FC;
+}
+
+
+/*
+*********************************************************************************************************
+*                                              MB_HistTx()
+*
+* Description : This function timestamps the reply to a request and records the processing and turnaround
+*               times.
+*
+* Argument(s) : pch          is a pointer to the Modbus channel.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_ASCII_Tx(),
+*               MB_RTU_Tx(),
+*               MB_TCP_Tx().
+*
+* Note(s)     : (1) Called for master channels too, whose state stays MB_HIST_STATE_IDLE.
+*********************************************************************************************************
+*/
+
+void  MB_HistTx (MODBUS_CH  *pch)
+{
+    CPU_INT32U  ts;
+
+
+    if (pch->HistState != MB_HIST_STATE_FC) {                   /* See Note #1                                        */
+        return;
+    }
+    ts = MB_OS_TS_Get();
+    MB_HistAdd(&pch->HistProc, ts - pch->HistFcTs);
+    MB_HistAdd(&pch->HistTurnTbl[pch->HistFcIx], ts - pch->HistRxTs);
+    pch->HistState = MB_HIST_STATE_IDLE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_HistRdFrame()
+*
+* Description : This function copies histogram registers into a response frame, most significant byte
+*               first.
+*
+* Argument(s) : pch          is a pointer to the Modbus channel the request was received on.
+*
+*               reg          is the number of the first register to read.
+*
+*               pdest        is a pointer to where the register values will be copied (2 bytes per register).
+*
+*               nbr_regs     is the number of registers to read.
+*
+* Return(s)   : MODBUS_ERR_NONE       the registers were copied
+*               MODBUS_ERR_RANGE      the registers are not all histogram registers
+*
+* Caller(s)   : MBS_FC04_InRegRd().
+*
+* Note(s)     : (1) The histograms are updated by the task calling this function (see Note #4 at the top of
+*                   the file), they don't change while being copied.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_HIST_REG_EN == DEF_ENABLED)
+CPU_INT16U  MB_HistRdFrame (MODBUS_CH   *pch,
+                            CPU_INT16U   reg,
+                            CPU_INT08U  *pdest,
+                            CPU_INT16U   nbr_regs)
+{
+    MODBUS_HIST  *phist;
+    CPU_INT16U    off;
+    CPU_INT16U    hist_ix;
+    CPU_INT16U    word;
+    CPU_INT32U    val;
+
+
+    if ((reg < MODBUS_CFG_HIST_REG_START) ||
+        ((CPU_INT32U)reg + nbr_regs > (CPU_INT32U)MODBUS_CFG_HIST_REG_START + MODBUS_HIST_REG_NBR)) {
+        return (MODBUS_ERR_RANGE);
+    }
+
+    off = reg - MODBUS_CFG_HIST_REG_START;
+    while (nbr_regs > 0) {
+        hist_ix = off / MB_HIST_REG_PER_HIST;                   /* See Note #5 at the top of the file                 */
+        word    = off % MB_HIST_REG_PER_HIST;
+        switch (hist_ix) {
+            case 0:
+                 phist = &pch->HistWait;
+                 break;
+
+            case 1:
+                 phist = &pch->HistProc;
+                 break;
+
+            default:
+                 phist = &pch->HistTurnTbl[hist_ix - 2];
+                 break;
+        }
+        if ((word / 2) < MODBUS_HIST_BUCKET_NBR) {
+            val = phist->BucketTbl[word / 2];
+        } else {
+            val = phist->Max;
+        }
+        if ((word & 1) == 0) {                                  /* Most significant register first                    */
+            val >>= 16;
+        }
+        *pdest++ = (CPU_INT08U)((val >> 8) & 0x00FF);
+        *pdest++ = (CPU_INT08U)(val & 0x00FF);
+        off++;
+        nbr_regs--;
+    }
+    return (MODBUS_ERR_NONE);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MB_HistFcIx()
+*
+* Description : This function finds the MODBUS_HIST_TURN histogram of a function code.
+*
+* Argument(s) : fc           is the function code.
+*
+* Return(s)   : The index of the histogram in .HistTurnTbl[].
+*
+* Caller(s)   : MB_HistGet(),
+*               MB_HistFcStart().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U  MB_HistFcIx (CPU_INT08U  fc)
+{
+    CPU_INT08U  ix;
+
+
+    for (ix = 0; ix < MODBUS_HIST_FC_NBR - 1; ix++) {
+        if (MB_HistFcTbl[ix] == fc) {
+            break;
+        }
+    }
+    return (ix);                                                /* MODBUS_HIST_FC_NBR - 1 for the other FCs           */
+}
+
+
+/*
+*********************************************************************************************************
+*                                             MB_HistAdd()
+*
+* Description : This function records a sample in a histogram.
+*
+* Argument(s) : phist        is a pointer to the histogram.
+*
+*               us           is the sample, in microseconds.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_HistFcStart(),
+*               MB_HistTx().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  MB_HistAdd (MODBUS_HIST  *phist,
+                          CPU_INT32U    us)
+{
+    CPU_INT08U  ix;
+    CPU_INT32U  val;
+    CPU_SR_ALLOC();
+
+
+    ix  = 0;                                                    /* Bucket = nbr of significant bits (see Note #2)     */
+    val = us;
+    while ((val != 0) &&
+           (ix  <  MODBUS_HIST_BUCKET_NBR - 1)) {
+        val >>= 1;
+        ix++;
+    }
+    CPU_CRITICAL_ENTER();                                       /* See Note #4                                        */
+    if (phist->BucketTbl[ix] != 0xFFFFFFFFu) {
+        phist->BucketTbl[ix]++;
+    }
+    if (us > phist->Max) {
+        phist->Max = us;
+    }
+    CPU_CRITICAL_EXIT();
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_HistCmdPrint()
+*
+* Description : This function prints a line of the 'mb_hist' shell command.
+*
+* Argument(s) : name         is the name of the histogram.
+*
+*               phist        is a pointer to the histogram.
+*
+*               buckets      is DEF_TRUE to also print the non-empty buckets.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_HistCmd().
+*
+* Note(s)     : (1) Empty histograms aren't printed.  Percentiles are bucket upper bounds (see
+*                   MB_HistPctGet()).
+*********************************************************************************************************
+*/
+
+#ifdef   RT_USING_FINSH
+static  void  MB_HistCmdPrint (const char   *name,
+                               MODBUS_HIST  *phist,
+                               CPU_BOOLEAN   buckets)
+{
+    CPU_INT32U  nbr;
+    CPU_INT08U  ix;
+
+
+    nbr = 0;
+    for (ix = 0; ix < MODBUS_HIST_BUCKET_NBR; ix++) {
+        nbr += phist->BucketTbl[ix];
+    }
+    if (nbr == 0) {                                             /* See Note #1                                        */
+        return;
+    }
+    rt_kprintf("  %-6s %10lu %10lu %10lu %10lu\n",
+               name,
+               (unsigned long)nbr,
+               (unsigned long)MB_HistPctGet(phist, 50),
+               (unsigned long)MB_HistPctGet(phist, 99),
+               (unsigned long)phist->Max);
+    if (buckets == DEF_TRUE) {
+        for (ix = 0; ix < MODBUS_HIST_BUCKET_NBR; ix++) {
+            if (phist->BucketTbl[ix] == 0) {
+                continue;
+            }
+            if (ix < MODBUS_HIST_BUCKET_NBR - 1) {
+                rt_kprintf("          < %7lu %10lu\n",
+                           (unsigned long)1 << ix,
+                           (unsigned long)phist->BucketTbl[ix]);
+            } else {
+                rt_kprintf("         >= %7lu %10lu\n",
+                           (unsigned long)1 << (ix - 1),
+                           (unsigned long)phist->BucketTbl[ix]);
+            }
+        }
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                             MB_HistCmd()
+*
+* Description : RT-Thread shell command printing the turnaround histograms of the slave channels, in us:
+*
+*                   mb_hist               Summary of all slave channels
+*                   mb_hist <ch>          Summary and non-empty buckets of channel <ch>
+*                   mb_hist clr [<ch>]    Clear the histograms of all slave channels or of channel <ch>
+*
+* Argument(s) : argc         is the number of arguments.
+*
+*               argv         is the table of arguments.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : RT-Thread shell.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#ifdef   RT_USING_FINSH
+static  void  MB_HistCmd (int    argc,
+                          char **argv)
+{
+    MODBUS_CH    *pch;
+    MODBUS_HIST   hist;
+    CPU_BOOLEAN   clr;
+    CPU_BOOLEAN   buckets;
+    int           ch;
+    int           ix;
+    CPU_INT08U    fc_ix;
+    CPU_INT08U    fc;
+    char          name[8];
+    CPU_SR_ALLOC();
+
+
+    clr     = DEF_FALSE;
+    buckets = DEF_FALSE;
+    ch      = -1;
+    for (ix = 1; ix < argc; ix++) {
+        if (strcmp(argv[ix], "clr") == 0) {
+            clr     = DEF_TRUE;
+        } else {
+            ch      = atoi(argv[ix]);
+            buckets = DEF_TRUE;
+        }
+    }
+    if (ch >= (int)MB_ChCtr) {
+        rt_kprintf("usage: mb_hist [clr] [ch], ch 0 to %d\n", (int)MB_ChCtr - 1);
+        return;
+    }
+
+    for (pch = &MB_ChTbl[0]; pch < &MB_ChTbl[MB_ChCtr]; pch++) {
+        if ((pch->MasterSlave != MODBUS_SLAVE) ||
+            ((ch >= 0) && (pch->Ch != (CPU_INT08U)ch))) {
+            continue;
+        }
+        if (clr == DEF_TRUE) {
+            MB_HistClr(pch);
+            continue;
+        }
+        rt_kprintf("ch %-5u        nbr        p50        p99        max\n", (unsigned)pch->Ch);
+        (void)MB_HistGet(pch, MODBUS_HIST_WAIT, 0, &hist);
+        MB_HistCmdPrint("wait", &hist, buckets);
+        (void)MB_HistGet(pch, MODBUS_HIST_PROC, 0, &hist);
+        MB_HistCmdPrint("proc", &hist, buckets);
+        (void)MB_HistGet(pch, MODBUS_HIST_TURN, 0, &hist);
+        MB_HistCmdPrint("turn", &hist, buckets);
+        for (fc_ix = 0; fc_ix < MODBUS_HIST_FC_NBR; fc_ix++) {
+            fc = MB_HistFcGet(fc_ix);
+            if (fc != 0) {
+                rt_snprintf(name, sizeof(name), "FC%02u", (unsigned)fc);
+            } else {
+                rt_snprintf(name, sizeof(name), "FC??");
+            }
+            CPU_CRITICAL_ENTER();
+            hist = pch->HistTurnTbl[fc_ix];
+            CPU_CRITICAL_EXIT();
+            MB_HistCmdPrint(name, &hist, buckets);
+        }
+    }
+}
+MSH_CMD_EXPORT_ALIAS(MB_HistCmd, mb_hist, Modbus slave turnaround histograms);
+#endif
+
+#endif
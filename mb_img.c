@@ -0,0 +1,433 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                     uC/MODBUS REGISTER IMAGES
+*
+* Filename : mb_img.c
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) A register image is a table of 16-bit registers owned by the application and published
+*                through a sequence lock :
+*
+*                (a) The writer makes .Seq odd, updates the registers and makes .Seq even again.
+*
+*                (b) A reader copies the registers and retries when .Seq was odd or changed while copying.
+*
+*                Readers never mask interrupts and a group of registers updated between MB_ImgWrBegin()
+*                and MB_ImgWrEnd() (e.g. both halves of a 32-bit value) is always seen as a whole.
+*
+*            (2) Only ONE writer may update a given image at a time.  Several tasks updating the same image
+*                MUST serialize their updates (e.g. with a mutex).
+*
+*            (3) A writer preempted by the Modbus task in the middle of an update makes the snapshot fail
+*                after MODBUS_CFG_IMG_RETRY_MAX attempts, the request is then answered with a 'Slave Device
+*                Busy' exception.  Updates should be kept short, or be done from a task with a higher
+*                priority than the Modbus Rx task.
+*
+*            (4) MB_IMG_BARRIER() orders the accesses to .Seq and to the registers.  It defaults to a full
+*                memory barrier with GCC compatible compilers, and otherwise relies on the 'volatile'
+*                accesses, which is sufficient on single core processors.  It can be overridden in
+*                mb_cfg.h.
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                             INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define   MB_IMG_MODULE
+#include "mb.h"
+
+#if (MODBUS_CFG_IMG_EN == DEF_ENABLED)
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#ifndef  MB_IMG_BARRIER                                         /* See Note #4.                                       */
+#if defined(__GNUC__)
+#define  MB_IMG_BARRIER()                __sync_synchronize()
+#else
+#define  MB_IMG_BARRIER()
+#endif
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  CPU_INT16U  MB_ImgSnapshot (MODBUS_IMG  *pimg,
+                                    CPU_INT16U   reg,
+                                    CPU_INT16U  *pval_tbl,
+                                    CPU_INT08U  *pdest,
+                                    CPU_INT16U   nbr_regs);
+
+
+/*
+*********************************************************************************************************
+*                                             MB_ImgInit()
+*
+* Description : This function initializes a register image.
+*
+* Argument(s) : pimg         is a pointer to the register image to initialize.
+*
+*               start_addr   is the number of the first register held by the image.
+*
+*               preg_tbl     is a pointer to the application's storage for the register values.
+*
+*               nbr_regs     is the number of registers held by the image.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) The image must be initialized before it is attached to a channel.
+*********************************************************************************************************
+*/
+
+void  MB_ImgInit (MODBUS_IMG  *pimg,
+                  CPU_INT16U   start_addr,
+                  CPU_INT16U  *preg_tbl,
+                  CPU_INT16U   nbr_regs)
+{
+    if (pimg != (MODBUS_IMG *)0) {
+        pimg->Seq       = 0;
+        pimg->StartAddr = start_addr;
+        pimg->NbrRegs   = nbr_regs;
+        pimg->RegTbl    = preg_tbl;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_ImgWrBegin()
+*
+* Description : This function is called before the application updates registers of an image.
+*
+* Argument(s) : pimg         is a pointer to the register image.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : Application,
+*               MB_ImgRegWrN().
+*
+* Note(s)     : (1) Between MB_ImgWrBegin() and MB_ImgWrEnd(), the application writes the new values directly
+*                   in .RegTbl[].
+*********************************************************************************************************
+*/
+
+void  MB_ImgWrBegin (MODBUS_IMG  *pimg)
+{
+    pimg->Seq++;                                                /* Sequence becomes odd: update in progress           */
+    MB_IMG_BARRIER();
+}
+
+
+/*
+*********************************************************************************************************
+*                                             MB_ImgWrEnd()
+*
+* Description : This function is called once the application has updated registers of an image.
+*
+* Argument(s) : pimg         is a pointer to the register image.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : Application,
+*               MB_ImgRegWrN().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_ImgWrEnd (MODBUS_IMG  *pimg)
+{
+    MB_IMG_BARRIER();
+    pimg->Seq++;                                                /* Sequence becomes even: registers are consistent    */
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_ImgRegWrN()
+*
+* Description : This function updates a block of registers of an image as a whole.
+*
+* Argument(s) : pimg         is a pointer to the register image.
+*
+*               reg          is the number of the first register to update.
+*
+*               pval_tbl     is a pointer to the new register values.
+*
+*               nbr_regs     is the number of registers to update.
+*
+* Return(s)   : MODBUS_ERR_NONE       the registers were updated
+*               MODBUS_ERR_NULLPTR    'pimg' or 'pval_tbl' is a NULL pointer
+*               MODBUS_ERR_RANGE      the registers are not all held by the image
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MB_ImgRegWrN (MODBUS_IMG  *pimg,
+                          CPU_INT16U   reg,
+                          CPU_INT16U  *pval_tbl,
+                          CPU_INT16U   nbr_regs)
+{
+    volatile  CPU_INT16U  *preg;
+
+
+    if ((pimg     == (MODBUS_IMG *)0) ||
+        (pval_tbl == (CPU_INT16U *)0)) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+    if ((reg < pimg->StartAddr) ||
+        ((CPU_INT32U)reg + nbr_regs > (CPU_INT32U)pimg->StartAddr + pimg->NbrRegs)) {
+        return (MODBUS_ERR_RANGE);
+    }
+
+    preg = &pimg->RegTbl[reg - pimg->StartAddr];
+    MB_ImgWrBegin(pimg);
+    while (nbr_regs > 0) {
+        *preg++ = *pval_tbl++;
+        nbr_regs--;
+    }
+    MB_ImgWrEnd(pimg);
+    return (MODBUS_ERR_NONE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                              MB_ImgRd()
+*
+* Description : This function copies a consistent snapshot of registers held by an image.
+*
+* Argument(s) : pimg         is a pointer to the register image.
+*
+*               reg          is the number of the first register to read.
+*
+*               pval_tbl     is a pointer to where the register values will be copied.
+*
+*               nbr_regs     is the number of registers to read.
+*
+* Return(s)   : MODBUS_ERR_NONE       the registers were copied
+*               MODBUS_ERR_NULLPTR    'pimg' or 'pval_tbl' is a NULL pointer
+*               MODBUS_ERR_RANGE      the registers are not all held by the image
+*               MODBUS_ERR_BUSY       the image kept being updated (see Note #3 at the top of the file)
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MB_ImgRd (MODBUS_IMG  *pimg,
+                      CPU_INT16U   reg,
+                      CPU_INT16U  *pval_tbl,
+                      CPU_INT16U   nbr_regs)
+{
+    if (pval_tbl == (CPU_INT16U *)0) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+    return (MB_ImgSnapshot(pimg, reg, pval_tbl, (CPU_INT08U *)0, nbr_regs));
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_ImgRdFrame()
+*
+* Description : This function copies a consistent snapshot of registers held by an image into a response
+*               frame, most significant byte first.
+*
+* Argument(s) : pimg         is a pointer to the register image.
+*
+*               reg          is the number of the first register to read.
+*
+*               pdest        is a pointer to where the register values will be copied (2 bytes per register).
+*
+*               nbr_regs     is the number of registers to read.
+*
+* Return(s)   : MODBUS_ERR_NONE       the registers were copied
+*               MODBUS_ERR_NULLPTR    'pimg' is a NULL pointer
+*               MODBUS_ERR_RANGE      the registers are not all held by the image
+*               MODBUS_ERR_BUSY       the image kept being updated (see Note #3 at the top of the file)
+*
+* Caller(s)   : MBS_FC03_HoldingRegRd(),
+*               MBS_FC04_InRegRd().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MB_ImgRdFrame (MODBUS_IMG  *pimg,
+                           CPU_INT16U   reg,
+                           CPU_INT08U  *pdest,
+                           CPU_INT16U   nbr_regs)
+{
+    return (MB_ImgSnapshot(pimg, reg, (CPU_INT16U *)0, pdest, nbr_regs));
+}
+
+
+/*
+*********************************************************************************************************
+*                                         MB_HoldingRegImgSet()
+*
+* Description : This function attaches a holding register image to a channel.
+*
+* Argument(s) : pch          is a pointer to the Modbus channel.
+*
+*               pimg         is a pointer to the register image, or NULL to detach the current image.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) FC03 requests for registers not all held by the image, or reaching
+*                   MODBUS_CFG_FP_START_IX, are still processed through MB_HoldingRegRd() and
+*                   MB_HoldingRegRdFP().
+*
+*               (2) When MODBUS_CFG_MULTI_ADDR_EN is DEF_ENABLED, this image serves the default data model,
+*                   other data models provide their own image in their .HoldingRegImgPtr.
+*********************************************************************************************************
+*/
+
+void  MB_HoldingRegImgSet (MODBUS_CH   *pch,
+                           MODBUS_IMG  *pimg)
+{
+    if (pch != (MODBUS_CH *)0) {
+        pch->HoldingRegImgPtr = pimg;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_InRegImgSet()
+*
+* Description : This function attaches an input register image to a channel.
+*
+* Argument(s) : pch          is a pointer to the Modbus channel.
+*
+*               pimg         is a pointer to the register image, or NULL to detach the current image.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) FC04 requests for registers not all held by the image, or reaching
+*                   MODBUS_CFG_FP_START_IX, are still processed through MB_InRegRd() and MB_InRegRdFP().
+*
+*               (2) When MODBUS_CFG_MULTI_ADDR_EN is DEF_ENABLED, this image serves the default data model,
+*                   other data models provide their own image in their .InRegImgPtr.
+*********************************************************************************************************
+*/
+
+void  MB_InRegImgSet (MODBUS_CH   *pch,
+                      MODBUS_IMG  *pimg)
+{
+    if (pch != (MODBUS_CH *)0) {
+        pch->InRegImgPtr = pimg;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_ImgSnapshot()
+*
+* Description : This function copies registers of an image, retrying until the copy is consistent.
+*
+* Argument(s) : pimg         is a pointer to the register image.
+*
+*               reg          is the number of the first register to read.
+*
+*               pval_tbl     is a pointer to where the register values will be copied, or NULL.
+*
+*               pdest        is a pointer to where the register values will be copied MSB first, used when
+*                            'pval_tbl' is NULL.
+*
+*               nbr_regs     is the number of registers to read.
+*
+* Return(s)   : MODBUS_ERR_NONE, MODBUS_ERR_NULLPTR, MODBUS_ERR_RANGE or MODBUS_ERR_BUSY.
+*
+* Caller(s)   : MB_ImgRd(),
+*               MB_ImgRdFrame().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_INT16U  MB_ImgSnapshot (MODBUS_IMG  *pimg,
+                                    CPU_INT16U   reg,
+                                    CPU_INT16U  *pval_tbl,
+                                    CPU_INT08U  *pdest,
+                                    CPU_INT16U   nbr_regs)
+{
+    volatile  CPU_INT16U  *preg;
+    CPU_INT32U             seq;
+    CPU_INT16U             val;
+    CPU_INT16U             ix;
+    CPU_INT16U             retry;
+
+
+    if (pimg == (MODBUS_IMG *)0) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+    if ((reg < pimg->StartAddr) ||
+        ((CPU_INT32U)reg + nbr_regs > (CPU_INT32U)pimg->StartAddr + pimg->NbrRegs)) {
+        return (MODBUS_ERR_RANGE);
+    }
+
+    for (retry = 0; retry < MODBUS_CFG_IMG_RETRY_MAX; retry++) {
+        seq = pimg->Seq;
+        if ((seq & 1) != 0) {                                   /* Update in progress, try again                      */
+            continue;
+        }
+        MB_IMG_BARRIER();
+        preg = &pimg->RegTbl[reg - pimg->StartAddr];
+        for (ix = 0; ix < nbr_regs; ix++) {
+            val = *preg++;
+            if (pval_tbl != (CPU_INT16U *)0) {
+                pval_tbl[ix]       = val;
+            } else {
+                pdest[ix * 2]      = (CPU_INT08U)((val >> 8) & 0x00FF);
+                pdest[ix * 2 + 1]  = (CPU_INT08U)(val & 0x00FF);
+            }
+        }
+        MB_IMG_BARRIER();
+        if (pimg->Seq == seq) {                                 /* Registers unchanged while copying?                 */
+            return (MODBUS_ERR_NONE);
+        }
+    }
+    return (MODBUS_ERR_BUSY);
+}
+
+#endif
@@ -17,7 +17,7 @@
 /*
 *********************************************************************************************************
 *
-*                                   MODBUS uC/OS-III LAYER INTERFACE
+*                                      MODBUS RTOS LAYER INTERFACE
 *
 * Filename : mb_os.h
 * Version  : V2.14.00
@@ -41,9 +41,15 @@
 *********************************************************************************************************
 */
 
-#include <os.h>
+#include "mb_cpu.h"
 #include "mb_cfg.h"
 
+#if (MB_OS_CFG_PORT == MB_OS_PORT_UCOS3)
+#include <os.h>
+#elif (MB_OS_CFG_PORT == MB_OS_PORT_RTTHREAD)
+#include <rtthread.h>
+#endif
+
 /*
 *********************************************************************************************************
 *                                               EXTERNS
@@ -98,9 +104,19 @@
 *********************************************************************************************************
 */
 
+#if      (MB_OS_CFG_PORT != MB_OS_PORT_UCOS3)    && \
+         (MB_OS_CFG_PORT != MB_OS_PORT_RTTHREAD) && \
+         (MB_OS_CFG_PORT != MB_OS_PORT_POSIX)
+#error  "MODBUS MB_OS_CFG_PORT illegally #define'd in 'mb_cpu.h'."
+#error  "... [MUST be MB_OS_PORT_UCOS3, MB_OS_PORT_RTTHREAD or MB_OS_PORT_POSIX]."
+#endif
+
+
+#if      (MB_OS_CFG_PORT == MB_OS_PORT_UCOS3)
 #if      (OS_CFG_Q_EN == 0)
 #error  "MODBUS Slave requires uC/OS-III Message Queue Services."
 #endif
+#endif
 
 
 #ifndef  MB_OS_CFG_RX_TASK_PRIO
@@ -113,11 +129,70 @@
 #endif
 
 
+#ifndef  MB_OS_CFG_RX_TASK_NBR
+#error  "MODBUS Missing number of Rx Tasks MB_OS_CFG_RX_TASK_NBR."
+#elif   (MB_OS_CFG_RX_TASK_NBR < 1) || \
+        (MB_OS_CFG_RX_TASK_NBR > MODBUS_CFG_MAX_CH)
+#error  "MODBUS MB_OS_CFG_RX_TASK_NBR must be 1 to MODBUS_CFG_MAX_CH."
+#endif
+
+
+#if      (MODBUS_CFG_MBM_REQ_EN  == DEF_ENABLED)
+#ifndef  MB_OS_CFG_MBM_TASK_NBR
+#error  "MODBUS Missing number of master request tasks MB_OS_CFG_MBM_TASK_NBR."
+#elif   (MB_OS_CFG_MBM_TASK_NBR < 1) || \
+        (MB_OS_CFG_MBM_TASK_NBR > MODBUS_CFG_MAX_CH)
+#error  "MODBUS MB_OS_CFG_MBM_TASK_NBR must be 1 to MODBUS_CFG_MAX_CH."
+#endif
+#endif
+
+
+#if      (MODBUS_CFG_TCP_EN    == DEF_ENABLED) && \
+         (MODBUS_CFG_SLAVE_EN  == DEF_ENABLED)
+#ifndef  MB_OS_CFG_TCP_TASK_PRIO
+#error  "MODBUS Missing Modbus/TCP server task's MB_OS_CFG_TCP_TASK_PRIO."
+#endif
+#ifndef  MB_OS_CFG_TCP_TASK_STK_SIZE
+#error  "MODBUS Missing Modbus/TCP server task's MB_OS_CFG_TCP_TASK_STK_SIZE."
+#endif
+#endif
+
+
+#if      (MB_OS_CFG_PORT       == MB_OS_PORT_UCOS3)
 #if      (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
 #if      (OS_CFG_SEM_EN        == 0          )
 #error  "MODBUS Master requires uC/OS-III Semaphore Services."
 #error  "... It needs at least MODBUS_CFG_MAX_CH semaphores."
 #endif
+#if      (OS_CFG_MUTEX_EN      == 0          )
+#error  "MODBUS Master requires uC/OS-III Mutex Services."
+#error  "... It needs at least MODBUS_CFG_MAX_CH mutexes."
+#endif
+#endif
+#endif
+
+
+#if      (MB_OS_CFG_PORT       == MB_OS_PORT_RTTHREAD)
+#if      (MODBUS_CFG_SLAVE_EN  == DEF_ENABLED)
+#ifndef  RT_USING_MAILBOX
+#error  "MODBUS Slave requires RT-Thread Mailbox Services (RT_USING_MAILBOX)."
+#endif
+#endif
+
+#if      (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+#ifndef  RT_USING_SEMAPHORE
+#error  "MODBUS Master requires RT-Thread Semaphore Services (RT_USING_SEMAPHORE)."
+#endif
+#ifndef  RT_USING_MUTEX
+#error  "MODBUS Master requires RT-Thread Mutex Services (RT_USING_MUTEX)."
+#endif
+#endif
+
+#if      (MODBUS_CFG_TCP_EN    == DEF_ENABLED)
+#ifndef  RT_USING_SAL
+#error  "MODBUS/TCP requires the RT-Thread socket abstraction layer (RT_USING_SAL)."
+#endif
+#endif
 #endif
 
 
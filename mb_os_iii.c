@@ -34,6 +34,8 @@
 #define   MB_OS_MODULE
 #include "mb.h"
 
+#if (MB_OS_CFG_PORT == MB_OS_PORT_UCOS3)
+
 
 /*
 *********************************************************************************************************
@@ -71,11 +73,29 @@
 
 #if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
 static  OS_SEM     MB_OS_RxSemTbl[MODBUS_CFG_MAX_CH];
+static  OS_MUTEX   MB_OS_ChMutexTbl[MODBUS_CFG_MAX_CH];
 #endif
 
 #if (MODBUS_CFG_SLAVE_EN  == DEF_ENABLED)
-static  OS_TCB     MB_OS_RxTaskTCB;
-static  CPU_STK    MB_OS_RxTaskStk[MB_OS_CFG_RX_TASK_STK_SIZE];
+static  OS_TCB     MB_OS_RxTaskTCB[MB_OS_CFG_RX_TASK_NBR];
+static  CPU_STK    MB_OS_RxTaskStk[MB_OS_CFG_RX_TASK_NBR][MB_OS_CFG_RX_TASK_STK_SIZE];
+#endif
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+static  OS_TCB     MB_OS_MBM_TaskTCB[MB_OS_CFG_MBM_TASK_NBR];
+static  CPU_STK    MB_OS_MBM_TaskStk[MB_OS_CFG_MBM_TASK_NBR][MB_OS_CFG_MBM_TASK_STK_SIZE];
+static  OS_SEM     MB_OS_MBM_ReqSemTbl[MB_OS_CFG_MBM_TASK_NBR];
+static  OS_SEM     MB_OS_MBM_DoneSem;
+#endif
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  OS_TCB     MB_OS_TCP_TaskTCB;
+static  CPU_STK    MB_OS_TCP_TaskStk[MB_OS_CFG_TCP_TASK_STK_SIZE];
+#endif
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+static  OS_MUTEX   MB_OS_TCP_Mutex;                           /* Guards the TCP client connections     */
 #endif
 
 
@@ -96,6 +116,19 @@ static  void  MB_OS_ExitSlave (void);
 static  void  MB_OS_RxTask    (void  *p_arg);
 #endif
 
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+static  void  MB_OS_InitMBM   (void);
+static  void  MB_OS_ExitMBM   (void);
+static  void  MB_OS_MBM_Task  (void  *p_arg);
+#endif
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_InitTCP   (void);
+static  void  MB_OS_ExitTCP   (void);
+static  void  MB_OS_TCP_Task  (void  *p_arg);
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -112,7 +145,11 @@ static  void  MB_OS_RxTask    (void  *p_arg);
 *
 *               (1) A message queue to signal the reception of a packet.
 *
-*               (2) A task that waits for packets to be received.
+*               (2) MB_OS_CFG_RX_TASK_NBR tasks that wait for packets to be received.
+*
+*               (3) MB_OS_CFG_MBM_TASK_NBR tasks that execute asynchronous master requests.
+*
+*               (4) The Modbus/TCP server task serving the slave channels in MODBUS_MODE_TCP.
 *
 * Argument(s) : none
 *
@@ -133,6 +170,15 @@ void  MB_OS_Init (void)
 #if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
     MB_OS_InitSlave();
 #endif
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+    MB_OS_InitMBM();
+#endif
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    MB_OS_InitTCP();
+#endif
 }
 
 
@@ -140,7 +186,9 @@ void  MB_OS_Init (void)
 *********************************************************************************************************
 *                                          MB_OS_InitMaster()
 *
-* Description : This function initializes and creates the kernel objectes needed for Modbus Master
+* Description : This function initializes and creates the kernel objectes needed for Modbus Master: a
+*               semaphore signaling the reception of a reply and a mutex serializing the transactions, for
+*               each channel.
 *
 * Argument(s) : none.
 *
@@ -164,6 +212,9 @@ static  void  MB_OS_InitMaster (void)
                     (CPU_CHAR *)"uC/Modbus Rx Sem",
                     0,
                     &err);
+        OSMutexCreate(&MB_OS_ChMutexTbl[i],                   /* ... and a mutex                       */
+                      (CPU_CHAR *)"uC/Modbus Ch Mutex",
+                      &err);
     }
 }
 #endif
@@ -181,25 +232,130 @@ static  void  MB_OS_InitMaster (void)
 *
 * Caller(s)   : MB_OS_Init().
 *
-* Note(s)     : none.
+* Note(s)     : (1) Each slave channel is served by Rx task (.Ch % MB_OS_CFG_RX_TASK_NBR), so a slow data
+*                   access on one channel doesn't delay the replies on channels served by other Rx tasks.
+*                   All Rx tasks start at MB_OS_CFG_RX_TASK_PRIO, see MB_OS_RxTaskPrioSet().
 *********************************************************************************************************
 */
 
 #if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
 static  void  MB_OS_InitSlave (void)
+{
+    CPU_INT08U  i;
+    OS_ERR      err;
+
+
+    for (i = 0; i < MB_OS_CFG_RX_TASK_NBR; i++) {             /* Create the Rx tasks (see Note #1)     */
+        OSTaskCreate(&MB_OS_RxTaskTCB[i],
+                     (CPU_CHAR   *)"Modbus Rx Task",
+                      MB_OS_RxTask,
+                     (void       *)0,
+                      MB_OS_CFG_RX_TASK_PRIO,
+                     &MB_OS_RxTaskStk[i][0],
+                      MB_OS_CFG_RX_TASK_STK_SIZE / 10,
+                      MB_OS_CFG_RX_TASK_STK_SIZE,
+                      MODBUS_CFG_MAX_CH,
+                      0,
+                      (void      *)0,
+                      (OS_OPT_TASK_STK_CHK | OS_OPT_TASK_STK_CLR),
+                      &err);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_InitMBM()
+*
+* Description : This function creates the master tasks executing asynchronous master requests, a semaphore
+*               per master task counting the requests submitted to it, and the completion queue semaphore.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Init().
+*
+* Note(s)     : (1) Each master channel is served by master task (.Ch % MB_OS_CFG_MBM_TASK_NBR).
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+static  void  MB_OS_InitMBM (void)
+{
+    CPU_INT08U  i;
+    OS_ERR      err;
+
+
+    OSSemCreate(&MB_OS_MBM_DoneSem,
+                (CPU_CHAR *)"uC/Modbus Done Sem",
+                0,
+                &err);
+
+    for (i = 0; i < MB_OS_CFG_MBM_TASK_NBR; i++) {            /* Create the master tasks (see Note #1) */
+        OSSemCreate(&MB_OS_MBM_ReqSemTbl[i],
+                    (CPU_CHAR *)"uC/Modbus Req Sem",
+                    0,
+                    &err);
+
+        OSTaskCreate(&MB_OS_MBM_TaskTCB[i],
+                     (CPU_CHAR   *)"Modbus Master Task",
+                      MB_OS_MBM_Task,
+                     (void       *)(CPU_ADDR)i,
+                      MB_OS_CFG_MBM_TASK_PRIO,
+                     &MB_OS_MBM_TaskStk[i][0],
+                      MB_OS_CFG_MBM_TASK_STK_SIZE / 10,
+                      MB_OS_CFG_MBM_TASK_STK_SIZE,
+                      0,
+                      0,
+                      (void      *)0,
+                      (OS_OPT_TASK_STK_CHK | OS_OPT_TASK_STK_CLR),
+                      &err);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_InitTCP()
+*
+* Description : This function creates the Modbus/TCP server task and, with the gateway, the mutex guarding
+*               the client connections.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Init().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_InitTCP (void)
 {
     OS_ERR  err;
 
 
-    OSTaskCreate(&MB_OS_RxTaskTCB,
-                 (CPU_CHAR   *)"Modbus Rx Task",
-                  MB_OS_RxTask,
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+    OSMutexCreate(&MB_OS_TCP_Mutex,
+                  (CPU_CHAR *)"uC/Modbus TCP Mutex",
+                  &err);
+#endif
+
+    OSTaskCreate(&MB_OS_TCP_TaskTCB,
+                 (CPU_CHAR   *)"Modbus TCP Server Task",
+                  MB_OS_TCP_Task,
                  (void       *)0,
-                  MB_OS_CFG_RX_TASK_PRIO,
-                 &MB_OS_RxTaskStk[0],
-                  MB_OS_CFG_RX_TASK_STK_SIZE / 10,
-                  MB_OS_CFG_RX_TASK_STK_SIZE,
-                  MODBUS_CFG_MAX_CH,
+                  MB_OS_CFG_TCP_TASK_PRIO,
+                 &MB_OS_TCP_TaskStk[0],
+                  MB_OS_CFG_TCP_TASK_STK_SIZE / 10,
+                  MB_OS_CFG_TCP_TASK_STK_SIZE,
+                  0,
                   0,
                   (void      *)0,
                   (OS_OPT_TASK_STK_CHK | OS_OPT_TASK_STK_CLR),
@@ -237,6 +393,15 @@ void  MB_OS_Exit (void)
 #if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
     MB_OS_ExitSlave();
 #endif
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+    MB_OS_ExitMBM();
+#endif
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    MB_OS_ExitTCP();
+#endif
 }
 
 
@@ -270,6 +435,9 @@ static  void  MB_OS_ExitMaster (void)
         OSSemDel(&MB_OS_RxSemTbl[i],
                   OS_OPT_DEL_ALWAYS,
                  &err);
+        OSMutexDel(&MB_OS_ChMutexTbl[i],                      /* ... and its mutex                     */
+                    OS_OPT_DEL_ALWAYS,
+                   &err);
     }
 }
 #endif
@@ -282,8 +450,8 @@ static  void  MB_OS_ExitMaster (void)
 * Description : This function is called to terminate the RTOS interface for Modbus Salve channels.
 *               The following objects are deleted.
 *
-*               (1) A task that waits for packets to be received.
-*               (2) A message queue to signal the reception of a packet.
+*               (1) The tasks that wait for packets to be received.
+*               (2) Their message queues used to signal the reception of a packet.
 *
 * Argument(s) : none
 *
@@ -296,14 +464,88 @@ static  void  MB_OS_ExitMaster (void)
 */
 
 #if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
-void  MB_OS_ExitSlave (void)
+static  void  MB_OS_ExitSlave (void)
+{
+    CPU_INT08U  i;
+    OS_ERR      err;
+
+
+    for (i = 0; i < MB_OS_CFG_RX_TASK_NBR; i++) {
+        OSTaskDel(&MB_OS_RxTaskTCB[i],                        /* Delete Modbus Rx Tasks                */
+                  &err);
+    }
+    (void)err;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_ExitMBM()
+*
+* Description : This function deletes the master tasks and the semaphores created by MB_OS_InitMBM().
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Exit().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+static  void  MB_OS_ExitMBM (void)
+{
+    CPU_INT08U  i;
+    OS_ERR      err;
+
+
+    for (i = 0; i < MB_OS_CFG_MBM_TASK_NBR; i++) {
+        OSTaskDel(&MB_OS_MBM_TaskTCB[i],                      /* Delete master tasks ...               */
+                  &err);
+        OSSemDel(&MB_OS_MBM_ReqSemTbl[i],                     /* ... and their semaphores              */
+                  OS_OPT_DEL_ALWAYS,
+                 &err);
+    }
+    OSSemDel(&MB_OS_MBM_DoneSem,
+              OS_OPT_DEL_ALWAYS,
+             &err);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_ExitTCP()
+*
+* Description : This function deletes the Modbus/TCP server task and its mutex, if any.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Exit().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_ExitTCP (void)
 {
     OS_ERR  err;
 
 
-    OSTaskDel(&MB_OS_RxTaskTCB,                               /* Delete Modbus Rx Task                 */
+    OSTaskDel(&MB_OS_TCP_TaskTCB,
               &err);
-    (void)err;
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+    OSMutexDel(&MB_OS_TCP_Mutex,
+                OS_OPT_DEL_ALWAYS,
+               &err);
+#endif
 }
 #endif
 
@@ -344,7 +586,7 @@ void  MB_OS_RxSignal (MODBUS_CH *pch)
 #if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
             case MODBUS_SLAVE:
             default:
-                 (void)OSTaskQPost(&MB_OS_RxTaskTCB,
+                 (void)OSTaskQPost(&MB_OS_RxTaskTCB[pch->Ch % MB_OS_CFG_RX_TASK_NBR],
                                     pch,
                                     sizeof(void *),
                                     OS_OPT_POST_FIFO,
@@ -390,7 +632,7 @@ void  MB_OS_RxWait (MODBUS_CH   *pch,
     if (pch != (MODBUS_CH *)0) {
         if (pch->MasterSlave == MODBUS_MASTER) {
             OSSemPend(&MB_OS_RxSemTbl[pch->Ch],
-                      pch->RxTimeout,
+                      pch->RxTimeoutCur,
                       OS_OPT_PEND_BLOCKING,
                       &ts,
                       &err);
@@ -425,12 +667,270 @@ void  MB_OS_RxWait (MODBUS_CH   *pch,
 #endif
 }
 
+
+/*
+*********************************************************************************************************
+*                                            MB_OS_ChLock()
+*
+* Description : This function gives the calling task exclusive use of a master channel, waiting for the
+*               transaction in progress on the channel (if any) to complete.
+*
+* Argument(s) : pch     specifies the Modbus channel.
+*
+*               perr    is a pointer to a variable that will receive an error code.  Possible errors are:
+*
+*                       MODBUS_ERR_NONE        the channel is locked by the caller
+*                       MODBUS_ERR_NULLPTR     'pch' is a NULL pointer
+*                       MODBUS_ERR_INVALID     an invalid error was detected
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_FCxx()  Modbus Master Functions,
+*               MBM_Bulkxxx().
+*
+* Note(s)     : (1) The lock may be nested by the task that owns the channel, each call must be matched by a
+*                   call to MB_OS_ChUnlock().
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+void  MB_OS_ChLock (MODBUS_CH   *pch,
+                    CPU_INT16U  *perr)
+{
+    OS_ERR  err;
+    CPU_TS  ts;
+
+
+    if (pch == (MODBUS_CH *)0) {
+        *perr = MODBUS_ERR_NULLPTR;
+        return;
+    }
+
+    OSMutexPend(&MB_OS_ChMutexTbl[pch->Ch],
+                 0,
+                 OS_OPT_PEND_BLOCKING,
+                &ts,
+                &err);
+    if ((err == OS_ERR_NONE) ||
+        (err == OS_ERR_MUTEX_OWNER)) {                        /* See Note #1                           */
+        *perr = MODBUS_ERR_NONE;
+    } else {
+        *perr = MODBUS_ERR_INVALID;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_ChUnlock()
+*
+* Description : This function releases a master channel locked by MB_OS_ChLock().
+*
+* Argument(s) : pch     specifies the Modbus channel.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_FCxx()  Modbus Master Functions
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_OS_ChUnlock (MODBUS_CH *pch)
+{
+    OS_ERR  err;
+
+
+    OSMutexPost(&MB_OS_ChMutexTbl[pch->Ch],
+                 OS_OPT_POST_NONE,
+                &err);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_TCP_Lock()
+*
+* Description : This function gives the calling task exclusive use of the Modbus/TCP client connections.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : mb_tcp.c.
+*
+* Note(s)     : (1) The server task holds the lock while it processes requests, the master tasks take it to
+*                   send the replies of the gateway (see mb_gw.c).  The lock may be nested, each call must be
+*                   matched by a call to MB_OS_TCP_Unlock().
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+void  MB_OS_TCP_Lock (void)
+{
+    OS_ERR  err;
+    CPU_TS  ts;
+
+
+    OSMutexPend(&MB_OS_TCP_Mutex,                             /* See Note #1                           */
+                 0,
+                 OS_OPT_PEND_BLOCKING,
+                &ts,
+                &err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_OS_TCP_Unlock()
+*
+* Description : This function releases the Modbus/TCP client connections locked by MB_OS_TCP_Lock().
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : mb_tcp.c.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_OS_TCP_Unlock (void)
+{
+    OS_ERR  err;
+
+
+    OSMutexPost(&MB_OS_TCP_Mutex,
+                 OS_OPT_POST_NONE,
+                &err);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MB_OS_TimeGet()
+*
+* Description : This function returns the current value of the kernel tick counter.
+*
+* Argument(s) : none.
+*
+* Return(s)   : The number of ticks elapsed since the kernel was started.
+*
+* Caller(s)   : Application,
+*               MB_InRegRd(),
+*               MB_HoldingRegRd().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_INT32U  MB_OS_TimeGet (void)
+{
+    OS_ERR  err;
+
+
+    return ((CPU_INT32U)OSTimeGet(&err));
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_OS_TickRateGet()
+*
+* Description : This function returns the frequency of the kernel tick.
+*
+* Argument(s) : none.
+*
+* Return(s)   : The number of ticks per second.
+*
+* Caller(s)   : MB_TCP_RxWait().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_INT32U  MB_OS_TickRateGet (void)
+{
+    return ((CPU_INT32U)OSCfg_TickRate_Hz);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_OS_TS_Get()
+*
+* Description : This function returns a free running timestamp in microseconds.
+*
+* Argument(s) : none.
+*
+* Return(s)   : The number of microseconds elapsed since an arbitrary origin, modulo 2^32.
+*
+* Caller(s)   : MB_HistRxEnd(),
+*               MB_HistFcStart(),
+*               MB_HistTx(),
+*               MB_TraceFrame().
+*
+* Note(s)     : (1) Derived from the kernel tick, the resolution is one tick.  Called from ISRs.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_HIST_EN  == DEF_ENABLED) || \
+    (MODBUS_CFG_TRACE_EN == DEF_ENABLED)
+CPU_INT32U  MB_OS_TS_Get (void)
+{
+    OS_ERR  err;
+
+
+    return ((CPU_INT32U)OSTimeGet(&err) * (1000000uL / (CPU_INT32U)OSCfg_TickRate_Hz));
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                         MB_OS_RxTaskPrioSet()
+*
+* Description : This function changes the priority of the Rx task serving a slave channel.
+*
+* Argument(s) : pch     specifies the Modbus channel data structure.
+*
+*               prio    is the new priority of the Rx task.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) The Rx task is shared by all the channels for which (.Ch % MB_OS_CFG_RX_TASK_NBR) is the
+*                   same.  Set MB_OS_CFG_RX_TASK_NBR to MODBUS_CFG_MAX_CH for one Rx task per channel.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+void  MB_OS_RxTaskPrioSet (MODBUS_CH   *pch,
+                           CPU_INT08U   prio)
+{
+    OS_ERR  err;
+
+
+    if (pch != (MODBUS_CH *)0) {
+        OSTaskChangePrio(&MB_OS_RxTaskTCB[pch->Ch % MB_OS_CFG_RX_TASK_NBR],
+                          (OS_PRIO)prio,
+                         &err);
+        (void)err;
+    }
+}
+#endif
+
 /*
 *********************************************************************************************************
 *                                            MB_OS_RxTask()
 *
 * Description : This task is created by MB_OS_Init() and waits for signals from either the Rx ISR(s) or
-*               the RTU timeout timer(s) to indicate that a packet needs to be processed.
+*               the RTU timeout timer(s) to indicate that a packet needs to be processed.  There is one
+*               instance of this task per group of channels (see MB_OS_InitSlave()).
 *
 * Argument(s) : p_arg       is a pointer to an optional argument that is passed by uC/OS-II to the task.
 *                           This argument is not used.
@@ -465,3 +965,180 @@ static  void  MB_OS_RxTask (void *p_arg)
 }
 #endif
 
+
+/*
+*********************************************************************************************************
+*                                        MB_OS_MBM_ReqSignal()
+*
+* Description : This function signals the master task serving a channel that a request was submitted.
+*
+* Argument(s) : pch     specifies the Modbus channel the request was submitted to.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_ReqSubmit().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+void  MB_OS_MBM_ReqSignal (MODBUS_CH *pch)
+{
+    OS_ERR  err;
+
+
+    (void)OSSemPost(&MB_OS_MBM_ReqSemTbl[pch->Ch % MB_OS_CFG_MBM_TASK_NBR],
+                    OS_OPT_POST_1,
+                    &err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                        MB_OS_MBM_DoneSignal()
+*
+* Description : This function signals that a request was posted to the completion queue.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_ReqDone().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_OS_MBM_DoneSignal (void)
+{
+    OS_ERR  err;
+
+
+    (void)OSSemPost(&MB_OS_MBM_DoneSem,
+                    OS_OPT_POST_1,
+                    &err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         MB_OS_MBM_DoneWait()
+*
+* Description : This function waits for a request to be posted to the completion queue.
+*
+* Argument(s) : timeout     is the maximum number of ticks to wait, 0 to wait forever.
+*
+*               perr        is a pointer to a variable that will receive an error code:
+*
+*                           MODBUS_ERR_NONE        a request was posted to the completion queue
+*                           MODBUS_ERR_TIMED_OUT   no request was posted within the specified timeout
+*                           MODBUS_ERR_INVALID     an invalid error was detected
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_ReqDoneWait().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_OS_MBM_DoneWait (CPU_INT32U   timeout,
+                          CPU_INT16U  *perr)
+{
+    OS_ERR  err;
+    CPU_TS  ts;
+
+
+    OSSemPend(&MB_OS_MBM_DoneSem,
+               timeout,
+               OS_OPT_PEND_BLOCKING,
+              &ts,
+              &err);
+    switch (err) {
+        case OS_ERR_NONE:
+             *perr = MODBUS_ERR_NONE;
+             break;
+
+        case OS_ERR_TIMEOUT:
+             *perr = MODBUS_ERR_TIMED_OUT;
+             break;
+
+        default:
+             *perr = MODBUS_ERR_INVALID;
+             break;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_MBM_Task()
+*
+* Description : This task is created by MB_OS_InitMBM() and executes the asynchronous master requests
+*               submitted to the channels it serves.
+*
+* Argument(s) : p_arg       is the index of the master task.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : This is a Task.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  MB_OS_MBM_Task (void *p_arg)
+{
+    CPU_INT08U  task_ix;
+    OS_ERR      err;
+    CPU_TS      ts;
+
+
+    task_ix = (CPU_INT08U)(CPU_ADDR)p_arg;
+
+    while (DEF_TRUE) {
+        OSSemPend(&MB_OS_MBM_ReqSemTbl[task_ix],            /* Wait for a request to be submitted                 */
+                   0,
+                   OS_OPT_PEND_BLOCKING,
+                  &ts,
+                  &err);
+        if (err == OS_ERR_NONE) {
+            MBM_ReqTask(task_ix);                            /* Execute it                                         */
+        }
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_TCP_Task()
+*
+* Description : This task is created by MB_OS_InitTCP() and serves the Modbus/TCP slave channels.
+*
+* Argument(s) : p_arg       is not used.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : This is a Task.
+*
+* Note(s)     : (1) MB_TCP_SrvPoll() blocks until a socket is readable, or for a short while when there are
+*                   no connections.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_TCP_Task (void *p_arg)
+{
+    (void)p_arg;
+
+    while (DEF_TRUE) {
+        MB_TCP_SrvPoll();                                    /* See Note #1                                        */
+    }
+}
+#endif
+
+#endif                                                          /* End of uC/OS-III port                              */
+
@@ -0,0 +1,1234 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                     MODBUS POSIX LAYER INTERFACE
+*
+* Filename : mb_os_posix.c
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) This port runs uC/Modbus as a process on a Linux host, with POSIX threads in place of the
+*                kernel tasks, so that the core files can be profiled and load-tested off target.  It is
+*                selected by defining PKG_USING_UC_MODBUS_OS_POSIX (see mb_cpu.h and CMakeLists.txt).
+*
+*            (2) The objects are those of the RT-Thread port: a mailbox per Rx thread, whose messages are
+*                channel pointers, and a semaphore per master channel.  A mailbox is a ring of channel
+*                pointers guarded by a mutex and a condition variable.
+*
+*            (3) The tick of MB_OS_TimeGet() is one millisecond of CLOCK_MONOTONIC.
+*
+*            (4) The threads are stopped by MB_OS_Exit(): the Rx threads by a NULL message, the other ones
+*                by clearing MB_OS_Run.  None is cancelled while it holds a lock.
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#ifndef  _GNU_SOURCE
+#define  _GNU_SOURCE                                     /* sem_clockwait()                           */
+#endif
+
+#define   MB_OS_MODULE
+#include "mb.h"
+
+#if (MB_OS_CFG_PORT == MB_OS_PORT_POSIX)
+
+#include  <pthread.h>
+#include  <semaphore.h>
+#include  <errno.h>
+#include  <time.h>
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  MB_OS_TICK_RATE_HZ                      1000u   /* See Note #3                               */
+
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 30)))
+#define  MB_OS_SEM_CLOCKWAIT_EN                          /* See MB_OS_SemWait() Note #1               */
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+typedef  struct  mb_os_mb {                              /* Mailbox of an Rx thread (see Note #2)     */
+    pthread_mutex_t   Mutex;
+    pthread_cond_t    Cond;
+    MODBUS_CH        *MsgTbl[MODBUS_CFG_MAX_CH];         /* Channels with a packet to process         */
+    CPU_INT16U        MsgIx;                             /* Oldest message                            */
+    CPU_INT16U        MsgCtr;                            /* Number of messages                        */
+} MB_OS_MB;
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+static  pthread_once_t       MB_OS_CritOnce = PTHREAD_ONCE_INIT;
+static  pthread_mutex_t      MB_OS_CritMutex;              /* See mb_cpu.h Note #3                      */
+
+static  volatile  CPU_BOOLEAN  MB_OS_Run;                  /* See Note #4                               */
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+static  sem_t                MB_OS_RxSemTbl[MODBUS_CFG_MAX_CH];
+static  pthread_mutex_t      MB_OS_ChMutexTbl[MODBUS_CFG_MAX_CH];
+#endif
+
+#if (MODBUS_CFG_SLAVE_EN  == DEF_ENABLED)
+static  pthread_t            MB_OS_RxTaskTbl[MB_OS_CFG_RX_TASK_NBR];
+static  MB_OS_MB             MB_OS_RxTaskMb[MB_OS_CFG_RX_TASK_NBR];
+#endif
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+static  pthread_t            MB_OS_MBM_TaskTbl[MB_OS_CFG_MBM_TASK_NBR];
+static  sem_t                MB_OS_MBM_ReqSemTbl[MB_OS_CFG_MBM_TASK_NBR];
+static  sem_t                MB_OS_MBM_DoneSem;
+#endif
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  pthread_t            MB_OS_TCP_TaskId;
+#endif
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+static  pthread_mutex_t      MB_OS_TCP_Mutex;              /* Guards the TCP client connections         */
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  void   MB_OS_CritInit  (void);
+static  void   MB_OS_MutexInit (pthread_mutex_t  *pmutex);
+#if (MODBUS_CFG_MASTER_EN  == DEF_ENABLED) || \
+    (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+static  void   MB_OS_SemWait   (sem_t            *psem,
+                                CPU_INT32U        timeout,
+                                CPU_INT16U       *perr);
+#endif
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+static  void   MB_OS_InitMaster(void);
+static  void   MB_OS_ExitMaster(void);
+#endif
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void   MB_OS_InitSlave (void);
+static  void   MB_OS_ExitSlave (void);
+static  void   MB_OS_MbPost    (MB_OS_MB         *pmb,
+                                MODBUS_CH        *pch);
+static  void  *MB_OS_RxTask    (void             *p_arg);
+#endif
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+static  void   MB_OS_InitMBM   (void);
+static  void   MB_OS_ExitMBM   (void);
+static  void  *MB_OS_MBM_Task  (void             *p_arg);
+#endif
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void   MB_OS_InitTCP   (void);
+static  void   MB_OS_ExitTCP   (void);
+static  void  *MB_OS_TCP_Task  (void             *p_arg);
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                              MB_OS_Init()
+*
+* Description : This function initializes the POSIX interface.  This function creates the following:
+*
+*               (1) A semaphore per channel to signal the reception of a reply by a master channel.
+*
+*               (2) MB_OS_CFG_RX_TASK_NBR threads, each with its own mailbox, that wait for packets to be
+*                   received by slave channels.
+*
+*               (3) MB_OS_CFG_MBM_TASK_NBR threads that execute asynchronous master requests.
+*
+*               (4) The Modbus/TCP server thread serving the slave channels in MODBUS_MODE_TCP.
+*
+* Argument(s) : none
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_Init().
+*
+* Note(s)     : (1) The threads get the default attributes of the process.  MB_OS_CFG_xxx_STK_SIZE and the
+*                   priorities are those of a target, they aren't used on a host.
+*********************************************************************************************************
+*/
+
+void  MB_OS_Init (void)
+{
+    MB_OS_Run = DEF_TRUE;
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+    MB_OS_InitMaster();
+#endif
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    MB_OS_InitSlave();
+#endif
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+    MB_OS_InitMBM();
+#endif
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    MB_OS_InitTCP();
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_OS_InitMaster()
+*
+* Description : This function initializes the objects needed for Modbus Master: a semaphore signaling the
+*               reception of a reply and a mutex serializing the transactions, for each channel.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Init().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+static  void  MB_OS_InitMaster (void)
+{
+    CPU_INT08U  i;
+
+
+    for (i = 0; i < MODBUS_CFG_MAX_CH; i++) {            /* Create a semaphore for each channel       */
+        (void)sem_init(&MB_OS_RxSemTbl[i], 0, 0);
+        MB_OS_MutexInit(&MB_OS_ChMutexTbl[i]);           /* ... and a mutex                           */
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          MB_OS_InitSlave()
+*
+* Description : This function initializes the objects needed for Modbus Slave.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Init().
+*
+* Note(s)     : (1) Each slave channel is served by Rx thread (.Ch % MB_OS_CFG_RX_TASK_NBR).
+*
+*               (2) A mailbox holds up to MODBUS_CFG_MAX_CH pending channels, as in the RT-Thread port.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_InitSlave (void)
+{
+    CPU_INT08U   i;
+    MB_OS_MB    *pmb;
+
+
+    for (i = 0; i < MB_OS_CFG_RX_TASK_NBR; i++) {        /* Create the Rx threads (see Note #1)       */
+        pmb         = &MB_OS_RxTaskMb[i];
+        pmb->MsgIx  = 0;                                 /* See Note #2                               */
+        pmb->MsgCtr = 0;
+        (void)pthread_mutex_init(&pmb->Mutex, (pthread_mutexattr_t *)0);
+        (void)pthread_cond_init(&pmb->Cond, (pthread_condattr_t *)0);
+
+        (void)pthread_create(&MB_OS_RxTaskTbl[i],
+                             (pthread_attr_t *)0,
+                             MB_OS_RxTask,
+                             (void *)pmb);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_InitMBM()
+*
+* Description : This function creates the master threads executing asynchronous master requests, a
+*               semaphore per master thread counting the requests submitted to it, and the completion queue
+*               semaphore.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Init().
+*
+* Note(s)     : (1) Each master channel is served by master thread (.Ch % MB_OS_CFG_MBM_TASK_NBR).
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+static  void  MB_OS_InitMBM (void)
+{
+    CPU_INT08U  i;
+
+
+    (void)sem_init(&MB_OS_MBM_DoneSem, 0, 0);
+
+    for (i = 0; i < MB_OS_CFG_MBM_TASK_NBR; i++) {       /* Create the master threads (see Note #1)   */
+        (void)sem_init(&MB_OS_MBM_ReqSemTbl[i], 0, 0);
+        (void)pthread_create(&MB_OS_MBM_TaskTbl[i],
+                             (pthread_attr_t *)0,
+                             MB_OS_MBM_Task,
+                             (void *)(CPU_ADDR)i);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_InitTCP()
+*
+* Description : This function creates the Modbus/TCP server thread and, with the gateway, the mutex guarding
+*               the client connections.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Init().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_InitTCP (void)
+{
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+    MB_OS_MutexInit(&MB_OS_TCP_Mutex);
+#endif
+    (void)pthread_create(&MB_OS_TCP_TaskId,
+                         (pthread_attr_t *)0,
+                         MB_OS_TCP_Task,
+                         (void *)0);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                             MB_OS_Exit()
+*
+* Description : This function is called to terminate the POSIX interface for Modbus channels.  The threads
+*               created by MB_OS_Init() are stopped and joined, the other objects destroyed.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_Exit().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_OS_Exit (void)
+{
+    MB_OS_Run = DEF_FALSE;                               /* See Note #4 at the top of the file        */
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    MB_OS_ExitTCP();
+#endif
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+    MB_OS_ExitMBM();
+#endif
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    MB_OS_ExitSlave();
+#endif
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+    MB_OS_ExitMaster();
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_OS_ExitMaster()
+*
+* Description : This function destroys the semaphores and mutexes of the Modbus Master channels.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Exit().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+static  void  MB_OS_ExitMaster (void)
+{
+    CPU_INT08U  i;
+
+
+    for (i = 0; i < MODBUS_CFG_MAX_CH; i++) {            /* Destroy semaphore for each channel        */
+        (void)sem_destroy(&MB_OS_RxSemTbl[i]);
+        (void)pthread_mutex_destroy(&MB_OS_ChMutexTbl[i]);   /* ... and its mutex                     */
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          MB_OS_ExitSlave()
+*
+* Description : This function stops the Rx threads of the Modbus Slave channels and destroys their
+*               mailboxes.
+*
+* Argument(s) : none
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Exit().
+*
+* Note(s)     : (1) The NULL message is queued behind the packets pending, which are processed first.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_ExitSlave (void)
+{
+    CPU_INT08U  i;
+
+
+    for (i = 0; i < MB_OS_CFG_RX_TASK_NBR; i++) {
+        MB_OS_MbPost(&MB_OS_RxTaskMb[i], (MODBUS_CH *)0);    /* See Note #1                           */
+        (void)pthread_join(MB_OS_RxTaskTbl[i], (void **)0);  /* Stop Modbus Rx threads ...            */
+        (void)pthread_cond_destroy(&MB_OS_RxTaskMb[i].Cond); /* ... and destroy their mailboxes       */
+        (void)pthread_mutex_destroy(&MB_OS_RxTaskMb[i].Mutex);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_ExitMBM()
+*
+* Description : This function stops the master threads and destroys the semaphores created by
+*               MB_OS_InitMBM().
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Exit().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+static  void  MB_OS_ExitMBM (void)
+{
+    CPU_INT08U  i;
+
+
+    for (i = 0; i < MB_OS_CFG_MBM_TASK_NBR; i++) {
+        (void)sem_post(&MB_OS_MBM_ReqSemTbl[i]);             /* Wake up the master threads ...        */
+        (void)pthread_join(MB_OS_MBM_TaskTbl[i], (void **)0);
+        (void)sem_destroy(&MB_OS_MBM_ReqSemTbl[i]);          /* ... and destroy their semaphores      */
+    }
+    (void)sem_destroy(&MB_OS_MBM_DoneSem);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_ExitTCP()
+*
+* Description : This function stops the Modbus/TCP server thread and destroys its mutex, if any.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Exit().
+*
+* Note(s)     : (1) The server thread sees MB_OS_Run cleared within MB_TCP_SRV_POLL_MS (see mb_tcp.c).
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_ExitTCP (void)
+{
+    (void)pthread_join(MB_OS_TCP_TaskId, (void **)0);    /* See Note #1                               */
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+    (void)pthread_mutex_destroy(&MB_OS_TCP_Mutex);
+#endif
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                              MB_OS_RxSignal()
+*
+* Description : This function signals the reception of a packet either from the Rx thread of a serial port
+*               or the RTU timeout timer to indicate that a received packet needs to be processed.
+*
+* Argument(s) : pch     specifies the Modbus channel data structure in which a packet was received.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_ASCII_RxByte(),
+*               MB_RTU_TmrUpdate().
+*
+* Note(s)     : (1) sem_post() and MB_OS_MbPost() don't block on a full queue, as from an ISR.
+*********************************************************************************************************
+*/
+
+void  MB_OS_RxSignal (MODBUS_CH *pch)
+{
+    if (pch != (MODBUS_CH *)0) {
+        switch (pch->MasterSlave) {
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+            case MODBUS_MASTER:
+                 (void)sem_post(&MB_OS_RxSemTbl[pch->Ch]);
+                 break;
+#endif
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+            case MODBUS_SLAVE:
+            default:
+                 MB_OS_MbPost(&MB_OS_RxTaskMb[pch->Ch % MB_OS_CFG_RX_TASK_NBR], pch);
+                 break;
+#endif
+        }
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                              MB_OS_RxWait()
+*
+* Description : This function waits for a response from a slave.
+*
+* Argument(s) : pch     specifies the Modbus channel data structure to wait on.
+*
+*               perr    is a pointer to a variable that will receive an error code.  Possible errors are:
+*
+*                       MODBUS_ERR_NONE        the call was successful and a packet was received
+*                       MODBUS_ERR_TIMED_OUT   a packet was not received within the specified timeout
+*                       MODBUS_ERR_NOT_MASTER  the channel is not a Master
+*                       MODBUS_ERR_INVALID     an invalid error was detected
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_FCxx()  Modbus Master Functions
+*
+* Note(s)     : (1) As with uC/OS-III, a timeout of 0 waits forever.
+*********************************************************************************************************
+*/
+
+void  MB_OS_RxWait (MODBUS_CH   *pch,
+                    CPU_INT16U  *perr)
+{
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+    if (pch != (MODBUS_CH *)0) {
+        if (pch->MasterSlave == MODBUS_MASTER) {
+            MB_OS_SemWait(&MB_OS_RxSemTbl[pch->Ch],      /* See Note #1                               */
+                          pch->RxTimeoutCur,
+                          perr);
+        } else {
+            *perr = MODBUS_ERR_NOT_MASTER;
+        }
+    } else {
+        *perr = MODBUS_ERR_NULLPTR;
+    }
+#else
+    *perr = MODBUS_ERR_INVALID;
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_OS_ChLock()
+*
+* Description : This function gives the calling thread exclusive use of a master channel, waiting for the
+*               transaction in progress on the channel (if any) to complete.
+*
+* Argument(s) : pch     specifies the Modbus channel.
+*
+*               perr    is a pointer to a variable that will receive an error code.  Possible errors are:
+*
+*                       MODBUS_ERR_NONE        the channel is locked by the caller
+*                       MODBUS_ERR_NULLPTR     'pch' is a NULL pointer
+*                       MODBUS_ERR_INVALID     an invalid error was detected
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_FCxx()  Modbus Master Functions,
+*               MBM_Bulkxxx().
+*
+* Note(s)     : (1) The lock may be nested by the thread that owns the channel, each call must be matched by a
+*                   call to MB_OS_ChUnlock().  The mutexes are recursive.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+void  MB_OS_ChLock (MODBUS_CH   *pch,
+                    CPU_INT16U  *perr)
+{
+    if (pch == (MODBUS_CH *)0) {
+        *perr = MODBUS_ERR_NULLPTR;
+        return;
+    }
+
+    if (pthread_mutex_lock(&MB_OS_ChMutexTbl[pch->Ch]) == 0) {
+        *perr = MODBUS_ERR_NONE;
+    } else {
+        *perr = MODBUS_ERR_INVALID;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_ChUnlock()
+*
+* Description : This function releases a master channel locked by MB_OS_ChLock().
+*
+* Argument(s) : pch     specifies the Modbus channel.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_FCxx()  Modbus Master Functions
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_OS_ChUnlock (MODBUS_CH *pch)
+{
+    (void)pthread_mutex_unlock(&MB_OS_ChMutexTbl[pch->Ch]);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_TCP_Lock()
+*
+* Description : This function gives the calling thread exclusive use of the Modbus/TCP client connections.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : mb_tcp.c.
+*
+* Note(s)     : (1) The server thread holds the lock while it processes requests, the master threads take it
+*                   to send the replies of the gateway (see mb_gw.c).  The lock may be nested, each call must
+*                   be matched by a call to MB_OS_TCP_Unlock().
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+void  MB_OS_TCP_Lock (void)
+{
+    (void)pthread_mutex_lock(&MB_OS_TCP_Mutex);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_OS_TCP_Unlock()
+*
+* Description : This function releases the Modbus/TCP client connections locked by MB_OS_TCP_Lock().
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : mb_tcp.c.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_OS_TCP_Unlock (void)
+{
+    (void)pthread_mutex_unlock(&MB_OS_TCP_Mutex);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MB_OS_TimeGet()
+*
+* Description : This function returns the current value of the tick counter.
+*
+* Argument(s) : none.
+*
+* Return(s)   : The number of ticks elapsed since an arbitrary origin (see Note #3 at the top of the file).
+*
+* Caller(s)   : Application,
+*               MB_InRegRd(),
+*               MB_HoldingRegRd().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_INT32U  MB_OS_TimeGet (void)
+{
+    struct timespec  ts;
+
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((CPU_INT32U)ts.tv_sec  * MB_OS_TICK_RATE_HZ +
+            (CPU_INT32U)ts.tv_nsec / (1000000000uL / MB_OS_TICK_RATE_HZ));
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_OS_TickRateGet()
+*
+* Description : This function returns the frequency of the tick.
+*
+* Argument(s) : none.
+*
+* Return(s)   : The number of ticks per second.
+*
+* Caller(s)   : MB_TCP_RxWait().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_INT32U  MB_OS_TickRateGet (void)
+{
+    return (MB_OS_TICK_RATE_HZ);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_OS_TS_Get()
+*
+* Description : This function returns a free running timestamp in microseconds.
+*
+* Argument(s) : none.
+*
+* Return(s)   : The number of microseconds elapsed since an arbitrary origin, modulo 2^32.
+*
+* Caller(s)   : MB_HistRxEnd(),
+*               MB_HistFcStart(),
+*               MB_HistTx(),
+*               MB_TraceFrame().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_HIST_EN  == DEF_ENABLED) || \
+    (MODBUS_CFG_TRACE_EN == DEF_ENABLED)
+CPU_INT32U  MB_OS_TS_Get (void)
+{
+    struct timespec  ts;
+
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((CPU_INT32U)ts.tv_sec  * 1000000uL +
+            (CPU_INT32U)ts.tv_nsec / 1000uL);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                         MB_OS_RxTaskPrioSet()
+*
+* Description : This function changes the priority of the Rx thread serving a slave channel.
+*
+* Argument(s) : pch     specifies the Modbus channel data structure.
+*
+*               prio    is the new priority of the Rx thread.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) The threads of a host process are scheduled with SCHED_OTHER, which has no priorities.
+*                   The call is accepted and ignored, so that an application runs unchanged on the host.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+void  MB_OS_RxTaskPrioSet (MODBUS_CH   *pch,
+                           CPU_INT08U   prio)
+{
+    (void)pch;                                           /* See Note #1                               */
+    (void)prio;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MB_OS_MbPost()
+*
+* Description : This function posts a channel to the mailbox of an Rx thread.
+*
+* Argument(s) : pmb     is a pointer to the mailbox.
+*
+*               pch     specifies the Modbus channel with a packet to process, NULL to stop the thread.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_ExitSlave(),
+*               MB_OS_RxSignal().
+*
+* Note(s)     : (1) A message posted to a full mailbox is dropped, as by rt_mb_send().
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_MbPost (MB_OS_MB   *pmb,
+                            MODBUS_CH  *pch)
+{
+    (void)pthread_mutex_lock(&pmb->Mutex);
+    if (pmb->MsgCtr < MODBUS_CFG_MAX_CH) {               /* See Note #1                               */
+        pmb->MsgTbl[(pmb->MsgIx + pmb->MsgCtr) % MODBUS_CFG_MAX_CH] = pch;
+        pmb->MsgCtr++;
+        (void)pthread_cond_signal(&pmb->Cond);
+    }
+    (void)pthread_mutex_unlock(&pmb->Mutex);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MB_OS_RxTask()
+*
+* Description : This thread is created by MB_OS_Init() and waits for signals from either the Rx thread of a
+*               serial port or the RTU timeout timer to indicate that a packet needs to be processed.  There
+*               is one instance of this thread per group of channels (see MB_OS_InitSlave()).
+*
+* Argument(s) : p_arg       is a pointer to the mailbox the thread waits on.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : This is a Task.
+*
+* Note(s)     : (1) A NULL message stops the thread (see MB_OS_ExitSlave()).
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  *MB_OS_RxTask (void *p_arg)
+{
+    MB_OS_MB   *pmb;
+    MODBUS_CH  *pch;
+
+
+    pmb = (MB_OS_MB *)p_arg;
+
+    while (DEF_TRUE) {
+        (void)pthread_mutex_lock(&pmb->Mutex);           /* Wait for a packet to be received          */
+        while (pmb->MsgCtr == 0) {
+            (void)pthread_cond_wait(&pmb->Cond, &pmb->Mutex);
+        }
+        pch         = pmb->MsgTbl[pmb->MsgIx];
+        pmb->MsgIx  = (pmb->MsgIx + 1) % MODBUS_CFG_MAX_CH;
+        pmb->MsgCtr--;
+        (void)pthread_mutex_unlock(&pmb->Mutex);
+
+        if (pch == (MODBUS_CH *)0) {                     /* See Note #1                               */
+            break;
+        }
+        MB_RxTask(pch);                                  /* Process the packet received               */
+    }
+    return ((void *)0);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        MB_OS_MBM_ReqSignal()
+*
+* Description : This function signals the master thread serving a channel that a request was submitted.
+*
+* Argument(s) : pch     specifies the Modbus channel the request was submitted to.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_ReqSubmit().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+void  MB_OS_MBM_ReqSignal (MODBUS_CH *pch)
+{
+    (void)sem_post(&MB_OS_MBM_ReqSemTbl[pch->Ch % MB_OS_CFG_MBM_TASK_NBR]);
+}
+
+
+/*
+*********************************************************************************************************
+*                                        MB_OS_MBM_DoneSignal()
+*
+* Description : This function signals that a request was posted to the completion queue.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_ReqDone().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_OS_MBM_DoneSignal (void)
+{
+    (void)sem_post(&MB_OS_MBM_DoneSem);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         MB_OS_MBM_DoneWait()
+*
+* Description : This function waits for a request to be posted to the completion queue.
+*
+* Argument(s) : timeout     is the maximum number of ticks to wait, 0 to wait forever.
+*
+*               perr        is a pointer to a variable that will receive an error code:
+*
+*                           MODBUS_ERR_NONE        a request was posted to the completion queue
+*                           MODBUS_ERR_TIMED_OUT   no request was posted within the specified timeout
+*                           MODBUS_ERR_INVALID     an invalid error was detected
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_ReqDoneWait().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_OS_MBM_DoneWait (CPU_INT32U   timeout,
+                          CPU_INT16U  *perr)
+{
+    MB_OS_SemWait(&MB_OS_MBM_DoneSem, timeout, perr);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_MBM_Task()
+*
+* Description : This thread is created by MB_OS_InitMBM() and executes the asynchronous master requests
+*               submitted to the channels it serves.
+*
+* Argument(s) : p_arg       is the index of the master thread.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : This is a Task.
+*
+* Note(s)     : (1) MB_OS_ExitMBM() clears MB_OS_Run and posts the semaphore to stop the thread.
+*********************************************************************************************************
+*/
+
+static  void  *MB_OS_MBM_Task (void *p_arg)
+{
+    CPU_INT08U  task_ix;
+
+
+    task_ix = (CPU_INT08U)(CPU_ADDR)p_arg;
+
+    while (DEF_TRUE) {
+        if (sem_wait(&MB_OS_MBM_ReqSemTbl[task_ix]) != 0) {
+            continue;                                    /* Interrupted by a signal                   */
+        }
+        if (MB_OS_Run == DEF_FALSE) {                    /* See Note #1                               */
+            break;
+        }
+        MBM_ReqTask(task_ix);                            /* Execute the request submitted             */
+    }
+    return ((void *)0);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_TCP_Task()
+*
+* Description : This thread is created by MB_OS_InitTCP() and serves the Modbus/TCP slave channels.
+*
+* Argument(s) : p_arg       is not used.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : This is a Task.
+*
+* Note(s)     : (1) MB_TCP_SrvPoll() blocks until a socket is readable, or for a short while when there are
+*                   no connections.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  *MB_OS_TCP_Task (void *p_arg)
+{
+    (void)p_arg;
+
+    while (MB_OS_Run == DEF_TRUE) {
+        MB_TCP_SrvPoll();                                /* See Note #1                               */
+    }
+    return ((void *)0);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MB_OS_SemWait()
+*
+* Description : This function waits on a semaphore for at most a number of ticks.
+*
+* Argument(s) : psem        is a pointer to the semaphore.
+*
+*               timeout     is the maximum number of ticks to wait, 0 to wait forever.
+*
+*               perr        is a pointer to a variable that will receive an error code:
+*
+*                           MODBUS_ERR_NONE        the semaphore was taken
+*                           MODBUS_ERR_TIMED_OUT   the semaphore wasn't posted within 'timeout'
+*                           MODBUS_ERR_INVALID     an invalid error was detected
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_MBM_DoneWait(),
+*               MB_OS_RxWait().
+*
+* Note(s)     : (1) The timeout is measured on CLOCK_MONOTONIC, as MB_OS_TimeGet(), so that setting the
+*                   wall clock doesn't stretch or cut short a wait.  sem_timedwait() only takes a
+*                   CLOCK_REALTIME deadline: sem_clockwait() (glibc 2.30 and later) is used instead, else
+*                   the semaphore is polled once per tick until the deadline.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN  == DEF_ENABLED) || \
+    (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+static  void  MB_OS_SemWait (sem_t       *psem,
+                             CPU_INT32U   timeout,
+                             CPU_INT16U  *perr)
+{
+    int              rtn;
+#ifdef   MB_OS_SEM_CLOCKWAIT_EN
+    struct timespec  ts;
+#else
+    CPU_INT32U       ts_start;
+    struct timespec  dly;
+#endif
+
+
+    if (timeout == 0) {
+        do {
+            rtn = sem_wait(psem);
+        } while ((rtn != 0) && (errno == EINTR));
+    } else {
+#ifdef   MB_OS_SEM_CLOCKWAIT_EN
+        (void)clock_gettime(CLOCK_MONOTONIC, &ts);       /* See Note #1                               */
+        ts.tv_sec  += (time_t)(timeout / MB_OS_TICK_RATE_HZ);
+        ts.tv_nsec += (long)((timeout % MB_OS_TICK_RATE_HZ) * (1000000000uL / MB_OS_TICK_RATE_HZ));
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        do {
+            rtn = sem_clockwait(psem, CLOCK_MONOTONIC, &ts);
+        } while ((rtn != 0) && (errno == EINTR));
+#else
+        ts_start    = MB_OS_TimeGet();                   /* See Note #1                               */
+        dly.tv_sec  = 0;
+        dly.tv_nsec = (long)(1000000000uL / MB_OS_TICK_RATE_HZ);
+        while (DEF_TRUE) {
+            rtn = sem_trywait(psem);
+            if ((rtn == 0) || (errno != EAGAIN)) {
+                break;
+            }
+            if ((MB_OS_TimeGet() - ts_start) >= timeout) {
+                errno = ETIMEDOUT;
+                break;
+            }
+            (void)nanosleep(&dly, (struct timespec *)0);
+        }
+#endif
+    }
+
+    if (rtn == 0) {
+        *perr = MODBUS_ERR_NONE;
+    } else if (errno == ETIMEDOUT) {
+        *perr = MODBUS_ERR_TIMED_OUT;
+    } else {
+        *perr = MODBUS_ERR_INVALID;
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_MutexInit()
+*
+* Description : This function initializes a recursive mutex.
+*
+* Argument(s) : pmutex      is a pointer to the mutex.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : various.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  MB_OS_MutexInit (pthread_mutex_t  *pmutex)
+{
+    pthread_mutexattr_t  attr;
+
+
+    (void)pthread_mutexattr_init(&attr);
+    (void)pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    (void)pthread_mutex_init(pmutex, &attr);
+    (void)pthread_mutexattr_destroy(&attr);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            CPU_SR_Save()
+*                                           CPU_SR_Restore()
+*
+* Description : These functions enter and exit a critical section (see mb_cpu.h Note #3).
+*
+* Argument(s) : cpu_sr      is the value returned by CPU_SR_Save(), not used.
+*
+* Return(s)   : CPU_SR_Save() returns 0.
+*
+* Caller(s)   : CPU_CRITICAL_ENTER(),
+*               CPU_CRITICAL_EXIT().
+*
+* Note(s)     : (1) The mutex is created on first use: the critical sections of the application may come
+*                   before MB_Init().
+*********************************************************************************************************
+*/
+
+CPU_SR  CPU_SR_Save (void)
+{
+    (void)pthread_once(&MB_OS_CritOnce, MB_OS_CritInit); /* See Note #1                               */
+    (void)pthread_mutex_lock(&MB_OS_CritMutex);
+    return ((CPU_SR)0);
+}
+
+
+void  CPU_SR_Restore (CPU_SR  cpu_sr)
+{
+    (void)cpu_sr;
+    (void)pthread_mutex_unlock(&MB_OS_CritMutex);
+}
+
+
+static  void  MB_OS_CritInit (void)
+{
+    MB_OS_MutexInit(&MB_OS_CritMutex);
+}
+
+#endif                                                   /* End of POSIX port                         */
@@ -0,0 +1,1125 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                   MODBUS RT-THREAD LAYER INTERFACE
+*
+* Filename : mb_os_rtthread.c
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) This port uses the RT-Thread kernel objects directly instead of going through the
+*                uC/OS-III compatibility layer.  It is selected by defining PKG_USING_UC_MODBUS_OS_RTTHREAD
+*                (see mb_cpu.h).
+*
+*            (2) Received slave packets are signaled through a mailbox rather than a message queue: the
+*                message is the channel pointer itself, which fits in a mailbox slot and is posted without
+*                copying.  Master channels use one semaphore each, as in the uC/OS-III port.
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define   MB_OS_MODULE
+#include "mb.h"
+
+#if (MB_OS_CFG_PORT == MB_OS_PORT_RTTHREAD)
+
+#if ((MODBUS_CFG_HIST_EN  == DEF_ENABLED)  || \
+     (MODBUS_CFG_TRACE_EN == DEF_ENABLED)) && \
+     defined(RT_USING_CPUTIME)
+#include <drivers/cputime.h>
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  MB_OS_RX_TASK_STK_SIZE_BYTES   (MB_OS_CFG_RX_TASK_STK_SIZE * sizeof(CPU_STK))
+#define  MB_OS_RX_TASK_TIME_SLICE                  10u   /* Time slice of the Rx tasks, in ticks               */
+
+#define  MB_OS_MBM_TASK_STK_SIZE_BYTES  (MB_OS_CFG_MBM_TASK_STK_SIZE * sizeof(CPU_STK))
+
+#define  MB_OS_TCP_TASK_STK_SIZE_BYTES  (MB_OS_CFG_TCP_TASK_STK_SIZE * sizeof(CPU_STK))
+
+#define  MB_OS_CPUTIME_MASK             (((CPU_INT64U)1 << MB_OS_CFG_CPUTIME_BITS) - 1u)
+#define  MB_OS_CPUTIME_FLUSH_US              1000000uL   /* See MB_OS_TS_Get() Note #2                 */
+
+
+/*
+*********************************************************************************************************
+*                                           LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+static  struct rt_semaphore  MB_OS_RxSemTbl[MODBUS_CFG_MAX_CH];
+static  struct rt_mutex      MB_OS_ChMutexTbl[MODBUS_CFG_MAX_CH];
+#endif
+
+#if (MODBUS_CFG_SLAVE_EN  == DEF_ENABLED)
+static  struct rt_thread     MB_OS_RxTaskTCB[MB_OS_CFG_RX_TASK_NBR];
+static  struct rt_mailbox    MB_OS_RxTaskMb[MB_OS_CFG_RX_TASK_NBR];
+static  rt_ubase_t           MB_OS_RxTaskMbPool[MB_OS_CFG_RX_TASK_NBR][MODBUS_CFG_MAX_CH];
+ALIGN(RT_ALIGN_SIZE)
+static  rt_uint8_t           MB_OS_RxTaskStk[MB_OS_CFG_RX_TASK_NBR][MB_OS_RX_TASK_STK_SIZE_BYTES];
+#endif
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+static  struct rt_thread     MB_OS_MBM_TaskTCB[MB_OS_CFG_MBM_TASK_NBR];
+static  struct rt_semaphore  MB_OS_MBM_ReqSemTbl[MB_OS_CFG_MBM_TASK_NBR];
+static  struct rt_semaphore  MB_OS_MBM_DoneSem;
+ALIGN(RT_ALIGN_SIZE)
+static  rt_uint8_t           MB_OS_MBM_TaskStk[MB_OS_CFG_MBM_TASK_NBR][MB_OS_MBM_TASK_STK_SIZE_BYTES];
+#endif
+
+#if ((MODBUS_CFG_HIST_EN  == DEF_ENABLED)  || \
+     (MODBUS_CFG_TRACE_EN == DEF_ENABLED)) && \
+     defined(RT_USING_CPUTIME)
+static  CPU_INT64U           MB_OS_TS_CpuLast;           /* Last reading of the CPU time counter       */
+static  CPU_INT64U           MB_OS_TS_CpuPend;           /* Counts not yet converted to microseconds   */
+static  CPU_INT64U           MB_OS_TS_Us;                /* Microseconds converted so far              */
+static  rt_tick_t            MB_OS_TS_TickLast;          /* Kernel tick at the last reading            */
+#endif
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  struct rt_thread     MB_OS_TCP_TaskTCB;
+ALIGN(RT_ALIGN_SIZE)
+static  rt_uint8_t           MB_OS_TCP_TaskStk[MB_OS_TCP_TASK_STK_SIZE_BYTES];
+#endif
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+static  struct rt_mutex      MB_OS_TCP_Mutex;                 /* Guards the TCP client connections     */
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+static  void  MB_OS_InitMaster(void);
+static  void  MB_OS_ExitMaster(void);
+#endif
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_InitSlave (void);
+static  void  MB_OS_ExitSlave (void);
+static  void  MB_OS_RxTask    (void  *p_arg);
+#endif
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+static  void  MB_OS_InitMBM   (void);
+static  void  MB_OS_ExitMBM   (void);
+static  void  MB_OS_MBM_Task  (void  *p_arg);
+#endif
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_InitTCP   (void);
+static  void  MB_OS_ExitTCP   (void);
+static  void  MB_OS_TCP_Task  (void  *p_arg);
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+#if ((MODBUS_CFG_HIST_EN  == DEF_ENABLED)  || \
+     (MODBUS_CFG_TRACE_EN == DEF_ENABLED)) && \
+     defined(RT_USING_CPUTIME)
+#if (MB_OS_CFG_CPUTIME_BITS < 8) || (MB_OS_CFG_CPUTIME_BITS > 63)
+#error  "MODBUS MB_OS_CFG_CPUTIME_BITS illegally #define'd in 'mb_cfg.h'."
+#error  "... [MUST be from 8 to 63]."
+#endif
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                              MB_OS_Init()
+*
+* Description : This function initializes the RTOS interface.  This function creates the following:
+*
+*               (1) A semaphore per channel to signal the reception of a reply by a master channel.
+*
+*               (2) MB_OS_CFG_RX_TASK_NBR threads, each with its own mailbox, that wait for packets to be
+*                   received by slave channels.
+*
+*               (3) MB_OS_CFG_MBM_TASK_NBR threads that execute asynchronous master requests.
+*
+*               (4) The Modbus/TCP server thread serving the slave channels in MODBUS_MODE_TCP.
+*
+* Argument(s) : none
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_Init().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_OS_Init (void)
+{
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+    MB_OS_InitMaster();
+#endif
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    MB_OS_InitSlave();
+#endif
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+    MB_OS_InitMBM();
+#endif
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    MB_OS_InitTCP();
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_OS_InitMaster()
+*
+* Description : This function initializes the kernel objects needed for Modbus Master: a semaphore
+*               signaling the reception of a reply and a mutex serializing the transactions, for each channel.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Init().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+static  void  MB_OS_InitMaster (void)
+{
+    CPU_INT08U  i;
+
+
+    for (i = 0; i < MODBUS_CFG_MAX_CH; i++) {                 /* Create a semaphore for each channel   */
+        (void)rt_sem_init(&MB_OS_RxSemTbl[i],
+                          "mb_rx",
+                          0,
+                          RT_IPC_FLAG_FIFO);
+        (void)rt_mutex_init(&MB_OS_ChMutexTbl[i],             /* ... and a mutex                       */
+                            "mb_ch",
+                            RT_IPC_FLAG_PRIO);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          MB_OS_InitSlave()
+*
+* Description : This function initializes the kernel objects needed for Modbus Slave.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Init().
+*
+* Note(s)     : (1) Each slave channel is served by Rx thread (.Ch % MB_OS_CFG_RX_TASK_NBR).  All Rx threads
+*                   start at MB_OS_CFG_RX_TASK_PRIO, see MB_OS_RxTaskPrioSet().
+*
+*               (2) A mailbox holds up to MODBUS_CFG_MAX_CH pending channels, the same depth as the task
+*                   queue of the uC/OS-III port.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_InitSlave (void)
+{
+    CPU_INT08U  i;
+
+
+    for (i = 0; i < MB_OS_CFG_RX_TASK_NBR; i++) {             /* Create the Rx threads (see Note #1)   */
+        (void)rt_mb_init(&MB_OS_RxTaskMb[i],
+                         "mb_rx",
+                         &MB_OS_RxTaskMbPool[i][0],
+                         MODBUS_CFG_MAX_CH,                   /* See Note #2                           */
+                         RT_IPC_FLAG_FIFO);
+
+        (void)rt_thread_init(&MB_OS_RxTaskTCB[i],
+                             "mb_rx",
+                              MB_OS_RxTask,
+                             (void *)&MB_OS_RxTaskMb[i],
+                             &MB_OS_RxTaskStk[i][0],
+                              MB_OS_RX_TASK_STK_SIZE_BYTES,
+                              MB_OS_CFG_RX_TASK_PRIO,
+                              MB_OS_RX_TASK_TIME_SLICE);
+        (void)rt_thread_startup(&MB_OS_RxTaskTCB[i]);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_InitMBM()
+*
+* Description : This function creates the master threads executing asynchronous master requests, a
+*               semaphore per master thread counting the requests submitted to it, and the completion queue
+*               semaphore.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Init().
+*
+* Note(s)     : (1) Each master channel is served by master thread (.Ch % MB_OS_CFG_MBM_TASK_NBR).
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+static  void  MB_OS_InitMBM (void)
+{
+    CPU_INT08U  i;
+
+
+    (void)rt_sem_init(&MB_OS_MBM_DoneSem,
+                      "mb_done",
+                      0,
+                      RT_IPC_FLAG_FIFO);
+
+    for (i = 0; i < MB_OS_CFG_MBM_TASK_NBR; i++) {            /* Create the master threads (see Note #1) */
+        (void)rt_sem_init(&MB_OS_MBM_ReqSemTbl[i],
+                          "mb_req",
+                          0,
+                          RT_IPC_FLAG_FIFO);
+
+        (void)rt_thread_init(&MB_OS_MBM_TaskTCB[i],
+                             "mb_mbm",
+                              MB_OS_MBM_Task,
+                             (void *)(CPU_ADDR)i,
+                             &MB_OS_MBM_TaskStk[i][0],
+                              MB_OS_MBM_TASK_STK_SIZE_BYTES,
+                              MB_OS_CFG_MBM_TASK_PRIO,
+                              MB_OS_RX_TASK_TIME_SLICE);
+        (void)rt_thread_startup(&MB_OS_MBM_TaskTCB[i]);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_InitTCP()
+*
+* Description : This function creates the Modbus/TCP server thread and, with the gateway, the mutex guarding
+*               the client connections.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Init().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_InitTCP (void)
+{
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+    (void)rt_mutex_init(&MB_OS_TCP_Mutex,
+                        "mb_tcp",
+                        RT_IPC_FLAG_PRIO);
+#endif
+    (void)rt_thread_init(&MB_OS_TCP_TaskTCB,
+                         "mb_tcp",
+                          MB_OS_TCP_Task,
+                         (void *)0,
+                         &MB_OS_TCP_TaskStk[0],
+                          MB_OS_TCP_TASK_STK_SIZE_BYTES,
+                          MB_OS_CFG_TCP_TASK_PRIO,
+                          MB_OS_RX_TASK_TIME_SLICE);
+    (void)rt_thread_startup(&MB_OS_TCP_TaskTCB);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                             MB_OS_Exit()
+*
+* Description : This function is called to terminate the RTOS interface for Modbus channels.  The kernel
+*               objects created by MB_OS_Init() are detached.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_Exit().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_OS_Exit (void)
+{
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+    MB_OS_ExitMaster();
+#endif
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    MB_OS_ExitSlave();
+#endif
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+    MB_OS_ExitMBM();
+#endif
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    MB_OS_ExitTCP();
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_OS_ExitMaster()
+*
+* Description : This function detaches the semaphores of the Modbus Master channels.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Exit().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+static  void  MB_OS_ExitMaster (void)
+{
+    CPU_INT08U  i;
+
+
+    for (i = 0; i < MODBUS_CFG_MAX_CH; i++) {                 /* Detach semaphore for each channel     */
+        (void)rt_sem_detach(&MB_OS_RxSemTbl[i]);
+        (void)rt_mutex_detach(&MB_OS_ChMutexTbl[i]);          /* ... and its mutex                     */
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          MB_OS_ExitSlave()
+*
+* Description : This function detaches the Rx threads of the Modbus Slave channels and their mailboxes.
+*
+* Argument(s) : none
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Exit().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_ExitSlave (void)
+{
+    CPU_INT08U  i;
+
+
+    for (i = 0; i < MB_OS_CFG_RX_TASK_NBR; i++) {
+        (void)rt_thread_detach(&MB_OS_RxTaskTCB[i]);          /* Detach Modbus Rx threads ...          */
+        (void)rt_mb_detach(&MB_OS_RxTaskMb[i]);               /* ... and their mailboxes               */
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_ExitMBM()
+*
+* Description : This function detaches the master threads and the semaphores created by MB_OS_InitMBM().
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Exit().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+static  void  MB_OS_ExitMBM (void)
+{
+    CPU_INT08U  i;
+
+
+    for (i = 0; i < MB_OS_CFG_MBM_TASK_NBR; i++) {
+        (void)rt_thread_detach(&MB_OS_MBM_TaskTCB[i]);        /* Detach master threads ...             */
+        (void)rt_sem_detach(&MB_OS_MBM_ReqSemTbl[i]);         /* ... and their semaphores              */
+    }
+    (void)rt_sem_detach(&MB_OS_MBM_DoneSem);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_ExitTCP()
+*
+* Description : This function detaches the Modbus/TCP server thread and its mutex, if any.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_Exit().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_ExitTCP (void)
+{
+    (void)rt_thread_detach(&MB_OS_TCP_TaskTCB);
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+    (void)rt_mutex_detach(&MB_OS_TCP_Mutex);
+#endif
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                              MB_OS_RxSignal()
+*
+* Description : This function signals the reception of a packet either from the Rx ISR(s) or the RTU timeout
+*               timer(s) to indicate that a received packet needs to be processed.
+*
+* Argument(s) : pch     specifies the Modbus channel data structure in which a packet was received.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_ASCII_RxByte(),
+*               MB_RTU_TmrUpdate().
+*
+* Note(s)     : (1) rt_sem_release() and rt_mb_send() don't block and may be called from an ISR.
+*********************************************************************************************************
+*/
+
+void  MB_OS_RxSignal (MODBUS_CH *pch)
+{
+    if (pch != (MODBUS_CH *)0) {
+        switch (pch->MasterSlave) {
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+            case MODBUS_MASTER:
+                 (void)rt_sem_release(&MB_OS_RxSemTbl[pch->Ch]);
+                 break;
+#endif
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+            case MODBUS_SLAVE:
+            default:
+                 (void)rt_mb_send(&MB_OS_RxTaskMb[pch->Ch % MB_OS_CFG_RX_TASK_NBR],
+                                  (rt_ubase_t)pch);
+                 break;
+#endif
+        }
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                              MB_OS_RxWait()
+*
+* Description : This function waits for a response from a slave.
+*
+* Argument(s) : pch     specifies the Modbus channel data structure to wait on.
+*
+*               perr    is a pointer to a variable that will receive an error code.  Possible errors are:
+*
+*                       MODBUS_ERR_NONE        the call was successful and a packet was received
+*                       MODBUS_ERR_TIMED_OUT   a packet was not received within the specified timeout
+*                       MODBUS_ERR_NOT_MASTER  the channel is not a Master
+*                       MODBUS_ERR_INVALID     an invalid error was detected
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_FCxx()  Modbus Master Functions
+*
+* Note(s)     : (1) As with uC/OS-III, a timeout of 0 waits forever.
+*********************************************************************************************************
+*/
+
+void  MB_OS_RxWait (MODBUS_CH   *pch,
+                    CPU_INT16U  *perr)
+{
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+    rt_int32_t  timeout;
+    rt_err_t    err;
+
+
+    if (pch != (MODBUS_CH *)0) {
+        if (pch->MasterSlave == MODBUS_MASTER) {
+            if (pch->RxTimeoutCur == 0) {                     /* See Note #1                           */
+                timeout = RT_WAITING_FOREVER;
+            } else {
+                timeout = (rt_int32_t)pch->RxTimeoutCur;
+            }
+            err = rt_sem_take(&MB_OS_RxSemTbl[pch->Ch], timeout);
+            switch (err) {
+                case RT_EOK:
+                     *perr = MODBUS_ERR_NONE;
+                     break;
+
+                case -RT_ETIMEOUT:
+                     *perr = MODBUS_ERR_TIMED_OUT;
+                     break;
+
+                default:
+                     *perr = MODBUS_ERR_INVALID;
+                     break;
+            }
+        } else {
+            *perr = MODBUS_ERR_NOT_MASTER;
+        }
+    } else {
+        *perr = MODBUS_ERR_NULLPTR;
+    }
+#else
+    *perr = MODBUS_ERR_INVALID;
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_OS_ChLock()
+*
+* Description : This function gives the calling thread exclusive use of a master channel, waiting for the
+*               transaction in progress on the channel (if any) to complete.
+*
+* Argument(s) : pch     specifies the Modbus channel.
+*
+*               perr    is a pointer to a variable that will receive an error code.  Possible errors are:
+*
+*                       MODBUS_ERR_NONE        the channel is locked by the caller
+*                       MODBUS_ERR_NULLPTR     'pch' is a NULL pointer
+*                       MODBUS_ERR_INVALID     an invalid error was detected
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_FCxx()  Modbus Master Functions,
+*               MBM_Bulkxxx().
+*
+* Note(s)     : (1) The lock may be nested by the thread that owns the channel, each call must be matched by a
+*                   call to MB_OS_ChUnlock().
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+void  MB_OS_ChLock (MODBUS_CH   *pch,
+                    CPU_INT16U  *perr)
+{
+    if (pch == (MODBUS_CH *)0) {
+        *perr = MODBUS_ERR_NULLPTR;
+        return;
+    }
+
+    if (rt_mutex_take(&MB_OS_ChMutexTbl[pch->Ch], RT_WAITING_FOREVER) == RT_EOK) {
+        *perr = MODBUS_ERR_NONE;
+    } else {
+        *perr = MODBUS_ERR_INVALID;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_ChUnlock()
+*
+* Description : This function releases a master channel locked by MB_OS_ChLock().
+*
+* Argument(s) : pch     specifies the Modbus channel.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_FCxx()  Modbus Master Functions
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_OS_ChUnlock (MODBUS_CH *pch)
+{
+    (void)rt_mutex_release(&MB_OS_ChMutexTbl[pch->Ch]);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_TCP_Lock()
+*
+* Description : This function gives the calling thread exclusive use of the Modbus/TCP client connections.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : mb_tcp.c.
+*
+* Note(s)     : (1) The server thread holds the lock while it processes requests, the master threads take it
+*                   to send the replies of the gateway (see mb_gw.c).  The lock may be nested, each call must
+*                   be matched by a call to MB_OS_TCP_Unlock().
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+void  MB_OS_TCP_Lock (void)
+{
+    (void)rt_mutex_take(&MB_OS_TCP_Mutex, RT_WAITING_FOREVER);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_OS_TCP_Unlock()
+*
+* Description : This function releases the Modbus/TCP client connections locked by MB_OS_TCP_Lock().
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : mb_tcp.c.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_OS_TCP_Unlock (void)
+{
+    (void)rt_mutex_release(&MB_OS_TCP_Mutex);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MB_OS_TimeGet()
+*
+* Description : This function returns the current value of the kernel tick counter.
+*
+* Argument(s) : none.
+*
+* Return(s)   : The number of ticks elapsed since the kernel was started.
+*
+* Caller(s)   : Application,
+*               MB_InRegRd(),
+*               MB_HoldingRegRd().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_INT32U  MB_OS_TimeGet (void)
+{
+    return ((CPU_INT32U)rt_tick_get());
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_OS_TickRateGet()
+*
+* Description : This function returns the frequency of the kernel tick.
+*
+* Argument(s) : none.
+*
+* Return(s)   : The number of ticks per second.
+*
+* Caller(s)   : MB_TCP_RxWait().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_INT32U  MB_OS_TickRateGet (void)
+{
+    return ((CPU_INT32U)RT_TICK_PER_SECOND);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_OS_TS_Get()
+*
+* Description : This function returns a free running timestamp in microseconds.
+*
+* Argument(s) : none.
+*
+* Return(s)   : The number of microseconds elapsed since an arbitrary origin, modulo 2^32.
+*
+* Caller(s)   : MB_HistRxEnd(),
+*               MB_HistFcStart(),
+*               MB_HistTx(),
+*               MB_TraceFrame().
+*
+* Note(s)     : (1) Read from the CPU time driver when RT_USING_CPUTIME is defined, otherwise derived from
+*                   the kernel tick, whose resolution is one tick.  Called from ISRs.
+*
+*               (2) The counter of the CPU time driver wraps at its own width, MB_OS_CFG_CPUTIME_BITS,
+*                   not at 2^32 microseconds, so its readings can't be converted as they are.  The
+*                   difference with the previous reading, modulo that width, is added to the counts not
+*                   yet converted.  Those are converted and moved to MB_OS_TS_Us once they're worth
+*                   MB_OS_CPUTIME_FLUSH_US, so that the rounding of clock_cpu_microsecond() is lost at most
+*                   once a second and its multiplication is never applied to a large count.
+*
+*               (3) A wrap of the counter between two readings, e.g. with no frame for longer than its
+*                   period, is recovered from the kernel tick: the number of whole periods that brings the
+*                   difference closest to the time elapsed in ticks is added to it.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_HIST_EN  == DEF_ENABLED) || \
+    (MODBUS_CFG_TRACE_EN == DEF_ENABLED)
+CPU_INT32U  MB_OS_TS_Get (void)
+{
+#ifdef  RT_USING_CPUTIME
+    CPU_INT64U  cnt;
+    CPU_INT64U  dly;
+    CPU_INT64U  dly_us;
+    CPU_INT64U  tick_us;
+    CPU_INT64U  period_us;
+    CPU_INT64U  us;
+    rt_tick_t   tick;
+    CPU_SR      cpu_sr;
+
+
+    CPU_CRITICAL_ENTER();                                /* See Note #2                                */
+    cnt     = (CPU_INT64U)clock_cpu_gettime() & MB_OS_CPUTIME_MASK;
+    tick    = rt_tick_get();
+    dly     = (cnt - MB_OS_TS_CpuLast) & MB_OS_CPUTIME_MASK;
+    tick_us = (CPU_INT64U)(rt_tick_t)(tick - MB_OS_TS_TickLast) * (1000000uL / RT_TICK_PER_SECOND);
+    dly_us  = clock_cpu_microsecond(dly);
+    if (tick_us > dly_us) {                              /* See Note #3                                */
+        period_us = clock_cpu_microsecond(MB_OS_CPUTIME_MASK) + 1u;
+        dly      += ((tick_us - dly_us + period_us / 2u) / period_us) * (MB_OS_CPUTIME_MASK + 1u);
+    }
+    MB_OS_TS_CpuLast   = cnt;
+    MB_OS_TS_TickLast  = tick;
+    MB_OS_TS_CpuPend  += dly;
+    us                 = clock_cpu_microsecond(MB_OS_TS_CpuPend);
+    if (us >= MB_OS_CPUTIME_FLUSH_US) {
+        MB_OS_TS_Us      += us;
+        MB_OS_TS_CpuPend  = 0u;
+        us                = 0u;
+    }
+    us += MB_OS_TS_Us;
+    CPU_CRITICAL_EXIT();
+
+    return ((CPU_INT32U)us);
+#else
+    return ((CPU_INT32U)rt_tick_get() * (1000000uL / RT_TICK_PER_SECOND));
+#endif
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                         MB_OS_RxTaskPrioSet()
+*
+* Description : This function changes the priority of the Rx thread serving a slave channel.
+*
+* Argument(s) : pch     specifies the Modbus channel data structure.
+*
+*               prio    is the new priority of the Rx thread.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) The Rx thread is shared by all the channels for which (.Ch % MB_OS_CFG_RX_TASK_NBR) is the
+*                   same.  Set MB_OS_CFG_RX_TASK_NBR to MODBUS_CFG_MAX_CH for one Rx thread per channel.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+void  MB_OS_RxTaskPrioSet (MODBUS_CH   *pch,
+                           CPU_INT08U   prio)
+{
+    rt_uint8_t  rt_prio;
+
+
+    if (pch != (MODBUS_CH *)0) {
+        rt_prio = (rt_uint8_t)prio;
+        (void)rt_thread_control(&MB_OS_RxTaskTCB[pch->Ch % MB_OS_CFG_RX_TASK_NBR],
+                                RT_THREAD_CTRL_CHANGE_PRIORITY,
+                                (void *)&rt_prio);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MB_OS_RxTask()
+*
+* Description : This thread is created by MB_OS_Init() and waits for signals from either the Rx ISR(s) or
+*               the RTU timeout timer(s) to indicate that a packet needs to be processed.  There is one
+*               instance of this thread per group of channels (see MB_OS_InitSlave()).
+*
+* Argument(s) : p_arg       is a pointer to the mailbox the thread waits on.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : This is a Task.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_RxTask (void *p_arg)
+{
+    struct rt_mailbox  *pmb;
+    rt_ubase_t          msg;
+
+
+    pmb = (struct rt_mailbox *)p_arg;
+
+    while (DEF_TRUE) {
+        if (rt_mb_recv(pmb, &msg, RT_WAITING_FOREVER) == RT_EOK) {  /* Wait for a packet to be received    */
+            MB_RxTask((MODBUS_CH *)msg);                            /* Process the packet received         */
+        }
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        MB_OS_MBM_ReqSignal()
+*
+* Description : This function signals the master thread serving a channel that a request was submitted.
+*
+* Argument(s) : pch     specifies the Modbus channel the request was submitted to.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_ReqSubmit().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+void  MB_OS_MBM_ReqSignal (MODBUS_CH *pch)
+{
+    (void)rt_sem_release(&MB_OS_MBM_ReqSemTbl[pch->Ch % MB_OS_CFG_MBM_TASK_NBR]);
+}
+
+
+/*
+*********************************************************************************************************
+*                                        MB_OS_MBM_DoneSignal()
+*
+* Description : This function signals that a request was posted to the completion queue.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_ReqDone().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_OS_MBM_DoneSignal (void)
+{
+    (void)rt_sem_release(&MB_OS_MBM_DoneSem);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         MB_OS_MBM_DoneWait()
+*
+* Description : This function waits for a request to be posted to the completion queue.
+*
+* Argument(s) : timeout     is the maximum number of ticks to wait, 0 to wait forever.
+*
+*               perr        is a pointer to a variable that will receive an error code:
+*
+*                           MODBUS_ERR_NONE        a request was posted to the completion queue
+*                           MODBUS_ERR_TIMED_OUT   no request was posted within the specified timeout
+*                           MODBUS_ERR_INVALID     an invalid error was detected
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_ReqDoneWait().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_OS_MBM_DoneWait (CPU_INT32U   timeout,
+                          CPU_INT16U  *perr)
+{
+    rt_err_t  err;
+
+
+    err = rt_sem_take(&MB_OS_MBM_DoneSem,
+                      (timeout == 0) ? RT_WAITING_FOREVER : (rt_int32_t)timeout);
+    switch (err) {
+        case RT_EOK:
+             *perr = MODBUS_ERR_NONE;
+             break;
+
+        case -RT_ETIMEOUT:
+             *perr = MODBUS_ERR_TIMED_OUT;
+             break;
+
+        default:
+             *perr = MODBUS_ERR_INVALID;
+             break;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_MBM_Task()
+*
+* Description : This thread is created by MB_OS_InitMBM() and executes the asynchronous master requests
+*               submitted to the channels it serves.
+*
+* Argument(s) : p_arg       is the index of the master thread.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : This is a Task.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  MB_OS_MBM_Task (void *p_arg)
+{
+    CPU_INT08U  task_ix;
+
+
+    task_ix = (CPU_INT08U)(CPU_ADDR)p_arg;
+
+    while (DEF_TRUE) {
+        if (rt_sem_take(&MB_OS_MBM_ReqSemTbl[task_ix], RT_WAITING_FOREVER) == RT_EOK) {
+            MBM_ReqTask(task_ix);                             /* Execute the request submitted          */
+        }
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_OS_TCP_Task()
+*
+* Description : This thread is created by MB_OS_InitTCP() and serves the Modbus/TCP slave channels.
+*
+* Argument(s) : p_arg       is not used.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : This is a Task.
+*
+* Note(s)     : (1) MB_TCP_SrvPoll() blocks until a socket is readable, or for a short while when there are
+*                   no connections.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_TCP_EN   == DEF_ENABLED) && \
+    (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_OS_TCP_Task (void *p_arg)
+{
+    (void)p_arg;
+
+    while (DEF_TRUE) {
+        MB_TCP_SrvPoll();                                     /* See Note #1                            */
+    }
+}
+#endif
+
+#endif                                                          /* End of RT-Thread port                              */
@@ -0,0 +1,2120 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                   uC/MODBUS TCP AND UDP TRANSPORTS
+*
+* Filename : mb_tcp.c
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) A Modbus/TCP frame is the RTU frame without its CRC, preceded by the MBAP header:
+*
+*                    +-------+-------+-------+-------+-------+-------+------+----+--------------+
+*                    |  Transaction  |   Protocol    |    Length     | Unit | FC |     Data     |
+*                    |  identifier   | identifier, 0 | (Unit + PDU)  |  id  |    |              |
+*                    +-------+-------+-------+-------+-------+-------+------+----+--------------+
+*
+*                The unit identifier takes the place of the node address, so .RxFrameData[] and
+*                .TxFrameData[] have the same layout as in ASCII and RTU mode and the requests are built
+*                and processed by the same mbm_core.c and mbs_core.c functions.
+*
+*            (2) The sockets are BSD sockets: SAL on RT-Thread, the host's own sockets otherwise.
+*
+*            (3) A slave channel listens with MB_TCP_Listen().  Its clients are served by MB_TCP_SrvPoll(),
+*                called in a loop by the Modbus/TCP server task of the OS port.  All the connections of all
+*                the slave channels are multiplexed in that one task: select() on RT-Thread SAL, epoll on
+*                a Linux host.  A connection is an entry of MB_TCP_ConnTbl[] (see mb_cfg.h, MODBUS TCP
+*                CONFIGURATION Note #4), so their number is bounded by memory, not by tasks.
+*
+*                The requests are parsed as they come in, any number of them per recv().  Each is
+*                processed by MBS_FCxx_Handler() through MB_RxTask(), there is no hand-over to the Rx task
+*                as with a UART.  The replies to the requests received together are batched in the
+*                connection's Tx buffer and sent with one send().
+*
+*            (4) A master channel connects with MB_TCP_Connect().  Its replies are received by
+*                MB_TCP_RxWait() in the task executing the request.  A connection lost is re-opened by the
+*                next request.  With MODBUS_CFG_MBM_PIPE_EN, several requests may be in flight, their
+*                replies are received with MB_TCP_RxNext() and matched by transaction id (see mbm_req.c).
+*
+*            (5) With MODBUS_CFG_GW_EN, the requests for a unit identifier routed by the gateway are handed
+*                over to mb_gw.c instead of being processed.  Their replies are sent later, from the task of
+*                the master channel, with MB_TCP_ConnReply().  The server task and the master tasks share
+*                the connections under MB_OS_TCP_Lock().
+*
+*            (6) With MODBUS_CFG_RTU_TCP_EN, a MODBUS_MODE_RTU_TCP channel carries RTU frames, node address
+*                and CRC included, instead of MBAP frames.  They're built by MB_RTU_TxFrame() and checked
+*                by MB_RTU_Rx().  Nothing in an RTU frame tells its length, MB_TCP_RTU_Len() works it
+*                out from the function code.  A master takes the next frame as the reply, there's no
+*                transaction identifier to match.
+*
+*                With MODBUS_CFG_UDP_EN, a MODBUS_MODE_UDP channel sends each MBAP frame as one datagram.
+*                A slave channel receives the requests of all its clients on one socket, the listen
+*                socket, and answers each to the address it came from (.TCP_Addr and .TCP_Port): no
+*                connection, no entry of MB_TCP_ConnTbl[].  The socket of a master channel is connect()ed
+*                to the slave only to set the destination of its requests, MB_TCP_Connect() re-targets
+*                it without a handshake.  One channel polls any number of slaves in turn that way.  A
+*                datagram lost is a request that times out, there's no stream to re-synchronize.
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define    MB_TCP_MODULE
+#include  "mb.h"
+
+
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+
+#include  <sys/types.h>
+#include  <sys/socket.h>
+#include  <sys/select.h>
+#include  <sys/ioctl.h>
+#include  <sys/time.h>
+#include  <netinet/in.h>
+#include  <netinet/tcp.h>
+#include  <arpa/inet.h>
+#include  <errno.h>
+#include  <string.h>
+
+#ifndef   RT_USING_SAL
+#include  <unistd.h>
+#endif
+
+#if       defined(__linux__) && !defined(RT_USING_SAL)
+#include  <sys/epoll.h>
+#define   MB_TCP_EPOLL_EN                                       /* See Note #3                                        */
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  MB_TCP_HDR_SIZE                                6       /* MBAP bytes preceding the unit identifier           */
+
+#define  MB_TCP_SRV_POLL_MS                           100       /* Max. time the server task blocks in select()       */
+
+#define  MB_TCP_SND_TMO_MS                           1000       /* Max. time a client may stall the server task       */
+
+#define  MB_TCP_CONN_TMO_MS                          3000       /* Max. time of a connect() without request timeout   */
+
+#define  MB_TCP_EV_MAX                                 16       /* Max. nbr of epoll events handled per wakeup        */
+
+#define  MB_TCP_EV_LISTEN         MODBUS_CFG_TCP_CONN_MAX       /* epoll id. of a listen socket, + channel index      */
+
+#define  MB_TCP_UNIT_ANY                             0xFF       /* Unit id. of a slave addressed directly over TCP    */
+
+#ifdef   RT_USING_SAL
+#define  MB_TCP_SOCK_CLOSE(sock)        closesocket(sock)
+#define  MB_TCP_SOCK_NBIO(sock, pon)    ioctlsocket((sock), FIONBIO, (pon))
+#else
+#define  MB_TCP_SOCK_CLOSE(sock)        close(sock)
+#define  MB_TCP_SOCK_NBIO(sock, pon)    ioctl((sock), FIONBIO, (pon))
+#endif
+
+#if (MODBUS_CFG_UDP_EN == DEF_ENABLED)                          /* See Note #6                                        */
+#define  MB_TCP_SOCK_TYPE(pch)          (((pch)->TCP_Mode == MODBUS_MODE_UDP) ? SOCK_DGRAM : SOCK_STREAM)
+#else
+#define  MB_TCP_SOCK_TYPE(pch)          SOCK_STREAM
+#endif
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)                           /* See Note #5                                        */
+#define  MB_TCP_LOCK()                  MB_OS_TCP_Lock()
+#define  MB_TCP_UNLOCK()                MB_OS_TCP_Unlock()
+                                                                /* Id. of a connection: generation and index          */
+#define  MB_TCP_CONN_ID(pconn)          (((CPU_INT32U)(pconn)->Gen << 8) | (CPU_INT32U)((pconn) - MB_TCP_ConnTbl))
+#else
+#define  MB_TCP_LOCK()
+#define  MB_TCP_UNLOCK()
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+typedef  struct  modbus_tcp_conn {                     /* Client connection of a slave channel                             */
+    CPU_INT32S       Sock;                             /* Connected socket, -1 if the entry is free                        */
+    MODBUS_CH       *ChPtr;                            /* Slave channel the client connected to                            */
+    CPU_INT32U       RxTs;                             /* Time data was last received (ticks)                              */
+    CPU_INT16U       RxBufByteCtr;                     /* Number of bytes in .RxBuf[]                                      */
+    CPU_INT16U       TxBufByteCtr;                     /* Number of bytes in .TxBuf[]                                      */
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+    CPU_INT08U       Gen;                              /* Incremented for each client, tells a reply for a former one      */
+#endif
+    CPU_INT08U       RxBuf[MODBUS_CFG_BUF_SIZE];       /* Requests received, the last one possibly incomplete              */
+    CPU_INT08U       TxBuf[MODBUS_CFG_BUF_SIZE];       /* Replies not sent yet                                             */
+} MODBUS_TCP_CONN;
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  MODBUS_TCP_CONN  MB_TCP_ConnTbl[MODBUS_CFG_TCP_CONN_MAX];
+static  CPU_INT16U       MB_TCP_ConnIx;                         /* Entry MB_TCP_Accept() looks at first               */
+
+#ifdef   MB_TCP_EPOLL_EN
+static  int              MB_TCP_EpollFd = -1;
+#endif
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  CPU_INT16U   MB_TCP_FrameLen  (MODBUS_CH        *pch,
+                                       CPU_INT08U       *pbuf,
+                                       CPU_INT16U        nbr_bytes);
+
+#if (MODBUS_CFG_RTU_TCP_EN == DEF_ENABLED)
+static  CPU_INT16U   MB_TCP_RTU_Len   (CPU_INT08U       *pbuf,
+                                       CPU_INT16U        nbr_bytes,
+                                       CPU_INT08U        master_slave);
+#endif
+
+static  void         MB_TCP_RxReset   (MODBUS_CH        *pch);
+
+static  CPU_BOOLEAN  MB_TCP_SendBuf   (CPU_INT32S        sock,
+                                       CPU_INT08U       *pbuf,
+                                       CPU_INT16U        nbr_bytes);
+
+static  void         MB_TCP_SockOpt   (CPU_INT32S        sock);
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+static  CPU_BOOLEAN  MB_TCP_RxSock    (MODBUS_CH        *pch);
+
+static  void         MB_TCP_Send      (MODBUS_CH        *pch);
+
+static  CPU_INT16U   MB_TCP_Open      (MODBUS_CH        *pch,
+                                       CPU_INT32U        timeout);
+#endif
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void         MB_TCP_SrvSelect (void);
+
+#ifdef   MB_TCP_EPOLL_EN
+static  void         MB_TCP_SrvEpoll  (void);
+
+static  void         MB_TCP_EpollAdd  (CPU_INT32S        sock,
+                                       CPU_INT32U        id);
+
+static  void         MB_TCP_EpollDel  (CPU_INT32S        sock);
+#endif
+
+static  void         MB_TCP_Accept    (MODBUS_CH        *pch);
+
+static  void         MB_TCP_ConnRx    (MODBUS_TCP_CONN  *pconn);
+
+static  void         MB_TCP_ConnTx    (MODBUS_CH        *pch);
+
+static  void         MB_TCP_ConnFlush (MODBUS_TCP_CONN  *pconn);
+
+static  void         MB_TCP_ConnClose (MODBUS_TCP_CONN  *pconn);
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+static  void         MB_TCP_ConnExcept(MODBUS_TCP_CONN  *pconn,
+                                       CPU_INT08U       *pframe,
+                                       CPU_INT08U        except);
+#endif
+
+#if (MODBUS_CFG_UDP_EN == DEF_ENABLED)
+static  void         MB_TCP_DgramRx   (MODBUS_CH        *pch);
+
+static  void         MB_TCP_DgramTx   (MODBUS_CH        *pch);
+#endif
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                             MB_TCP_Init()
+*
+* Description : Initializes the Modbus/TCP transport: frees the client connections of the slave channels
+*               and, on a Linux host, creates the epoll instance of the server task.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_Init().
+*
+* Note(s)     : (1) Without an epoll instance, MB_TCP_SrvPoll() falls back on select().
+*********************************************************************************************************
+*/
+
+void  MB_TCP_Init (void)
+{
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    CPU_INT16U        i;
+    MODBUS_TCP_CONN  *pconn;
+
+
+    MB_TCP_ConnIx = 0;
+    pconn         = &MB_TCP_ConnTbl[0];
+    for (i = 0; i < MODBUS_CFG_TCP_CONN_MAX; i++) {
+        pconn->Sock         = -1;
+        pconn->ChPtr        = (MODBUS_CH *)0;
+        pconn->RxTs         = 0;
+        pconn->RxBufByteCtr = 0;
+        pconn->TxBufByteCtr = 0;
+        pconn++;
+    }
+
+#ifdef   MB_TCP_EPOLL_EN
+    if (MB_TCP_EpollFd < 0) {                                   /* See Note #1                                        */
+        MB_TCP_EpollFd = epoll_create1(EPOLL_CLOEXEC);
+    }
+#endif
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_TCP_Listen()
+*
+* Description : Opens the listening socket of a Modbus/TCP slave channel.
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel, configured as a MODBUS_SLAVE in MODBUS_MODE_TCP,
+*                           MODBUS_MODE_RTU_TCP or MODBUS_MODE_UDP.
+*
+*               port        Is the TCP (or UDP) port to listen on, normally MODBUS_TCP_PORT (502).
+*
+* Return(s)   : MODBUS_ERR_NONE       If the channel is listening.
+*               MODBUS_ERR_NULLPTR    If 'pch' is a NULL pointer.
+*               MODBUS_ERR_INVALID    If the channel isn't a Modbus/TCP slave channel.
+*               MODBUS_ERR_TCP        If the socket couldn't be opened, bound or put in the listen state.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) Connections are accepted by the Modbus/TCP server task (see Note #3 at the top of the
+*                   file).  When all the connections are in use, a new client replaces the least recently
+*                   active one, so a client reconnecting after a cable was pulled isn't locked out by the
+*                   half-open connection it left behind.
+*
+*               (2) A UDP socket is bound only, the requests are received on it (see Note #6 at the top of
+*                   the file).
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+CPU_INT16U  MB_TCP_Listen (MODBUS_CH   *pch,
+                           CPU_INT16U   port)
+{
+    CPU_INT32S          sock;
+    int                 opt;
+    struct sockaddr_in  addr;
+
+
+    if (pch == (MODBUS_CH *)0) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+    if ((pch->Mode        != MODBUS_MODE_TCP) ||
+        (pch->MasterSlave != MODBUS_SLAVE)) {
+        return (MODBUS_ERR_INVALID);
+    }
+
+    sock = socket(AF_INET, MB_TCP_SOCK_TYPE(pch), 0);
+    if (sock < 0) {
+        return (MODBUS_ERR_TCP);
+    }
+    opt = 1;                                                    /* Allow a restart while old connections linger       */
+    (void)setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (void *)&opt, sizeof(opt));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if ((bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+        ((pch->TCP_Mode != MODBUS_MODE_UDP) &&                  /* See Note #2                                        */
+         (listen(sock, MODBUS_CFG_TCP_CONN_MAX) < 0))) {
+        MB_TCP_SOCK_CLOSE(sock);
+        return (MODBUS_ERR_TCP);
+    }
+
+    MB_TCP_Close(pch);
+    pch->TCP_ListenSock = sock;
+#ifdef   MB_TCP_EPOLL_EN
+    MB_TCP_EpollAdd(sock, MB_TCP_EV_LISTEN + (CPU_INT32U)(pch - &MB_ChTbl[0]));
+#endif
+    return (MODBUS_ERR_NONE);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TCP_Connect()
+*
+* Description : Connects a Modbus/TCP master channel to a slave.
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel, configured as a MODBUS_MASTER in MODBUS_MODE_TCP,
+*                           MODBUS_MODE_RTU_TCP or MODBUS_MODE_UDP.
+*
+*               ip_addr     Is the IPv4 address of the slave in dotted decimal notation, e.g. "192.168.0.10".
+*
+*               port        Is the TCP (or UDP) port of the slave, normally MODBUS_TCP_PORT (502).
+*
+* Return(s)   : MODBUS_ERR_NONE       If the channel is connected.
+*               MODBUS_ERR_NULLPTR    If 'pch' or 'ip_addr' is a NULL pointer.
+*               MODBUS_ERR_INVALID    If the channel isn't a Modbus/TCP master channel or 'ip_addr' is invalid.
+*               MODBUS_ERR_TCP        If the connection failed.  The next request tries again.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) The address of the slave is kept by the channel.  When the connection is lost, the next
+*                   request re-opens it (see MB_TCP_Tx()).
+*
+*               (2) The socket of a UDP channel is kept, only its destination changes (see Note #6 at the
+*                   top of the file).
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+CPU_INT16U  MB_TCP_Connect (MODBUS_CH   *pch,
+                            CPU_CHAR    *ip_addr,
+                            CPU_INT16U   port)
+{
+    CPU_INT32U  addr;
+    CPU_INT16U  err;
+
+
+    if ((pch     == (MODBUS_CH *)0) ||
+        (ip_addr == (CPU_CHAR  *)0)) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+    if ((pch->Mode        != MODBUS_MODE_TCP) ||
+        (pch->MasterSlave != MODBUS_MASTER)) {
+        return (MODBUS_ERR_INVALID);
+    }
+    addr = (CPU_INT32U)inet_addr(ip_addr);
+    if (addr == (CPU_INT32U)INADDR_NONE) {
+        return (MODBUS_ERR_INVALID);
+    }
+
+    MB_OS_ChLock(pch, &err);                                    /* Don't pull the socket from under a request         */
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+    if (pch->TCP_Mode != MODBUS_MODE_UDP) {                     /* See Note #2                                        */
+        MB_TCP_Close(pch);
+    }
+    pch->TCP_Addr = addr;
+    pch->TCP_Port = port;
+    err           = MB_TCP_Open(pch, pch->RxTimeout);
+    MB_OS_ChUnlock(pch);
+
+    return (err);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MB_TCP_Close()
+*
+* Description : Closes the sockets of a Modbus/TCP channel, the connections of its clients included.
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : Application,
+*               MB_TCP_Connect(),
+*               MB_TCP_Exit(),
+*               MB_TCP_Listen().
+*
+* Note(s)     : (1) A master channel forgets the address of its slave, it isn't reconnected until
+*                   MB_TCP_Connect() is called again.
+*********************************************************************************************************
+*/
+
+void  MB_TCP_Close (MODBUS_CH  *pch)
+{
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    CPU_INT16U        i;
+    MODBUS_TCP_CONN  *pconn;
+#endif
+
+
+    if (pch == (MODBUS_CH *)0) {
+        return;
+    }
+    if (pch->TCP_Sock >= 0) {
+        MB_TCP_SOCK_CLOSE(pch->TCP_Sock);
+        pch->TCP_Sock = -1;
+    }
+    if (pch->TCP_ListenSock >= 0) {
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED) && \
+    defined(MB_TCP_EPOLL_EN)
+        MB_TCP_EpollDel(pch->TCP_ListenSock);
+#endif
+        MB_TCP_SOCK_CLOSE(pch->TCP_ListenSock);
+        pch->TCP_ListenSock = -1;
+    }
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    MB_TCP_LOCK();
+    pconn = &MB_TCP_ConnTbl[0];
+    for (i = 0; i < MODBUS_CFG_TCP_CONN_MAX; i++) {
+        if ((pconn->Sock  >= 0) &&
+            (pconn->ChPtr == pch)) {
+            MB_TCP_ConnClose(pconn);
+        }
+        pconn++;
+    }
+    MB_TCP_UNLOCK();
+#endif
+    pch->TCP_Port = 0;                                          /* See Note #1                                        */
+    MB_TCP_RxReset(pch);
+}
+
+
+/*
+*********************************************************************************************************
+*                                             MB_TCP_Exit()
+*
+* Description : Closes the sockets of all the Modbus/TCP channels and the epoll instance, if any.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_Exit().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MB_TCP_Exit (void)
+{
+    CPU_INT08U   ch;
+    MODBUS_CH   *pch;
+
+
+    pch = &MB_ChTbl[0];
+    for (ch = 0; ch < MODBUS_CFG_MAX_CH; ch++) {
+        if (pch->Mode == MODBUS_MODE_TCP) {
+            MB_TCP_Close(pch);
+        }
+        pch++;
+    }
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED) && \
+    defined(MB_TCP_EPOLL_EN)
+    if (MB_TCP_EpollFd >= 0) {
+        (void)close(MB_TCP_EpollFd);
+        MB_TCP_EpollFd = -1;
+    }
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                              MB_TCP_Rx()
+*
+* Description : Converts a Modbus/TCP frame received in .RxBuf[] into a Modbus frame.
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel's data structure.
+*
+* Return(s)   : DEF_TRUE    If all checks pass.
+*               DEF_FALSE   If any checks fail.
+*
+* Caller(s)   : MBM_RxReply(),
+*               MBS_TCP_Task().
+*
+* Note(s)     : (1) A slave answers the unit identifiers MB_TCP_UNIT_ANY and 0 as its own node address, as
+*                   a device reached directly over TCP should (see MODBUS Messaging on TCP/IP Implementation
+*                   Guide, section 4.4.2.1).  The reply carries the identifier of the request.
+*
+*               (2) An RTU frame carries its CRC, checked here (see Note #6 at the top of the file).  It's
+*                   recorded in the trace ring by MB_RTU_Rx().
+*********************************************************************************************************
+*/
+
+CPU_BOOLEAN  MB_TCP_Rx (MODBUS_CH  *pch)
+{
+    CPU_INT08U  *pmsg;
+    CPU_INT08U  *prx_data;
+    CPU_INT16U   rx_size;
+    CPU_INT16U   len;
+    CPU_INT16U   i;
+#if (MODBUS_CFG_RTU_TCP_EN == DEF_ENABLED)
+    CPU_BOOLEAN  ok;
+
+
+    if (pch->TCP_Mode == MODBUS_MODE_RTU_TCP) {                 /* See Note #2                                        */
+        ok = MB_RTU_Rx(pch);
+        if ((ok                    == DEF_TRUE) &&
+            (MB_RTU_RxCalcCRC(pch) != pch->RxFrameCRC)) {
+#if (MODBUS_CFG_FC08_EN == DEF_ENABLED)
+            pch->StatCRCErrCtr++;
+#endif
+            ok = DEF_FALSE;
+        }
+        return (ok);
+    }
+#endif
+
+    pmsg    = &pch->RxBuf[0];
+    rx_size =  pch->RxBufByteCtr;
+#if (MODBUS_CFG_TRACE_EN == DEF_ENABLED)
+    MB_TraceFrame(pch,                                          /* Record the frame (see mb_trace.c)                  */
+                  MODBUS_TRACE_RX,
+                  pmsg,
+                  rx_size);
+#endif
+    if (rx_size < MODBUS_TCP_MIN_MSG_SIZE) {                    /* Is the message long enough?                        */
+        return (DEF_FALSE);
+    }
+    len = ((CPU_INT16U)pmsg[4] << 8) | (CPU_INT16U)pmsg[5];
+    if ((pmsg[2] != 0) ||                                       /* Modbus protocol identifier?                        */
+        (pmsg[3] != MODBUS_TCP_PROTOCOL_ID) ||
+        (len     != rx_size - MB_TCP_HDR_SIZE)) {               /* Length consistent with what was received?          */
+        return (DEF_FALSE);
+    }
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    if (pch->MasterSlave == MODBUS_SLAVE) {                     /* A master keeps the id. of its last request         */
+        pch->TCP_TID  = ((CPU_INT16U)pmsg[0] << 8) | (CPU_INT16U)pmsg[1];
+        pch->TCP_Unit = pmsg[MB_TCP_HDR_SIZE];
+    }
+#endif
+
+    prx_data = &pch->RxFrameData[0];                            /* Transfer unit id., function code and data          */
+    pmsg    += MB_TCP_HDR_SIZE;
+    for (i = 0; i < len; i++) {
+        *prx_data++ = *pmsg++;
+    }
+    pch->RxFrameNDataBytes = len - 2;
+    pch->RxFrameCRC        = 0;                                 /* TCP has its own checksum                           */
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    if ((pch->MasterSlave    == MODBUS_SLAVE) &&                /* See Note #1                                        */
+        ((pch->TCP_Unit      == MB_TCP_UNIT_ANY) ||
+         (pch->TCP_Unit      == 0))) {
+        pch->RxFrameData[0] = pch->NodeAddr;
+    }
+#endif
+    return (DEF_TRUE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                              MB_TCP_Tx()
+*
+* Description : Adds the MBAP header to the Modbus frame and sends it on the channel's connection.  The
+*               reply of a slave is queued on the connection of the client that sent the request, or sent
+*               to the address of the request on a UDP channel.
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel's data structure.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_TxCmd(),
+*               MBS_TCP_Task().
+*
+* Note(s)     : (1) A master numbers its requests, a slave echoes the transaction identifier and the unit
+*                   identifier of the request it answers.  The Rx buffer of a master isn't flushed, it may
+*                   hold part of the reply to a request still in flight (see MB_TCP_RxNext()).
+*
+*               (2) The replies to the requests received in the same recv() are sent together once they're
+*                   all processed (see MB_TCP_ConnRx()).
+*
+*               (3) An RTU frame replaces the MBAP header with the CRC (see Note #6 at the top of the file).
+*********************************************************************************************************
+*/
+
+void  MB_TCP_Tx (MODBUS_CH  *pch)
+{
+    CPU_INT08U  *ptx_data;
+    CPU_INT08U  *pbuf;
+    CPU_INT16U   len;
+    CPU_INT16U   i;
+
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+    if (pch->MasterSlave == MODBUS_MASTER) {                    /* See Note #1                                        */
+        pch->TCP_TID++;
+        pch->TCP_Unit = pch->TxFrameData[0];
+        if ((pch->TCP_Sock <  0) &&                             /* Re-open a connection lost                          */
+            (pch->TCP_Port != 0)) {
+            (void)MB_TCP_Open(pch, pch->RxTimeoutCur);
+        }
+    }
+#endif
+
+#if (MODBUS_CFG_RTU_TCP_EN == DEF_ENABLED)
+    if (pch->TCP_Mode == MODBUS_MODE_RTU_TCP) {                 /* See Note #3                                        */
+        MB_RTU_TxFrame(pch);
+    } else
+#endif
+    {
+        len      = pch->TxFrameNDataBytes + 2;                  /* Unit id., function code and data                   */
+        pbuf     = &pch->TxBuf[0];
+        *pbuf++  = (CPU_INT08U)(pch->TCP_TID >> 8);             /* MBAP header                                        */
+        *pbuf++  = (CPU_INT08U)(pch->TCP_TID & 0x00FF);
+        *pbuf++  = 0;
+        *pbuf++  = MODBUS_TCP_PROTOCOL_ID;
+        *pbuf++  = (CPU_INT08U)(len >> 8);
+        *pbuf++  = (CPU_INT08U)(len & 0x00FF);
+        *pbuf++  = pch->TCP_Unit;
+        ptx_data = &pch->TxFrameData[1];
+        for (i = 1; i < len; i++) {
+            *pbuf++ = *ptx_data++;
+        }
+        pch->TxFrameCRC   = 0;
+        pch->TxBufByteCtr = MB_TCP_HDR_SIZE + len;
+    }
+
+#if (MODBUS_CFG_TRACE_EN == DEF_ENABLED)
+    MB_TraceFrame(pch,                                          /* Record the frame (see mb_trace.c)                  */
+                  MODBUS_TRACE_TX,
+                  &pch->TxBuf[0],
+                  pch->TxBufByteCtr);
+#endif
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+    if (pch->MasterSlave == MODBUS_SLAVE) {
+#if (MODBUS_CFG_HIST_EN == DEF_ENABLED)
+        MB_HistTx(pch);                                         /* Timestamp the reply (see mb_hist.c)                */
+#endif
+#if (MODBUS_CFG_UDP_EN == DEF_ENABLED)
+        if (pch->TCP_Mode == MODBUS_MODE_UDP) {
+            MB_TCP_DgramTx(pch);
+            return;
+        }
+#endif
+        MB_TCP_ConnTx(pch);                                     /* See Note #2                                        */
+        return;
+    }
+#endif
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+    MB_TCP_Send(pch);
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_TCP_RxWait()
+*
+* Description : Waits for the reply to the request sent by a Modbus/TCP master channel.
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel's data structure.
+*
+*               perr        Is a pointer to a variable that will receive an error code:
+*
+*                               MODBUS_ERR_NONE           The reply is in .RxBuf[]
+*                               MODBUS_ERR_TIMED_OUT      No reply within .RxTimeoutCur ticks, or the connection
+*                                                         is down.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_TxRxAttempt().
+*
+* Note(s)     : (1) The reply is received in the calling task, which saves the context switches of a
+*                   hand-over from a receive task.  It must be the task that sent the request.
+*
+*               (2) A frame with another transaction identifier is the late reply to an earlier request
+*                   that timed out.  It's dropped and the wait goes on.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+void  MB_TCP_RxWait (MODBUS_CH   *pch,
+                     CPU_INT16U  *perr)
+{
+    CPU_INT32U  ts;
+    CPU_INT32U  dly;
+    CPU_INT16U  tid;
+
+
+    ts  = MB_OS_TimeGet();
+    dly = 0;                                                    /* No limit when .RxTimeoutCur is 0                   */
+    while (DEF_TRUE) {
+        if (pch->RxTimeoutCur != 0) {
+            dly = MB_OS_TimeGet() - ts;
+            if (dly >= pch->RxTimeoutCur) {
+                *perr = MODBUS_ERR_TIMED_OUT;
+                return;
+            }
+            dly = pch->RxTimeoutCur - dly;                      /* Time left                                          */
+        }
+
+        tid = MB_TCP_RxNext(pch, dly, perr);
+        if (*perr != MODBUS_ERR_NONE) {
+            return;
+        }
+        if (tid == pch->TCP_TID) {
+            return;
+        }
+        MB_TCP_RxReset(pch);                                    /* See Note #2                                        */
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MB_TCP_RxNext()
+*
+* Description : Waits for the next frame received on a Modbus/TCP master channel.
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel's data structure.
+*
+*               timeout     Is the maximum number of ticks to wait, 0 to wait forever.
+*
+*               perr        Is a pointer to a variable that will receive an error code:
+*
+*                               MODBUS_ERR_NONE           A frame is in .RxBuf[]
+*                               MODBUS_ERR_TIMED_OUT      No frame within 'timeout' ticks, or the
+*                                                         connection is down (.TCP_Sock is then -1).
+*
+* Return(s)   : The transaction identifier of the frame received.
+*
+* Caller(s)   : MB_TCP_RxWait(),
+*               MBM_ReqPipe().
+*
+* Note(s)     : (1) The frame stays in .RxBuf[] until the caller empties it.  A frame left partly received
+*                   by a timeout is completed by the next call.
+*
+*               (2) An RTU frame has no transaction identifier, it's taken as the reply to the last request
+*                   (see Note #6 at the top of the file).
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+CPU_INT16U  MB_TCP_RxNext (MODBUS_CH   *pch,
+                           CPU_INT32U   timeout,
+                           CPU_INT16U  *perr)
+{
+    CPU_INT32U       ts;
+    CPU_INT32U       dly;
+    CPU_INT32U       rate;
+    fd_set           rd_set;
+    struct timeval   tv;
+    struct timeval  *ptv;
+    int              n;
+
+
+    ts   = MB_OS_TimeGet();
+    rate = MB_OS_TickRateGet();
+    while (DEF_TRUE) {
+        if (pch->TCP_Sock < 0) {                                /* Connection down                                    */
+            *perr = MODBUS_ERR_TIMED_OUT;
+            return (0);
+        }
+        ptv = (struct timeval *)0;                              /* Time left, no limit when 'timeout' is 0            */
+        if (timeout != 0) {
+            dly = MB_OS_TimeGet() - ts;
+            if (dly >= timeout) {
+                *perr = MODBUS_ERR_TIMED_OUT;
+                return (0);
+            }
+            dly        = timeout - dly;
+            tv.tv_sec  = (long)(dly / rate);
+            tv.tv_usec = (long)(((dly % rate) * 1000000uL) / rate);
+            ptv        = &tv;
+        }
+
+        FD_ZERO(&rd_set);
+        FD_SET(pch->TCP_Sock, &rd_set);
+        n = select(pch->TCP_Sock + 1, &rd_set, (fd_set *)0, (fd_set *)0, ptv);
+        if (n == 0) {
+            *perr = MODBUS_ERR_TIMED_OUT;
+            return (0);
+        }
+        if (n < 0) {
+            if (errno != EINTR) {
+                MB_TCP_SOCK_CLOSE(pch->TCP_Sock);
+                pch->TCP_Sock = -1;
+            }
+            continue;
+        }
+
+        if (MB_TCP_RxSock(pch) == DEF_TRUE) {
+            *perr = MODBUS_ERR_NONE;
+#if (MODBUS_CFG_RTU_TCP_EN == DEF_ENABLED)
+            if (pch->TCP_Mode == MODBUS_MODE_RTU_TCP) {         /* See Note #2                                        */
+                return (pch->TCP_TID);
+            }
+#endif
+            return (((CPU_INT16U)pch->RxBuf[0] << 8) | (CPU_INT16U)pch->RxBuf[1]);
+        }
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TCP_SrvPoll()
+*
+* Description : Accepts connections and processes the requests received by the Modbus/TCP slave channels.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : Modbus/TCP server task (see MB_OS_Init()).
+*
+* Note(s)     : (1) Blocks for at most MB_TCP_SRV_POLL_MS, so that channels set up after the server task
+*                   started are served.
+*
+*               (2) select() walks all the sockets on every call, epoll only the ones with data.  The
+*                   latter is used when available (see MB_TCP_Init()).
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+void  MB_TCP_SrvPoll (void)
+{
+#ifdef   MB_TCP_EPOLL_EN
+    if (MB_TCP_EpollFd >= 0) {                                  /* See Note #2                                        */
+        MB_TCP_SrvEpoll();
+        return;
+    }
+#endif
+    MB_TCP_SrvSelect();
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          MB_TCP_SrvSelect()
+*
+* Description : Waits with select() for connections and requests on the Modbus/TCP slave channels.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_TCP_SrvPoll().
+*
+* Note(s)     : (1) The connections are served before the new clients are accepted, so a connection that
+*                   replaces an evicted one isn't mistaken for it.
+*
+*               (2) The sockets must be below FD_SETSIZE, which bounds the number of connections on hosts
+*                   without epoll.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_TCP_SrvSelect (void)
+{
+    CPU_INT16U        i;
+    CPU_INT08U        ch;
+    MODBUS_CH        *pch;
+    MODBUS_TCP_CONN  *pconn;
+    CPU_INT32S        sock_max;
+    fd_set            rd_set;
+    struct timeval    tv;
+    int               n;
+
+
+    FD_ZERO(&rd_set);                                           /* See Note #2                                        */
+    sock_max = -1;
+    pch      = &MB_ChTbl[0];
+    for (ch = 0; ch < MB_ChCtr; ch++) {                         /* Collect the listen sockets of the slave channels   */
+        if ((pch->Mode           == MODBUS_MODE_TCP) &&
+            (pch->MasterSlave    == MODBUS_SLAVE)    &&
+            (pch->TCP_ListenSock >= 0)) {
+            FD_SET(pch->TCP_ListenSock, &rd_set);
+            if (pch->TCP_ListenSock > sock_max) {
+                sock_max = pch->TCP_ListenSock;
+            }
+        }
+        pch++;
+    }
+    pconn = &MB_TCP_ConnTbl[0];
+    for (i = 0; i < MODBUS_CFG_TCP_CONN_MAX; i++) {             /* ... and the client connections                     */
+        if (pconn->Sock >= 0) {
+            FD_SET(pconn->Sock, &rd_set);
+            if (pconn->Sock > sock_max) {
+                sock_max = pconn->Sock;
+            }
+        }
+        pconn++;
+    }
+
+    tv.tv_sec  = 0;                                             /* See MB_TCP_SrvPoll() Note #1                       */
+    tv.tv_usec = MB_TCP_SRV_POLL_MS * 1000L;
+    n          = select(sock_max + 1, &rd_set, (fd_set *)0, (fd_set *)0, &tv);
+    if (n <= 0) {
+        return;
+    }
+
+    MB_TCP_LOCK();
+    pconn = &MB_TCP_ConnTbl[0];
+    for (i = 0; i < MODBUS_CFG_TCP_CONN_MAX; i++) {             /* See Note #1                                        */
+        if ((pconn->Sock >= 0) &&
+            (FD_ISSET(pconn->Sock, &rd_set))) {
+            MB_TCP_ConnRx(pconn);
+        }
+        pconn++;
+    }
+    pch = &MB_ChTbl[0];
+    for (ch = 0; ch < MB_ChCtr; ch++) {
+        if ((pch->Mode           == MODBUS_MODE_TCP) &&
+            (pch->MasterSlave    == MODBUS_SLAVE)    &&
+            (pch->TCP_ListenSock >= 0)               &&
+            (FD_ISSET(pch->TCP_ListenSock, &rd_set))) {
+#if (MODBUS_CFG_UDP_EN == DEF_ENABLED)
+            if (pch->TCP_Mode == MODBUS_MODE_UDP) {             /* A request, not a client (see Note #6 of the file)  */
+                MB_TCP_DgramRx(pch);
+            } else
+#endif
+            {
+                MB_TCP_Accept(pch);
+            }
+        }
+        pch++;
+    }
+    MB_TCP_UNLOCK();
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TCP_SrvEpoll()
+*
+* Description : Waits with epoll for connections and requests on the Modbus/TCP slave channels.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_TCP_SrvPoll().
+*
+* Note(s)     : (1) The events carry the index of the connection in MB_TCP_ConnTbl[], or MB_TCP_EV_LISTEN
+*                   plus the index of the channel for a listen socket.
+*
+*               (2) A connection closed by an earlier event of the same batch may be reused by a client
+*                   accepted since.  Its stale event then finds no data, which MB_TCP_ConnRx() ignores.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED) && \
+    defined(MB_TCP_EPOLL_EN)
+static  void  MB_TCP_SrvEpoll (void)
+{
+    struct epoll_event   ev_tbl[MB_TCP_EV_MAX];
+    CPU_INT32U           id;
+    MODBUS_CH           *pch;
+    MODBUS_TCP_CONN     *pconn;
+    int                  n;
+    int                  i;
+
+
+    n = epoll_wait(MB_TCP_EpollFd, &ev_tbl[0], MB_TCP_EV_MAX, MB_TCP_SRV_POLL_MS);
+    if (n <= 0) {
+        return;
+    }
+
+    MB_TCP_LOCK();
+    for (i = 0; i < n; i++) {
+        id = ev_tbl[i].data.u32;                                /* See Note #1                                        */
+        if (id < MB_TCP_EV_LISTEN) {
+            pconn = &MB_TCP_ConnTbl[id];
+            if (pconn->Sock >= 0) {                             /* See Note #2                                        */
+                MB_TCP_ConnRx(pconn);
+            }
+        } else if (id - MB_TCP_EV_LISTEN < MODBUS_CFG_MAX_CH) {
+            pch = &MB_ChTbl[id - MB_TCP_EV_LISTEN];
+            if (pch->TCP_ListenSock >= 0) {
+#if (MODBUS_CFG_UDP_EN == DEF_ENABLED)
+                if (pch->TCP_Mode == MODBUS_MODE_UDP) {         /* A request, not a client (see Note #6 of the file)  */
+                    MB_TCP_DgramRx(pch);
+                } else
+#endif
+                {
+                    MB_TCP_Accept(pch);
+                }
+            }
+        }
+    }
+    MB_TCP_UNLOCK();
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TCP_EpollAdd()
+*                                           MB_TCP_EpollDel()
+*
+* Description : Adds a socket to, or removes it from, the epoll instance of the server task.
+*
+* Argument(s) : sock        Is the socket.
+*
+*               id          Is the identifier returned with its events (see MB_TCP_SrvEpoll() Note #1).
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_TCP_Accept(),
+*               MB_TCP_Close(),
+*               MB_TCP_ConnClose(),
+*               MB_TCP_Listen().
+*
+* Note(s)     : (1) A socket must be removed before it's closed: a socket number reused by a new connection
+*                   would otherwise still report the events of the old one.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED) && \
+    defined(MB_TCP_EPOLL_EN)
+static  void  MB_TCP_EpollAdd (CPU_INT32S  sock,
+                               CPU_INT32U  id)
+{
+    struct epoll_event  ev;
+
+
+    if (MB_TCP_EpollFd < 0) {
+        return;
+    }
+    memset(&ev, 0, sizeof(ev));
+    ev.events   = EPOLLIN;
+    ev.data.u32 = id;
+    (void)epoll_ctl(MB_TCP_EpollFd, EPOLL_CTL_ADD, sock, &ev);
+}
+
+
+static  void  MB_TCP_EpollDel (CPU_INT32S  sock)
+{
+    struct epoll_event  ev;
+
+
+    if (MB_TCP_EpollFd < 0) {
+        return;
+    }
+    memset(&ev, 0, sizeof(ev));                                 /* Kernels before 2.6.9 want an event, even unused    */
+    (void)epoll_ctl(MB_TCP_EpollFd, EPOLL_CTL_DEL, sock, &ev);  /* See Note #1                                        */
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TCP_Accept()
+*
+* Description : Accepts a client on the listen socket of a Modbus/TCP slave channel.
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel's data structure.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_TCP_SrvEpoll(),
+*               MB_TCP_SrvSelect().
+*
+* Note(s)     : (1) The client takes a free connection, or the least recently active one when all are in use
+*                   (see MB_TCP_Listen() Note #1).  The search starts after the entry taken last, so that
+*                   among connections equally idle the oldest goes first.
+*
+*               (2) Replies are sent from the server task, a client that stops reading can't hold it, and
+*                   with it all the other clients, for more than MB_TCP_SND_TMO_MS.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_TCP_Accept (MODBUS_CH  *pch)
+{
+    CPU_INT16U        i;
+    CPU_INT16U        ix;
+    CPU_INT16U        ix_new;
+    CPU_INT32S        sock;
+    CPU_INT32U        ts;
+    CPU_INT32U        idle;
+    CPU_INT32U        idle_max;
+    MODBUS_TCP_CONN  *pconn;
+    MODBUS_TCP_CONN  *pconn_new;
+    struct timeval    tv;
+
+
+    sock = accept(pch->TCP_ListenSock, (struct sockaddr *)0, (socklen_t *)0);
+    if (sock < 0) {
+        return;
+    }
+
+    ts       = MB_OS_TimeGet();                                 /* See Note #1                                        */
+    idle_max = 0;
+    ix_new   = MB_TCP_ConnIx;
+    for (i = 0; i < MODBUS_CFG_TCP_CONN_MAX; i++) {
+        ix    = (MB_TCP_ConnIx + i) % MODBUS_CFG_TCP_CONN_MAX;
+        pconn = &MB_TCP_ConnTbl[ix];
+        if (pconn->Sock < 0) {
+            ix_new = ix;
+            break;
+        }
+        idle = ts - pconn->RxTs;
+        if (idle > idle_max) {
+            idle_max = idle;
+            ix_new   = ix;
+        }
+    }
+    MB_TCP_ConnIx = (ix_new + 1) % MODBUS_CFG_TCP_CONN_MAX;
+    pconn_new     = &MB_TCP_ConnTbl[ix_new];
+    if (pconn_new->Sock >= 0) {
+        MB_TCP_ConnClose(pconn_new);
+    }
+
+    MB_TCP_SockOpt(sock);
+    tv.tv_sec  = MB_TCP_SND_TMO_MS / 1000;                      /* See Note #2                                        */
+    tv.tv_usec = (MB_TCP_SND_TMO_MS % 1000) * 1000L;
+    (void)setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, (void *)&tv, sizeof(tv));
+
+    pconn_new->Sock         = sock;
+    pconn_new->ChPtr        = pch;
+    pconn_new->RxTs         = ts;
+    pconn_new->RxBufByteCtr = 0;
+    pconn_new->TxBufByteCtr = 0;
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+    pconn_new->Gen++;
+#endif
+#ifdef   MB_TCP_EPOLL_EN
+    MB_TCP_EpollAdd(sock, (CPU_INT32U)ix_new);
+#endif
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TCP_ConnRx()
+*
+* Description : Receives the data available on a client connection and processes the requests completed.
+*
+* Argument(s) : pconn       Is a pointer to the connection.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_TCP_SrvEpoll(),
+*               MB_TCP_SrvSelect().
+*
+* Note(s)     : (1) One recv() per call, so that a client sending without pause doesn't starve the others.
+*                   A frame always fits in .RxBuf[], there's room for the rest of the one left incomplete.
+*
+*               (2) Each request is copied to the channel's .RxBuf[] and processed as if received on a
+*                   UART.  MB_TCP_Tx() finds the connection to reply on in .TCP_ConnPtr.
+*
+*               (3) A byte stream can't be re-synchronized after an invalid header, the connection is
+*                   closed.  So is a connection closed or reset by the peer.
+*
+*               (4) A request for a unit identifier routed by the gateway is queued by MB_GW_Rx(), the reply
+*                   comes later (see Note #5 of this file).  A request the gateway can't take is answered
+*                   right away with the exception returned.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_TCP_ConnRx (MODBUS_TCP_CONN  *pconn)
+{
+    MODBUS_CH   *pch;
+    CPU_INT08U  *pframe;
+    CPU_INT16U   nbr_bytes;
+    CPU_INT16U   len;
+    int          n;
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+    CPU_INT08U   except;
+#endif
+
+
+    n = recv(pconn->Sock,                                       /* See Note #1                                        */
+             (void *)&pconn->RxBuf[pconn->RxBufByteCtr],
+             MODBUS_CFG_BUF_SIZE - pconn->RxBufByteCtr,
+             MSG_DONTWAIT);
+    if (n <= 0) {
+        if ((n < 0) &&
+            ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))) {
+            return;
+        }
+        MB_TCP_ConnClose(pconn);                                /* See Note #3                                        */
+        return;
+    }
+    pch                  = pconn->ChPtr;
+    pch->RxCtr          += (CPU_INT32U)n;
+    pconn->RxBufByteCtr += (CPU_INT16U)n;
+    pconn->RxTs          = MB_OS_TimeGet();
+
+    pframe    = &pconn->RxBuf[0];
+    nbr_bytes =  pconn->RxBufByteCtr;
+    while (nbr_bytes > 0) {                                     /* Process the complete requests                      */
+        len = MB_TCP_FrameLen(pch, pframe, nbr_bytes);
+        if (len == 0) {                                         /* See Note #3                                        */
+            MB_TCP_ConnClose(pconn);
+            return;
+        }
+        if (len > nbr_bytes) {
+            break;
+        }
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+        if ((pch->TCP_Mode == MODBUS_MODE_TCP) &&
+            (MB_GW_RouteGet(pframe[MB_TCP_HDR_SIZE]) != (MODBUS_CH *)0)) {
+            except = MB_GW_Rx(pframe,                           /* See Note #4                                        */
+                              len,
+                              MB_TCP_CONN_ID(pconn));
+            if (except != MODBUS_ERR_NONE) {
+                MB_TCP_ConnExcept(pconn, pframe, except);
+            }
+        } else
+#endif
+        {
+            memcpy(&pch->RxBuf[0], pframe, len);                /* See Note #2                                        */
+            pch->RxBufByteCtr = len;
+            pch->RxBufPtr     = &pch->RxBuf[len];
+            pch->TCP_ConnPtr  = pconn;
+#if (MODBUS_CFG_HIST_EN == DEF_ENABLED)
+            MB_HistRxEnd(pch);                                  /* Timestamp the end of the request (see mb_hist.c)   */
+#endif
+            MB_RxTask(pch);
+            pch->TCP_ConnPtr  = (MODBUS_TCP_CONN *)0;
+        }
+        if (pconn->Sock < 0) {                                  /* Closed by a failed send                            */
+            return;
+        }
+        pframe    += len;
+        nbr_bytes -= len;
+    }
+    if ((nbr_bytes >  0) &&                                     /* Keep the start of the next request                 */
+        (pframe    != &pconn->RxBuf[0])) {
+        memmove(&pconn->RxBuf[0], pframe, nbr_bytes);
+    }
+    pconn->RxBufByteCtr = nbr_bytes;
+
+    MB_TCP_ConnFlush(pconn);                                    /* Send the replies                                   */
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TCP_ConnTx()
+*
+* Description : Queues the reply built in the channel's .TxBuf[] on the connection of the request.
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel's data structure.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_TCP_Tx().
+*
+* Note(s)     : (1) The replies queued so far are sent first when the new one doesn't fit.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_TCP_ConnTx (MODBUS_CH  *pch)
+{
+    MODBUS_TCP_CONN  *pconn;
+
+
+    pconn = pch->TCP_ConnPtr;
+    if ((pconn       != (MODBUS_TCP_CONN *)0) &&
+        (pconn->Sock >= 0)) {
+        if (pconn->TxBufByteCtr + pch->TxBufByteCtr > MODBUS_CFG_BUF_SIZE) {
+            MB_TCP_ConnFlush(pconn);                            /* See Note #1                                        */
+        }
+        if (pconn->Sock >= 0) {
+            memcpy(&pconn->TxBuf[pconn->TxBufByteCtr], &pch->TxBuf[0], pch->TxBufByteCtr);
+            pconn->TxBufByteCtr += pch->TxBufByteCtr;
+        }
+    }
+    pch->TxCtr        = pch->TxBufByteCtr;
+    pch->TxBufByteCtr = 0;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          MB_TCP_ConnFlush()
+*
+* Description : Sends the replies queued on a client connection.
+*
+* Argument(s) : pconn       Is a pointer to the connection.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_TCP_ConnRx(),
+*               MB_TCP_ConnTx().
+*
+* Note(s)     : (1) An error, or a client not reading its replies, closes the connection.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_TCP_ConnFlush (MODBUS_TCP_CONN  *pconn)
+{
+    CPU_BOOLEAN  ok;
+
+
+    if (pconn->TxBufByteCtr == 0) {
+        return;
+    }
+    ok                  = MB_TCP_SendBuf(pconn->Sock, &pconn->TxBuf[0], pconn->TxBufByteCtr);
+    pconn->TxBufByteCtr = 0;
+    if (ok == DEF_FALSE) {
+        MB_TCP_ConnClose(pconn);                                /* See Note #1                                        */
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          MB_TCP_ConnClose()
+*
+* Description : Closes a client connection and frees its entry.
+*
+* Argument(s) : pconn       Is a pointer to the connection.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : various.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED)
+static  void  MB_TCP_ConnClose (MODBUS_TCP_CONN  *pconn)
+{
+#ifdef   MB_TCP_EPOLL_EN
+    MB_TCP_EpollDel(pconn->Sock);
+#endif
+    MB_TCP_SOCK_CLOSE(pconn->Sock);
+    pconn->Sock         = -1;
+    pconn->ChPtr        = (MODBUS_CH *)0;
+    pconn->RxBufByteCtr = 0;
+    pconn->TxBufByteCtr = 0;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          MB_TCP_ConnReply()
+*
+* Description : Sends a reply on the client connection of a request forwarded by the gateway.
+*
+* Argument(s) : conn_id     Is the identifier of the connection, as passed to MB_GW_Rx().
+*
+*               pbuf        Is a pointer to the reply, MBAP header included.
+*
+*               nbr_bytes   Is the length of the reply.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : mb_gw.c.
+*
+* Note(s)     : (1) The reply is dropped if the client is gone: the connection is closed, or was given to
+*                   another client since (its generation changed).
+*
+*               (2) The replies queued by the server task meanwhile go first.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+void  MB_TCP_ConnReply (CPU_INT32U   conn_id,
+                        CPU_INT08U  *pbuf,
+                        CPU_INT16U   nbr_bytes)
+{
+    MODBUS_TCP_CONN  *pconn;
+
+
+    if (((conn_id & 0xFF) >= MODBUS_CFG_TCP_CONN_MAX) ||
+        (nbr_bytes        >  MODBUS_CFG_BUF_SIZE)) {
+        return;
+    }
+
+    MB_TCP_LOCK();
+    pconn = &MB_TCP_ConnTbl[conn_id & 0xFF];
+    if ((pconn->Sock >= 0) &&                                   /* See Note #1                                        */
+        (pconn->Gen  == (CPU_INT08U)(conn_id >> 8))) {
+        if (pconn->TxBufByteCtr + nbr_bytes > MODBUS_CFG_BUF_SIZE) {
+            MB_TCP_ConnFlush(pconn);                            /* See Note #2                                        */
+        }
+        if (pconn->Sock >= 0) {
+            memcpy(&pconn->TxBuf[pconn->TxBufByteCtr], pbuf, nbr_bytes);
+            pconn->TxBufByteCtr += nbr_bytes;
+            pconn->ChPtr->TxCtr  = nbr_bytes;
+            MB_TCP_ConnFlush(pconn);
+        }
+    }
+    MB_TCP_UNLOCK();
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          MB_TCP_ConnExcept()
+*
+* Description : Queues an exception response to a request on its client connection.
+*
+* Argument(s) : pconn       Is a pointer to the connection.
+*
+*               pframe      Is a pointer to the request, MBAP header included.
+*
+*               except      Is the exception code.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_TCP_ConnRx().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+static  void  MB_TCP_ConnExcept (MODBUS_TCP_CONN  *pconn,
+                                 CPU_INT08U       *pframe,
+                                 CPU_INT08U        except)
+{
+    CPU_INT08U  *pbuf;
+
+
+    if (pconn->TxBufByteCtr + MB_TCP_HDR_SIZE + 3 > MODBUS_CFG_BUF_SIZE) {
+        MB_TCP_ConnFlush(pconn);
+        if (pconn->Sock < 0) {
+            return;
+        }
+    }
+    pbuf    = &pconn->TxBuf[pconn->TxBufByteCtr];
+    *pbuf++ = pframe[0];                                        /* Transaction id. of the request                     */
+    *pbuf++ = pframe[1];
+    *pbuf++ = 0;
+    *pbuf++ = MODBUS_TCP_PROTOCOL_ID;
+    *pbuf++ = 0;
+    *pbuf++ = 3;                                                /* Unit id., function code and exception code         */
+    *pbuf++ = pframe[MB_TCP_HDR_SIZE];
+    *pbuf++ = pframe[MB_TCP_HDR_SIZE + 1] | 0x80;
+    *pbuf   = except;
+    pconn->TxBufByteCtr += MB_TCP_HDR_SIZE + 3;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TCP_DgramRx()
+*
+* Description : Receives a request on the socket of a UDP slave channel and processes it.
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel's data structure.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_TCP_SrvEpoll(),
+*               MB_TCP_SrvSelect().
+*
+* Note(s)     : (1) One datagram per call, as one recv() per call on a connection (see MB_TCP_ConnRx()
+*                   Note #1).  The others are received on the next wakeups.
+*
+*               (2) A datagram holds one request, whole.  One that doesn't is dropped.
+*
+*               (3) The reply goes to the address of the request (see MB_TCP_DgramTx()).
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED) && \
+    (MODBUS_CFG_UDP_EN   == DEF_ENABLED)
+static  void  MB_TCP_DgramRx (MODBUS_CH  *pch)
+{
+    struct sockaddr_in  addr;
+    socklen_t           addr_len;
+    int                 n;
+
+
+    addr_len = sizeof(addr);                                    /* See Note #1                                        */
+    n        = recvfrom(pch->TCP_ListenSock,
+                        (void *)&pch->RxBuf[0],
+                        MODBUS_CFG_BUF_SIZE,
+                        MSG_DONTWAIT,
+                        (struct sockaddr *)&addr,
+                        &addr_len);
+    if (n <= 0) {
+        return;
+    }
+    pch->RxCtr += (CPU_INT32U)n;
+    if (MB_TCP_FrameLen(pch, &pch->RxBuf[0], (CPU_INT16U)n) != (CPU_INT16U)n) {
+        return;                                                 /* See Note #2                                        */
+    }
+
+    pch->TCP_Addr     = (CPU_INT32U)addr.sin_addr.s_addr;       /* See Note #3                                        */
+    pch->TCP_Port     = ntohs(addr.sin_port);
+    pch->RxBufByteCtr = (CPU_INT16U)n;
+    pch->RxBufPtr     = &pch->RxBuf[n];
+#if (MODBUS_CFG_HIST_EN == DEF_ENABLED)
+    MB_HistRxEnd(pch);                                          /* Timestamp the end of the request (see mb_hist.c)   */
+#endif
+    MB_RxTask(pch);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TCP_DgramTx()
+*
+* Description : Sends the reply built in the channel's .TxBuf[] to the client of a UDP slave channel.
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel's data structure.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_TCP_Tx().
+*
+* Note(s)     : (1) A reply lost is a request that times out at the client, it isn't sent again.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED) && \
+    (MODBUS_CFG_UDP_EN   == DEF_ENABLED)
+static  void  MB_TCP_DgramTx (MODBUS_CH  *pch)
+{
+    struct sockaddr_in  addr;
+
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(pch->TCP_Port);
+    addr.sin_addr.s_addr = pch->TCP_Addr;
+    (void)sendto(pch->TCP_ListenSock,                           /* See Note #1                                        */
+                 (void *)&pch->TxBuf[0],
+                 pch->TxBufByteCtr,
+                 0,
+                 (struct sockaddr *)&addr,
+                 sizeof(addr));
+    pch->TxCtr        = pch->TxBufByteCtr;
+    pch->TxBufByteCtr = 0;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TCP_FrameLen()
+*
+* Description : Determines the length of the frame at the start of a receive buffer.
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel the frame is received on.
+*
+*               pbuf        Is a pointer to the first byte of the frame.
+*
+*               nbr_bytes   Is the number of bytes received so far.
+*
+* Return(s)   : The length of the frame, MBAP header included, once the length field is received.
+*               MB_TCP_HDR_SIZE until then.
+*               0 if the header is invalid or the frame doesn't fit in a MODBUS_CFG_BUF_SIZE buffer.
+*
+* Caller(s)   : MB_TCP_ConnRx(),
+*               MB_TCP_DgramRx(),
+*               MB_TCP_RxSock().
+*
+* Note(s)     : (1) An RTU frame is sized by MB_TCP_RTU_Len().
+*********************************************************************************************************
+*/
+
+static  CPU_INT16U  MB_TCP_FrameLen (MODBUS_CH   *pch,
+                                     CPU_INT08U  *pbuf,
+                                     CPU_INT16U   nbr_bytes)
+{
+    CPU_INT16U  len;
+
+
+#if (MODBUS_CFG_RTU_TCP_EN == DEF_ENABLED)
+    if (pch->TCP_Mode == MODBUS_MODE_RTU_TCP) {                 /* See Note #1                                        */
+        return (MB_TCP_RTU_Len(pbuf, nbr_bytes, pch->MasterSlave));
+    }
+#else
+    (void)pch;
+#endif
+    if (nbr_bytes < MB_TCP_HDR_SIZE) {
+        return (MB_TCP_HDR_SIZE);
+    }
+    len = ((CPU_INT16U)pbuf[4] << 8) | (CPU_INT16U)pbuf[5];
+    if ((pbuf[2] != 0) ||
+        (pbuf[3] != MODBUS_TCP_PROTOCOL_ID) ||
+        (len     <  2) ||                                       /* At least the unit id. and the function code        */
+        (len     >  MODBUS_CFG_BUF_SIZE - MB_TCP_HDR_SIZE)) {
+        return (0);
+    }
+    return (MB_TCP_HDR_SIZE + len);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TCP_RTU_Len()
+*
+* Description : Determines the length of the RTU frame at the start of a receive buffer.
+*
+* Argument(s) : pbuf          Is a pointer to the first byte of the frame.
+*
+*               nbr_bytes     Is the number of bytes received so far.
+*
+*               master_slave  Is MODBUS_SLAVE if the frame is a request, MODBUS_MASTER if it's a reply.
+*
+* Return(s)   : The length of the frame, CRC included, once the bytes that tell it are received.  A
+*               number of bytes larger than 'nbr_bytes' until then.
+*               0 if the frame doesn't fit in a MODBUS_CFG_BUF_SIZE buffer.
+*
+* Caller(s)   : MB_TCP_FrameLen().
+*
+* Note(s)     : (1) The length of the frames of the function codes implemented follows from the function
+*                   code and, for some, a byte count.
+*
+*               (2) The end of any other frame, e.g. the reply to a request passed with MODBUS_MBM_FC_PDU,
+*                   is where the CRC of the bytes so far checks (see MB_RTU_CRC_Upd() Note #1).  Its bytes
+*                   are then received one by one by a master (see MB_TCP_RxSock() Note #1).
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_RTU_TCP_EN == DEF_ENABLED)
+static  CPU_INT16U  MB_TCP_RTU_Len (CPU_INT08U  *pbuf,
+                                    CPU_INT16U   nbr_bytes,
+                                    CPU_INT08U   master_slave)
+{
+    CPU_INT16U  len;
+    CPU_INT16U  crc;
+    CPU_INT16U  i;
+
+
+    if (nbr_bytes < 2) {                                        /* Node address and function code                     */
+        return (2);
+    }
+
+    len = 0;                                                    /* See Note #1                                        */
+    if (master_slave == MODBUS_SLAVE) {
+        switch (pbuf[1]) {                                      /* Request                                            */
+            case MODBUS_FC01_COIL_RD:
+            case MODBUS_FC02_DI_RD:
+            case MODBUS_FC03_HOLDING_REG_RD:
+            case MODBUS_FC04_IN_REG_RD:
+            case MODBUS_FC05_COIL_WR:
+            case MODBUS_FC06_HOLDING_REG_WR:
+            case MODBUS_FC08_LOOPBACK:
+                 len = 8;
+                 break;
+
+            case MODBUS_FC15_COIL_WR_MULTIPLE:
+            case MODBUS_FC16_HOLDING_REG_WR_MULTIPLE:
+                 len = (nbr_bytes < 7) ? 7 : (9 + (CPU_INT16U)pbuf[6]);
+                 break;
+
+            default:
+                 break;
+        }
+    } else if ((pbuf[1] & 0x80) != 0) {                         /* Exception response                                 */
+        len = 5;
+    } else {
+        switch (pbuf[1]) {                                      /* Response                                           */
+            case MODBUS_FC01_COIL_RD:
+            case MODBUS_FC02_DI_RD:
+            case MODBUS_FC03_HOLDING_REG_RD:
+            case MODBUS_FC04_IN_REG_RD:
+                 len = (nbr_bytes < 3) ? 3 : (5 + (CPU_INT16U)pbuf[2]);
+                 break;
+
+            case MODBUS_FC05_COIL_WR:
+            case MODBUS_FC06_HOLDING_REG_WR:
+            case MODBUS_FC08_LOOPBACK:
+            case MODBUS_FC15_COIL_WR_MULTIPLE:
+            case MODBUS_FC16_HOLDING_REG_WR_MULTIPLE:
+                 len = 8;
+                 break;
+
+            default:
+                 break;
+        }
+    }
+
+    if (len == 0) {                                             /* See Note #2                                        */
+        crc = 0xFFFF;
+        for (i = 0; i < nbr_bytes; i++) {
+            crc = MB_RTU_CRC_Upd(crc, pbuf[i]);
+            if ((i   >= MODBUS_RTU_MIN_MSG_SIZE - 1) &&
+                (crc == 0)) {
+                return (i + 1);
+            }
+        }
+        len = nbr_bytes + 1;
+    }
+    if (len > MODBUS_CFG_BUF_SIZE) {
+        return (0);
+    }
+    return (len);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MB_TCP_RxSock()
+*
+* Description : Receives the data available on a master channel's connection into .RxBuf[].
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel's data structure.
+*
+* Return(s)   : DEF_TRUE    If a complete frame is in .RxBuf[].
+*               DEF_FALSE   Otherwise.
+*
+* Caller(s)   : MB_TCP_RxNext().
+*
+* Note(s)     : (1) No more than the rest of the current frame is read, a reply pipelined behind it stays
+*                   in the socket until the current one is processed.
+*
+*               (2) A byte stream can't be re-synchronized after an invalid header, the connection is
+*                   closed.  So is a connection closed or reset by the peer.
+*
+*               (3) A datagram holds one frame, whole.  One that doesn't is dropped, as are the errors
+*                   reported on a UDP socket, e.g. an ICMP 'port unreachable': the request times out.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+static  CPU_BOOLEAN  MB_TCP_RxSock (MODBUS_CH  *pch)
+{
+    CPU_INT16U  len;
+    int         flags;
+    int         n;
+
+
+#if (MODBUS_CFG_UDP_EN == DEF_ENABLED)
+    if (pch->TCP_Mode == MODBUS_MODE_UDP) {                     /* See Note #3                                        */
+        MB_TCP_RxReset(pch);
+        n = recv(pch->TCP_Sock, (void *)&pch->RxBuf[0], MODBUS_CFG_BUF_SIZE, MSG_DONTWAIT);
+        if (n <= 0) {
+            return (DEF_FALSE);
+        }
+        pch->RxCtr += (CPU_INT32U)n;
+        if (MB_TCP_FrameLen(pch, &pch->RxBuf[0], (CPU_INT16U)n) != (CPU_INT16U)n) {
+            return (DEF_FALSE);
+        }
+        pch->RxBufPtr     = &pch->RxBuf[n];
+        pch->RxBufByteCtr = (CPU_INT16U)n;
+        return (DEF_TRUE);
+    }
+#endif
+
+    flags = 0;                                                  /* The socket is readable, 1st recv() doesn't block   */
+    while (DEF_TRUE) {
+        len = MB_TCP_FrameLen(pch, &pch->RxBuf[0], pch->RxBufByteCtr);
+        if (len == 0) {                                         /* See Note #2                                        */
+            break;
+        }
+        if (pch->RxBufByteCtr == len) {                         /* Never so until the frame is complete               */
+            return (DEF_TRUE);
+        }
+
+        n = recv(pch->TCP_Sock,                                 /* See Note #1                                        */
+                 (void *)pch->RxBufPtr,
+                 len - pch->RxBufByteCtr,
+                 flags);
+        if (n <= 0) {
+            if ((n < 0) &&
+                ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))) {
+                return (DEF_FALSE);                             /* Rest of the frame not in yet                       */
+            }
+            break;
+        }
+        pch->RxBufPtr     += n;
+        pch->RxBufByteCtr += (CPU_INT16U)n;
+        pch->RxCtr        += (CPU_INT32U)n;
+        flags              = MSG_DONTWAIT;
+    }
+
+    MB_TCP_SOCK_CLOSE(pch->TCP_Sock);
+    pch->TCP_Sock = -1;
+    MB_TCP_RxReset(pch);
+    return (DEF_FALSE);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TCP_RxReset()
+*
+* Description : Empties the channel's Rx buffer.
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel's data structure.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : various.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  MB_TCP_RxReset (MODBUS_CH  *pch)
+{
+    pch->RxBufByteCtr = 0;
+    pch->RxBufPtr     = &pch->RxBuf[0];
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_TCP_SendBuf()
+*
+* Description : Sends a buffer on a connected socket.
+*
+* Argument(s) : sock        Is the socket.
+*
+*               pbuf        Is a pointer to the data to send.
+*
+*               nbr_bytes   Is the number of bytes to send.
+*
+* Return(s)   : DEF_TRUE    If all the data was sent.
+*               DEF_FALSE   If the connection failed, the caller closes it.
+*
+* Caller(s)   : MB_TCP_ConnFlush(),
+*               MB_TCP_Send().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_BOOLEAN  MB_TCP_SendBuf (CPU_INT32S   sock,
+                                     CPU_INT08U  *pbuf,
+                                     CPU_INT16U   nbr_bytes)
+{
+    int  n;
+
+
+    while (nbr_bytes > 0) {
+        n = send(sock, (void *)pbuf, nbr_bytes, 0);
+        if (n > 0) {
+            pbuf      += n;
+            nbr_bytes -= (CPU_INT16U)n;
+        } else if ((n < 0) && (errno == EINTR)) {
+            continue;
+        } else {
+            return (DEF_FALSE);
+        }
+    }
+    return (DEF_TRUE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                             MB_TCP_Send()
+*
+* Description : Sends the content of .TxBuf[] on a master channel's connection.
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel's data structure.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_TCP_Tx().
+*
+* Note(s)     : (1) An error closes the connection.  The master then times out waiting for the reply.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+static  void  MB_TCP_Send (MODBUS_CH  *pch)
+{
+    if (pch->TCP_Sock >= 0) {
+        if (MB_TCP_SendBuf(pch->TCP_Sock, &pch->TxBuf[0], pch->TxBufByteCtr) == DEF_FALSE) {
+            MB_TCP_SOCK_CLOSE(pch->TCP_Sock);                   /* See Note #1                                        */
+            pch->TCP_Sock = -1;
+        }
+    }
+    pch->TxCtr        = pch->TxBufByteCtr;
+    pch->TxBufByteCtr = 0;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TCP_SockOpt()
+*
+* Description : Sets the options of a connected socket.
+*
+* Argument(s) : sock        Is the socket.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_TCP_Accept(),
+*               MB_TCP_Open().
+*
+* Note(s)     : (1) Frames are sent whole in one send(), Nagle's algorithm would only hold them back
+*                   waiting for the ACK of the previous one.
+*********************************************************************************************************
+*/
+
+static  void  MB_TCP_SockOpt (CPU_INT32S  sock)
+{
+    int  opt;
+
+
+    opt = 1;                                                    /* See Note #1                                        */
+    (void)setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (void *)&opt, sizeof(opt));
+}
+
+
+/*
+*********************************************************************************************************
+*                                             MB_TCP_Open()
+*
+* Description : Opens the connection of a master channel to its slave.
+*
+* Argument(s) : pch         Is a pointer to the Modbus channel's data structure.
+*
+*               timeout     Is the max. time, in ticks, the connection may take to establish.  0 means
+*                           MB_TCP_CONN_TMO_MS.
+*
+* Return(s)   : MODBUS_ERR_NONE       If the channel is connected.
+*               MODBUS_ERR_TCP        Otherwise.
+*
+* Caller(s)   : MB_TCP_Connect(),
+*               MB_TCP_Tx().
+*
+* Note(s)     : (1) A UDP socket still open is connect()ed again, to another slave (see MB_TCP_Connect()
+*                   Note #2).  The datagrams of the former slave still queued are dropped by transaction
+*                   identifier, as late replies (see MB_TCP_RxWait() Note #2).
+*
+*               (2) Datagrams aren't held back by Nagle's algorithm.
+*
+*               (3) The callers hold the channel lock.  A blocking connect() to a slave that doesn't
+*                   answer would hold it for the stack's own SYN retries, a minute or more, so the socket
+*                   connects in non-blocking mode and select() waits for it to become writable no longer
+*                   than 'timeout'.  The outcome of the handshake is then read from SO_ERROR and the
+*                   socket goes back to blocking mode, which the rest of the file expects.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+static  CPU_INT16U  MB_TCP_Open (MODBUS_CH   *pch,
+                                 CPU_INT32U   timeout)
+{
+    CPU_INT32S          sock;
+    struct sockaddr_in  addr;
+    fd_set              wr_set;
+    struct timeval      tv;
+    CPU_INT32U          rate;
+    int                 nbio;
+    int                 rtn;
+    int                 sock_err;
+    socklen_t           len;
+
+
+    sock = pch->TCP_Sock;                                       /* See Note #1                                        */
+    if (sock < 0) {
+        sock = socket(AF_INET, MB_TCP_SOCK_TYPE(pch), 0);
+        if (sock < 0) {
+            return (MODBUS_ERR_TCP);
+        }
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(pch->TCP_Port);
+    addr.sin_addr.s_addr = pch->TCP_Addr;
+
+    nbio = 1;                                                   /* See Note #3                                        */
+    (void)MB_TCP_SOCK_NBIO(sock, &nbio);
+    rtn  = connect(sock, (struct sockaddr *)&addr, sizeof(addr));
+    if ((rtn < 0) && (errno == EINPROGRESS)) {
+        rate = MB_OS_TickRateGet();
+        if (timeout == 0) {
+            timeout = (CPU_INT32U)(((CPU_INT64U)MB_TCP_CONN_TMO_MS * rate + 999u) / 1000u);
+        }
+        tv.tv_sec  = (long)(timeout / rate);
+        tv.tv_usec = (long)(((timeout % rate) * 1000000uL) / rate);
+        do {
+            FD_ZERO(&wr_set);
+            FD_SET(sock, &wr_set);
+            rtn = select(sock + 1, (fd_set *)0, &wr_set, (fd_set *)0, &tv);
+        } while ((rtn < 0) && (errno == EINTR));
+        if (rtn > 0) {                                          /* Handshake over, see how it ended                   */
+            sock_err = 0;
+            len      = sizeof(sock_err);
+            rtn      = getsockopt(sock, SOL_SOCKET, SO_ERROR, (void *)&sock_err, &len);
+            if ((rtn == 0) && (sock_err != 0)) {
+                rtn = -1;
+            }
+        } else {                                                /* Timed out, or select() failed                      */
+            rtn = -1;
+        }
+    }
+    if (rtn < 0) {
+        MB_TCP_SOCK_CLOSE(sock);
+        pch->TCP_Sock = -1;
+        return (MODBUS_ERR_TCP);
+    }
+    nbio = 0;
+    (void)MB_TCP_SOCK_NBIO(sock, &nbio);
+    if (pch->TCP_Mode != MODBUS_MODE_UDP) {                     /* See Note #2                                        */
+        MB_TCP_SockOpt(sock);
+    }
+
+    pch->TCP_Sock = sock;
+    MB_TCP_RxReset(pch);
+    return (MODBUS_ERR_NONE);
+}
+#endif
+
+#endif
@@ -0,0 +1,606 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                      uC/MODBUS FRAME TRACE RING
+*
+* Filename : mb_trace.c
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) Each channel records the last MODBUS_CFG_TRACE_NBR frames it received and sent in
+*                .TraceTbl[], a ring indexed by the record number modulo MODBUS_CFG_TRACE_NBR :
+*
+*                (a) A frame received is recorded as it's parsed, by MB_ASCII_Rx(), MB_RTU_Rx() or
+*                    MB_TCP_Rx(), before any check: frames with a bad CRC or for another node are recorded
+*                    too.
+*
+*                (b) A frame sent is recorded as it's handed to the driver, by MB_ASCII_Tx(), MB_RTU_Tx()
+*                    or MB_TCP_Tx().
+*
+*                The frame is recorded as it is on the line (ASCII characters, RTU frame with its CRC, MBAP
+*                header and PDU), without the inter-frame silence or the TCP/IP headers.
+*
+*            (2) Recording a frame takes a timestamp, one memcpy() of at most MODBUS_CFG_TRACE_CAPTURE
+*                bytes and a few stores: no lock and no critical section.  When MODBUS_CFG_TRACE_EN is
+*                DEF_DISABLED, neither the calls nor the ring are compiled in.
+*
+*            (3) The frames of a channel are recorded by ONE task at a time: the Rx task of a serial slave,
+*                the Modbus/TCP server task, or the task holding the channel of a master (MB_OS_ChLock()).
+*                The replies relayed by the gateway with MB_TCP_ConnReply() aren't recorded.
+*
+*            (4) Readers don't block the writer.  .Seq of a record is its number while it's written and its
+*                number + 1 once complete.  MB_TraceRd() copies a record and checks .Seq before and after:
+*                a record overwritten meanwhile is skipped, a reader too slow loses records, never the
+*                writer.  The numbers of the records returned tell how many were lost.
+*
+*            (5) MB_TRACE_BARRIER() orders the accesses to .Seq, .TraceCtr and the record.  It defaults to
+*                a full memory barrier with GCC compatible compilers, and otherwise relies on the
+*                'volatile' accesses, which is sufficient on single core processors.  It can be overridden
+*                in mb_cfg.h.
+*
+*            (6) Timestamps are read with MB_OS_TS_Get(), a free running microsecond counter that wraps
+*                every 71 minutes.  Its resolution depends on the port, down to the kernel tick.
+*
+*            (7) MB_TraceDump() writes the records either as text, one line per frame :
+*
+*                    ch <ch> <rx|tx> <sec>.<usec> <len> : <bytes in hex>[ ...]
+*
+*                or as a pcap file (classic format, microsecond timestamps, little endian), one packet per
+*                frame.  The link type is a DLT_USER type, which Wireshark maps to a dissector in its
+*                'DLT User' preferences table :
+*
+*                    MB_TRACE_PCAP_LINK_RTU      147  (User 0)    RTU frames, serial or over TCP     mbrtu
+*                    MB_TRACE_PCAP_LINK_TCP      148  (User 1)    MBAP frames over TCP or UDP        mbtcp
+*                    MB_TRACE_PCAP_LINK_ASCII    149  (User 2)    ASCII frames
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                             INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define   MB_TRACE_MODULE
+#include "mb.h"
+
+#if (MODBUS_CFG_TRACE_EN == DEF_ENABLED)
+
+#include <string.h>
+
+#ifdef   RT_USING_FINSH
+#include <rtthread.h>
+#include <finsh.h>
+#include <stdlib.h>
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#ifndef  MB_TRACE_BARRIER                                       /* See Note #5.                                       */
+#if defined(__GNUC__)
+#define  MB_TRACE_BARRIER()              __sync_synchronize()
+#else
+#define  MB_TRACE_BARRIER()
+#endif
+#endif
+
+#define  MB_TRACE_PCAP_MAGIC               0xA1B2C3D4u          /* pcap, microsecond timestamps                       */
+#define  MB_TRACE_PCAP_LINK_RTU                   147           /* Link types (see Note #7)                           */
+#define  MB_TRACE_PCAP_LINK_TCP                   148
+#define  MB_TRACE_PCAP_LINK_ASCII                 149
+
+#define  MB_TRACE_TEXT_CHUNK                       16           /* Hex text is passed to 'out' once longer than this. */
+                                                                /* buf[24] of MB_TraceDump() holds it + 8 chars       */
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U  *MB_TracePut32 (CPU_INT08U  *pbuf,
+                                    CPU_INT32U   val);
+
+static  CPU_INT08U  *MB_TracePutDec(CPU_INT08U  *pbuf,
+                                    CPU_INT32U   val,
+                                    CPU_INT08U   nbr_dig);
+
+static  CPU_INT08U  *MB_TracePutStr(CPU_INT08U  *pbuf,
+                                    const char  *pstr);
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+#if ((MB_TRACE_TEXT_CHUNK + 8) > 24)                            /* Chunk, 3 more hex chars, " ..." and '\n'           */
+#error  "MB_TRACE_TEXT_CHUNK                     too large for buf[] of MB_TraceDump()                  "
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TraceFrame()
+*
+* Description : This function records a frame in the trace ring of a channel.
+*
+* Argument(s) : pch          is a pointer to the Modbus channel.
+*
+*               dir          is MODBUS_TRACE_RX for a frame received, MODBUS_TRACE_TX for a frame sent.
+*
+*               pframe       is a pointer to the frame.
+*
+*               len          is the length of the frame, in bytes.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_ASCII_Rx(),
+*               MB_ASCII_Tx(),
+*               MB_RTU_Rx(),
+*               MB_RTU_Tx(),
+*               MB_TCP_Rx(),
+*               MB_TCP_Tx().
+*
+* Note(s)     : (1) Only the first MODBUS_CFG_TRACE_CAPTURE bytes are kept, .Len is the length of the whole
+*                   frame.
+*********************************************************************************************************
+*/
+
+void  MB_TraceFrame (MODBUS_CH         *pch,
+                     CPU_INT08U         dir,
+                     CPU_INT08U const  *pframe,
+                     CPU_INT16U         len)
+{
+    MODBUS_TRACE_REC  *prec;
+    CPU_INT32U         ctr;
+    CPU_INT16U         nbr_bytes;
+
+
+    ctr       = pch->TraceCtr;
+    prec      = &pch->TraceTbl[ctr & (MODBUS_CFG_TRACE_NBR - 1)];
+    prec->Seq = ctr;                                            /* Record being written (see Note #4 of the file)     */
+    MB_TRACE_BARRIER();
+    nbr_bytes = len;
+    if (nbr_bytes > MODBUS_CFG_TRACE_CAPTURE) {                 /* See Note #1                                        */
+        nbr_bytes = MODBUS_CFG_TRACE_CAPTURE;
+    }
+    prec->Ts  = MB_OS_TS_Get();
+    prec->Len = len;
+    prec->Dir = dir;
+    memcpy(&prec->Data[0], pframe, nbr_bytes);
+    MB_TRACE_BARRIER();
+    prec->Seq     = ctr + 1;                                    /* Record complete                                    */
+    pch->TraceCtr = ctr + 1;
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MB_TraceRd()
+*
+* Description : This function copies the next record of the trace ring of a channel.
+*
+* Argument(s) : pch          is a pointer to the Modbus channel.
+*
+*               pseq         is a pointer to the number of the next record to read, 0 the first time.  It's
+*                            set to the number following the record returned.
+*
+*               prec         is a pointer to where the record will be copied.  prec->Seq is the number of the
+*                            record + 1.
+*
+* Return(s)   : MODBUS_ERR_NONE       a record was copied
+*               MODBUS_ERR_NO_DATA    no record was made since record '*pseq' - 1
+*               MODBUS_ERR_NULLPTR    'pch', 'pseq' or 'prec' is a NULL pointer
+*
+* Caller(s)   : Application,
+*               MB_TraceDump().
+*
+* Note(s)     : (1) When record '*pseq' was overwritten, the oldest record still in the ring is returned:
+*                   prec->Seq - 1 - '*pseq' records were lost (see Note #4 at the top of the file).
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MB_TraceRd (MODBUS_CH         *pch,
+                        CPU_INT32U        *pseq,
+                        MODBUS_TRACE_REC  *prec)
+{
+    MODBUS_TRACE_REC  *psrc;
+    CPU_INT32U         seq;
+    CPU_INT32U         ctr;
+    CPU_INT16U         nbr_bytes;
+
+
+    if ((pch  == (MODBUS_CH        *)0) ||
+        (pseq == (CPU_INT32U       *)0) ||
+        (prec == (MODBUS_TRACE_REC *)0)) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+
+    seq = *pseq;
+    while (DEF_TRUE) {
+        ctr = pch->TraceCtr;
+        if (ctr == seq) {
+            *pseq = seq;
+            return (MODBUS_ERR_NO_DATA);
+        }
+        if (ctr - seq > MODBUS_CFG_TRACE_NBR) {                 /* Record overwritten, skip to the oldest one         */
+            seq = ctr - MODBUS_CFG_TRACE_NBR;
+        }
+        MB_TRACE_BARRIER();
+        psrc = &pch->TraceTbl[seq & (MODBUS_CFG_TRACE_NBR - 1)];
+        if (psrc->Seq == seq + 1) {
+            MB_TRACE_BARRIER();
+            prec->Ts  = psrc->Ts;
+            prec->Len = psrc->Len;
+            prec->Dir = psrc->Dir;
+            nbr_bytes = prec->Len;
+            if (nbr_bytes > MODBUS_CFG_TRACE_CAPTURE) {
+                nbr_bytes = MODBUS_CFG_TRACE_CAPTURE;
+            }
+            memcpy(&prec->Data[0], &psrc->Data[0], nbr_bytes);
+            MB_TRACE_BARRIER();
+            if (psrc->Seq == seq + 1) {                         /* Record unchanged while copying?                    */
+                prec->Seq = seq + 1;
+                *pseq     = seq + 1;
+                return (MODBUS_ERR_NONE);
+            }
+        }
+        seq++;                                                  /* Overwritten meanwhile, lost                        */
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TraceDump()
+*
+* Description : This function writes the records of the trace ring of a channel, oldest first, as text or
+*               as a pcap file.
+*
+* Argument(s) : pch          is a pointer to the Modbus channel.
+*
+*               fmt          is the format of the dump:
+*                            MODBUS_TRACE_FMT_TEXT    one line per frame
+*                            MODBUS_TRACE_FMT_PCAP    pcap file, header included
+*
+*               out          is the function called with each piece of the dump.
+*
+*               parg         is the argument passed to 'out'.
+*
+* Return(s)   : The number of frames written.
+*
+* Caller(s)   : Application,
+*               MB_TraceCmd().
+*
+* Note(s)     : (1) The formats are described in Note #7 at the top of the file.  The frames recorded while
+*                   the dump is in progress aren't written.
+*
+*               (2) The text is written in small pieces, 'out' doesn't get a whole line at once.
+*********************************************************************************************************
+*/
+
+CPU_INT32U  MB_TraceDump (MODBUS_CH         *pch,
+                          CPU_INT08U         fmt,
+                          MODBUS_TRACE_OUT   out,
+                          void              *parg)
+{
+    MODBUS_TRACE_REC   rec;
+    CPU_INT08U         buf[24];
+    CPU_INT08U        *pbuf;
+    CPU_INT32U         seq;
+    CPU_INT32U         end;
+    CPU_INT32U         nbr;
+    CPU_INT32U         link;
+    CPU_INT16U         nbr_bytes;
+    CPU_INT16U         ix;
+    CPU_INT08U         hex;
+
+
+    if ((pch == (MODBUS_CH        *)0) ||
+        (out == (MODBUS_TRACE_OUT  )0)) {
+        return (0);
+    }
+
+    end = pch->TraceCtr;
+    seq = 0;
+    if (end > MODBUS_CFG_TRACE_NBR) {
+        seq = end - MODBUS_CFG_TRACE_NBR;
+    }
+
+    if (fmt == MODBUS_TRACE_FMT_PCAP) {                         /* pcap global header                                 */
+        switch (pch->Mode) {
+            case MODBUS_MODE_ASCII:
+                 link = MB_TRACE_PCAP_LINK_ASCII;
+                 break;
+
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+            case MODBUS_MODE_TCP:
+                 link = MB_TRACE_PCAP_LINK_TCP;
+                 if (pch->TCP_Mode == MODBUS_MODE_RTU_TCP) {
+                     link = MB_TRACE_PCAP_LINK_RTU;
+                 }
+                 break;
+#endif
+
+            default:
+                 link = MB_TRACE_PCAP_LINK_RTU;
+                 break;
+        }
+        pbuf    = MB_TracePut32(&buf[0], MB_TRACE_PCAP_MAGIC);
+        *pbuf++ = 2;                                            /* Version 2.4                                        */
+        *pbuf++ = 0;
+        *pbuf++ = 4;
+        *pbuf++ = 0;
+        pbuf    = MB_TracePut32(pbuf, 0);                       /* Time zone                                          */
+        pbuf    = MB_TracePut32(pbuf, 0);                       /* Timestamp accuracy                                 */
+        pbuf    = MB_TracePut32(pbuf, MODBUS_CFG_TRACE_CAPTURE);
+        (void)MB_TracePut32(pbuf, link);
+        out(parg, &buf[0], 24);
+    }
+
+    nbr = 0;
+    while (seq != end) {
+        if (MB_TraceRd(pch, &seq, &rec) != MODBUS_ERR_NONE) {
+            break;
+        }
+        if ((CPU_INT32S)(rec.Seq - end) > 0) {                  /* Recorded after the dump started (see Note #1)      */
+            break;
+        }
+        nbr_bytes = rec.Len;
+        if (nbr_bytes > MODBUS_CFG_TRACE_CAPTURE) {
+            nbr_bytes = MODBUS_CFG_TRACE_CAPTURE;
+        }
+
+        if (fmt == MODBUS_TRACE_FMT_PCAP) {
+            pbuf = MB_TracePut32(&buf[0], rec.Ts / 1000000uL);  /* Packet header                                      */
+            pbuf = MB_TracePut32(pbuf,    rec.Ts % 1000000uL);
+            pbuf = MB_TracePut32(pbuf,    nbr_bytes);
+            (void)MB_TracePut32(pbuf,     rec.Len);
+            out(parg, &buf[0], 16);
+            out(parg, &rec.Data[0], nbr_bytes);
+
+        } else {
+            pbuf = MB_TracePutStr(&buf[0], "ch ");              /* ch <ch> <rx|tx> <sec>.<usec> <len> :               */
+            pbuf = MB_TracePutDec(pbuf, pch->Ch, 0);
+            pbuf = MB_TracePutStr(pbuf, (rec.Dir == MODBUS_TRACE_RX) ? " rx " : " tx ");
+            out(parg, &buf[0], (CPU_INT16U)(pbuf - &buf[0]));
+            pbuf = MB_TracePutDec(&buf[0], rec.Ts / 1000000uL, 0);
+            *pbuf++ = '.';
+            pbuf = MB_TracePutDec(pbuf, rec.Ts % 1000000uL, 6);
+            *pbuf++ = ' ';
+            pbuf = MB_TracePutDec(pbuf, rec.Len, 0);
+            pbuf = MB_TracePutStr(pbuf, " :");
+            out(parg, &buf[0], (CPU_INT16U)(pbuf - &buf[0]));
+
+            pbuf = &buf[0];                                     /* Bytes of the frame, see Note #2                    */
+            for (ix = 0; ix < nbr_bytes; ix++) {
+                hex     = rec.Data[ix];
+                *pbuf++ = ' ';
+                *pbuf++ = "0123456789abcdef"[hex >> 4];
+                *pbuf++ = "0123456789abcdef"[hex & 0x0F];
+                if (pbuf - &buf[0] > MB_TRACE_TEXT_CHUNK) {
+                    out(parg, &buf[0], (CPU_INT16U)(pbuf - &buf[0]));
+                    pbuf = &buf[0];
+                }
+            }
+            if (nbr_bytes < rec.Len) {                          /* Frame truncated                                    */
+                pbuf = MB_TracePutStr(pbuf, " ...");
+            }
+            *pbuf++ = '\n';
+            out(parg, &buf[0], (CPU_INT16U)(pbuf - &buf[0]));
+        }
+        nbr++;
+    }
+    return (nbr);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TracePut32()
+*
+* Description : This function stores a 32-bit value, least significant byte first.
+*
+* Argument(s) : pbuf         is a pointer to where the value will be stored.
+*
+*               val          is the value.
+*
+* Return(s)   : A pointer to the byte following the value.
+*
+* Caller(s)   : MB_TraceDump().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U  *MB_TracePut32 (CPU_INT08U  *pbuf,
+                                    CPU_INT32U   val)
+{
+    *pbuf++ = (CPU_INT08U)( val        & 0xFF);
+    *pbuf++ = (CPU_INT08U)((val >>  8) & 0xFF);
+    *pbuf++ = (CPU_INT08U)((val >> 16) & 0xFF);
+    *pbuf++ = (CPU_INT08U)((val >> 24) & 0xFF);
+    return (pbuf);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_TracePutDec()
+*
+* Description : This function writes a value in decimal.
+*
+* Argument(s) : pbuf         is a pointer to where the digits will be written (10 at most).
+*
+*               val          is the value.
+*
+*               nbr_dig      is the minimum number of digits, padded with zeros, 0 for no padding.
+*
+* Return(s)   : A pointer to the character following the digits.
+*
+* Caller(s)   : MB_TraceDump().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U  *MB_TracePutDec (CPU_INT08U  *pbuf,
+                                     CPU_INT32U   val,
+                                     CPU_INT08U   nbr_dig)
+{
+    CPU_INT08U  dig[10];
+    CPU_INT08U  nbr;
+
+
+    nbr = 0;
+    do {
+        dig[nbr++] = (CPU_INT08U)('0' + val % 10);
+        val       /= 10;
+    } while ((val != 0) ||
+             (nbr <  nbr_dig));
+    while (nbr > 0) {
+        *pbuf++ = dig[--nbr];
+    }
+    return (pbuf);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MB_TracePutStr()
+*
+* Description : This function writes a string, without its terminating NUL.
+*
+* Argument(s) : pbuf         is a pointer to where the string will be written.
+*
+*               pstr         is the string.
+*
+* Return(s)   : A pointer to the character following the string.
+*
+* Caller(s)   : MB_TraceDump().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U  *MB_TracePutStr (CPU_INT08U  *pbuf,
+                                     const char  *pstr)
+{
+    while (*pstr != '\0') {
+        *pbuf++ = (CPU_INT08U)*pstr++;
+    }
+    return (pbuf);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MB_TraceCmdOut()
+*
+* Description : This function prints a piece of the text dump of the 'mb_trace' shell command.
+*
+* Argument(s) : parg         is not used.
+*
+*               pbuf         is a pointer to the text.
+*
+*               len          is the length of the text.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_TraceDump().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#ifdef   RT_USING_FINSH
+static  void  MB_TraceCmdOut (void              *parg,
+                              CPU_INT08U const  *pbuf,
+                              CPU_INT16U         len)
+{
+    char  str[32];
+
+
+    (void)parg;
+    if (len >= sizeof(str)) {
+        len = sizeof(str) - 1;
+    }
+    memcpy(str, pbuf, len);
+    str[len] = '\0';
+    rt_kputs(str);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                             MB_TraceCmd()
+*
+* Description : RT-Thread shell command printing the trace rings, oldest frame first:
+*
+*                   mb_trace              Frames of all the channels
+*                   mb_trace <ch>         Frames of channel <ch>
+*
+* Argument(s) : argc         is the number of arguments.
+*
+*               argv         is the table of arguments.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : RT-Thread shell.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#ifdef   RT_USING_FINSH
+static  void  MB_TraceCmd (int    argc,
+                           char **argv)
+{
+    MODBUS_CH  *pch;
+    int         ch;
+
+
+    ch = -1;
+    if (argc > 1) {
+        ch = atoi(argv[1]);
+    }
+    if (ch >= (int)MB_ChCtr) {
+        rt_kprintf("usage: mb_trace [ch], ch 0 to %d\n", (int)MB_ChCtr - 1);
+        return;
+    }
+
+    for (pch = &MB_ChTbl[0]; pch < &MB_ChTbl[MB_ChCtr]; pch++) {
+        if ((ch >= 0) && (pch->Ch != (CPU_INT08U)ch)) {
+            continue;
+        }
+        (void)MB_TraceDump(pch, MODBUS_TRACE_FMT_TEXT, MB_TraceCmdOut, (void *)0);
+    }
+}
+MSH_CMD_EXPORT_ALIAS(MB_TraceCmd, mb_trace, Modbus frame trace);
+#endif
+
+#endif
@@ -354,3 +354,184 @@ CPU_INT16U  MB_RTU_TxCalcCRC (MODBUS_CH *pch)
     return (crc);                                      /* Return CRC for all data in block.                       */
 }
 #endif
+
+
+/*
+*********************************************************************************************************
+*                                            MB_RTU_CRC_Upd()
+*
+* Description : Adds one byte to a running CRC-16.
+*
+* Argument(s) : crc       Is the CRC of the bytes so far, 0xFFFF before the first byte.
+*
+*               data      Is the next byte.
+*
+* Return(s)   : The CRC-16 including 'data'.
+*
+* Caller(s)   : MB_RTU_RxByte(),
+*               MB_TCP_RTU_Len().
+*
+* Note*(s)    : (1) The CRC of a frame including its own (valid) CRC is 0.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
+CPU_INT16U  MB_RTU_CRC_Upd (CPU_INT16U  crc,
+                            CPU_INT08U  data)
+{
+    CPU_INT08U      shiftctr;
+
+
+    crc      ^= (CPU_INT16U)data;
+    shiftctr  = 8;
+    do {
+        if ((crc & 0x0001) != 0) {                     /* If the bit shifted out is a 1 ...                       */
+            crc = (crc >> 1) ^ MODBUS_CRC16_POLY;      /* ... Exclusive OR with the generating polynomial         */
+        } else {
+            crc =  crc >> 1;
+        }
+        shiftctr--;
+    } while (shiftctr > 0);
+
+    return (crc);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MB_RegTypeSize()
+*
+* Description : Returns the size of a register value type.
+*
+* Argument(s) : type      Is one of MODBUS_TYPE_xxx.
+*
+* Return(s)   : The number of bytes (twice the number of registers) the type occupies, 0 if 'type' is invalid.
+*
+* Caller(s)   : MB_RegDecode(),
+*               MBM_FC03_HoldingRegRdT(),
+*               MBM_FC04_InRegRdT().
+*
+* Note*(s)    : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+CPU_INT08U  MB_RegTypeSize (CPU_INT08U  type)
+{
+    switch (type) {
+        case MODBUS_TYPE_U16:
+        case MODBUS_TYPE_S16:
+             return (2);
+
+        case MODBUS_TYPE_U32:
+        case MODBUS_TYPE_S32:
+        case MODBUS_TYPE_FP32:
+             return (4);
+
+        case MODBUS_TYPE_FP64:
+             return (8);
+
+        default:
+             return (0);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                             MB_RegDecode()
+*
+* Description : Converts register data as found in a Modbus frame into an array of native values.
+*
+* Argument(s) : psrc      Is a pointer to the first data byte in the frame.
+*
+*               pdest     Is a pointer to an array of 'nbr_vals' values of the C type matching 'type'
+*                         (CPU_INT16U, CPU_INT16S, CPU_INT32U, CPU_INT32S, CPU_FP32 or CPU_FP64).
+*
+*               nbr_vals  Is the number of values to convert.
+*
+*               type      Is the value type, one of MODBUS_TYPE_xxx.
+*
+*               order     Is the order of the bytes in the frame, one of MODBUS_ORDER_xxx:
+*
+*                             MODBUS_ORDER_ABCD    Most significant register first, high byte first
+*                             MODBUS_ORDER_BADC    Most significant register first, low  byte first
+*                             MODBUS_ORDER_CDAB    Least significant register first, high byte first
+*                             MODBUS_ORDER_DCBA    Least significant register first, low  byte first
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_RegRd_Resp(),
+*               MBM_RegRdFP_Resp().
+*
+* Note*(s)    : (1) The position in the frame of every byte of the native value is worked out once for
+*                   the whole array, for both the word order and the CPU's endianness.  Each value is
+*                   then converted in a single pass with no further swapping.
+*
+*               (2) Plain 16-bit registers, the most common case, are assembled directly.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MASTER_EN == DEF_ENABLED)
+void  MB_RegDecode (CPU_INT08U  *psrc,
+                    void        *pdest,
+                    CPU_INT16U   nbr_vals,
+                    CPU_INT08U   type,
+                    CPU_INT08U   order)
+{
+    CPU_INT08U   map[8];
+    CPU_INT08U   size;
+    CPU_INT08U   nbr_words;
+    CPU_INT08U   sig;
+    CPU_INT08U   word;
+    CPU_INT08U   byte;
+    CPU_INT08U   k;
+    CPU_INT16U   i;
+    CPU_INT08U  *pdest08;
+    CPU_INT16U  *pdest16;
+
+
+    size = MB_RegTypeSize(type);
+    if (size == 0) {
+        return;
+    }
+
+    if ((size == 2) && ((order & MODBUS_ORDER_BYTE_SWAP) == 0)) {  /* See Note #2                                  */
+        pdest16 = (CPU_INT16U *)pdest;
+        for (i = 0; i < nbr_vals; i++) {
+            *pdest16++ = ((CPU_INT16U)psrc[0] << 8) | (CPU_INT16U)psrc[1];
+            psrc      += 2;
+        }
+        return;
+    }
+
+    nbr_words = size / 2;                                  /* Build the byte map (see Note #1)                    */
+    for (k = 0; k < size; k++) {
+#if CPU_CFG_ENDIAN_TYPE == CPU_ENDIAN_TYPE_BIG
+        sig  = k;                                          /* Significance of native byte 'k', 0 = MSB            */
+#else
+        sig  = size - 1 - k;
+#endif
+        word = sig / 2;
+        byte = sig % 2;
+        if ((order & MODBUS_ORDER_WORD_SWAP) != 0) {
+            word = nbr_words - 1 - word;
+        }
+        if ((order & MODBUS_ORDER_BYTE_SWAP) != 0) {
+            byte = 1 - byte;
+        }
+        map[k] = word * 2 + byte;
+    }
+
+    pdest08 = (CPU_INT08U *)pdest;
+    for (i = 0; i < nbr_vals; i++) {
+        for (k = 0; k < size; k++) {
+            pdest08[k] = psrc[map[k]];
+        }
+        pdest08 += size;
+        psrc    += size;
+    }
+}
+#endif
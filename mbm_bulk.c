@@ -0,0 +1,500 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                   uC/MODBUS MASTER BULK TRANSFERS
+*
+* Filename : mbm_bulk.c
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) The MBM_Bulkxxx() functions read or write any number of consecutive coils, DIs or registers.
+*                The range is split into as few requests as the frame limits allow:
+*
+*                    FC01/FC02 read     2000 coils/DIs    FC15 write     1968 coils
+*                    FC03/FC04 read      125 registers    FC16 write      123 registers
+*
+*                or less when MODBUS_CFG_BUF_SIZE is too small for a full frame (see Note #4).  The data of
+*                each request is transferred directly to/from the caller's table.
+*
+*            (2) The channel stays locked for the whole range, the requests are sent back to back and no other
+*                task can use the channel in between.  A serial line carries one request at a time, so the
+*                requests are not pipelined.
+*
+*            (3) The transfer stops at the first request that fails.  The points before it have been read or
+*                written, the other ones have not.
+*
+*            (4) The largest request and response must fit .TxBuf[] and .RxBuf[] in the channel's framing, so
+*                an ASCII channel transfers about half as many points per request as an RTU channel (see
+*                MBM_NbrMax()).
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define    MBM_BULK_MODULE
+#include  "mb.h"
+
+
+#if (MODBUS_CFG_MBM_BULK_EN == DEF_ENABLED)
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  MBM_BULK_WR_OVERHEAD                 9                 /* RTU write request: addr, FC, start, qty, byte ...  */
+                                                                /* ... count and CRC                                  */
+
+
+/*
+*********************************************************************************************************
+*                                           LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  CPU_INT16U  MBM_BulkXfer (MODBUS_CH   *pch,
+                                  CPU_INT08U   slave_node,
+                                  CPU_INT08U   fc,
+                                  CPU_INT16U   slave_addr,
+                                  CPU_INT08U  *p_bit_tbl,
+                                  CPU_INT16U  *p_reg_tbl,
+                                  CPU_INT16U   nbr_points);
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_ASCII_EN == DEF_ENABLED)
+#if ((((MODBUS_CFG_BUF_SIZE - 1) / 2 - MBM_BULK_WR_OVERHEAD) / 2) < 1)
+#error  "MODBUS_CFG_BUF_SIZE                     too small for MODBUS_CFG_MBM_BULK_EN in ASCII mode      "
+#endif
+#else
+#if (((MODBUS_CFG_BUF_SIZE - 4 - MBM_BULK_WR_OVERHEAD) / 2) < 1)
+#error  "MODBUS_CFG_BUF_SIZE                     too small for MODBUS_CFG_MBM_BULK_EN                    "
+#endif
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MBM_BulkCoilRd()
+*
+* Description : Reads any number of consecutive coils from a slave (see Note #1 at the top of this file).
+*
+* Argument(s) : pch              Is a pointer to the Modbus channel to send the requests to.
+*
+*               slave_node       Is the Modbus node number of the desired slave to obtain the information from.
+*
+*               slave_addr       Is the Modbus coil start address
+*
+*               p_coil_tbl       Is a pointer to an array of bytes that will receive the value of the coils read,
+*                                in the format of MBM_FC01_CoilRd().  The array must be greater than or equal
+*                                to:   (nbr_coils - 1) / 8 + 1
+*
+*               nbr_coils        Is the desired number of coils to read
+*
+* Return(s)   : MODBUS_ERR_NONE          If all the coils were read.
+*               MODBUS_ERR_NULLPTR       If 'pch' or 'p_coil_tbl' is a NULL pointer.
+*               MODBUS_ERR_INVALID       If 'nbr_coils' is 0 or the range goes past address 65535.
+*               Other                    See MBM_FC01_CoilRd().
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_FC01_EN == DEF_ENABLED)
+CPU_INT16U  MBM_BulkCoilRd (MODBUS_CH   *pch,
+                            CPU_INT08U   slave_node,
+                            CPU_INT16U   slave_addr,
+                            CPU_INT08U  *p_coil_tbl,
+                            CPU_INT16U   nbr_coils)
+{
+    return (MBM_BulkXfer(pch, slave_node, MODBUS_FC01_COIL_RD, slave_addr, p_coil_tbl, (CPU_INT16U *)0, nbr_coils));
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_BulkDIRd()
+*
+* Description : Reads any number of consecutive discrete inputs from a slave (see Note #1 at the top of this
+*               file).
+*
+* Argument(s) : pch              Is a pointer to the Modbus channel to send the requests to.
+*
+*               slave_node       Is the Modbus node number of the desired slave to obtain the information from.
+*
+*               slave_addr       Is the Modbus discrete input start address
+*
+*               p_di_tbl         Is a pointer to an array of bytes that will receive the state of the discrete
+*                                inputs, in the format of MBM_FC02_DIRd().  The array must be greater than or
+*                                equal to:   (nbr_di - 1) / 8 + 1
+*
+*               nbr_di           Is the desired number of discrete inputs to read
+*
+* Return(s)   : MODBUS_ERR_NONE          If all the discrete inputs were read.
+*               MODBUS_ERR_NULLPTR       If 'pch' or 'p_di_tbl' is a NULL pointer.
+*               MODBUS_ERR_INVALID       If 'nbr_di' is 0 or the range goes past address 65535.
+*               Other                    See MBM_FC02_DIRd().
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_FC02_EN == DEF_ENABLED)
+CPU_INT16U  MBM_BulkDIRd (MODBUS_CH   *pch,
+                          CPU_INT08U   slave_node,
+                          CPU_INT16U   slave_addr,
+                          CPU_INT08U  *p_di_tbl,
+                          CPU_INT16U   nbr_di)
+{
+    return (MBM_BulkXfer(pch, slave_node, MODBUS_FC02_DI_RD, slave_addr, p_di_tbl, (CPU_INT16U *)0, nbr_di));
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        MBM_BulkHoldingRegRd()
+*
+* Description : Reads any number of consecutive holding registers from a slave (see Note #1 at the top of
+*               this file).
+*
+* Argument(s) : pch              Is a pointer to the Modbus channel to send the requests to.
+*
+*               slave_node       Is the Modbus node number of the desired slave to obtain the information from.
+*
+*               slave_addr       Is the Modbus holding register start address
+*
+*               p_reg_tbl        Is a pointer to an array of integers that will receive the value of the
+*                                registers.  The array must hold at least 'nbr_regs' entries.
+*
+*               nbr_regs         Is the desired number of registers to read
+*
+* Return(s)   : MODBUS_ERR_NONE          If all the registers were read.
+*               MODBUS_ERR_NULLPTR       If 'pch' or 'p_reg_tbl' is a NULL pointer.
+*               MODBUS_ERR_INVALID       If 'nbr_regs' is 0 or the range goes past address 65535.
+*               Other                    See MBM_FC03_HoldingRegRd().
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_FC03_EN == DEF_ENABLED)
+CPU_INT16U  MBM_BulkHoldingRegRd (MODBUS_CH   *pch,
+                                  CPU_INT08U   slave_node,
+                                  CPU_INT16U   slave_addr,
+                                  CPU_INT16U  *p_reg_tbl,
+                                  CPU_INT16U   nbr_regs)
+{
+    return (MBM_BulkXfer(pch, slave_node, MODBUS_FC03_HOLDING_REG_RD, slave_addr, (CPU_INT08U *)0, p_reg_tbl, nbr_regs));
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          MBM_BulkInRegRd()
+*
+* Description : Reads any number of consecutive input registers from a slave (see Note #1 at the top of this
+*               file).
+*
+* Argument(s) : pch              Is a pointer to the Modbus channel to send the requests to.
+*
+*               slave_node       Is the Modbus node number of the desired slave to obtain the information from.
+*
+*               slave_addr       Is the Modbus input register start address
+*
+*               p_reg_tbl        Is a pointer to an array of integers that will receive the value of the
+*                                registers.  The array must hold at least 'nbr_regs' entries.
+*
+*               nbr_regs         Is the desired number of registers to read
+*
+* Return(s)   : MODBUS_ERR_NONE          If all the registers were read.
+*               MODBUS_ERR_NULLPTR       If 'pch' or 'p_reg_tbl' is a NULL pointer.
+*               MODBUS_ERR_INVALID       If 'nbr_regs' is 0 or the range goes past address 65535.
+*               Other                    See MBM_FC04_InRegRd().
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_FC04_EN == DEF_ENABLED)
+CPU_INT16U  MBM_BulkInRegRd (MODBUS_CH   *pch,
+                             CPU_INT08U   slave_node,
+                             CPU_INT16U   slave_addr,
+                             CPU_INT16U  *p_reg_tbl,
+                             CPU_INT16U   nbr_regs)
+{
+    return (MBM_BulkXfer(pch, slave_node, MODBUS_FC04_IN_REG_RD, slave_addr, (CPU_INT08U *)0, p_reg_tbl, nbr_regs));
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MBM_BulkCoilWr()
+*
+* Description : Writes any number of consecutive coils to a slave (see Note #1 at the top of this file).
+*
+* Argument(s) : pch              Is a pointer to the Modbus channel to send the requests to.
+*
+*               slave_node       Is the Modbus node number of the desired slave to write to.
+*
+*               slave_addr       Is the Modbus coil start address
+*
+*               p_coil_tbl       Is a pointer to an array of bytes containing the value of the coils to write,
+*                                in the format of MBM_FC15_CoilWr().  The array must be greater than or equal
+*                                to:   (nbr_coils - 1) / 8 + 1
+*
+*               nbr_coils        Is the desired number of coils to write
+*
+* Return(s)   : MODBUS_ERR_NONE          If all the coils were written.
+*               MODBUS_ERR_NULLPTR       If 'pch' or 'p_coil_tbl' is a NULL pointer.
+*               MODBUS_ERR_INVALID       If 'nbr_coils' is 0 or the range goes past address 65535.
+*               Other                    See MBM_FC15_CoilWr().
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_FC15_EN == DEF_ENABLED)
+CPU_INT16U  MBM_BulkCoilWr (MODBUS_CH   *pch,
+                            CPU_INT08U   slave_node,
+                            CPU_INT16U   slave_addr,
+                            CPU_INT08U  *p_coil_tbl,
+                            CPU_INT16U   nbr_coils)
+{
+    return (MBM_BulkXfer(pch, slave_node, MODBUS_FC15_COIL_WR_MULTIPLE, slave_addr, p_coil_tbl, (CPU_INT16U *)0, nbr_coils));
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        MBM_BulkHoldingRegWr()
+*
+* Description : Writes any number of consecutive holding registers to a slave (see Note #1 at the top of
+*               this file).
+*
+* Argument(s) : pch              Is a pointer to the Modbus channel to send the requests to.
+*
+*               slave_node       Is the Modbus node number of the desired slave to write to.
+*
+*               slave_addr       Is the Modbus holding register start address
+*
+*               p_reg_tbl        Is a pointer to an array of integers containing the value of the registers to
+*                                write.  The array must hold at least 'nbr_regs' entries.
+*
+*               nbr_regs         Is the desired number of registers to write
+*
+* Return(s)   : MODBUS_ERR_NONE          If all the registers were written.
+*               MODBUS_ERR_NULLPTR       If 'pch' or 'p_reg_tbl' is a NULL pointer.
+*               MODBUS_ERR_INVALID       If 'nbr_regs' is 0 or the range goes past address 65535.
+*               Other                    See MBM_FC16_HoldingRegWrN().
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_FC16_EN == DEF_ENABLED)
+CPU_INT16U  MBM_BulkHoldingRegWr (MODBUS_CH   *pch,
+                                  CPU_INT08U   slave_node,
+                                  CPU_INT16U   slave_addr,
+                                  CPU_INT16U  *p_reg_tbl,
+                                  CPU_INT16U   nbr_regs)
+{
+    return (MBM_BulkXfer(pch, slave_node, MODBUS_FC16_HOLDING_REG_WR_MULTIPLE, slave_addr, (CPU_INT08U *)0, p_reg_tbl, nbr_regs));
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_BulkXfer()
+*
+* Description : Splits a range of points into requests of the largest size allowed and executes them.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel to send the requests to.
+*
+*               slave_node   Is the Modbus node number of the slave.
+*
+*               fc           Is the function code of the requests (MODBUS_FC01_xxx to MODBUS_FC04_xxx,
+*                            MODBUS_FC15_xxx or MODBUS_FC16_xxx).
+*
+*               slave_addr   Is the address of the first point.
+*
+*               p_bit_tbl    Is a pointer to the caller's table of coils/DIs (FC01, FC02 and FC15).
+*
+*               p_reg_tbl    Is a pointer to the caller's table of registers (FC03, FC04 and FC16).
+*
+*               nbr_points   Is the number of points to transfer.
+*
+* Return(s)   : MODBUS_ERR_NONE     If all the points were transferred.
+*               MODBUS_ERR_NULLPTR  If 'pch' or the table is a NULL pointer.
+*               MODBUS_ERR_INVALID  If 'nbr_points' is 0 or the range goes past address 65535.
+*               Other               The error of the request that failed (see Note #3 at the top of this file).
+*
+* Caller(s)   : MBM_Bulkxxx().
+*
+* Note(s)     : (1) A request for the largest number of coils/DIs fills a whole number of bytes, so every
+*                   request but the last one starts on a byte boundary of the caller's table.
+*********************************************************************************************************
+*/
+
+static  CPU_INT16U  MBM_BulkXfer (MODBUS_CH   *pch,
+                                  CPU_INT08U   slave_node,
+                                  CPU_INT08U   fc,
+                                  CPU_INT16U   slave_addr,
+                                  CPU_INT08U  *p_bit_tbl,
+                                  CPU_INT16U  *p_reg_tbl,
+                                  CPU_INT16U   nbr_points)
+{
+    CPU_INT16U  err;
+    CPU_INT16U  nbr_max;
+    CPU_INT16U  nbr;
+
+
+    if (pch == (MODBUS_CH *)0) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+    if ((p_bit_tbl == (CPU_INT08U *)0) &&
+        (p_reg_tbl == (CPU_INT16U *)0)) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+    if ((nbr_points == 0) ||
+        (((CPU_INT32U)slave_addr + nbr_points) > 0x10000uL)) {
+        return (MODBUS_ERR_INVALID);
+    }
+
+    nbr_max = MBM_NbrMax(pch, fc);
+
+    MB_OS_ChLock(pch,                                           /* Keep the channel for the whole range               */
+                 &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
+    while ((nbr_points > 0) &&
+           (err        == MODBUS_ERR_NONE)) {
+        nbr = (nbr_points > nbr_max) ? nbr_max : nbr_points;
+        switch (fc) {
+#if (MODBUS_CFG_FC01_EN == DEF_ENABLED)
+            case MODBUS_FC01_COIL_RD:
+                 err = MBM_FC01_CoilRd(pch, slave_node, slave_addr, p_bit_tbl, nbr);
+                 break;
+#endif
+
+#if (MODBUS_CFG_FC02_EN == DEF_ENABLED)
+            case MODBUS_FC02_DI_RD:
+                 err = MBM_FC02_DIRd(pch, slave_node, slave_addr, p_bit_tbl, nbr);
+                 break;
+#endif
+
+#if (MODBUS_CFG_FC03_EN == DEF_ENABLED)
+            case MODBUS_FC03_HOLDING_REG_RD:
+                 err = MBM_FC03_HoldingRegRd(pch, slave_node, slave_addr, p_reg_tbl, nbr);
+                 break;
+#endif
+
+#if (MODBUS_CFG_FC04_EN == DEF_ENABLED)
+            case MODBUS_FC04_IN_REG_RD:
+                 err = MBM_FC04_InRegRd(pch, slave_node, slave_addr, p_reg_tbl, nbr);
+                 break;
+#endif
+
+#if (MODBUS_CFG_FC15_EN == DEF_ENABLED)
+            case MODBUS_FC15_COIL_WR_MULTIPLE:
+                 err = MBM_FC15_CoilWr(pch, slave_node, slave_addr, p_bit_tbl, nbr);
+                 break;
+#endif
+
+#if (MODBUS_CFG_FC16_EN == DEF_ENABLED)
+            case MODBUS_FC16_HOLDING_REG_WR_MULTIPLE:
+                 err = MBM_FC16_HoldingRegWrN(pch, slave_node, slave_addr, p_reg_tbl, nbr);
+                 break;
+#endif
+
+            default:
+                 err = MODBUS_ERR_INVALID;
+                 break;
+        }
+
+        if (p_bit_tbl != (CPU_INT08U *)0) {                     /* Advance to the next request (see Note #1)          */
+            p_bit_tbl += nbr / 8;
+        } else {
+            p_reg_tbl += nbr;
+        }
+        slave_addr += nbr;
+        nbr_points -= nbr;
+    }
+
+    MB_OS_ChUnlock(pch);
+
+    return (err);
+}
+#endif
@@ -0,0 +1,678 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                      uC/MODBUS MASTER VALUE CACHE
+*
+* Filename : mbm_cache.c
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) The cache holds the last value of coils, DIs and registers read by the master, keyed by
+*                channel, slave, table (MODBUS_FC01_xxx to MODBUS_FC04_xxx) and address.  Each entry has the
+*                time the value was acquired and its quality:
+*
+*                    MODBUS_MBM_CACHE_GOOD     the last request for the point succeeded
+*                    MODBUS_MBM_CACHE_BAD      the last request failed, the value is the one read before
+*
+*            (2) The cache is filled below the master API: every successful FC01 to FC04 read stores its
+*                points, whether the request came from the application, the bulk functions or the scan list
+*                (see mbm_scan.c).  Successful writes (FC05, FC06, FC15 and FC16) update the points that are
+*                already cached.  A failed request marks the points it covers as BAD.  Floating point
+*                and typed (MBM_FC0x_xxxRdT()) requests are not cached.
+*
+*            (3) MBM_CacheRegRd() and MBM_CacheBitRd() return cached values no older than 'age_max' ticks
+*                without using the bus, and read the slave otherwise.  MBM_CacheValGet() returns one point
+*                with its timestamp and quality, and never uses the bus.
+*
+*            (4) Entries are placed by hashing their key into MODBUS_CFG_MBM_CACHE_SIZE slots.  A key is
+*                looked up in MBM_CACHE_PROBE_MAX consecutive slots at most.  When none of these is free,
+*                the entry acquired the longest time ago is replaced.
+*
+*            (5) The cache is shared by all the channels, it is only accessed in critical sections.
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define    MBM_CACHE_MODULE
+#include  "mb.h"
+
+
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_CACHE_SIZE < 8)                             /* Max. nbr of slots searched for a key (see Note #4) */
+#define  MBM_CACHE_PROBE_MAX            MODBUS_CFG_MBM_CACHE_SIZE
+#else
+#define  MBM_CACHE_PROBE_MAX                            8
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+typedef  struct  mbm_cache_entry {
+    MODBUS_CH   *ChPtr;                                 /* Channel of the slave, NULL if the slot is free     */
+    CPU_INT08U   SlaveAddr;                             /* Node address of the slave                          */
+    CPU_INT08U   FC;                                    /* Table, MODBUS_FC01_xxx to MODBUS_FC04_xxx          */
+    CPU_INT16U   Addr;                                  /* Address of the coil, DI or register                */
+    CPU_INT16U   Val;                                   /* Last value read (0 or 1 for coils and DIs)         */
+    CPU_INT08U   Quality;                               /* MODBUS_MBM_CACHE_GOOD or MODBUS_MBM_CACHE_BAD      */
+    CPU_INT32U   Ts;                                    /* Time the value was acquired (ticks)                */
+} MBM_CACHE_ENTRY;
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+static  MBM_CACHE_ENTRY  MBM_CacheTbl[MODBUS_CFG_MBM_CACHE_SIZE];
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  MBM_CACHE_ENTRY  *MBM_CacheGet (MODBUS_CH   *pch,
+                                        CPU_INT08U   slave_addr,
+                                        CPU_INT08U   fc,
+                                        CPU_INT16U   addr,
+                                        CPU_INT32U   now,
+                                        CPU_BOOLEAN  alloc);
+
+static  CPU_INT16U        MBM_CacheChk (MODBUS_CH   *pch,
+                                        CPU_INT08U   slave_addr,
+                                        CPU_INT08U   fc,
+                                        CPU_INT16U   addr,
+                                        CPU_INT16U   nbr,
+                                        CPU_INT32U   age_max,
+                                        CPU_INT08U  *p_bit_tbl,
+                                        CPU_INT16U  *p_reg_tbl);
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_CacheClr()
+*
+* Description : Empties the cache.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_Init(),
+*               Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MBM_CacheClr (void)
+{
+    CPU_INT16U   i;
+    CPU_SR       cpu_sr;
+
+
+    cpu_sr = 0;
+    for (i = 0; i < MODBUS_CFG_MBM_CACHE_SIZE; i++) {
+        CPU_CRITICAL_ENTER();
+        MBM_CacheTbl[i].ChPtr = (MODBUS_CH *)0;
+        CPU_CRITICAL_EXIT();
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MBM_CacheValGet()
+*
+* Description : Returns the cached value of a coil, DI or register without using the bus.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel of the slave.
+*
+*               slave_addr   Is the node address of the slave.
+*
+*               fc           Is the table of the point: MODBUS_FC01_COIL_RD, MODBUS_FC02_DI_RD,
+*                            MODBUS_FC03_HOLDING_REG_RD or MODBUS_FC04_IN_REG_RD.
+*
+*               addr         Is the address of the point.
+*
+*               pval         Is a pointer to a variable that will receive the value (0 or 1 for coils and DIs).
+*
+*               pts          Is a pointer to a variable that will receive the time the value was acquired, in
+*                            ticks (see MB_OS_TimeGet()).  May be NULL.
+*
+*               pquality     Is a pointer to a variable that will receive the quality of the value,
+*                            MODBUS_MBM_CACHE_GOOD or MODBUS_MBM_CACHE_BAD.  May be NULL.
+*
+* Return(s)   : MODBUS_ERR_NONE          If the point is cached.
+*               MODBUS_ERR_NULLPTR       If 'pch' or 'pval' is a NULL pointer.
+*               MODBUS_ERR_NO_DATA       If the point is not cached.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MBM_CacheValGet (MODBUS_CH   *pch,
+                             CPU_INT08U   slave_addr,
+                             CPU_INT08U   fc,
+                             CPU_INT16U   addr,
+                             CPU_INT16U  *pval,
+                             CPU_INT32U  *pts,
+                             CPU_INT08U  *pquality)
+{
+    MBM_CACHE_ENTRY  *pentry;
+    CPU_INT32U        now;
+    CPU_SR            cpu_sr;
+
+
+    if ((pch  == (MODBUS_CH  *)0) ||
+        (pval == (CPU_INT16U *)0)) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+
+    now    = MB_OS_TimeGet();
+    cpu_sr = 0;
+    CPU_CRITICAL_ENTER();
+    pentry = MBM_CacheGet(pch, slave_addr, fc, addr, now, DEF_FALSE);
+    if (pentry == (MBM_CACHE_ENTRY *)0) {
+        CPU_CRITICAL_EXIT();
+        return (MODBUS_ERR_NO_DATA);
+    }
+    *pval = pentry->Val;
+    if (pts != (CPU_INT32U *)0) {
+        *pts = pentry->Ts;
+    }
+    if (pquality != (CPU_INT08U *)0) {
+        *pquality = pentry->Quality;
+    }
+    CPU_CRITICAL_EXIT();
+
+    return (MODBUS_ERR_NONE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MBM_CacheRegRd()
+*
+* Description : Reads holding or input registers from the cache if they are recent enough, from the slave
+*               otherwise (see Note #3 at the top of this file).
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel of the slave.
+*
+*               slave_node   Is the node address of the slave.
+*
+*               fc           Is MODBUS_FC03_HOLDING_REG_RD or MODBUS_FC04_IN_REG_RD.
+*
+*               slave_addr   Is the address of the first register.
+*
+*               p_reg_tbl    Is a pointer to an array that will receive the 'nbr_regs' registers.
+*
+*               nbr_regs     Is the number of registers to read.
+*
+*               age_max      Is the age of the oldest value the caller accepts, in ticks.
+*
+* Return(s)   : MODBUS_ERR_NONE          If the registers were read.
+*               MODBUS_ERR_NULLPTR       If 'pch' or 'p_reg_tbl' is a NULL pointer.
+*               MODBUS_ERR_INVALID       If 'fc' is not a register table.
+*               Other                    See MBM_FC03_HoldingRegRd() and MBM_FC04_InRegRd().
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) If any of the registers is missing, BAD or too old, the whole range is read from the
+*                   slave, which refreshes the cache.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MBM_CacheRegRd (MODBUS_CH   *pch,
+                            CPU_INT08U   slave_node,
+                            CPU_INT08U   fc,
+                            CPU_INT16U   slave_addr,
+                            CPU_INT16U  *p_reg_tbl,
+                            CPU_INT16U   nbr_regs,
+                            CPU_INT32U   age_max)
+{
+    CPU_INT16U  err;
+
+
+    if ((pch       == (MODBUS_CH  *)0) ||
+        (p_reg_tbl == (CPU_INT16U *)0)) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+
+    err = MBM_CacheChk(pch, slave_node, fc, slave_addr, nbr_regs, age_max, (CPU_INT08U *)0, p_reg_tbl);
+    if (err == MODBUS_ERR_NONE) {                               /* Served from the cache                              */
+        return (err);
+    }
+
+    switch (fc) {                                               /* See Note #1                                        */
+#if (MODBUS_CFG_FC03_EN == DEF_ENABLED)
+        case MODBUS_FC03_HOLDING_REG_RD:
+             err = MBM_FC03_HoldingRegRd(pch, slave_node, slave_addr, p_reg_tbl, nbr_regs);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC04_EN == DEF_ENABLED)
+        case MODBUS_FC04_IN_REG_RD:
+             err = MBM_FC04_InRegRd(pch, slave_node, slave_addr, p_reg_tbl, nbr_regs);
+             break;
+#endif
+
+        default:
+             err = MODBUS_ERR_INVALID;
+             break;
+    }
+
+    return (err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MBM_CacheBitRd()
+*
+* Description : Reads coils or discrete inputs from the cache if they are recent enough, from the slave
+*               otherwise (see Note #3 at the top of this file).
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel of the slave.
+*
+*               slave_node   Is the node address of the slave.
+*
+*               fc           Is MODBUS_FC01_COIL_RD or MODBUS_FC02_DI_RD.
+*
+*               slave_addr   Is the address of the first coil or DI.
+*
+*               p_bit_tbl    Is a pointer to an array of bytes that will receive the 'nbr_bits' points, in the
+*                            format of MBM_FC01_CoilRd().
+*
+*               nbr_bits     Is the number of coils or DIs to read.
+*
+*               age_max      Is the age of the oldest value the caller accepts, in ticks.
+*
+* Return(s)   : MODBUS_ERR_NONE          If the points were read.
+*               MODBUS_ERR_NULLPTR       If 'pch' or 'p_bit_tbl' is a NULL pointer.
+*               MODBUS_ERR_INVALID       If 'fc' is not a coil or DI table.
+*               Other                    See MBM_FC01_CoilRd() and MBM_FC02_DIRd().
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) If any of the points is missing, BAD or too old, the whole range is read from the slave,
+*                   which refreshes the cache.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MBM_CacheBitRd (MODBUS_CH   *pch,
+                            CPU_INT08U   slave_node,
+                            CPU_INT08U   fc,
+                            CPU_INT16U   slave_addr,
+                            CPU_INT08U  *p_bit_tbl,
+                            CPU_INT16U   nbr_bits,
+                            CPU_INT32U   age_max)
+{
+    CPU_INT16U  err;
+
+
+    if ((pch       == (MODBUS_CH  *)0) ||
+        (p_bit_tbl == (CPU_INT08U *)0)) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+
+    err = MBM_CacheChk(pch, slave_node, fc, slave_addr, nbr_bits, age_max, p_bit_tbl, (CPU_INT16U *)0);
+    if (err == MODBUS_ERR_NONE) {                               /* Served from the cache                              */
+        return (err);
+    }
+
+    switch (fc) {                                               /* See Note #1                                        */
+#if (MODBUS_CFG_FC01_EN == DEF_ENABLED)
+        case MODBUS_FC01_COIL_RD:
+             err = MBM_FC01_CoilRd(pch, slave_node, slave_addr, p_bit_tbl, nbr_bits);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC02_EN == DEF_ENABLED)
+        case MODBUS_FC02_DI_RD:
+             err = MBM_FC02_DIRd(pch, slave_node, slave_addr, p_bit_tbl, nbr_bits);
+             break;
+#endif
+
+        default:
+             err = MODBUS_ERR_INVALID;
+             break;
+    }
+
+    return (err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_CacheUpd()
+*
+* Description : Updates the cache with the outcome of a master request (see Note #2 at the top of this file).
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel.
+*
+*               slave_addr   Is the node address of the slave.
+*
+*               fc           Is the function code of the request, MODBUS_FC01_xxx to MODBUS_FC06_xxx,
+*                            MODBUS_FC15_xxx or MODBUS_FC16_xxx.
+*
+*               addr         Is the address of the first point of the request.
+*
+*               nbr          Is the number of points of the request.
+*
+*               p_bit_tbl    Is a pointer to the coils or DIs read or written (FC01, FC02, FC05 and FC15), in
+*                            the format of MBM_FC01_CoilRd().
+*
+*               p_reg_tbl    Is a pointer to the registers read or written (FC03, FC04, FC06 and FC16).
+*
+*               err          Is the result of the request.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_FCxx  Modbus Master Functions.
+*
+* Note(s)     : (1) Broadcasts are not answered, the slaves' values are unknown.
+*********************************************************************************************************
+*/
+
+void  MBM_CacheUpd (MODBUS_CH   *pch,
+                    CPU_INT08U   slave_addr,
+                    CPU_INT08U   fc,
+                    CPU_INT16U   addr,
+                    CPU_INT16U   nbr,
+                    CPU_INT08U  *p_bit_tbl,
+                    CPU_INT16U  *p_reg_tbl,
+                    CPU_INT16U   err)
+{
+    MBM_CACHE_ENTRY  *pentry;
+    CPU_BOOLEAN       alloc;
+    CPU_INT16U        i;
+    CPU_INT16U        val;
+    CPU_INT32U        ts;
+    CPU_SR            cpu_sr;
+
+
+    if (slave_addr == 0) {                                      /* See Note #1                                        */
+        return;
+    }
+
+    alloc = DEF_FALSE;                                          /* Writes only update cached points                   */
+    switch (fc) {
+        case MODBUS_FC01_COIL_RD:
+        case MODBUS_FC02_DI_RD:
+        case MODBUS_FC03_HOLDING_REG_RD:
+        case MODBUS_FC04_IN_REG_RD:
+             alloc = (err == MODBUS_ERR_NONE) ? DEF_TRUE : DEF_FALSE;
+             break;
+
+        case MODBUS_FC05_COIL_WR:
+        case MODBUS_FC15_COIL_WR_MULTIPLE:
+             fc    = MODBUS_FC01_COIL_RD;
+             break;
+
+        case MODBUS_FC06_HOLDING_REG_WR:
+        case MODBUS_FC16_HOLDING_REG_WR_MULTIPLE:
+             fc    = MODBUS_FC03_HOLDING_REG_RD;
+             break;
+
+        default:
+             return;
+    }
+
+    ts     = MB_OS_TimeGet();
+    cpu_sr = 0;
+    for (i = 0; i < nbr; i++) {
+        if (err == MODBUS_ERR_NONE) {
+            if (p_bit_tbl != (CPU_INT08U *)0) {
+                val = (p_bit_tbl[i / 8] >> (i % 8)) & 0x01;
+            } else {
+                val =  p_reg_tbl[i];
+            }
+        } else {
+            val = 0;
+        }
+
+        CPU_CRITICAL_ENTER();
+        pentry = MBM_CacheGet(pch, slave_addr, fc, addr + i, ts, alloc);
+        if (pentry != (MBM_CACHE_ENTRY *)0) {
+            if (err == MODBUS_ERR_NONE) {
+                pentry->Val     = val;
+                pentry->Quality = MODBUS_MBM_CACHE_GOOD;
+                pentry->Ts      = ts;
+            } else {
+                pentry->Quality = MODBUS_MBM_CACHE_BAD;
+            }
+        }
+        CPU_CRITICAL_EXIT();
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_CacheChk()
+*
+* Description : Copies a range of points from the cache if they are all GOOD and no older than 'age_max'.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel of the slave.
+*
+*               slave_addr   Is the node address of the slave.
+*
+*               fc           Is the table of the points, MODBUS_FC01_xxx to MODBUS_FC04_xxx.
+*
+*               addr         Is the address of the first point.
+*
+*               nbr          Is the number of points.
+*
+*               age_max      Is the age of the oldest value accepted, in ticks.
+*
+*               p_bit_tbl    Is a pointer to the array of bytes receiving coils or DIs, or NULL.
+*
+*               p_reg_tbl    Is a pointer to the array receiving registers, or NULL.
+*
+* Return(s)   : MODBUS_ERR_NONE          If all the points were copied.
+*               MODBUS_ERR_NO_DATA       If a point is missing, BAD or too old.  The destination may have
+*                                        been partially written.
+*
+* Caller(s)   : MBM_CacheBitRd(),
+*               MBM_CacheRegRd().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_INT16U  MBM_CacheChk (MODBUS_CH   *pch,
+                                  CPU_INT08U   slave_addr,
+                                  CPU_INT08U   fc,
+                                  CPU_INT16U   addr,
+                                  CPU_INT16U   nbr,
+                                  CPU_INT32U   age_max,
+                                  CPU_INT08U  *p_bit_tbl,
+                                  CPU_INT16U  *p_reg_tbl)
+{
+    MBM_CACHE_ENTRY  *pentry;
+    CPU_INT16U        i;
+    CPU_INT16U        val;
+    CPU_INT32U        now;
+    CPU_BOOLEAN       ok;
+    CPU_SR            cpu_sr;
+
+
+    if (nbr == 0) {
+        return (MODBUS_ERR_NO_DATA);
+    }
+
+    now    = MB_OS_TimeGet();
+    cpu_sr = 0;
+    for (i = 0; i < nbr; i++) {
+        CPU_CRITICAL_ENTER();
+        pentry = MBM_CacheGet(pch, slave_addr, fc, addr + i, now, DEF_FALSE);
+        ok     = DEF_FALSE;
+        val    = 0;
+        if (pentry != (MBM_CACHE_ENTRY *)0) {
+            if ((pentry->Quality == MODBUS_MBM_CACHE_GOOD) &&
+                ((now - pentry->Ts) <= age_max)) {
+                ok  = DEF_TRUE;
+                val = pentry->Val;
+            }
+        }
+        CPU_CRITICAL_EXIT();
+
+        if (ok == DEF_FALSE) {
+            return (MODBUS_ERR_NO_DATA);
+        }
+
+        if (p_bit_tbl != (CPU_INT08U *)0) {
+            if ((i % 8) == 0) {
+                p_bit_tbl[i / 8] = 0;
+            }
+            p_bit_tbl[i / 8] |= (CPU_INT08U)(val << (i % 8));
+        } else {
+            p_reg_tbl[i] = val;
+        }
+    }
+
+    return (MODBUS_ERR_NONE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_CacheGet()
+*
+* Description : Finds the cache entry of a point, or takes one for it.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel of the slave.
+*
+*               slave_addr   Is the node address of the slave.
+*
+*               fc           Is the table of the point, MODBUS_FC01_xxx to MODBUS_FC04_xxx.
+*
+*               addr         Is the address of the point.
+*
+*               now          Is the current time, in ticks.
+*
+*               alloc        Is DEF_TRUE to take an entry when the point is not cached.
+*
+* Return(s)   : A pointer to the entry, NULL if the point is not cached and 'alloc' is DEF_FALSE.
+*
+* Caller(s)   : various.
+*
+* Note(s)     : (1) See Note #4 at the top of this file.  The caller is in a critical section.
+*
+*               (2) A new entry holds no value yet, the caller fills it.
+*********************************************************************************************************
+*/
+
+static  MBM_CACHE_ENTRY  *MBM_CacheGet (MODBUS_CH   *pch,
+                                        CPU_INT08U   slave_addr,
+                                        CPU_INT08U   fc,
+                                        CPU_INT16U   addr,
+                                        CPU_INT32U   now,
+                                        CPU_BOOLEAN  alloc)
+{
+    MBM_CACHE_ENTRY  *pentry;
+    MBM_CACHE_ENTRY  *pvictim;
+    CPU_INT32U        key;
+    CPU_INT16U        ix;
+    CPU_INT16U        i;
+
+
+    key     = ((CPU_INT32U)addr       << 16)                    /* See Note #1                                        */
+            ^ ((CPU_INT32U)slave_addr <<  8)
+            ^ ((CPU_INT32U)fc         <<  5)
+            ^  (CPU_INT32U)pch->Ch;
+    ix      = (CPU_INT16U)(((key * 2654435761u) >> 16) % MODBUS_CFG_MBM_CACHE_SIZE);
+    pvictim = (MBM_CACHE_ENTRY *)0;
+
+    for (i = 0; i < MBM_CACHE_PROBE_MAX; i++) {
+        pentry = &MBM_CacheTbl[ix];
+        if (pentry->ChPtr == (MODBUS_CH *)0) {                  /* Free slot, the key isn't further                   */
+            pvictim = pentry;
+            break;
+        }
+        if ((pentry->ChPtr     == pch)        &&
+            (pentry->SlaveAddr == slave_addr) &&
+            (pentry->FC        == fc)         &&
+            (pentry->Addr      == addr)) {
+            return (pentry);
+        }
+        if ((pvictim == (MBM_CACHE_ENTRY *)0) ||                /* Oldest entry of the slots searched                 */
+            ((now - pentry->Ts) > (now - pvictim->Ts))) {
+            pvictim = pentry;
+        }
+        ix++;
+        if (ix >= MODBUS_CFG_MBM_CACHE_SIZE) {
+            ix = 0;
+        }
+    }
+
+    if (alloc == DEF_FALSE) {
+        return ((MBM_CACHE_ENTRY *)0);
+    }
+
+    pvictim->ChPtr     = pch;                                   /* See Note #2                                        */
+    pvictim->SlaveAddr = slave_addr;
+    pvictim->FC        = fc;
+    pvictim->Addr      = addr;
+
+    return (pvictim);
+}
+
+#endif
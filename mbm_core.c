@@ -43,6 +43,21 @@
 *********************************************************************************************************
 */
 
+#if (((MODBUS_CFG_BUF_SIZE - 5) / 2) < 125)                     /* Max. nbr of registers in a typed read              */
+#define  MBM_REG_RD_MAX                 ((MODBUS_CFG_BUF_SIZE - 5) / 2)
+#else
+#define  MBM_REG_RD_MAX                                125
+#endif
+
+#define  MBM_NBR_BIT_RD_MAX                2000                 /* Max. nbr of coils/DIs per read request             */
+#define  MBM_NBR_BIT_WR_MAX                1968                 /* Max. nbr of coils per write request                */
+#define  MBM_NBR_REG_RD_MAX                 125                 /* Max. nbr of registers per read request             */
+#define  MBM_NBR_REG_WR_MAX                 123                 /* Max. nbr of registers per write request            */
+
+#define  MBM_NBR_RD_OVERHEAD                  5                 /* RTU read response: addr, FC, byte count and CRC    */
+#define  MBM_NBR_WR_OVERHEAD                  9                 /* RTU write request: addr, FC, start, qty, byte ...  */
+                                                                /* ... count and CRC                                  */
+
 
 /*
 *********************************************************************************************************
@@ -157,7 +172,9 @@ static  CPU_INT16U   MBM_Coil_DI_Rd_Resp(MODBUS_CH   *pch,
 #if  (MODBUS_CFG_FC03_EN == DEF_ENABLED) || \
      (MODBUS_CFG_FC04_EN == DEF_ENABLED)
 static  CPU_INT16U   MBM_RegRd_Resp     (MODBUS_CH   *pch,
-                                         CPU_INT16U  *ptbl);
+                                         void        *ptbl,
+                                         CPU_INT08U   type,
+                                         CPU_INT08U   order);
 #endif
 
 #if  (MODBUS_CFG_FC03_EN == DEF_ENABLED) && \
@@ -187,10 +204,42 @@ static  CPU_INT16U   MBM_Diag_Resp      (MODBUS_CH   *pch,
                                          CPU_INT16U  *pval);
 #endif
 
+#if   (MODBUS_CFG_GW_EN == DEF_ENABLED)
+static  void         MBM_PDU_Cmd        (MODBUS_CH   *pch,
+                                         CPU_INT08U   slave_node,
+                                         CPU_INT08U  *p_pdu,
+                                         CPU_INT16U   pdu_len);
+
+static  CPU_INT16U   MBM_PDU_Resp       (MODBUS_CH   *pch,
+                                         CPU_INT08U  *p_pdu,
+                                         CPU_INT16U  *p_pdu_len,
+                                         CPU_INT16U   pdu_size);
+#endif
+
 static  CPU_BOOLEAN  MBM_RxReply        (MODBUS_CH   *pch);
 
 static  void         MBM_TxCmd          (MODBUS_CH   *pch);
 
+#if (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)
+static  CPU_INT16U   MBM_ReqCmd         (MODBUS_CH       *pch,
+                                         MODBUS_MBM_REQ  *preq);
+#endif
+
+#if (MODBUS_CFG_MBM_RX_EARLY_EN == DEF_ENABLED)
+static  CPU_INT16U   MBM_RxLenExp       (MODBUS_CH   *pch);
+#endif
+
+static  CPU_INT16U   MBM_TxRx           (MODBUS_CH   *pch);
+
+static  CPU_INT16U   MBM_TxRxAttempt    (MODBUS_CH   *pch,
+                                         CPU_INT32U   tmo_max,
+                                         CPU_BOOLEAN  retry);
+
+#if (MODBUS_CFG_MBM_RETRY_EN == DEF_ENABLED)
+static  CPU_BOOLEAN  MBM_RetryChk       (MODBUS_CH   *pch,
+                                         CPU_INT16U   err);
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -247,10 +296,15 @@ CPU_INT16U  MBM_FC01_CoilRd (MODBUS_CH   *pch,
                              CPU_INT16U   nbr_coils)
 {
     CPU_INT16U   err;
-    CPU_BOOLEAN  ok;
 
 
 
+    MB_OS_ChLock(pch,                                                           /* Get exclusive use of the channel  */
+                 &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
     MBM_TX_FRAME_NBYTES             = 4;
     MBM_TX_FRAME_SLAVE_ADDR         = slave_addr;                               /* Slave Address                     */
     MBM_TX_FRAME_FC                 = 1;                                        /* Function Code                     */
@@ -259,24 +313,23 @@ CPU_INT16U  MBM_FC01_CoilRd (MODBUS_CH   *pch,
     MBM_TX_FRAME_FC01_NBR_POINTS_HI = (CPU_INT08U)((nbr_coils  >> 8) & 0x00FF); /* Number of points                  */
     MBM_TX_FRAME_FC01_NBR_POINTS_LO = (CPU_INT08U) (nbr_coils        & 0x00FF);
 
-    MBM_TxCmd(pch);                                                             /* Send command to the slave         */
-
-    MB_OS_RxWait(pch,                                                           /* Wait for response from slave      */
-                 &err);
+    err = MBM_TxRx(pch);                                                        /* Send command, wait for the reply  */
 
     if (err == MODBUS_ERR_NONE) {
-        ok = MBM_RxReply(pch);
-        if (ok == MODBUS_TRUE) {
-            err = MBM_Coil_DI_Rd_Resp(pch,                                      /* Parse the response from the slave */
-                                      p_coil_tbl);
-        } else {
-            err = MODBUS_ERR_RX;
-        }
+        err = MBM_Coil_DI_Rd_Resp(pch,                                          /* Parse the response from the slave */
+                                  p_coil_tbl);
     }
 
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+    MBM_CacheUpd(pch, slave_addr, MODBUS_FC01_COIL_RD,                          /* Update the value cache            */
+                 start_addr, nbr_coils, p_coil_tbl, (CPU_INT16U *)0, err);
+#endif
+
     pch->RxBufByteCtr = 0;
     pch->RxBufPtr     = &pch->RxBuf[0];
 
+    MB_OS_ChUnlock(pch);                                                        /* Release the channel               */
+
     return (err);
 }
 #endif
@@ -330,10 +383,15 @@ CPU_INT16U  MBM_FC02_DIRd (MODBUS_CH   *pch,
                            CPU_INT16U   nbr_di)
 {
     CPU_INT16U   err;
-    CPU_BOOLEAN  ok;
 
 
 
+    MB_OS_ChLock(pch,                                                           /* Get exclusive use of the channel  */
+                 &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
     MBM_TX_FRAME_NBYTES             = 4;
     MBM_TX_FRAME_SLAVE_ADDR         = slave_node;                               /* Setup command                     */
     MBM_TX_FRAME_FC                 = 2;
@@ -342,24 +400,23 @@ CPU_INT16U  MBM_FC02_DIRd (MODBUS_CH   *pch,
     MBM_TX_FRAME_FC02_NBR_POINTS_HI = (CPU_INT08U)((nbr_di     >> 8) & 0x00FF);
     MBM_TX_FRAME_FC02_NBR_POINTS_LO = (CPU_INT08U) (nbr_di           & 0x00FF);
 
-    MBM_TxCmd(pch);                                                             /* Send command to the slave         */
-
-    MB_OS_RxWait(pch,                                                           /* Wait for response from slave      */
-                 &err);
+    err = MBM_TxRx(pch);                                                        /* Send command, wait for the reply  */
 
     if (err == MODBUS_ERR_NONE) {
-        ok = MBM_RxReply(pch);
-        if (ok == MODBUS_TRUE) {
-            err = MBM_Coil_DI_Rd_Resp(pch,                                      /* Parse the response from the slave */
-                                      p_di_tbl);
-        } else {
-            err = MODBUS_ERR_RX;
-        }
+        err = MBM_Coil_DI_Rd_Resp(pch,                                          /* Parse the response from the slave */
+                                  p_di_tbl);
     }
 
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+    MBM_CacheUpd(pch, slave_node, MODBUS_FC02_DI_RD,                            /* Update the value cache            */
+                 slave_addr, nbr_di, p_di_tbl, (CPU_INT16U *)0, err);
+#endif
+
     pch->RxBufByteCtr = 0;
     pch->RxBufPtr     = &pch->RxBuf[0];
 
+    MB_OS_ChUnlock(pch);                                                        /* Release the channel               */
+
     return (err);
 }
 #endif
@@ -403,10 +460,15 @@ CPU_INT16U  MBM_FC03_HoldingRegRd (MODBUS_CH   *pch,
                                    CPU_INT16U   nbr_regs)
 {
     CPU_INT16U   err;
-    CPU_BOOLEAN  ok;
 
 
 
+    MB_OS_ChLock(pch,                                                           /* Get exclusive use of the channel  */
+                 &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
     MBM_TX_FRAME_NBYTES             = 4;
     MBM_TX_FRAME_SLAVE_ADDR         = slave_node;                               /* Setup command                     */
     MBM_TX_FRAME_FC                 = 3;
@@ -415,24 +477,25 @@ CPU_INT16U  MBM_FC03_HoldingRegRd (MODBUS_CH   *pch,
     MBM_TX_FRAME_FC03_NBR_POINTS_HI = (CPU_INT08U)((nbr_regs   >> 8) & 0x00FF);
     MBM_TX_FRAME_FC03_NBR_POINTS_LO = (CPU_INT08U) (nbr_regs         & 0x00FF);
 
-    MBM_TxCmd(pch);                                                             /* Send command to the slave         */
-
-    MB_OS_RxWait(pch,                                                           /* Wait for response from slave      */
-                 &err);
+    err = MBM_TxRx(pch);                                                        /* Send command, wait for the reply  */
 
     if (err == MODBUS_ERR_NONE) {
-        ok = MBM_RxReply(pch);
-        if (ok == MODBUS_TRUE) {
-            err = MBM_RegRd_Resp(pch,                                           /* Parse the response from the slave */
-                                 p_reg_tbl);
-        } else {
-            err = MODBUS_ERR_RX;
-        }
+        err = MBM_RegRd_Resp(pch,                                               /* Parse the response from the slave */
+                             p_reg_tbl,
+                             MODBUS_TYPE_U16,
+                             MODBUS_ORDER_ABCD);
     }
 
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+    MBM_CacheUpd(pch, slave_node, MODBUS_FC03_HOLDING_REG_RD,                   /* Update the value cache            */
+                 slave_addr, nbr_regs, (CPU_INT08U *)0, p_reg_tbl, err);
+#endif
+
     pch->RxBufByteCtr = 0;
     pch->RxBufPtr     = &pch->RxBuf[0];
 
+    MB_OS_ChUnlock(pch);                                                        /* Release the channel               */
+
     return (err);
 }
 #endif
@@ -473,9 +536,14 @@ CPU_INT16U  MBM_FC03_HoldingRegRdFP (MODBUS_CH   *pch,
                                      CPU_INT16U   nbr_regs)
 {
     CPU_INT16U   err;
-    CPU_BOOLEAN  ok;
 
 
+    MB_OS_ChLock(pch,                                                           /* Get exclusive use of the channel  */
+                 &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
     MBM_TX_FRAME_NBYTES             = 4;
     MBM_TX_FRAME_SLAVE_ADDR         = slave_node;                               /* Setup command                     */
     MBM_TX_FRAME_FC                 = 3;
@@ -484,24 +552,18 @@ CPU_INT16U  MBM_FC03_HoldingRegRdFP (MODBUS_CH   *pch,
     MBM_TX_FRAME_FC03_NBR_POINTS_HI = (CPU_INT08U)((nbr_regs   >> 8) & 0x00FF);
     MBM_TX_FRAME_FC03_NBR_POINTS_LO = (CPU_INT08U) (nbr_regs         & 0x00FF);
 
-    MBM_TxCmd(pch);                                                             /* Send command to the slave         */
-
-    MB_OS_RxWait(pch,                                                           /* Wait for response from slave      */
-                 &err);
+    err = MBM_TxRx(pch);                                                        /* Send command, wait for the reply  */
 
     if (err == MODBUS_ERR_NONE) {
-        ok = MBM_RxReply(pch);
-        if (ok == MODBUS_TRUE) {
-            err = MBM_RegRdFP_Resp(pch,                                         /* Parse the response from the slave */
-                                   p_reg_tbl);
-        } else {
-            err = MODBUS_ERR_RX;
-        }
+        err = MBM_RegRdFP_Resp(pch,                                             /* Parse the response from the slave */
+                               p_reg_tbl);
     }
 
     pch->RxBufByteCtr = 0;
     pch->RxBufPtr     = &pch->RxBuf[0];
 
+    MB_OS_ChUnlock(pch);                                                        /* Release the channel               */
+
     return (err);
 }
 #endif
@@ -545,10 +607,15 @@ CPU_INT16U  MBM_FC04_InRegRd (MODBUS_CH   *pch,
                               CPU_INT16U   nbr_regs)
 {
     CPU_INT16U   err;
-    CPU_BOOLEAN  ok;
 
 
 
+    MB_OS_ChLock(pch,                                                           /* Get exclusive use of the channel  */
+                 &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
     MBM_TX_FRAME_NBYTES             = 4;
     MBM_TX_FRAME_SLAVE_ADDR         = slave_node;                               /* Setup command                     */
     MBM_TX_FRAME_FC                 = 4;
@@ -557,24 +624,219 @@ CPU_INT16U  MBM_FC04_InRegRd (MODBUS_CH   *pch,
     MBM_TX_FRAME_FC04_NBR_POINTS_HI = (CPU_INT08U)((nbr_regs   >> 8) & 0x00FF);
     MBM_TX_FRAME_FC04_NBR_POINTS_LO = (CPU_INT08U) (nbr_regs         & 0x00FF);
 
-    MBM_TxCmd(pch);                                                             /* Send command to the slave         */
+    err = MBM_TxRx(pch);                                                        /* Send command, wait for the reply  */
+
+    if (err == MODBUS_ERR_NONE) {
+        err = MBM_RegRd_Resp(pch,                                               /* Parse the response from the slave */
+                             p_reg_tbl,
+                             MODBUS_TYPE_U16,
+                             MODBUS_ORDER_ABCD);
+    }
+
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+    MBM_CacheUpd(pch, slave_node, MODBUS_FC04_IN_REG_RD,                        /* Update the value cache            */
+                 slave_addr, nbr_regs, (CPU_INT08U *)0, p_reg_tbl, err);
+#endif
+
+    pch->RxBufByteCtr = 0;
+    pch->RxBufPtr     = &pch->RxBuf[0];
+
+    MB_OS_ChUnlock(pch);                                                        /* Release the channel               */
+
+    return (err);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                         MBM_FC03_HoldingRegRdT()
+*
+* Description : Sends a MODBUS message to read holding registers from a slave unit and decodes their contents
+*               as typed values.
+*
+* Argument(s) : pch              Is a pointer to the Modbus channel to send the request to.
+*
+*               slave_node       Is the Modbus node number of the desired slave to obtain the information from.
+*
+*               slave_addr       Is the Modbus holding register start address
+*
+*               p_val_tbl        Is a pointer to an array that will receive the values.  The array must be of
+*                                the C type matching 'type' (see MB_RegDecode()) and hold 'nbr_vals' entries.
+*
+*               nbr_vals         Is the desired number of values to read
+*
+*               type             Is the type of each value, one of MODBUS_TYPE_xxx.  32-bit types take two
+*                                registers and 64-bit types take four.
+*
+*               order            Is the order in which the slave sends the bytes of a value, one of
+*                                MODBUS_ORDER_xxx.
+*
+* Return(s)   : MODBUS_ERR_NONE          If the function was sucessful.
+*               MODBUS_ERR_INVALID       If 'type' is invalid or the values don't fit in a single request
+*               MODBUS_ERR_RX            If a timeout occurred before receiving a response from the slave.
+*               MODBUS_ERR_SLAVE_ADDR    If the transmitted slave address doesn't correspond to the received slave address
+*               MODBUS_ERR_FC            If the transmitted function code doesn't correspond to the received function code
+*               MODBUS_ERR_BYTE_COUNT    If the expected number of bytes to receive doesn't correspond to the number of bytes received
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) The values are decoded straight from the receive buffer into 'p_val_tbl', so the
+*                   application gets native values with no further byte swapping.
+*
+*               (2) Typed reads are not entered into the value cache.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_FC03_EN == DEF_ENABLED)
+CPU_INT16U  MBM_FC03_HoldingRegRdT (MODBUS_CH   *pch,
+                                    CPU_INT08U   slave_node,
+                                    CPU_INT16U   slave_addr,
+                                    void        *p_val_tbl,
+                                    CPU_INT16U   nbr_vals,
+                                    CPU_INT08U   type,
+                                    CPU_INT08U   order)
+{
+    CPU_INT16U   nbr_regs;
+    CPU_INT16U   err;
+
+
+
+    if ((nbr_vals == 0) ||                                                      /* Validate the request              */
+        (nbr_vals >  MBM_REG_RD_MAX)) {
+        return (MODBUS_ERR_INVALID);
+    }
+    nbr_regs = nbr_vals * (MB_RegTypeSize(type) / 2);
+    if ((nbr_regs == 0) ||
+        (nbr_regs >  MBM_REG_RD_MAX)) {
+        return (MODBUS_ERR_INVALID);
+    }
 
-    MB_OS_RxWait(pch,                                                           /* Wait for response from slave      */
+    MB_OS_ChLock(pch,                                                           /* Get exclusive use of the channel  */
                  &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
+    MBM_TX_FRAME_NBYTES             = 4;
+    MBM_TX_FRAME_SLAVE_ADDR         = slave_node;                               /* Setup command                     */
+    MBM_TX_FRAME_FC                 = 3;
+    MBM_TX_FRAME_FC03_ADDR_HI       = (CPU_INT08U)((slave_addr >> 8) & 0x00FF);
+    MBM_TX_FRAME_FC03_ADDR_LO       = (CPU_INT08U) (slave_addr       & 0x00FF);
+    MBM_TX_FRAME_FC03_NBR_POINTS_HI = (CPU_INT08U)((nbr_regs   >> 8) & 0x00FF);
+    MBM_TX_FRAME_FC03_NBR_POINTS_LO = (CPU_INT08U) (nbr_regs         & 0x00FF);
+
+    err = MBM_TxRx(pch);                                                        /* Send command, wait for the reply  */
 
     if (err == MODBUS_ERR_NONE) {
-        ok = MBM_RxReply(pch);
-        if (ok == MODBUS_TRUE) {
-            err = MBM_RegRd_Resp(pch,                                           /* Parse the response from the slave */
-                                 p_reg_tbl);
-        } else {
-            err = MODBUS_ERR_RX;
-        }
+        err = MBM_RegRd_Resp(pch,                                               /* Decode the response (see Note #1) */
+                             p_val_tbl,
+                             type,
+                             order);
+    }
+
+    pch->RxBufByteCtr = 0;
+    pch->RxBufPtr     = &pch->RxBuf[0];
+
+    MB_OS_ChUnlock(pch);                                                        /* Release the channel               */
+
+    return (err);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                         MBM_FC04_InRegRdT()
+*
+* Description : Sends a MODBUS message to read input registers from a slave unit and decodes their contents
+*               as typed values.
+*
+* Argument(s) : pch              Is a pointer to the Modbus channel to send the request to.
+*
+*               slave_node       Is the Modbus node number of the desired slave to obtain the information from.
+*
+*               slave_addr       Is the Modbus input register start address
+*
+*               p_val_tbl        Is a pointer to an array that will receive the values.  The array must be of
+*                                the C type matching 'type' (see MB_RegDecode()) and hold 'nbr_vals' entries.
+*
+*               nbr_vals         Is the desired number of values to read
+*
+*               type             Is the type of each value, one of MODBUS_TYPE_xxx.  32-bit types take two
+*                                registers and 64-bit types take four.
+*
+*               order            Is the order in which the slave sends the bytes of a value, one of
+*                                MODBUS_ORDER_xxx.
+*
+* Return(s)   : MODBUS_ERR_NONE          If the function was sucessful.
+*               MODBUS_ERR_INVALID       If 'type' is invalid or the values don't fit in a single request
+*               MODBUS_ERR_RX            If a timeout occurred before receiving a response from the slave.
+*               MODBUS_ERR_SLAVE_ADDR    If the transmitted slave address doesn't correspond to the received slave address
+*               MODBUS_ERR_FC            If the transmitted function code doesn't correspond to the received function code
+*               MODBUS_ERR_BYTE_COUNT    If the expected number of bytes to receive doesn't correspond to the number of bytes received
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) The values are decoded straight from the receive buffer into 'p_val_tbl', so the
+*                   application gets native values with no further byte swapping.
+*
+*               (2) Typed reads are not entered into the value cache.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_FC04_EN == DEF_ENABLED)
+CPU_INT16U  MBM_FC04_InRegRdT (MODBUS_CH   *pch,
+                               CPU_INT08U   slave_node,
+                               CPU_INT16U   slave_addr,
+                               void        *p_val_tbl,
+                               CPU_INT16U   nbr_vals,
+                               CPU_INT08U   type,
+                               CPU_INT08U   order)
+{
+    CPU_INT16U   nbr_regs;
+    CPU_INT16U   err;
+
+
+
+    if ((nbr_vals == 0) ||                                                      /* Validate the request              */
+        (nbr_vals >  MBM_REG_RD_MAX)) {
+        return (MODBUS_ERR_INVALID);
+    }
+    nbr_regs = nbr_vals * (MB_RegTypeSize(type) / 2);
+    if ((nbr_regs == 0) ||
+        (nbr_regs >  MBM_REG_RD_MAX)) {
+        return (MODBUS_ERR_INVALID);
+    }
+
+    MB_OS_ChLock(pch,                                                           /* Get exclusive use of the channel  */
+                 &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
+    MBM_TX_FRAME_NBYTES             = 4;
+    MBM_TX_FRAME_SLAVE_ADDR         = slave_node;                               /* Setup command                     */
+    MBM_TX_FRAME_FC                 = 4;
+    MBM_TX_FRAME_FC04_ADDR_HI       = (CPU_INT08U)((slave_addr >> 8) & 0x00FF);
+    MBM_TX_FRAME_FC04_ADDR_LO       = (CPU_INT08U) (slave_addr       & 0x00FF);
+    MBM_TX_FRAME_FC04_NBR_POINTS_HI = (CPU_INT08U)((nbr_regs   >> 8) & 0x00FF);
+    MBM_TX_FRAME_FC04_NBR_POINTS_LO = (CPU_INT08U) (nbr_regs         & 0x00FF);
+
+    err = MBM_TxRx(pch);                                                        /* Send command, wait for the reply  */
+
+    if (err == MODBUS_ERR_NONE) {
+        err = MBM_RegRd_Resp(pch,                                               /* Decode the response (see Note #1) */
+                             p_val_tbl,
+                             type,
+                             order);
     }
 
     pch->RxBufByteCtr = 0;
     pch->RxBufPtr     = &pch->RxBuf[0];
 
+    MB_OS_ChUnlock(pch);                                                        /* Release the channel               */
+
     return (err);
 }
 #endif
@@ -616,10 +878,15 @@ CPU_INT16U  MBM_FC05_CoilWr (MODBUS_CH    *pch,
                              CPU_BOOLEAN   coil_val)
 {
     CPU_INT16U   err;
-    CPU_BOOLEAN  ok;
 
 
 
+    MB_OS_ChLock(pch,                                                           /* Get exclusive use of the channel  */
+                 &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
     MBM_TX_FRAME_NBYTES        = 4;
     MBM_TX_FRAME_SLAVE_ADDR    = slave_node;                                    /* Setup command                     */
     MBM_TX_FRAME_FC            = 5;
@@ -633,23 +900,22 @@ CPU_INT16U  MBM_FC05_CoilWr (MODBUS_CH    *pch,
         MBM_TX_FRAME_FC05_FORCE_DATA_LO = (CPU_INT08U)0x00;
     }
 
-    MBM_TxCmd(pch);                                                             /* Send command to the slave         */
-
-    MB_OS_RxWait(pch,                                                           /* Wait for response from slave      */
-                 &err);
+    err = MBM_TxRx(pch);                                                        /* Send command, wait for the reply  */
 
     if (err == MODBUS_ERR_NONE) {
-        ok = MBM_RxReply(pch);
-        if (ok == MODBUS_TRUE) {
-            err = MBM_CoilWr_Resp(pch);                                         /* Parse the response from the slave */
-        } else {
-            err = MODBUS_ERR_RX;
-        }
+        err = MBM_CoilWr_Resp(pch);                                             /* Parse the response from the slave */
     }
 
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+    MBM_CacheUpd(pch, slave_node, MODBUS_FC05_COIL_WR,                          /* Update the value cache            */
+                 slave_addr, 1, &MBM_TX_FRAME_FC05_FORCE_DATA_HI, (CPU_INT16U *)0, err);
+#endif
+
     pch->RxBufByteCtr = 0;
     pch->RxBufPtr     = &pch->RxBuf[0];
 
+    MB_OS_ChUnlock(pch);                                                        /* Release the channel               */
+
     return (err);
 }
 #endif
@@ -688,9 +954,14 @@ CPU_INT16U  MBM_FC06_HoldingRegWr (MODBUS_CH   *pch,
                                    CPU_INT16U   reg_val)
 {
     CPU_INT16U   err;
-    CPU_BOOLEAN  ok;
 
 
+    MB_OS_ChLock(pch,                                                           /* Get exclusive use of the channel  */
+                 &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
     MBM_TX_FRAME_NBYTES       = 4;
     MBM_TX_FRAME_SLAVE_ADDR   = slave_node;                                     /* Setup command                     */
     MBM_TX_FRAME_FC           = 6;
@@ -699,23 +970,22 @@ CPU_INT16U  MBM_FC06_HoldingRegWr (MODBUS_CH   *pch,
     MBM_TX_FRAME_FC06_DATA_HI = (CPU_INT08U)((reg_val >> 8)    & 0x00FF);
     MBM_TX_FRAME_FC06_DATA_LO = (CPU_INT08U) (reg_val          & 0x00FF);
 
-    MBM_TxCmd(pch);                                                             /* Send command to the slave         */
-
-    MB_OS_RxWait(pch,                                                           /* Wait for response from slave      */
-                 &err);
+    err = MBM_TxRx(pch);                                                        /* Send command, wait for the reply  */
 
     if (err == MODBUS_ERR_NONE) {
-        ok = MBM_RxReply(pch);
-        if (ok == MODBUS_TRUE) {
-            err = MBM_RegWr_Resp(pch);                                          /* Parse the response from the slave */
-        } else {
-            err = MODBUS_ERR_RX;
-        }
+        err = MBM_RegWr_Resp(pch);                                              /* Parse the response from the slave */
     }
 
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+    MBM_CacheUpd(pch, slave_node, MODBUS_FC06_HOLDING_REG_WR,                   /* Update the value cache            */
+                 slave_addr, 1, (CPU_INT08U *)0, &reg_val, err);
+#endif
+
     pch->RxBufByteCtr = 0;
     pch->RxBufPtr     = &pch->RxBuf[0];
 
+    MB_OS_ChUnlock(pch);                                                        /* Release the channel               */
+
     return (err);
 }
 #endif
@@ -755,13 +1025,18 @@ CPU_INT16U  MBM_FC06_HoldingRegWrFP (MODBUS_CH   *pch,
                                      CPU_FP32     reg_val_fp)
 {
     CPU_INT16U   err;
-    CPU_BOOLEAN  ok;
     CPU_INT08U   i;
     CPU_INT08U  *p_fp;
     CPU_INT08U  *p_data;
 
 
 
+    MB_OS_ChLock(pch,                                                           /* Get exclusive use of the channel  */
+                 &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
     MBM_TX_FRAME_NBYTES       = 4;
     MBM_TX_FRAME_SLAVE_ADDR   = slave_node;                                     /* Setup command                     */
     MBM_TX_FRAME_FC           = 6;
@@ -782,23 +1057,17 @@ CPU_INT16U  MBM_FC06_HoldingRegWrFP (MODBUS_CH   *pch,
     }
 #endif
 
-    MBM_TxCmd(pch);                                                             /* Send command                      */
-
-    MB_OS_RxWait(pch,                                                           /* Wait for response from slave      */
-                 &err);
+    err = MBM_TxRx(pch);                                                        /* Send command, wait for the reply  */
 
     if (err == MODBUS_ERR_NONE) {
-        ok = MBM_RxReply(pch);
-        if (ok == DEF_TRUE) {
-            err = MBM_RegWr_Resp(pch);                                          /* Parse the response from the slave */
-        } else {
-            err = MODBUS_ERR_RX;
-        }
+        err = MBM_RegWr_Resp(pch);                                              /* Parse the response from the slave */
     }
 
     pch->RxBufByteCtr = 0;
     pch->RxBufPtr     = &pch->RxBuf[0];
 
+    MB_OS_ChUnlock(pch);                                                        /* Release the channel               */
+
     return (err);
 }
 #endif
@@ -837,10 +1106,15 @@ CPU_INT16U  MBM_FC08_Diag (MODBUS_CH   *pch,
                            CPU_INT16U  *pval)
 {
     CPU_INT16U   err;
-    CPU_BOOLEAN  ok;
 
 
 
+    MB_OS_ChLock(pch,                                                           /* Get exclusive use of the channel  */
+                 &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
     MBM_TX_FRAME_NBYTES            = 4;
     MBM_TX_FRAME_SLAVE_ADDR        = slave_node;                                /* Setup command                     */
     MBM_TX_FRAME_FC                = 8;
@@ -849,19 +1123,11 @@ CPU_INT16U  MBM_FC08_Diag (MODBUS_CH   *pch,
     MBM_TX_FRAME_FC08_FNCT_DATA_HI = (CPU_INT08U)((fnct_data  >> 8) & 0x00FF);
     MBM_TX_FRAME_FC08_FNCT_DATA_LO = (CPU_INT08U) (fnct_data        & 0x00FF);
 
-    MBM_TxCmd(pch);                                                             /* Send command                      */
-
-    MB_OS_RxWait(pch,                                                           /* Wait for response from slave      */
-                 &err);
+    err = MBM_TxRx(pch);                                                        /* Send command, wait for the reply  */
 
     if (err == MODBUS_ERR_NONE) {
-        ok = MBM_RxReply(pch);
-        if (ok == MODBUS_TRUE) {
-            err = MBM_Diag_Resp(pch,                                            /* Parse the response from the slave */
-                                pval);
-        } else {
-            err = MODBUS_ERR_RX;
-        }
+        err = MBM_Diag_Resp(pch,                                                /* Parse the response from the slave */
+                            pval);
     } else {
         *pval = 0;
     }
@@ -869,6 +1135,8 @@ CPU_INT16U  MBM_FC08_Diag (MODBUS_CH   *pch,
     pch->RxBufByteCtr = 0;
     pch->RxBufPtr     = &pch->RxBuf[0];
 
+    MB_OS_ChUnlock(pch);                                                        /* Release the channel               */
+
     return (err);
 }
 #endif
@@ -922,21 +1190,26 @@ CPU_INT16U  MBM_FC15_CoilWr (MODBUS_CH   *pch,
                              CPU_INT16U   nbr_coils)
 {
     CPU_INT16U   err;
-    CPU_BOOLEAN  ok;
     CPU_INT08U   nbr_bytes;
     CPU_INT08U   i;
     CPU_INT08U  *p_data;
 
 
 
-    MBM_TX_FRAME_NBYTES             =  4;
+    MB_OS_ChLock(pch,                                                           /* Get exclusive use of the channel  */
+                 &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
+    nbr_bytes                       = (CPU_INT08U)(((nbr_coils - 1) / 8) + 1);
+    MBM_TX_FRAME_NBYTES             =  nbr_bytes + 5;
     MBM_TX_FRAME_SLAVE_ADDR         = slave_node;                               /* Setup command                     */
     MBM_TX_FRAME_FC                 = 15;
     MBM_TX_FRAME_FC15_ADDR_HI       = (CPU_INT08U) ((slave_addr >> 8) & 0x00FF);
     MBM_TX_FRAME_FC15_ADDR_LO       = (CPU_INT08U)  (slave_addr       & 0x00FF);
     MBM_TX_FRAME_FC15_NBR_POINTS_HI = (CPU_INT08U) ((nbr_coils  >> 8) & 0x00FF);
     MBM_TX_FRAME_FC15_NBR_POINTS_LO = (CPU_INT08U)  (nbr_coils        & 0x00FF);
-    nbr_bytes                       = (CPU_INT08U)(((nbr_coils - 1) / 8) + 1);
     MBM_TX_FRAME_FC15_BYTE_CNT      = nbr_bytes;
     p_data                          = MBM_TX_FRAME_FC15_DATA;
 
@@ -944,23 +1217,22 @@ CPU_INT16U  MBM_FC15_CoilWr (MODBUS_CH   *pch,
         *p_data++ = *p_coil_tbl++;
     }
 
-    MBM_TxCmd(pch);                                                             /* Send command                      */
-
-    MB_OS_RxWait(pch,                                                           /* Wait for response from slave      */
-                 &err);
+    err = MBM_TxRx(pch);                                                        /* Send command, wait for the reply  */
 
     if (err == MODBUS_ERR_NONE) {
-        ok = MBM_RxReply(pch);
-        if (ok == MODBUS_TRUE) {
-            err = MBM_CoilWrN_Resp(pch);                                        /* Parse the response from the slave */
-        } else {
-            err = MODBUS_ERR_RX;
-        }
+        err = MBM_CoilWrN_Resp(pch);                                            /* Parse the response from the slave */
     }
 
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+    MBM_CacheUpd(pch, slave_node, MODBUS_FC15_COIL_WR_MULTIPLE,                 /* Update the value cache            */
+                 slave_addr, nbr_coils, MBM_TX_FRAME_FC15_DATA, (CPU_INT16U *)0, err);
+#endif
+
     pch->RxBufByteCtr = 0;
     pch->RxBufPtr     = &pch->RxBuf[0];
 
+    MB_OS_ChUnlock(pch);                                                        /* Release the channel               */
+
     return (err);
 }
 #endif
@@ -1007,13 +1279,18 @@ CPU_INT16U  MBM_FC16_HoldingRegWrN (MODBUS_CH   *pch,
                                     CPU_INT16U   nbr_regs)
 {
     CPU_INT16U   err;
-    CPU_BOOLEAN  ok;
     CPU_INT08U   nbr_bytes;
     CPU_INT08U   i;
     CPU_INT08U  *p_data;
 
 
 
+    MB_OS_ChLock(pch,                                                           /* Get exclusive use of the channel  */
+                 &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
     MBM_TX_FRAME_NBYTES             =  nbr_regs * sizeof(CPU_INT16U) + 5;
     MBM_TX_FRAME_SLAVE_ADDR         = slave_node;                               /* Setup command                     */
     MBM_TX_FRAME_FC                 = 16;
@@ -1025,29 +1302,27 @@ CPU_INT16U  MBM_FC16_HoldingRegWrN (MODBUS_CH   *pch,
     MBM_TX_FRAME_FC16_BYTE_CNT      = nbr_bytes;
     p_data                          = MBM_TX_FRAME_FC16_DATA;
 
-    for (i = 0; i < nbr_bytes; i++) {
-        *p_data++ = (CPU_INT08U)((*p_reg_tbl >> 8) & 0x00FF);                   /* Write HIGH data byte              */
-        *p_data++ = (CPU_INT08U) (*p_reg_tbl       & 0x00FF);                   /* Write LOW  data byte              */
-        p_reg_tbl++;
+    for (i = 0; i < nbr_regs; i++) {
+        *p_data++ = (CPU_INT08U)((p_reg_tbl[i] >> 8) & 0x00FF);                 /* Write HIGH data byte              */
+        *p_data++ = (CPU_INT08U) (p_reg_tbl[i]       & 0x00FF);                 /* Write LOW  data byte              */
     }
 
-    MBM_TxCmd(pch);                                                             /* Send command                      */
-
-    MB_OS_RxWait(pch,                                                           /* Wait for response from slave      */
-                 &err);
+    err = MBM_TxRx(pch);                                                        /* Send command, wait for the reply  */
 
     if (err == MODBUS_ERR_NONE) {
-        ok = MBM_RxReply(pch);
-        if (ok == MODBUS_TRUE) {
-            err = MBM_RegWrN_Resp(pch);                                         /* Parse the response from the slave */
-        } else {
-            err = MODBUS_ERR_RX;
-        }
+        err = MBM_RegWrN_Resp(pch);                                             /* Parse the response from the slave */
     }
 
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+    MBM_CacheUpd(pch, slave_node, MODBUS_FC16_HOLDING_REG_WR_MULTIPLE,          /* Update the value cache            */
+                 slave_addr, nbr_regs, (CPU_INT08U *)0, p_reg_tbl, err);
+#endif
+
     pch->RxBufByteCtr = 0;
     pch->RxBufPtr     = &pch->RxBuf[0];
 
+    MB_OS_ChUnlock(pch);                                                        /* Release the channel               */
+
     return (err);
 }
 #endif
@@ -1095,7 +1370,6 @@ CPU_INT16U  MBM_FC16_HoldingRegWrNFP (MODBUS_CH   *pch,
                                       CPU_INT16U   nbr_regs)
 {
     CPU_INT16U   err;
-    CPU_BOOLEAN  ok;
     CPU_INT08U   nbr_bytes;
     CPU_INT08U   i;
     CPU_INT16U   n;
@@ -1104,7 +1378,13 @@ CPU_INT16U  MBM_FC16_HoldingRegWrNFP (MODBUS_CH   *pch,
 
 
 
-    MBM_TX_FRAME_NBYTES           =  4;
+    MB_OS_ChLock(pch,                                                           /* Get exclusive use of the channel  */
+                 &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
+    MBM_TX_FRAME_NBYTES           =  nbr_regs * sizeof(CPU_FP32) + 5;
     MBM_TX_FRAME_SLAVE_ADDR       = slave_node;                                 /* Setup command                     */
     MBM_TX_FRAME_FC               = 16;
     MBM_TX_FRAME_FC16_ADDR_HI     = (CPU_INT08U)((slave_addr >> 8) & 0x00FF);
@@ -1130,22 +1410,415 @@ CPU_INT16U  MBM_FC16_HoldingRegWrNFP (MODBUS_CH   *pch,
         p_reg_tbl++;
     }
 
-    MBM_TxCmd(pch);                                                             /* Send command                      */
+    err = MBM_TxRx(pch);                                                        /* Send command, wait for the reply  */
+
+    if (err == MODBUS_ERR_NONE) {
+        err = MBM_RegWrN_Resp(pch);                                             /* Parse the response from the slave */
+    }
+
+    pch->RxBufByteCtr = 0;
+    pch->RxBufPtr     = &pch->RxBuf[0];
+
+    MB_OS_ChUnlock(pch);                                                        /* Release the channel               */
+
+    return (err);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_PDU_Xfer()
+*
+* Description : Sends a request given as a raw protocol data unit (function code and data) to a slave and
+*               returns the PDU of the reply.  Used to forward requests of any function code, e.g. by the
+*               gateway (see mb_gw.c).
+*
+* Argument(s) : pch              Is a pointer to the Modbus channel to send the request to.
+*
+*               slave_node       Is the Modbus node number of the desired slave.
+*
+*               p_pdu            Is a pointer to the PDU of the request, replaced by the PDU of the reply.
+*
+*               p_pdu_len        Is a pointer to the length of the PDU of the request, replaced by the length
+*                                of the PDU of the reply.
+*
+*               pdu_size         Is the size of the buffer at 'p_pdu'.
+*
+* Return(s)   : MODBUS_ERR_NONE          If a reply was received, possibly an exception response.
+*               MODBUS_ERR_NULLPTR       If 'p_pdu' or 'p_pdu_len' is a NULL pointer.
+*               MODBUS_ERR_INVALID       If the PDU doesn't fit in the channel's Tx frame.
+*               MODBUS_ERR_RX            If a timeout occurred before receiving a response from the slave.
+*               MODBUS_ERR_SLAVE_ADDR    If the reply doesn't come from 'slave_node'.
+*               MODBUS_ERR_FC            If the reply is for another function code.
+*               MODBUS_ERR_BYTE_COUNT    If the reply doesn't fit in 'pdu_size' bytes.
+*
+* Caller(s)   : MBM_ReqExec(),
+*               Application.
+*
+* Note(s)     : (1) An exception response is returned as is: its function code has bit 7 set and its data is
+*                   the exception code.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+CPU_INT16U  MBM_PDU_Xfer (MODBUS_CH   *pch,
+                          CPU_INT08U   slave_node,
+                          CPU_INT08U  *p_pdu,
+                          CPU_INT16U  *p_pdu_len,
+                          CPU_INT16U   pdu_size)
+{
+    CPU_INT16U   err;
+
+
+    if ((p_pdu     == (CPU_INT08U *)0) ||
+        (p_pdu_len == (CPU_INT16U *)0)) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+
+    if ((*p_pdu_len <  1) ||                                                    /* Address + PDU must fit the frame  */
+        (*p_pdu_len >= MODBUS_CFG_BUF_SIZE)) {
+        return (MODBUS_ERR_INVALID);
+    }
 
-    MB_OS_RxWait(pch,                                                           /* Wait for response from slave      */
+    MB_OS_ChLock(pch,                                                           /* Get exclusive use of the channel  */
                  &err);
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
+    MBM_PDU_Cmd(pch,                                                            /* Setup command                     */
+                slave_node,
+                p_pdu,
+                *p_pdu_len);
+
+    err = MBM_TxRx(pch);                                                        /* Send command, wait for the reply  */
+
+    if (err == MODBUS_ERR_NONE) {
+        err = MBM_PDU_Resp(pch,                                                 /* Copy the response from the slave  */
+                           p_pdu,
+                           p_pdu_len,
+                           pdu_size);
+    }
+
+    pch->RxBufByteCtr = 0;
+    pch->RxBufPtr     = &pch->RxBuf[0];
+
+    MB_OS_ChUnlock(pch);                                                        /* Release the channel               */
+
+    return (err);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_NbrMax()
+*
+* Description : Returns the largest number of points a request of a channel can transfer.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel.
+*
+*               fc           Is the function code of the request: MODBUS_FC01_COIL_RD, MODBUS_FC02_DI_RD,
+*                            MODBUS_FC03_HOLDING_REG_RD, MODBUS_FC04_IN_REG_RD, MODBUS_FC15_COIL_WR_MULTIPLE
+*                            or MODBUS_FC16_HOLDING_REG_WR_MULTIPLE.
+*
+* Return(s)   : The number of coils/DIs or registers, a multiple of 8 for coils/DIs.
+*
+* Caller(s)   : MBM_BulkXfer(),
+*               MBM_ScanMerge().
+*
+* Note(s)     : (1) The largest request and response must fit .TxBuf[] and .RxBuf[] in the channel's framing:
+*
+*                       RTU, RTU over TCP    address, PDU and CRC
+*                       ASCII                ':', address, PDU and LRC as 2 characters per byte, CR and LF
+*                       TCP, UDP             MBAP header (unit identifier included) and PDU
+*
+*                   'size' is the longest RTU frame that fits, so an ASCII channel transfers about half as
+*                   many points per request as an RTU channel.  The result never exceeds the protocol limits:
+*
+*                       FC01/FC02 read     2000 coils/DIs    FC15 write     1968 coils
+*                       FC03/FC04 read      125 registers    FC16 write      123 registers
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_BULK_EN == DEF_ENABLED) || \
+    (MODBUS_CFG_MBM_SCAN_EN == DEF_ENABLED)
+CPU_INT16U  MBM_NbrMax (MODBUS_CH   *pch,
+                        CPU_INT08U   fc)
+{
+    CPU_INT16U  size;
+    CPU_INT16U  nbr_max;
+
+
+    size = MODBUS_CFG_BUF_SIZE;                                 /* See Note #1                                        */
+    switch (pch->Mode) {
+#if (MODBUS_CFG_ASCII_EN == DEF_ENABLED)
+        case MODBUS_MODE_ASCII:                                 /* ':', 2 chars per byte, LRC instead of CRC, CR LF   */
+             size = (MODBUS_CFG_BUF_SIZE - 1) / 2;
+             break;
+#endif
+
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+        case MODBUS_MODE_TCP:
+             if (pch->TCP_Mode != MODBUS_MODE_RTU_TCP) {        /* MBAP header instead of address and CRC             */
+                 size = MODBUS_CFG_BUF_SIZE - 4;
+             }
+             break;
+#endif
+
+        default:
+             break;
+    }
+
+    switch (fc) {
+        case MODBUS_FC01_COIL_RD:
+        case MODBUS_FC02_DI_RD:
+             nbr_max = (size - MBM_NBR_RD_OVERHEAD) * 8;
+             if (nbr_max > MBM_NBR_BIT_RD_MAX) {
+                 nbr_max = MBM_NBR_BIT_RD_MAX;
+             }
+             break;
+
+        case MODBUS_FC15_COIL_WR_MULTIPLE:
+             nbr_max = (size - MBM_NBR_WR_OVERHEAD) * 8;
+             if (nbr_max > MBM_NBR_BIT_WR_MAX) {
+                 nbr_max = MBM_NBR_BIT_WR_MAX;
+             }
+             break;
+
+        case MODBUS_FC16_HOLDING_REG_WR_MULTIPLE:
+             nbr_max = (size - MBM_NBR_WR_OVERHEAD) / 2;
+             if (nbr_max > MBM_NBR_REG_WR_MAX) {
+                 nbr_max = MBM_NBR_REG_WR_MAX;
+             }
+             break;
+
+        default:
+             nbr_max = (size - MBM_NBR_RD_OVERHEAD) / 2;
+             if (nbr_max > MBM_NBR_REG_RD_MAX) {
+                 nbr_max = MBM_NBR_REG_RD_MAX;
+             }
+             break;
+    }
+    return (nbr_max);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                             MBM_ReqTx()
+*
+* Description : Sends a master request without waiting for the reply (pipelined Modbus/TCP request).
+*
+* Argument(s) : pch          Is a pointer to the Modbus/TCP master channel.
+*
+*               preq         Is a pointer to the request descriptor (see MBM_ReqExec()).
+*
+* Return(s)   : MODBUS_ERR_NONE          If the request was sent, .TID, .TxTs and .Timeout are set.
+*               MODBUS_ERR_FC            If .FC is not supported.
+*               MODBUS_ERR_SLAVE_OFFLINE If the slave is offline (see MBM_TxRxAttempt() Note #1).
+*
+* Caller(s)   : MBM_ReqPipe().
+*
+* Note(s)     : (1) The caller holds the channel (see MB_OS_ChLock()).
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)
+CPU_INT16U  MBM_ReqTx (MODBUS_CH       *pch,
+                       MODBUS_MBM_REQ  *preq)
+{
+    CPU_INT16U  err;
+
+
+    err = MBM_ReqCmd(pch, preq);                                /* Setup command                                      */
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
+#if (MODBUS_CFG_MBM_RTO_EN    == DEF_ENABLED) || \
+    (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+    err = MBM_SlaveTxStart(pch, preq->SlaveAddr);               /* Sets .RxTimeoutCur                                 */
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+#else
+    pch->RxTimeoutCur = pch->RxTimeout;
+#endif
+
+    preq->Timeout = pch->RxTimeoutCur;
+    preq->TxTs    = MB_OS_TimeGet();
+    MBM_TxCmd(pch);                                             /* Send command                                       */
+    preq->TID     = pch->TCP_TID;
+
+    return (MODBUS_ERR_NONE);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                             MBM_ReqRx()
+*
+* Description : Completes a master request sent by MBM_ReqTx().
+*
+* Argument(s) : pch          Is a pointer to the Modbus/TCP master channel.
+*
+*               preq         Is a pointer to the request descriptor.
+*
+*               err          Is MODBUS_ERR_NONE if the reply to the request is in .RxBuf[], or the reason why
+*                            no reply was received (MODBUS_ERR_TIMED_OUT).
+*
+* Return(s)   : The result of the request, as returned by the MBM_FCxx() function of .FC.
+*
+* Caller(s)   : MBM_ReqPipe().
+*
+* Note(s)     : (1) The reply is checked against the command, which is set up again in the Tx frame: other
+*                   requests were sent since.
+*
+*               (2) The caller holds the channel.  The reply is removed from the Rx buffer.  Without a reply,
+*                   the Rx buffer is left alone: it may hold part of the reply to another request.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)
+CPU_INT16U  MBM_ReqRx (MODBUS_CH       *pch,
+                       MODBUS_MBM_REQ  *preq,
+                       CPU_INT16U       err)
+{
+    CPU_BOOLEAN  ok;
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+    CPU_INT08U  *p_bit_tbl;
+    CPU_INT16U  *p_reg_tbl;
+    CPU_INT16U   nbr;
+#endif
+
+
+    (void)MBM_ReqCmd(pch, preq);                                /* See Note #1                                        */
+
+#if (MODBUS_CFG_MBM_RTO_EN    == DEF_ENABLED) || \
+    (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+    MBM_SlaveRxDone(pch, preq->SlaveAddr, err, MB_OS_TimeGet() - preq->TxTs);
+#endif
 
     if (err == MODBUS_ERR_NONE) {
         ok = MBM_RxReply(pch);
-        if (ok == DEF_TRUE) {
-            err = MBM_RegWrN_Resp(pch);                                         /* Parse the response from the slave */
-        } else {
+        if (ok != MODBUS_TRUE) {
             err = MODBUS_ERR_RX;
         }
+        pch->RxBufByteCtr = 0;                                  /* See Note #2                                        */
+        pch->RxBufPtr     = &pch->RxBuf[0];
     }
 
-    pch->RxBufByteCtr = 0;
-    pch->RxBufPtr     = &pch->RxBuf[0];
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+    p_bit_tbl = (CPU_INT08U *)0;
+    p_reg_tbl = (CPU_INT16U *)0;
+    nbr       = preq->NbrPoints;
+#endif
+    switch (preq->FC) {                                         /* Parse the response from the slave                  */
+#if (MODBUS_CFG_FC01_EN == DEF_ENABLED) || \
+    (MODBUS_CFG_FC02_EN == DEF_ENABLED)
+        case MODBUS_FC01_COIL_RD:
+        case MODBUS_FC02_DI_RD:
+             if (err == MODBUS_ERR_NONE) {
+                 err = MBM_Coil_DI_Rd_Resp(pch, (CPU_INT08U *)preq->DataPtr);
+             }
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+             p_bit_tbl = (CPU_INT08U *)preq->DataPtr;
+#endif
+             break;
+#endif
+
+#if (MODBUS_CFG_FC03_EN == DEF_ENABLED) || \
+    (MODBUS_CFG_FC04_EN == DEF_ENABLED)
+        case MODBUS_FC03_HOLDING_REG_RD:
+        case MODBUS_FC04_IN_REG_RD:
+             if (err == MODBUS_ERR_NONE) {
+                 err = MBM_RegRd_Resp(pch, preq->DataPtr, MODBUS_TYPE_U16, MODBUS_ORDER_ABCD);
+             }
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+             p_reg_tbl = (CPU_INT16U *)preq->DataPtr;
+#endif
+             break;
+#endif
+
+#if (MODBUS_CFG_FC05_EN == DEF_ENABLED)
+        case MODBUS_FC05_COIL_WR:
+             if (err == MODBUS_ERR_NONE) {
+                 err = MBM_CoilWr_Resp(pch);
+             }
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+             p_bit_tbl = &MBM_TX_FRAME_FC05_FORCE_DATA_HI;
+             nbr       = 1;
+#endif
+             break;
+#endif
+
+#if (MODBUS_CFG_FC06_EN == DEF_ENABLED)
+        case MODBUS_FC06_HOLDING_REG_WR:
+             if (err == MODBUS_ERR_NONE) {
+                 err = MBM_RegWr_Resp(pch);
+             }
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+             p_reg_tbl = &preq->Val;
+             nbr       = 1;
+#endif
+             break;
+#endif
+
+#if (MODBUS_CFG_FC08_EN == DEF_ENABLED)
+        case MODBUS_FC08_LOOPBACK:
+             if (err == MODBUS_ERR_NONE) {
+                 err = MBM_Diag_Resp(pch, (CPU_INT16U *)preq->DataPtr);
+             } else {
+                 *(CPU_INT16U *)preq->DataPtr = 0;
+             }
+             break;
+#endif
+
+#if (MODBUS_CFG_FC15_EN == DEF_ENABLED)
+        case MODBUS_FC15_COIL_WR_MULTIPLE:
+             if (err == MODBUS_ERR_NONE) {
+                 err = MBM_CoilWrN_Resp(pch);
+             }
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+             p_bit_tbl = MBM_TX_FRAME_FC15_DATA;
+#endif
+             break;
+#endif
+
+#if (MODBUS_CFG_FC16_EN == DEF_ENABLED)
+        case MODBUS_FC16_HOLDING_REG_WR_MULTIPLE:
+             if (err == MODBUS_ERR_NONE) {
+                 err = MBM_RegWrN_Resp(pch);
+             }
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+             p_reg_tbl = (CPU_INT16U *)preq->DataPtr;
+#endif
+             break;
+#endif
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+        case MODBUS_MBM_FC_PDU:
+             if (err == MODBUS_ERR_NONE) {
+                 err = MBM_PDU_Resp(pch, (CPU_INT08U *)preq->DataPtr, &preq->NbrPoints, preq->Val);
+             }
+             break;
+#endif
+
+        default:
+             break;
+    }
+
+#if (MODBUS_CFG_MBM_CACHE_EN == DEF_ENABLED)
+    if ((p_bit_tbl != (CPU_INT08U *)0) ||                       /* Update the value cache                             */
+        (p_reg_tbl != (CPU_INT16U *)0)) {
+        MBM_CacheUpd(pch, preq->SlaveAddr, preq->FC,
+                     preq->StartAddr, nbr, p_bit_tbl, p_reg_tbl, err);
+    }
+#endif
 
     return (err);
 }
@@ -1168,7 +1841,8 @@ CPU_INT16U  MBM_FC16_HoldingRegWrNFP (MODBUS_CH   *pch,
 *               MODBUS_ERR_BYTE_COUNT    If the expected number of bytes to receive doesn't correspond to the number of bytes received
 *
 * Caller(s)   : MBM_FC01_CoilRd(),
-*               MBM_FC02_DIRd().
+*               MBM_FC02_DIRd(),
+*               MBM_ReqRx().
 *
 * Note(s)     : none.
 *********************************************************************************************************
@@ -1181,7 +1855,7 @@ static  CPU_INT16U  MBM_Coil_DI_Rd_Resp (MODBUS_CH *pch, CPU_INT08U *ptbl)
     CPU_INT08U       slave_addr;
     CPU_INT08U       fnct_code;
     CPU_INT08U       byte_cnt;
-    CPU_INT08U       nbr_points;
+    CPU_INT16U       nbr_points;                              /* Up to 2000 coils/DIs per request            */
     CPU_INT08U       i;
     CPU_INT08U      *psrc;
 
@@ -1223,29 +1897,36 @@ static  CPU_INT16U  MBM_Coil_DI_Rd_Resp (MODBUS_CH *pch, CPU_INT08U *ptbl)
 *
 *               ptbl            A pointer to where data will be placed
 *
+*               type            The type of the values in 'ptbl', one of MODBUS_TYPE_xxx
+*
+*               order           The order of the bytes of each value in the response, one of MODBUS_ORDER_xxx
+*
 * Return(s)   : MODBUS_ERR_NONE          If the function was sucessful.
 *               MODBUS_ERR_SLAVE_ADDR    If the transmitted slave address doesn't correspond to the received slave address
 *               MODBUS_ERR_FC            If the transmitted function code doesn't correspond to the received function code
 *               MODBUS_ERR_BYTE_COUNT    If the expected number of bytes to receive doesn't correspond to the number of bytes received
 *
-* Caller(s)   : none.
+* Caller(s)   : MBM_FC03_HoldingRegRd(),
+*               MBM_FC03_HoldingRegRdT(),
+*               MBM_FC04_InRegRd(),
+*               MBM_FC04_InRegRdT(),
+*               MBM_ReqRx().
 *
-* Note(s)     : none.
+* Note(s)     : (1) The values are decoded straight from the receive buffer, see MB_RegDecode().
 *********************************************************************************************************
 */
 
 #if (MODBUS_CFG_FC03_EN == DEF_ENABLED) || \
     (MODBUS_CFG_FC04_EN == DEF_ENABLED)
-static  CPU_INT16U  MBM_RegRd_Resp (MODBUS_CH *pch, CPU_INT16U *ptbl)
+static  CPU_INT16U  MBM_RegRd_Resp (MODBUS_CH   *pch,
+                                    void        *ptbl,
+                                    CPU_INT08U   type,
+                                    CPU_INT08U   order)
 {
     CPU_INT08U       slave_addr;
     CPU_INT08U       fnct_code;
     CPU_INT08U       byte_cnt;
     CPU_INT08U       nbr_points;
-    CPU_INT08U       data_hi;
-    CPU_INT08U       data_lo;
-    CPU_INT08U       i;
-    CPU_INT08U      *psrc;
 
 
 
@@ -1266,12 +1947,11 @@ static  CPU_INT16U  MBM_RegRd_Resp (MODBUS_CH *pch, CPU_INT16U *ptbl)
         return (MODBUS_ERR_BYTE_COUNT);
     }
 
-    psrc = &pch->RxFrameData[3];                              /* Copy received data to destination array     */
-    for (i = 0; i < byte_cnt; i += sizeof(CPU_INT16U)) {
-        data_hi = *psrc++;
-        data_lo = *psrc++;
-        *ptbl++ = ((CPU_INT16U)data_hi << 8) + (CPU_INT16U)data_lo;
-    }
+    MB_RegDecode(&pch->RxFrameData[3],                        /* Decode received data into destination array */
+                 ptbl,
+                 byte_cnt / MB_RegTypeSize(type),
+                 type,
+                 order);
 
     return (MODBUS_ERR_NONE);
 }
@@ -1306,10 +1986,6 @@ static  CPU_INT16U  MBM_RegRdFP_Resp (MODBUS_CH *pch, CPU_FP32 *ptbl)
     CPU_INT08U       fnct_code;
     CPU_INT08U       byte_cnt;
     CPU_INT08U       nbr_points;
-    CPU_INT08U       i;
-    CPU_INT08U       j;
-    CPU_INT08U      *psrc;
-    CPU_INT08U      *pdest;
 
 
 
@@ -1330,21 +2006,11 @@ static  CPU_INT16U  MBM_RegRdFP_Resp (MODBUS_CH *pch, CPU_FP32 *ptbl)
         return (MODBUS_ERR_BYTE_COUNT);
     }
 
-    psrc  = &pch->RxFrameData[3];                             /* Copy received data to destination array     */
-    pdest = (CPU_INT08U *)ptbl;
-    for (i = 0; i < byte_cnt; i += sizeof(CPU_FP32)) {
-#if CPU_CFG_ENDIAN_TYPE == CPU_ENDIAN_TYPE_BIG
-        for (j = 0; j < sizeof(CPU_FP32); j++) {
-            *pdest++ = *psrc++;
-        }
-#else
-        pdest += sizeof(CPU_FP32) - 1;
-        for (j = 0; j < sizeof(CPU_FP32); j++) {
-            *pdest-- = *psrc++;
-        }
-        pdest += sizeof(CPU_FP32) + 1;
-#endif
-    }
+    MB_RegDecode(&pch->RxFrameData[3],                        /* Decode received data into destination array */
+                 ptbl,
+                 nbr_points,
+                 MODBUS_TYPE_FP32,
+                 MODBUS_ORDER_ABCD);
 
     return (MODBUS_ERR_NONE);
 }
@@ -1364,7 +2030,8 @@ static  CPU_INT16U  MBM_RegRdFP_Resp (MODBUS_CH *pch, CPU_FP32 *ptbl)
 *               MODBUS_ERR_BYTE_COUNT    If the expected number of bytes to receive doesn't correspond to the number of bytes received
 *               MODBUS_ERR_COIL_ADDR     If you specified an invalid coil address
 *
-* Caller(s)   : MBM_FC05_CoilWr().
+* Caller(s)   : MBM_FC05_CoilWr(),
+*               MBM_ReqRx().
 *
 * Note(s)     : none.
 *********************************************************************************************************
@@ -1413,7 +2080,8 @@ static  CPU_INT16U  MBM_CoilWr_Resp (MODBUS_CH *pch)
 *               MODBUS_ERR_FC            If the transmitted function code doesn't correspond to the received function code
 *               MODBUS_ERR_BYTE_COUNT    If the expected number of bytes to receive doesn't correspond to the number of bytes received
 *
-* Caller(s)   : MBM_FC15_CoilWr().
+* Caller(s)   : MBM_FC15_CoilWr(),
+*               MBM_ReqRx().
 *
 * Note(s)     : none.
 *********************************************************************************************************
@@ -1471,7 +2139,8 @@ static  CPU_INT16U  MBM_CoilWrN_Resp (MODBUS_CH *pch)
 *               MODBUS_ERR_BYTE_COUNT    If the expected number of bytes to receive doesn't correspond to the number of bytes received
 *
 * Caller(s)   : MBM_FC06_HoldingRegWr(),
-*               MBM_FC06_HoldingRegWrFP().
+*               MBM_FC06_HoldingRegWrFP(),
+*               MBM_ReqRx().
 *
 * Note(s)     : none.
 *********************************************************************************************************
@@ -1521,7 +2190,8 @@ static  CPU_INT16U  MBM_RegWr_Resp (MODBUS_CH *pch)
 *               MODBUS_ERR_BYTE_COUNT    If the expected number of bytes to receive doesn't correspond to the number of bytes received
 *
 * Caller(s)   : MBM_FC16_HoldingRegWrN(),
-*               MBM_FC16_HoldingRegWrNFP().
+*               MBM_FC16_HoldingRegWrNFP(),
+*               MBM_ReqRx().
 *
 * Note(s)     : none.
 *********************************************************************************************************
@@ -1581,7 +2251,8 @@ static  CPU_INT16U  MBM_RegWrN_Resp (MODBUS_CH *pch)
 * Return(s)   : MODBUS_ERR_NONE    If the function was sucessful.
 *               err_code           Otherwise.
 *
-* Caller(s)   : MBM_FC08_Diag().
+* Caller(s)   : MBM_FC08_Diag(),
+*               MBM_ReqRx().
 *
 * Note(s)     : none.
 *********************************************************************************************************
@@ -1645,6 +2316,108 @@ static  CPU_INT16U  MBM_Diag_Resp (MODBUS_CH *pch, CPU_INT16U *pval)
 #endif
 
 
+/*
+*********************************************************************************************************
+*                                            MBM_PDU_Cmd()
+*
+* Description : Sets up a command given as a raw protocol data unit in the channel's Tx frame.
+*
+* Argument(s) : pch          A pointer to the channel the command will be sent on.
+*
+*               slave_node   Is the Modbus node number of the slave.
+*
+*               p_pdu        Is a pointer to the PDU: function code followed by the data.
+*
+*               pdu_len      Is the length of the PDU, checked by the caller.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_PDU_Xfer(),
+*               MBM_ReqCmd().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+static  void  MBM_PDU_Cmd (MODBUS_CH   *pch,
+                           CPU_INT08U   slave_node,
+                           CPU_INT08U  *p_pdu,
+                           CPU_INT16U   pdu_len)
+{
+    CPU_INT16U  i;
+
+
+    MBM_TX_FRAME_NBYTES     = pdu_len - 1;                      /* Nbr of data bytes after the function code          */
+    MBM_TX_FRAME_SLAVE_ADDR = slave_node;
+    for (i = 0; i < pdu_len; i++) {
+        pch->TxFrameData[i + 1] = p_pdu[i];
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_PDU_Resp()
+*
+* Description : Checks the slave's response to a raw PDU request and copies its PDU.
+*
+* Argument(s) : pch          A pointer to the channel that the message was received on.
+*
+*               p_pdu        Is a pointer to where the PDU of the reply is placed.
+*
+*               p_pdu_len    Is a pointer to where the length of the PDU of the reply is placed.
+*
+*               pdu_size     Is the size of the buffer at 'p_pdu'.
+*
+* Return(s)   : MODBUS_ERR_NONE          If the reply was copied.
+*               MODBUS_ERR_SLAVE_ADDR    If the transmitted slave address doesn't correspond to the received slave address
+*               MODBUS_ERR_FC            If the received function code is neither the transmitted one nor its
+*                                        exception response.
+*               MODBUS_ERR_BYTE_COUNT    If the reply doesn't fit in 'pdu_size' bytes.
+*
+* Caller(s)   : MBM_PDU_Xfer(),
+*               MBM_ReqRx().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+static  CPU_INT16U  MBM_PDU_Resp (MODBUS_CH   *pch,
+                                  CPU_INT08U  *p_pdu,
+                                  CPU_INT16U  *p_pdu_len,
+                                  CPU_INT16U   pdu_size)
+{
+    CPU_INT16U  nbr_bytes;
+    CPU_INT16U  i;
+
+
+    if (MBM_TX_FRAME_SLAVE_ADDR != pch->RxFrameData[0]) {       /* Validate slave address                             */
+        return (MODBUS_ERR_SLAVE_ADDR);
+    }
+
+    if ((MBM_TX_FRAME_FC          != pch->RxFrameData[1]) &&    /* Validate function code, exceptions pass through    */
+        ((MBM_TX_FRAME_FC | 0x80) != pch->RxFrameData[1])) {
+        return (MODBUS_ERR_FC);
+    }
+
+    nbr_bytes = pch->RxFrameNDataBytes + 1;                     /* Function code and data                             */
+    if (nbr_bytes > pdu_size) {
+        return (MODBUS_ERR_BYTE_COUNT);
+    }
+
+    for (i = 0; i < nbr_bytes; i++) {
+        p_pdu[i] = pch->RxFrameData[i + 1];
+    }
+    *p_pdu_len = nbr_bytes;
+
+    return (MODBUS_ERR_NONE);
+}
+#endif
+
+
 /*
 *********************************************************************************************************
 *                                             MBM_RxReply()
@@ -1679,6 +2452,12 @@ static  CPU_BOOLEAN  MBM_RxReply (MODBUS_CH *pch)
             ok = MB_RTU_Rx(pch);
         }
 #endif
+
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+        if (pch->Mode == MODBUS_MODE_TCP) {
+            ok = MB_TCP_Rx(pch);
+        }
+#endif
     }
     return (ok);
 }
@@ -1711,10 +2490,417 @@ static  void  MBM_TxCmd (MODBUS_CH *pch)
 
 #if (MODBUS_CFG_RTU_EN == DEF_ENABLED)
         if (pch->Mode == MODBUS_MODE_RTU) {
+#if (MODBUS_CFG_MBM_RX_EARLY_EN == DEF_ENABLED)
+            pch->RTU_RxCRC    = 0xFFFF;                         /* Arm early completion of the reply (see mb.c)       */
+            pch->RTU_RxLenExp = MBM_RxLenExp(pch);
+#endif
             MB_RTU_Tx(pch);
         }
 #endif
+
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+        if (pch->Mode == MODBUS_MODE_TCP) {
+            MB_TCP_Tx(pch);
+        }
+#endif
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                             MBM_ReqCmd()
+*
+* Description : Sets up the command of a master request in the channel's Tx frame.
+*
+* Argument(s) : pch      Specifies the Modbus channel on which the command will be sent
+*
+*               preq     Is a pointer to the request descriptor (see MBM_ReqExec()).
+*
+* Return(s)   : MODBUS_ERR_NONE   If the command is set up.
+*               MODBUS_ERR_FC     If .FC is not supported.
+*
+* Caller(s)   : MBM_ReqTx(),
+*               MBM_ReqRx().
+*
+* Note(s)     : (1) The command is the one set up by the MBM_FCxx() function of .FC.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)
+static  CPU_INT16U  MBM_ReqCmd (MODBUS_CH       *pch,
+                                MODBUS_MBM_REQ  *preq)
+{
+    CPU_INT16U   nbr;
+#if (MODBUS_CFG_FC15_EN == DEF_ENABLED) || \
+    (MODBUS_CFG_FC16_EN == DEF_ENABLED)
+    CPU_INT08U   nbr_bytes;
+    CPU_INT08U   i;
+    CPU_INT08U  *p_data;
+#endif
+#if (MODBUS_CFG_FC15_EN == DEF_ENABLED)
+    CPU_INT08U  *p_coil_tbl;
+#endif
+#if (MODBUS_CFG_FC16_EN == DEF_ENABLED)
+    CPU_INT16U  *p_reg_tbl;
+#endif
+
+
+    nbr                     = preq->NbrPoints;
+    MBM_TX_FRAME_NBYTES     = 4;
+    MBM_TX_FRAME_SLAVE_ADDR = preq->SlaveAddr;
+    MBM_TX_FRAME_FC         = preq->FC;
+    switch (preq->FC) {
+#if (MODBUS_CFG_FC01_EN == DEF_ENABLED) || \
+    (MODBUS_CFG_FC02_EN == DEF_ENABLED) || \
+    (MODBUS_CFG_FC03_EN == DEF_ENABLED) || \
+    (MODBUS_CFG_FC04_EN == DEF_ENABLED)
+#if (MODBUS_CFG_FC01_EN == DEF_ENABLED)
+        case MODBUS_FC01_COIL_RD:                               /* Same layout for FC01 to FC04                       */
+#endif
+#if (MODBUS_CFG_FC02_EN == DEF_ENABLED)
+        case MODBUS_FC02_DI_RD:
+#endif
+#if (MODBUS_CFG_FC03_EN == DEF_ENABLED)
+        case MODBUS_FC03_HOLDING_REG_RD:
+#endif
+#if (MODBUS_CFG_FC04_EN == DEF_ENABLED)
+        case MODBUS_FC04_IN_REG_RD:
+#endif
+             MBM_TX_FRAME_FC01_ADDR_HI       = (CPU_INT08U)((preq->StartAddr >> 8) & 0x00FF);
+             MBM_TX_FRAME_FC01_ADDR_LO       = (CPU_INT08U) (preq->StartAddr       & 0x00FF);
+             MBM_TX_FRAME_FC01_NBR_POINTS_HI = (CPU_INT08U)((nbr             >> 8) & 0x00FF);
+             MBM_TX_FRAME_FC01_NBR_POINTS_LO = (CPU_INT08U) (nbr                   & 0x00FF);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC05_EN == DEF_ENABLED)
+        case MODBUS_FC05_COIL_WR:
+             MBM_TX_FRAME_FC05_ADDR_HI       = (CPU_INT08U)((preq->StartAddr >> 8) & 0x00FF);
+             MBM_TX_FRAME_FC05_ADDR_LO       = (CPU_INT08U) (preq->StartAddr       & 0x00FF);
+             if (preq->Val == MODBUS_COIL_OFF) {
+                 MBM_TX_FRAME_FC05_FORCE_DATA_HI = (CPU_INT08U)0x00;
+             } else {
+                 MBM_TX_FRAME_FC05_FORCE_DATA_HI = (CPU_INT08U)0xFF;
+             }
+             MBM_TX_FRAME_FC05_FORCE_DATA_LO = (CPU_INT08U)0x00;
+             break;
+#endif
+
+#if (MODBUS_CFG_FC06_EN == DEF_ENABLED)
+        case MODBUS_FC06_HOLDING_REG_WR:
+             MBM_TX_FRAME_FC06_ADDR_HI       = (CPU_INT08U)((preq->StartAddr >> 8) & 0x00FF);
+             MBM_TX_FRAME_FC06_ADDR_LO       = (CPU_INT08U) (preq->StartAddr       & 0x00FF);
+             MBM_TX_FRAME_FC06_DATA_HI       = (CPU_INT08U)((preq->Val       >> 8) & 0x00FF);
+             MBM_TX_FRAME_FC06_DATA_LO       = (CPU_INT08U) (preq->Val             & 0x00FF);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC08_EN == DEF_ENABLED)
+        case MODBUS_FC08_LOOPBACK:
+             MBM_TX_FRAME_FC08_FNCT_HI       = (CPU_INT08U)((preq->StartAddr >> 8) & 0x00FF);
+             MBM_TX_FRAME_FC08_FNCT_LO       = (CPU_INT08U) (preq->StartAddr       & 0x00FF);
+             MBM_TX_FRAME_FC08_FNCT_DATA_HI  = (CPU_INT08U)((preq->Val       >> 8) & 0x00FF);
+             MBM_TX_FRAME_FC08_FNCT_DATA_LO  = (CPU_INT08U) (preq->Val             & 0x00FF);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC15_EN == DEF_ENABLED)
+        case MODBUS_FC15_COIL_WR_MULTIPLE:
+             nbr_bytes                       = (CPU_INT08U)(((nbr - 1) / 8) + 1);
+             MBM_TX_FRAME_NBYTES             =  nbr_bytes + 5;
+             MBM_TX_FRAME_FC15_ADDR_HI       = (CPU_INT08U)((preq->StartAddr >> 8) & 0x00FF);
+             MBM_TX_FRAME_FC15_ADDR_LO       = (CPU_INT08U) (preq->StartAddr       & 0x00FF);
+             MBM_TX_FRAME_FC15_NBR_POINTS_HI = (CPU_INT08U)((nbr             >> 8) & 0x00FF);
+             MBM_TX_FRAME_FC15_NBR_POINTS_LO = (CPU_INT08U) (nbr                   & 0x00FF);
+             MBM_TX_FRAME_FC15_BYTE_CNT      = nbr_bytes;
+             p_data                          = MBM_TX_FRAME_FC15_DATA;
+             p_coil_tbl                      = (CPU_INT08U *)preq->DataPtr;
+             for (i = 0; i < nbr_bytes; i++) {
+                 *p_data++ = *p_coil_tbl++;
+             }
+             break;
+#endif
+
+#if (MODBUS_CFG_FC16_EN == DEF_ENABLED)
+        case MODBUS_FC16_HOLDING_REG_WR_MULTIPLE:
+             nbr_bytes                       = (CPU_INT08U)(nbr * sizeof(CPU_INT16U));
+             MBM_TX_FRAME_NBYTES             =  nbr_bytes + 5;
+             MBM_TX_FRAME_FC16_ADDR_HI       = (CPU_INT08U)((preq->StartAddr >> 8) & 0x00FF);
+             MBM_TX_FRAME_FC16_ADDR_LO       = (CPU_INT08U) (preq->StartAddr       & 0x00FF);
+             MBM_TX_FRAME_FC16_NBR_REGS_HI   = (CPU_INT08U)((nbr             >> 8) & 0x00FF);
+             MBM_TX_FRAME_FC16_NBR_REGS_LO   = (CPU_INT08U) (nbr                   & 0x00FF);
+             MBM_TX_FRAME_FC16_BYTE_CNT      = nbr_bytes;
+             p_data                          = MBM_TX_FRAME_FC16_DATA;
+             p_reg_tbl                       = (CPU_INT16U *)preq->DataPtr;
+             for (i = 0; i < nbr; i++) {
+                 *p_data++ = (CPU_INT08U)((p_reg_tbl[i] >> 8) & 0x00FF);
+                 *p_data++ = (CPU_INT08U) (p_reg_tbl[i]       & 0x00FF);
+             }
+             break;
+#endif
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+        case MODBUS_MBM_FC_PDU:
+             if ((nbr <  1) ||
+                 (nbr >= MODBUS_CFG_BUF_SIZE)) {
+                 return (MODBUS_ERR_INVALID);
+             }
+             MBM_PDU_Cmd(pch, preq->SlaveAddr, (CPU_INT08U *)preq->DataPtr, nbr);
+             break;
+#endif
+
+        default:
+             return (MODBUS_ERR_FC);
+    }
+
+    return (MODBUS_ERR_NONE);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_RxLenExp()
+*
+* Description : Determines the length of the RTU reply expected for the command in the channel's Tx frame.
+*
+* Argument(s) : pch      Specifies the Modbus channel on which the command will be sent
+*
+* Return(s)   : The length of the reply in bytes, CRC included, or 0 if it can't be determined.
+*
+* Caller(s)   : MBM_TxCmd().
+*
+* Note(s)     : (1) A read response carries a byte count, MB_RTU_RxByte() derives the final length from it.
+*                   The length of the response header is returned until then.
+*
+*               (2) Broadcasts aren't answered.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_RX_EARLY_EN == DEF_ENABLED)
+static  CPU_INT16U  MBM_RxLenExp (MODBUS_CH *pch)
+{
+    if (MBM_TX_FRAME_SLAVE_ADDR == 0) {                         /* See Note #2                                        */
+        return (0);
+    }
+
+    switch (MBM_TX_FRAME_FC) {
+        case MODBUS_FC01_COIL_RD:                               /* See Note #1                                        */
+        case MODBUS_FC02_DI_RD:
+        case MODBUS_FC03_HOLDING_REG_RD:
+        case MODBUS_FC04_IN_REG_RD:
+             return (3);
+
+        case MODBUS_FC05_COIL_WR:                               /* Echo of the command or address and quantity        */
+        case MODBUS_FC06_HOLDING_REG_WR:
+        case MODBUS_FC08_LOOPBACK:
+        case MODBUS_FC15_COIL_WR_MULTIPLE:
+        case MODBUS_FC16_HOLDING_REG_WR_MULTIPLE:
+             return (8);
+
+        default:
+             return (0);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                              MBM_TxRx()
+*
+* Description : Sends the command in the channel's Tx frame and waits for the slave's reply, retrying if the
+*               channel's retry policy allows it.
+*
+* Argument(s) : pch      Specifies the Modbus channel on which the command will be sent
+*
+* Return(s)   : The result of the last attempt, see MBM_TxRxAttempt().
+*
+* Caller(s)   : MBM_Fxx  Modbus Master Functions.
+*
+* Note(s)     : (1) With MODBUS_CFG_MBM_RETRY_EN, a failed attempt is followed right away by the next one, up
+*                   to 'pch->RetryNbr' times (see MB_MasterRetrySet()).  When the channel has a deadline, the
+*                   timeout of each attempt is cut to the time left and no attempt starts after the deadline.
+*********************************************************************************************************
+*/
+
+static  CPU_INT16U  MBM_TxRx (MODBUS_CH *pch)
+{
+    CPU_INT16U  err;
+#if (MODBUS_CFG_MBM_RETRY_EN == DEF_ENABLED)
+    CPU_INT08U  retry_ctr;
+    CPU_INT32U  ts;
+    CPU_INT32U  elapsed;
+    CPU_INT32U  tmo_max;
+
+
+    ts        = MB_OS_TimeGet();
+    err       = MBM_TxRxAttempt(pch, pch->RetryDeadline, DEF_FALSE);
+    retry_ctr = 0;
+    while ((retry_ctr < pch->RetryNbr) &&                       /* See Note #1                                        */
+           (MBM_RetryChk(pch, err) == DEF_TRUE)) {
+        tmo_max = 0;
+        if (pch->RetryDeadline != 0) {
+            elapsed = MB_OS_TimeGet() - ts;
+            if (elapsed >= pch->RetryDeadline) {                /* Out of time, report the last failure               */
+                break;
+            }
+            tmo_max = pch->RetryDeadline - elapsed;
+        }
+        retry_ctr++;
+        pch->RetryCtr++;
+        pch->RxBufByteCtr = 0;                                  /* Discard the failed reply                           */
+        pch->RxBufPtr     = &pch->RxBuf[0];
+        err = MBM_TxRxAttempt(pch, tmo_max, DEF_TRUE);
+    }
+#else
+    err = MBM_TxRxAttempt(pch, 0, DEF_FALSE);
+#endif
+
+    return (err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MBM_TxRxAttempt()
+*
+* Description : Sends the command in the channel's Tx frame once and waits for the slave's reply.
+*
+* Argument(s) : pch      Specifies the Modbus channel on which the command will be sent
+*
+*               tmo_max  Is the longest time to wait for the reply, in ticks (0 for the channel's timeout).
+*
+*               retry    Is DEF_TRUE when the command was already sent (see Note #2).
+*
+* Return(s)   : MODBUS_ERR_NONE          If a valid reply was received.
+*               MODBUS_ERR_TIMED_OUT     If no reply was received in time.
+*               MODBUS_ERR_SLAVE_OFFLINE If the slave is offline (see Note #1), nothing was sent.
+*               MODBUS_ERR_RX            If the reply is not a valid frame.
+*               Other                    See MB_OS_RxWait() or MB_TCP_RxWait().
+*
+* Caller(s)   : MBM_TxRx().
+*
+* Note(s)     : (1) With MODBUS_CFG_MBM_RTO_EN, the timeout is derived from the round-trip time measured for
+*                   the slave.  With MODBUS_CFG_MBM_HEALTH_EN, requests to an offline slave fail right away.
+*                   The outcome of the request updates the slave's entry (see mbm_slave.c).
+*
+*               (2) The reply to a retry may be a late reply to an earlier attempt, so its round-trip time
+*                   isn't used as a sample (Karn's algorithm).
+*
+*               (3) A Modbus/TCP reply is read from the socket by the calling task itself (see mb_tcp.c).
+*********************************************************************************************************
+*/
+
+static  CPU_INT16U  MBM_TxRxAttempt (MODBUS_CH   *pch,
+                                     CPU_INT32U   tmo_max,
+                                     CPU_BOOLEAN  retry)
+{
+    CPU_INT16U   err;
+    CPU_BOOLEAN  ok;
+#if (MODBUS_CFG_MBM_RTO_EN    == DEF_ENABLED) || \
+    (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+    CPU_INT08U   slave_addr;
+    CPU_INT32U   ts;
+    CPU_INT32U   rtt;
+#endif
+
+
+    pch->RxTimeoutCur = pch->RxTimeout;
+#if (MODBUS_CFG_MBM_RTO_EN    == DEF_ENABLED) || \
+    (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)                   /* See Note #1                                        */
+    slave_addr = MBM_TX_FRAME_SLAVE_ADDR;
+    err        = MBM_SlaveTxStart(pch, slave_addr);
+    if (err != MODBUS_ERR_NONE) {                               /* Slave offline, don't use the bus                   */
+        return (err);
+    }
+    ts         = MB_OS_TimeGet();
+#else
+    (void)retry;
+#endif
+    if ((tmo_max != 0) &&                                       /* Don't wait past the caller's deadline              */
+        ((pch->RxTimeoutCur == 0) || (pch->RxTimeoutCur > tmo_max))) {
+        pch->RxTimeoutCur = tmo_max;
+    }
+
+    MBM_TxCmd(pch);                                             /* Send command                                       */
+
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+    if (pch->Mode == MODBUS_MODE_TCP) {                         /* See Note #3                                        */
+        MB_TCP_RxWait(pch,
+                      &err);
+    } else
+#endif
+    {
+        MB_OS_RxWait(pch,                                       /* Wait for response from slave                       */
+                     &err);
     }
+
+#if (MODBUS_CFG_MBM_RTO_EN    == DEF_ENABLED) || \
+    (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+    if (retry == DEF_FALSE) {
+        rtt = MB_OS_TimeGet() - ts;
+    } else {
+        rtt = MODBUS_MBM_RTT_NONE;                              /* See Note #2                                        */
+    }
+    MBM_SlaveRxDone(pch, slave_addr, err, rtt);
+#endif
+
+    if (err == MODBUS_ERR_NONE) {
+        ok = MBM_RxReply(pch);
+        if (ok != MODBUS_TRUE) {
+            err = MODBUS_ERR_RX;
+        }
+    }
+
+    return (err);
 }
 
+
+/*
+*********************************************************************************************************
+*                                            MBM_RetryChk()
+*
+* Description : Determines whether the outcome of an attempt calls for a retry.
+*
+* Argument(s) : pch      Specifies the Modbus channel
+*
+*               err      Is the result of MBM_TxRxAttempt().
+*
+* Return(s)   : DEF_TRUE  if the failure is one of the channel's retry conditions (MODBUS_MBM_RETRY_xxx),
+*               DEF_FALSE otherwise.
+*
+* Caller(s)   : MBM_TxRx().
+*
+* Note(s)     : (1) An exception response is a valid frame, the function code of which is the requested one
+*                   with bit 7 set.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_RETRY_EN == DEF_ENABLED)
+static  CPU_BOOLEAN  MBM_RetryChk (MODBUS_CH   *pch,
+                                   CPU_INT16U   err)
+{
+    switch (err) {
+        case MODBUS_ERR_TIMED_OUT:
+             return ((pch->RetryOpt & MODBUS_MBM_RETRY_TIMEOUT) != 0);
+
+        case MODBUS_ERR_RX:
+             return ((pch->RetryOpt & MODBUS_MBM_RETRY_RX) != 0);
+
+        case MODBUS_ERR_NONE:                                   /* See Note #1                                        */
+             if (((pch->RetryOpt & MODBUS_MBM_RETRY_BUSY) != 0)   &&
+                 (pch->RxFrameData[1] == (MBM_TX_FRAME_FC | 0x80)) &&
+                 (pch->RxFrameData[2] == MODBUS_ERR_SLAVE_DEVICE_BUSY)) {
+                 return (DEF_TRUE);
+             }
+             return (DEF_FALSE);
+
+        default:
+             return (DEF_FALSE);
+    }
+}
+#endif
+
 #endif
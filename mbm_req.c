@@ -0,0 +1,919 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                  uC/MODBUS MASTER ASYNCHRONOUS REQUESTS
+*
+* Filename : mbm_req.c
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) A master request is described by a MODBUS_MBM_REQ owned by the application.  The request
+*                is queued on its channel by MBM_ReqSubmit(), which returns immediately.  The request is
+*                then executed by the master task serving the channel (see MB_OS_CFG_MBM_TASK_NBR), and on
+*                completion either:
+*
+*                (a) .Callback is called from the master task, or
+*                (b) the request is posted to the completion queue, see MBM_ReqDoneWait().
+*
+*            (2) The descriptor and the buffer pointed to by .DataPtr must remain valid until the request
+*                completes.  A request may be submitted again from its own callback.
+*
+*            (3) Each master channel holds one FIFO per priority class (MODBUS_MBM_PRIO_xxx).  A master task
+*                always executes the oldest request of the highest priority queued on the channels it serves,
+*                so an operator's write submitted at MODBUS_MBM_PRIO_HIGH goes ahead of background polls.
+*
+*            (4) Transactions on a channel are serialized by MB_OS_ChLock(), whether they come from a master
+*                task or from an application task calling the MBM_FCxx() functions directly.
+*
+*            (5) With MODBUS_CFG_MBM_PIPE_EN, the requests queued on a Modbus/TCP channel are pipelined: the
+*                master task keeps up to .MBM_PipeWin of them in flight on the connection, matches each reply
+*                to its request by MBAP transaction identifier and completes the requests in the order the
+*                replies arrive (see MBM_ReqPipe()).  The poll rate over a link with a long round-trip time
+*                is then limited by the bandwidth, not by the round-trip time.  Only MBAP framed connections
+*                are pipelined, neither RTU-over-TCP nor UDP channels.
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define    MBM_REQ_MODULE
+#include  "mb.h"
+
+
+#if (MODBUS_CFG_MBM_REQ_EN == DEF_ENABLED)
+
+#include  <string.h>
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  MBM_REQ_PIPE_POLL_MS                          10       /* Max. wait for a reply while the window isn't full  */
+
+
+/*
+*********************************************************************************************************
+*                                           LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+static  MODBUS_MBM_REQ  *MBM_ReqDoneHeadPtr;                    /* Completion queue (FIFO)                            */
+static  MODBUS_MBM_REQ  *MBM_ReqDoneTailPtr;
+
+static  CPU_INT08U       MBM_ReqChLast[MB_OS_CFG_MBM_TASK_NBR]; /* Last channel served by each master task            */
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  MODBUS_MBM_REQ  *MBM_ReqGet    (CPU_INT08U       task_ix);
+
+static  MODBUS_MBM_REQ  *MBM_ReqRemove (MODBUS_CH       *pch,
+                                        CPU_INT08U       prio);
+
+static  void             MBM_ReqDone   (MODBUS_MBM_REQ  *preq);
+
+#if (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)
+static  void             MBM_ReqPipe   (MODBUS_CH       *pch,
+                                        MODBUS_MBM_REQ  *preq);
+
+static  MODBUS_MBM_REQ  *MBM_ReqGetCh  (MODBUS_CH       *pch);
+
+static  void             MBM_ReqPipeDone(MODBUS_CH       *pch,
+                                         MODBUS_MBM_REQ  *preq,
+                                         CPU_INT16U       err);
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                             MBM_ReqInit()
+*
+* Description : Initializes a master request descriptor before its first submission.
+*
+* Argument(s) : preq         Is a pointer to the request descriptor.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : Application,
+*               MB_GW_Dispatch().
+*
+* Note(s)     : (1) All the fields are cleared, .Prio is set to MODBUS_MBM_PRIO_NORMAL and .State to
+*                   MODBUS_MBM_REQ_STATE_IDLE.  The descriptor can then be filled in and submitted.
+*********************************************************************************************************
+*/
+
+void  MBM_ReqInit (MODBUS_MBM_REQ  *preq)
+{
+    if (preq == (MODBUS_MBM_REQ *)0) {
+        return;
+    }
+    memset(preq, 0, sizeof(*preq));
+    preq->Prio  = MODBUS_MBM_PRIO_NORMAL;
+    preq->State = MODBUS_MBM_REQ_STATE_IDLE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_ReqSubmit()
+*
+* Description : Queues a master request on a channel and returns without waiting for the reply.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel to send the request to.
+*
+*               preq         Is a pointer to the request descriptor, initialized with MBM_ReqInit() (see
+*                            Note #2).  The application sets .SlaveAddr, .FC, .Prio, .StartAddr, .NbrPoints,
+*                            .Val, .DataPtr, .Callback and .ArgPtr as needed by the function code (see
+*                            MBM_ReqExec()).
+*
+* Return(s)   : MODBUS_ERR_NONE          If the request was queued.
+*               MODBUS_ERR_NULLPTR       If 'pch' or 'preq' is a NULL pointer.
+*               MODBUS_ERR_NOT_MASTER    If the channel is not a master.
+*               MODBUS_ERR_INVALID       If .Prio is not a valid priority.
+*               MODBUS_ERR_BUSY          If the request is already queued, in progress or in the completion queue.
+*               MODBUS_ERR_FULL          If the channel's queue is full (see Note #1).
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) A channel queues at most MODBUS_CFG_MBM_Q_SIZE requests.  The last entry is only given to
+*                   MODBUS_MBM_PRIO_HIGH requests, so background polls can't lock out an operator's command.
+*                   The caller decides whether to retry, drop or coalesce a request rejected with
+*                   MODBUS_ERR_FULL.
+*
+*               (2) .State tells whether the descriptor is already queued, in progress or waiting in the
+*                   completion queue, in which case it's refused with MODBUS_ERR_BUSY.  A descriptor submitted
+*                   for the first time MUST have been initialized with MBM_ReqInit(), or at least have its
+*                   .State set to MODBUS_MBM_REQ_STATE_IDLE: a descriptor on the stack holds garbage.  A
+*                   descriptor whose request completed can be submitted again as is.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MBM_ReqSubmit (MODBUS_CH       *pch,
+                           MODBUS_MBM_REQ  *preq)
+{
+    CPU_INT08U  prio;
+    CPU_INT16U  q_size;
+    CPU_SR      cpu_sr;
+
+
+    if ((pch  == (MODBUS_CH      *)0) ||
+        (preq == (MODBUS_MBM_REQ *)0)) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+
+    if (pch->MasterSlave != MODBUS_MASTER) {
+        return (MODBUS_ERR_NOT_MASTER);
+    }
+
+    prio = preq->Prio;
+    if (prio >= MODBUS_MBM_PRIO_NBR) {
+        return (MODBUS_ERR_INVALID);
+    }
+
+    if (prio == MODBUS_MBM_PRIO_HIGH) {                         /* See Note #1                                        */
+        q_size = MODBUS_CFG_MBM_Q_SIZE;
+    } else {
+        q_size = MODBUS_CFG_MBM_Q_SIZE - 1;
+    }
+
+    CPU_CRITICAL_ENTER();
+    if ((preq->State == MODBUS_MBM_REQ_STATE_PEND  ) ||          /* See Note #2                                        */
+        (preq->State == MODBUS_MBM_REQ_STATE_ACTIVE) ||
+        (preq->State == MODBUS_MBM_REQ_STATE_DONE_Q)) {
+        CPU_CRITICAL_EXIT();
+        return (MODBUS_ERR_BUSY);
+    }
+    if (pch->MBM_ReqCtr >= q_size) {
+        CPU_CRITICAL_EXIT();
+        return (MODBUS_ERR_FULL);
+    }
+    preq->ChPtr   = pch;
+    preq->State   = MODBUS_MBM_REQ_STATE_PEND;
+    preq->Err     = MODBUS_ERR_NONE;
+    preq->NextPtr = (MODBUS_MBM_REQ *)0;
+    if (pch->MBM_ReqTailPtr[prio] == (MODBUS_MBM_REQ *)0) {    /* Append to the queue of the request's priority      */
+        pch->MBM_ReqHeadPtr[prio]          = preq;
+    } else {
+        pch->MBM_ReqTailPtr[prio]->NextPtr = preq;
+    }
+    pch->MBM_ReqTailPtr[prio] = preq;
+    pch->MBM_ReqCtr++;
+    CPU_CRITICAL_EXIT();
+
+    MB_OS_MBM_ReqSignal(pch);                                   /* Wake up the master task serving the channel        */
+
+    return (MODBUS_ERR_NONE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MBM_ReqDoneWait()
+*
+* Description : Waits for a request submitted without a callback to complete.
+*
+* Argument(s) : timeout      Is the maximum number of ticks to wait, 0 to wait forever.
+*
+*               perr         Is a pointer to a variable that will receive an error code:
+*
+*                            MODBUS_ERR_NONE        A request completed, see its .Err field for the result.
+*                            MODBUS_ERR_TIMED_OUT   No request completed within 'timeout'.
+*                            MODBUS_ERR_INVALID     The wait failed.
+*
+* Return(s)   : A pointer to the completed request, or NULL if none.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) Requests are returned in the order they completed, whatever the channel.
+*********************************************************************************************************
+*/
+
+MODBUS_MBM_REQ  *MBM_ReqDoneWait (CPU_INT32U   timeout,
+                                  CPU_INT16U  *perr)
+{
+    MODBUS_MBM_REQ  *preq;
+    CPU_SR           cpu_sr;
+
+
+    MB_OS_MBM_DoneWait(timeout, perr);
+    if (*perr != MODBUS_ERR_NONE) {
+        return ((MODBUS_MBM_REQ *)0);
+    }
+
+    CPU_CRITICAL_ENTER();
+    preq = MBM_ReqDoneHeadPtr;                                  /* Remove the oldest completed request                */
+    if (preq != (MODBUS_MBM_REQ *)0) {
+        MBM_ReqDoneHeadPtr = preq->NextPtr;
+        if (MBM_ReqDoneHeadPtr == (MODBUS_MBM_REQ *)0) {
+            MBM_ReqDoneTailPtr = (MODBUS_MBM_REQ *)0;
+        }
+        preq->NextPtr = (MODBUS_MBM_REQ *)0;
+        preq->State   = MODBUS_MBM_REQ_STATE_DONE;
+    }
+    CPU_CRITICAL_EXIT();
+
+    if (preq == (MODBUS_MBM_REQ *)0) {
+        *perr = MODBUS_ERR_INVALID;
+    }
+    return (preq);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_ReqWinSet()
+*
+* Description : Sets the number of requests a Modbus/TCP master channel keeps in flight.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel.
+*
+*               win          Is the window: 1 (one request at a time) to MODBUS_CFG_MBM_PIPE_WIN.
+*
+* Return(s)   : MODBUS_ERR_NONE          If the window was set.
+*               MODBUS_ERR_NULLPTR       If 'pch' is a NULL pointer.
+*               MODBUS_ERR_NOT_MASTER    If the channel is not a master.
+*               MODBUS_ERR_INVALID       If 'win' is out of range.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) The window defaults to MODBUS_CFG_MBM_PIPE_WIN.  A slave that serves one request at a
+*                   time may drop the requests queued behind, its channel should use a window of 1.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)
+CPU_INT16U  MBM_ReqWinSet (MODBUS_CH   *pch,
+                           CPU_INT08U   win)
+{
+    if (pch == (MODBUS_CH *)0) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+
+    if (pch->MasterSlave != MODBUS_MASTER) {
+        return (MODBUS_ERR_NOT_MASTER);
+    }
+
+    if ((win <  1) ||
+        (win >  MODBUS_CFG_MBM_PIPE_WIN)) {
+        return (MODBUS_ERR_INVALID);
+    }
+
+    pch->MBM_PipeWin = win;
+
+    return (MODBUS_ERR_NONE);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_ReqExec()
+*
+* Description : Executes a master request on a channel and waits for the reply.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel to send the request to.
+*
+*               preq         Is a pointer to the request descriptor.  Depending on .FC:
+*
+*                            FC01, FC02   .DataPtr points to a CPU_INT08U array receiving .NbrPoints bits
+*                            FC03, FC04   .DataPtr points to a CPU_INT16U array receiving .NbrPoints registers
+*                            FC05         .Val is the coil value (MODBUS_COIL_OFF or MODBUS_COIL_ON)
+*                            FC06         .Val is the register value
+*                            FC08         .StartAddr is the sub-function, .Val its data and .DataPtr points to
+*                                         a CPU_INT16U receiving the value returned by the slave
+*                            FC15         .DataPtr points to a CPU_INT08U array holding .NbrPoints bits
+*                            FC16         .DataPtr points to a CPU_INT16U array holding .NbrPoints registers
+*                            FC_PDU       .DataPtr points to the PDU of the request, .NbrPoints is its length
+*                                         and .Val the size of the buffer, replaced by the PDU of the reply
+*                                         (see MBM_PDU_Xfer())
+*
+* Return(s)   : The error code returned by the MBM_FCxx() function, or
+*               MODBUS_ERR_FC if .FC is not supported.
+*
+* Caller(s)   : MBM_ReqTask(),
+*               Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MBM_ReqExec (MODBUS_CH       *pch,
+                         MODBUS_MBM_REQ  *preq)
+{
+    CPU_INT16U  err;
+
+
+    switch (preq->FC) {
+#if (MODBUS_CFG_FC01_EN == DEF_ENABLED)
+        case MODBUS_FC01_COIL_RD:
+             err = MBM_FC01_CoilRd(pch,
+                                   preq->SlaveAddr,
+                                   preq->StartAddr,
+                                   (CPU_INT08U *)preq->DataPtr,
+                                   preq->NbrPoints);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC02_EN == DEF_ENABLED)
+        case MODBUS_FC02_DI_RD:
+             err = MBM_FC02_DIRd(pch,
+                                 preq->SlaveAddr,
+                                 preq->StartAddr,
+                                 (CPU_INT08U *)preq->DataPtr,
+                                 preq->NbrPoints);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC03_EN == DEF_ENABLED)
+        case MODBUS_FC03_HOLDING_REG_RD:
+             err = MBM_FC03_HoldingRegRd(pch,
+                                         preq->SlaveAddr,
+                                         preq->StartAddr,
+                                         (CPU_INT16U *)preq->DataPtr,
+                                         preq->NbrPoints);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC04_EN == DEF_ENABLED)
+        case MODBUS_FC04_IN_REG_RD:
+             err = MBM_FC04_InRegRd(pch,
+                                    preq->SlaveAddr,
+                                    preq->StartAddr,
+                                    (CPU_INT16U *)preq->DataPtr,
+                                    preq->NbrPoints);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC05_EN == DEF_ENABLED)
+        case MODBUS_FC05_COIL_WR:
+             err = MBM_FC05_CoilWr(pch,
+                                   preq->SlaveAddr,
+                                   preq->StartAddr,
+                                   (CPU_BOOLEAN)preq->Val);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC06_EN == DEF_ENABLED)
+        case MODBUS_FC06_HOLDING_REG_WR:
+             err = MBM_FC06_HoldingRegWr(pch,
+                                         preq->SlaveAddr,
+                                         preq->StartAddr,
+                                         preq->Val);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC08_EN == DEF_ENABLED)
+        case MODBUS_FC08_LOOPBACK:
+             err = MBM_FC08_Diag(pch,
+                                 preq->SlaveAddr,
+                                 preq->StartAddr,
+                                 preq->Val,
+                                 (CPU_INT16U *)preq->DataPtr);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC15_EN == DEF_ENABLED)
+        case MODBUS_FC15_COIL_WR_MULTIPLE:
+             err = MBM_FC15_CoilWr(pch,
+                                   preq->SlaveAddr,
+                                   preq->StartAddr,
+                                   (CPU_INT08U *)preq->DataPtr,
+                                   preq->NbrPoints);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC16_EN == DEF_ENABLED)
+        case MODBUS_FC16_HOLDING_REG_WR_MULTIPLE:
+             err = MBM_FC16_HoldingRegWrN(pch,
+                                          preq->SlaveAddr,
+                                          preq->StartAddr,
+                                          (CPU_INT16U *)preq->DataPtr,
+                                          preq->NbrPoints);
+             break;
+#endif
+
+#if (MODBUS_CFG_GW_EN == DEF_ENABLED)
+        case MODBUS_MBM_FC_PDU:
+             err = MBM_PDU_Xfer(pch,
+                                preq->SlaveAddr,
+                                (CPU_INT08U *)preq->DataPtr,
+                                &preq->NbrPoints,
+                                preq->Val);
+             break;
+#endif
+
+        default:
+             err = MODBUS_ERR_FC;
+             break;
+    }
+
+    return (err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_ReqTask()
+*
+* Description : Executes the next request queued on the channels served by a master task.
+*
+* Argument(s) : task_ix      Is the index of the master task (0 to MB_OS_CFG_MBM_TASK_NBR - 1).
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_OS_MBM_Task().
+*
+* Note(s)     : (1) The master task is signaled once per request submitted, so it calls this function once
+*                   per signal.  Requests executed by MBM_ReqPipe() leave signals behind, the calls that
+*                   find no request return right away.
+*********************************************************************************************************
+*/
+
+void  MBM_ReqTask (CPU_INT08U task_ix)
+{
+    MODBUS_MBM_REQ  *preq;
+    MODBUS_CH       *pch;
+
+
+    preq = MBM_ReqGet(task_ix);
+    if (preq == (MODBUS_MBM_REQ *)0) {
+        return;
+    }
+
+    pch        = preq->ChPtr;
+#if (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)
+    if ((pch->Mode        == MODBUS_MODE_TCP) &&                /* See Note #5 at the top of the file                 */
+        (pch->TCP_Mode    == MODBUS_MODE_TCP) &&
+        (pch->MBM_PipeWin >  1)) {
+        MBM_ReqPipe(pch, preq);
+        return;
+    }
+#endif
+    preq->Err  = MBM_ReqExec(pch, preq);
+    MBM_ReqDone(preq);
+}
+
+
+/*
+*********************************************************************************************************
+*                                             MBM_ReqGet()
+*
+* Description : Removes the next request to execute from the channels served by a master task.
+*
+* Argument(s) : task_ix      Is the index of the master task.
+*
+* Return(s)   : A pointer to the request, or NULL if none is queued.
+*
+* Caller(s)   : MBM_ReqTask().
+*
+* Note(s)     : (1) The highest priority queued on any of the channels served by the task wins.  Within a
+*                   priority, the channels served by the task (.Ch % MB_OS_CFG_MBM_TASK_NBR == task_ix) are
+*                   visited round-robin, starting after the channel served last, so a busy channel can't
+*                   starve the others.
+*********************************************************************************************************
+*/
+
+static  MODBUS_MBM_REQ  *MBM_ReqGet (CPU_INT08U task_ix)
+{
+    MODBUS_MBM_REQ  *preq;
+    MODBUS_CH       *pch;
+    CPU_INT08U       prio;
+    CPU_INT08U       ch;
+    CPU_INT08U       i;
+    CPU_SR           cpu_sr;
+
+
+    preq = (MODBUS_MBM_REQ *)0;
+
+    CPU_CRITICAL_ENTER();
+    for (prio = 0; prio < MODBUS_MBM_PRIO_NBR; prio++) {       /* See Note #1                                        */
+        ch = MBM_ReqChLast[task_ix];
+        for (i = 0; i < MODBUS_CFG_MAX_CH; i++) {
+            ch++;
+            if (ch >= MODBUS_CFG_MAX_CH) {
+                ch = 0;
+            }
+            if ((ch % MB_OS_CFG_MBM_TASK_NBR) != task_ix) {
+                continue;
+            }
+            pch  = &MB_ChTbl[ch];
+            preq = MBM_ReqRemove(pch, prio);
+            if (preq != (MODBUS_MBM_REQ *)0) {
+                MBM_ReqChLast[task_ix] = ch;
+                CPU_CRITICAL_EXIT();
+                return (preq);
+            }
+        }
+    }
+    CPU_CRITICAL_EXIT();
+
+    return ((MODBUS_MBM_REQ *)0);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           MBM_ReqRemove()
+*
+* Description : Removes the oldest request of a priority from a channel's queue.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel.
+*
+*               prio         Is the priority, MODBUS_MBM_PRIO_xxx.
+*
+* Return(s)   : A pointer to the request, now MODBUS_MBM_REQ_STATE_ACTIVE, or NULL if none is queued.
+*
+* Caller(s)   : MBM_ReqGet(),
+*               MBM_ReqGetCh().
+*
+* Note(s)     : (1) Called in a critical section.
+*********************************************************************************************************
+*/
+
+static  MODBUS_MBM_REQ  *MBM_ReqRemove (MODBUS_CH   *pch,
+                                        CPU_INT08U   prio)
+{
+    MODBUS_MBM_REQ  *preq;
+
+
+    preq = pch->MBM_ReqHeadPtr[prio];
+    if (preq != (MODBUS_MBM_REQ *)0) {
+        pch->MBM_ReqHeadPtr[prio] = preq->NextPtr;
+        if (pch->MBM_ReqHeadPtr[prio] == (MODBUS_MBM_REQ *)0) {
+            pch->MBM_ReqTailPtr[prio] = (MODBUS_MBM_REQ *)0;
+        }
+        pch->MBM_ReqCtr--;
+        preq->NextPtr = (MODBUS_MBM_REQ *)0;
+        preq->State   = MODBUS_MBM_REQ_STATE_ACTIVE;
+    }
+
+    return (preq);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_ReqDone()
+*
+* Description : Reports the completion of a request to the application.
+*
+* Argument(s) : preq         Is a pointer to the completed request.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_ReqTask(),
+*               MBM_ReqPipeDone().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  MBM_ReqDone (MODBUS_MBM_REQ *preq)
+{
+    CPU_SR  cpu_sr;
+
+
+    if (preq->Callback != (MODBUS_MBM_REQ_CALLBACK)0) {
+        preq->State = MODBUS_MBM_REQ_STATE_DONE;
+        preq->Callback(preq);
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();
+    preq->State = MODBUS_MBM_REQ_STATE_DONE_Q;
+    if (MBM_ReqDoneTailPtr == (MODBUS_MBM_REQ *)0) {            /* Append to the completion queue                     */
+        MBM_ReqDoneHeadPtr          = preq;
+    } else {
+        MBM_ReqDoneTailPtr->NextPtr = preq;
+    }
+    MBM_ReqDoneTailPtr = preq;
+    CPU_CRITICAL_EXIT();
+
+    MB_OS_MBM_DoneSignal();
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_ReqPipe()
+*
+* Description : Executes the requests queued on a Modbus/TCP master channel, several at a time.
+*
+* Argument(s) : pch          Is a pointer to the Modbus/TCP master channel.
+*
+*               preq         Is a pointer to the first request, removed from the channel's queue.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_ReqTask().
+*
+* Note(s)     : (1) Requests are sent as long as fewer than .MBM_PipeWin are in flight.  No more than
+*                   MODBUS_CFG_MBM_Q_SIZE are sent per call, after which the window drains and the master
+*                   task moves on to its other channels.
+*
+*               (2) A reply is matched to its request by transaction identifier, so requests complete in
+*                   the order the slave answers them.  A reply matching no request in flight is the late
+*                   reply to a request that timed out, it's dropped.
+*
+*               (3) While the window isn't full, the wait for a reply is cut to MBM_REQ_PIPE_POLL_MS so that
+*                   a request submitted meanwhile is sent without waiting for a reply to come in.
+*
+*               (4) Requests are not retried (see MB_MasterRetrySet()).  A connection lost fails all the
+*                   requests in flight with MODBUS_ERR_TIMED_OUT, the next request opens a new connection.
+*
+*               (5) The channel is held until the window is empty.  Callbacks are called with the channel
+*                   held, they must not call the MBM_FCxx() functions on the same channel.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)
+static  void  MBM_ReqPipe (MODBUS_CH       *pch,
+                           MODBUS_MBM_REQ  *preq)
+{
+    MODBUS_MBM_REQ  *pnext;
+    CPU_INT16U       err;
+    CPU_INT16U       tid;
+    CPU_INT16U       nbr_tx;
+    CPU_INT32U       ts;
+    CPU_INT32U       elapsed;
+    CPU_INT32U       tmo;
+    CPU_INT32U       tmo_poll;
+
+
+    MB_OS_ChLock(pch,                                           /* Get exclusive use of the channel                   */
+                 &err);
+    if (err != MODBUS_ERR_NONE) {
+        preq->Err = err;
+        MBM_ReqDone(preq);
+        return;
+    }
+
+    tmo_poll = (MBM_REQ_PIPE_POLL_MS * MB_OS_TickRateGet() + 999) / 1000;
+    nbr_tx   = 0;
+    while (DEF_TRUE) {
+        while (preq != (MODBUS_MBM_REQ *)0) {                   /* Fill the window (see Note #1)                      */
+            err = MBM_ReqTx(pch, preq);
+            nbr_tx++;
+            if (err == MODBUS_ERR_NONE) {
+                preq->NextPtr = (MODBUS_MBM_REQ *)0;            /* Append to the requests in flight                   */
+                if (pch->MBM_PipeTailPtr == (MODBUS_MBM_REQ *)0) {
+                    pch->MBM_PipeHeadPtr          = preq;
+                } else {
+                    pch->MBM_PipeTailPtr->NextPtr = preq;
+                }
+                pch->MBM_PipeTailPtr = preq;
+                pch->MBM_PipeCtr++;
+            } else {
+                preq->Err = err;
+                MBM_ReqDone(preq);
+            }
+            preq = (MODBUS_MBM_REQ *)0;
+            if ((pch->MBM_PipeCtr < pch->MBM_PipeWin) &&
+                (nbr_tx           < MODBUS_CFG_MBM_Q_SIZE)) {
+                preq = MBM_ReqGetCh(pch);
+            }
+        }
+        if (pch->MBM_PipeCtr == 0) {
+            break;
+        }
+
+        ts   = MB_OS_TimeGet();                                 /* Time out requests, find the next deadline          */
+        tmo  = 0;
+        preq = pch->MBM_PipeHeadPtr;
+        while (preq != (MODBUS_MBM_REQ *)0) {
+            pnext = preq->NextPtr;
+            if (preq->Timeout != 0) {
+                elapsed = ts - preq->TxTs;
+                if (elapsed >= preq->Timeout) {
+                    MBM_ReqPipeDone(pch, preq, MODBUS_ERR_TIMED_OUT);
+                } else if ((tmo == 0) ||
+                           (preq->Timeout - elapsed < tmo)) {
+                    tmo = preq->Timeout - elapsed;
+                }
+            }
+            preq = pnext;
+        }
+
+        if (pch->MBM_PipeCtr != 0) {
+            if ((pch->MBM_PipeCtr < pch->MBM_PipeWin) &&        /* See Note #3                                        */
+                (nbr_tx           < MODBUS_CFG_MBM_Q_SIZE) &&
+                ((tmo == 0) || (tmo > tmo_poll))) {
+                tmo = tmo_poll;
+            }
+            tid = MB_TCP_RxNext(pch, tmo, &err);
+            if (err == MODBUS_ERR_NONE) {
+                preq = pch->MBM_PipeHeadPtr;                    /* See Note #2                                        */
+                while ((preq      != (MODBUS_MBM_REQ *)0) &&
+                       (preq->TID != tid)) {
+                    preq = preq->NextPtr;
+                }
+                if (preq != (MODBUS_MBM_REQ *)0) {
+                    MBM_ReqPipeDone(pch, preq, MODBUS_ERR_NONE);
+                } else {
+                    pch->RxBufByteCtr = 0;
+                    pch->RxBufPtr     = &pch->RxBuf[0];
+                }
+            } else if (pch->TCP_Sock < 0) {                     /* See Note #4                                        */
+                while (pch->MBM_PipeHeadPtr != (MODBUS_MBM_REQ *)0) {
+                    MBM_ReqPipeDone(pch, pch->MBM_PipeHeadPtr, MODBUS_ERR_TIMED_OUT);
+                }
+            }
+        }
+
+        preq = (MODBUS_MBM_REQ *)0;
+        if ((pch->MBM_PipeCtr < pch->MBM_PipeWin) &&
+            (nbr_tx           < MODBUS_CFG_MBM_Q_SIZE)) {
+            preq = MBM_ReqGetCh(pch);
+        }
+    }
+
+    MB_OS_ChUnlock(pch);                                        /* Release the channel                                */
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MBM_ReqGetCh()
+*
+* Description : Removes the next request to execute from a channel's queue.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel.
+*
+* Return(s)   : A pointer to the request of the highest priority queued, or NULL if none is queued.
+*
+* Caller(s)   : MBM_ReqPipe().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)
+static  MODBUS_MBM_REQ  *MBM_ReqGetCh (MODBUS_CH  *pch)
+{
+    MODBUS_MBM_REQ  *preq;
+    CPU_INT08U       prio;
+    CPU_SR           cpu_sr;
+
+
+    preq = (MODBUS_MBM_REQ *)0;
+
+    CPU_CRITICAL_ENTER();
+    for (prio = 0; prio < MODBUS_MBM_PRIO_NBR; prio++) {
+        preq = MBM_ReqRemove(pch, prio);
+        if (preq != (MODBUS_MBM_REQ *)0) {
+            break;
+        }
+    }
+    CPU_CRITICAL_EXIT();
+
+    return (preq);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          MBM_ReqPipeDone()
+*
+* Description : Completes a request in flight on a Modbus/TCP master channel.
+*
+* Argument(s) : pch          Is a pointer to the Modbus/TCP master channel.
+*
+*               preq         Is a pointer to the request, in the channel's list of requests in flight.
+*
+*               err          Is MODBUS_ERR_NONE if the reply to the request is in .RxBuf[], or
+*                            MODBUS_ERR_TIMED_OUT.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_ReqPipe().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_PIPE_EN == DEF_ENABLED)
+static  void  MBM_ReqPipeDone (MODBUS_CH       *pch,
+                               MODBUS_MBM_REQ  *preq,
+                               CPU_INT16U       err)
+{
+    MODBUS_MBM_REQ  *pprev;
+
+
+    if (pch->MBM_PipeHeadPtr == preq) {                         /* Remove from the requests in flight                 */
+        pprev                = (MODBUS_MBM_REQ *)0;
+        pch->MBM_PipeHeadPtr = preq->NextPtr;
+    } else {
+        pprev = pch->MBM_PipeHeadPtr;
+        while (pprev->NextPtr != preq) {
+            pprev = pprev->NextPtr;
+        }
+        pprev->NextPtr = preq->NextPtr;
+    }
+    if (pch->MBM_PipeTailPtr == preq) {
+        pch->MBM_PipeTailPtr = pprev;
+    }
+    pch->MBM_PipeCtr--;
+    preq->NextPtr = (MODBUS_MBM_REQ *)0;
+
+    preq->Err = MBM_ReqRx(pch, preq, err);
+    MBM_ReqDone(preq);
+}
+#endif
+
+#endif
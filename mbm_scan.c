@@ -0,0 +1,747 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                    uC/MODBUS MASTER CYCLIC POLL SCHEDULER
+*
+* Filename : mbm_scan.c
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) The application registers tags with MBM_ScanTagAdd().  A tag is one coil, DI, holding
+*                register or input register of a slave, read every 'period' kernel ticks.  The last value
+*                read is returned by MBM_ScanTagRd().
+*
+*            (2) Tags of the same channel, slave and table are sorted by address and merged into blocks.
+*                Each block is read with a single FC01/02/03/04 request, within the frame limits of its
+*                channel (125 registers or 2000 coils/DIs, less if the request and reply don't fit
+*                MODBUS_CFG_BUF_SIZE in the channel's framing, see MBM_NbrMax()).  RTU framing has the
+*                largest blocks, MBM_ScanRegBuf[] and MBM_ScanBitBuf[] are sized for it.  Tags up to
+*                MODBUS_CFG_MBM_SCAN_GAP_REG/_BIT points apart share a block, the points in between are
+*                read and discarded.  A block is read at the shortest period of its tags.
+*
+*            (3) MBM_ScanExec() reads the blocks that are due, earliest deadline first, and returns the
+*                number of ticks until the next deadline.  It is called from a single application task:
+*
+*                    for (;;) {
+*                        dly = MBM_ScanExec();
+*                        if (dly > APP_SCAN_DLY_MAX) {
+*                            dly = APP_SCAN_DLY_MAX;
+*                        }
+*                        OSTimeDly(dly, OS_OPT_TIME_DLY, &err);
+*                    }
+*
+*            (4) Tags may be added while the scan runs.  The blocks are rebuilt by the next call to
+*                MBM_ScanExec(), and the new blocks are all read right away.
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define    MBM_SCAN_MODULE
+#include  "mb.h"
+
+
+#if (MODBUS_CFG_MBM_SCAN_EN == DEF_ENABLED)
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#if (((MODBUS_CFG_BUF_SIZE - 5) / 2) < 125)                     /* Max. nbr of registers per read request, RTU        */
+#define  MBM_SCAN_REG_MAX               ((MODBUS_CFG_BUF_SIZE - 5) / 2)
+#else
+#define  MBM_SCAN_REG_MAX                             125
+#endif
+
+#if (((MODBUS_CFG_BUF_SIZE - 5) * 8) < 2000)                    /* Max. nbr of coils/DIs per read request, RTU        */
+#define  MBM_SCAN_BIT_MAX               ((MODBUS_CFG_BUF_SIZE - 5) * 8)
+#else
+#define  MBM_SCAN_BIT_MAX                            2000
+#endif
+
+#define  MBM_SCAN_DLY_IDLE                    0xFFFFFFFFu       /* Returned by MBM_ScanExec() when there are no tags  */
+
+
+/*
+*********************************************************************************************************
+*                                           LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+typedef  struct  mbm_scan_tag {
+    MODBUS_CH   *ChPtr;                                 /* Channel the slave is connected to                  */
+    CPU_INT08U   SlaveAddr;                             /* Node address of the slave                          */
+    CPU_INT08U   FC;                                    /* Table, MODBUS_FC01_xxx to MODBUS_FC04_xxx          */
+    CPU_INT16U   Addr;                                  /* Address of the coil, DI or register                */
+    CPU_INT32U   Period;                                /* Poll period (ticks)                                */
+    CPU_INT16U   Val;                                   /* Last value read (0 or 1 for coils and DIs)         */
+    CPU_INT16U   Err;                                   /* Result of the last read                            */
+    CPU_INT32U   Ts;                                    /* Time of the last successful read (ticks)           */
+} MBM_SCAN_TAG;
+
+typedef  struct  mbm_scan_blk {
+    MODBUS_CH   *ChPtr;
+    CPU_INT08U   SlaveAddr;
+    CPU_INT08U   FC;
+    CPU_INT16U   StartAddr;                             /* First point read                                   */
+    CPU_INT16U   NbrPoints;                             /* Number of points read                              */
+    CPU_INT32U   Period;                                /* Shortest period of the tags in the block (ticks)   */
+    CPU_INT32U   NextTime;                              /* Deadline of the next read (ticks)                  */
+    CPU_INT16U   TagFirst;                              /* First tag of the block in MBM_ScanTagIxTbl[]       */
+    CPU_INT16U   TagNbr;                                /* Number of tags in the block                        */
+} MBM_SCAN_BLK;
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+static  MBM_SCAN_TAG  MBM_ScanTagTbl[MODBUS_CFG_MBM_SCAN_TAG_MAX];
+static  CPU_INT16U    MBM_ScanTagCtr;                   /* Number of tags registered                          */
+
+static  CPU_INT16U    MBM_ScanTagIxTbl[MODBUS_CFG_MBM_SCAN_TAG_MAX];  /* Tags sorted by block (see Note #2)   */
+
+static  MBM_SCAN_BLK  MBM_ScanBlkTbl[MODBUS_CFG_MBM_SCAN_BLK_MAX];
+static  CPU_INT16U    MBM_ScanBlkCtr;                   /* Number of blocks built                             */
+
+static  CPU_BOOLEAN   MBM_ScanDirty;                    /* DEF_TRUE when the blocks must be rebuilt           */
+
+static  CPU_INT16U    MBM_ScanRegBuf[MBM_SCAN_REG_MAX];             /* Registers read by the current request  */
+static  CPU_INT08U    MBM_ScanBitBuf[(MBM_SCAN_BIT_MAX + 7) / 8];   /* Coils/DIs read by the current request  */
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  void         MBM_ScanBuild  (void);
+
+static  CPU_BOOLEAN  MBM_ScanTagGt  (MBM_SCAN_TAG  *ptag1,
+                                     MBM_SCAN_TAG  *ptag2);
+
+static  CPU_BOOLEAN  MBM_ScanMerge  (MBM_SCAN_BLK  *pblk,
+                                     MBM_SCAN_TAG  *ptag);
+
+static  void         MBM_ScanBlkRd  (MBM_SCAN_BLK  *pblk);
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                           MBM_ScanTagAdd()
+*
+* Description : Adds a tag to the scan list.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel the slave is connected to.
+*
+*               slave_addr   Is the node address of the slave.
+*
+*               fc           Is the table the tag is read from:
+*
+*                                MODBUS_FC01_COIL_RD           Coil
+*                                MODBUS_FC02_DI_RD             Discrete input
+*                                MODBUS_FC03_HOLDING_REG_RD    Holding register
+*                                MODBUS_FC04_IN_REG_RD         Input register
+*
+*               addr         Is the address of the coil, DI or register.
+*
+*               period       Is the poll period, in kernel ticks.
+*
+*               perr         Is a pointer to where the error code is returned:
+*
+*                                MODBUS_ERR_NONE          The tag was added.
+*                                MODBUS_ERR_NULLPTR       'pch' is a NULL pointer.
+*                                MODBUS_ERR_NOT_MASTER    The channel is not a master.
+*                                MODBUS_ERR_FC            'fc' is not a read function code, or is disabled.
+*                                MODBUS_ERR_INVALID       'period' is 0.
+*                                MODBUS_ERR_FULL          MODBUS_CFG_MBM_SCAN_TAG_MAX tags are registered.
+*
+* Return(s)   : The tag's handle, to pass to MBM_ScanTagRd(), only valid when '*perr' is MODBUS_ERR_NONE (see
+*               Note #1).
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) Handles are numbered from 0, in the order the tags are added.  0 is also returned on error,
+*                   '*perr' is the only error indication.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MBM_ScanTagAdd (MODBUS_CH   *pch,
+                            CPU_INT08U   slave_addr,
+                            CPU_INT08U   fc,
+                            CPU_INT16U   addr,
+                            CPU_INT32U   period,
+                            CPU_INT16U  *perr)
+{
+    MBM_SCAN_TAG  *ptag;
+    CPU_INT16U     tag;
+    CPU_SR         cpu_sr;
+
+
+    if (pch == (MODBUS_CH *)0) {
+        *perr = MODBUS_ERR_NULLPTR;
+        return (0);
+    }
+
+    if (pch->MasterSlave != MODBUS_MASTER) {
+        *perr = MODBUS_ERR_NOT_MASTER;
+        return (0);
+    }
+
+    switch (fc) {
+#if (MODBUS_CFG_FC01_EN == DEF_ENABLED)
+        case MODBUS_FC01_COIL_RD:
+#endif
+#if (MODBUS_CFG_FC02_EN == DEF_ENABLED)
+        case MODBUS_FC02_DI_RD:
+#endif
+#if (MODBUS_CFG_FC03_EN == DEF_ENABLED)
+        case MODBUS_FC03_HOLDING_REG_RD:
+#endif
+#if (MODBUS_CFG_FC04_EN == DEF_ENABLED)
+        case MODBUS_FC04_IN_REG_RD:
+#endif
+             break;
+
+        default:
+             *perr = MODBUS_ERR_FC;
+             return (0);
+    }
+
+    if (period == 0) {
+        *perr = MODBUS_ERR_INVALID;
+        return (0);
+    }
+
+    CPU_CRITICAL_ENTER();
+    tag = MBM_ScanTagCtr;
+    if (tag >= MODBUS_CFG_MBM_SCAN_TAG_MAX) {
+        CPU_CRITICAL_EXIT();
+        *perr = MODBUS_ERR_FULL;
+        return (0);
+    }
+    ptag            = &MBM_ScanTagTbl[tag];
+    ptag->ChPtr     = pch;
+    ptag->SlaveAddr = slave_addr;
+    ptag->FC        = fc;
+    ptag->Addr      = addr;
+    ptag->Period    = period;
+    ptag->Val       = 0;
+    ptag->Err       = MODBUS_ERR_NO_DATA;
+    ptag->Ts        = 0;
+    MBM_ScanTagCtr  = tag + 1;
+    MBM_ScanDirty   = DEF_TRUE;                         /* See Note #4 of this module                         */
+    CPU_CRITICAL_EXIT();
+
+    *perr = MODBUS_ERR_NONE;
+    return (tag);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_ScanTagRd()
+*
+* Description : Returns the last value read for a tag.
+*
+* Argument(s) : tag          Is the handle returned by MBM_ScanTagAdd().
+*
+*               pval         Is a pointer to where the last value successfully read is returned (0 or 1 for
+*                            coils and DIs).
+*
+*               pts          Is a pointer to where the time of that read (see MB_OS_TimeGet()) is returned,
+*                            may be NULL.
+*
+* Return(s)   : MODBUS_ERR_NONE          If the last read of the tag succeeded.
+*               MODBUS_ERR_NULLPTR       If 'pval' is a NULL pointer.
+*               MODBUS_ERR_INVALID       If 'tag' is not a valid handle.
+*               MODBUS_ERR_NO_DATA       If the tag was not read yet.
+*               MODBUS_ERR_FULL          If the tag doesn't fit in MODBUS_CFG_MBM_SCAN_BLK_MAX blocks.
+*               Other                    The error returned by the last MBM_FCxx() call that read the tag.
+*                                        '*pval' still holds the last good value, '*pts' tells how old.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MBM_ScanTagRd (CPU_INT16U   tag,
+                           CPU_INT16U  *pval,
+                           CPU_INT32U  *pts)
+{
+    MBM_SCAN_TAG  *ptag;
+    CPU_INT16U     err;
+    CPU_SR         cpu_sr;
+
+
+    if (pval == (CPU_INT16U *)0) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+
+    CPU_CRITICAL_ENTER();
+    if (tag >= MBM_ScanTagCtr) {
+        CPU_CRITICAL_EXIT();
+        return (MODBUS_ERR_INVALID);
+    }
+    ptag  = &MBM_ScanTagTbl[tag];
+    err   =  ptag->Err;
+    *pval =  ptag->Val;
+    if (pts != (CPU_INT32U *)0) {
+        *pts = ptag->Ts;
+    }
+    CPU_CRITICAL_EXIT();
+
+    return (err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                             MBM_ScanClr()
+*
+* Description : Removes all the tags from the scan list.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) Must not be called while MBM_ScanExec() runs, i.e. call it from the scan task or before the
+*                   scan task is started.
+*********************************************************************************************************
+*/
+
+void  MBM_ScanClr (void)
+{
+    CPU_SR         cpu_sr;
+
+
+    CPU_CRITICAL_ENTER();
+    MBM_ScanTagCtr = 0;
+    MBM_ScanDirty  = DEF_TRUE;
+    CPU_CRITICAL_EXIT();
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MBM_ScanBlkNbrGet()
+*
+* Description : Returns the number of read requests the tags are merged into.
+*
+* Argument(s) : none.
+*
+* Return(s)   : The number of blocks built by the last call to MBM_ScanExec().
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : (1) Comparing this number with the number of tags tells how many transactions the merge saves
+*                   per scan, and helps tuning MODBUS_CFG_MBM_SCAN_GAP_REG/_BIT.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MBM_ScanBlkNbrGet (void)
+{
+    return (MBM_ScanBlkCtr);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_ScanExec()
+*
+* Description : Reads the blocks whose deadline has passed, earliest deadline first.
+*
+* Argument(s) : none.
+*
+* Return(s)   : The number of ticks until the next deadline, 0xFFFFFFFF if the scan list is empty.
+*
+* Caller(s)   : Application (scan task, see Note #3 of this module).
+*
+* Note(s)     : (1) Each block is read at most once per call, so the caller gets control back even when the
+*                   bus can't keep up with the configured periods.
+*
+*               (2) When a block is late by a full period or more, the missed reads are skipped instead of
+*                   being issued back to back.
+*********************************************************************************************************
+*/
+
+CPU_INT32U  MBM_ScanExec (void)
+{
+    MBM_SCAN_BLK  *pblk;
+    MBM_SCAN_BLK  *pblk_next;
+    CPU_INT32U     now;
+    CPU_INT32U     dly;
+    CPU_INT32U     dly_min;
+    CPU_INT16U     ctr;
+    CPU_INT16U     i;
+
+
+    if (MBM_ScanDirty == DEF_TRUE) {
+        MBM_ScanBuild();
+    }
+
+    if (MBM_ScanBlkCtr == 0) {
+        return (MBM_SCAN_DLY_IDLE);
+    }
+
+    for (ctr = 0; ctr < MBM_ScanBlkCtr; ctr++) {               /* See Note #1                                        */
+        now       = MB_OS_TimeGet();
+        pblk_next = (MBM_SCAN_BLK *)0;
+        for (i = 0; i < MBM_ScanBlkCtr; i++) {                  /* Find the earliest deadline that has passed         */
+            pblk = &MBM_ScanBlkTbl[i];
+            if ((CPU_INT32S)(now - pblk->NextTime) >= 0) {
+                if ((pblk_next == (MBM_SCAN_BLK *)0) ||
+                    ((CPU_INT32S)(pblk->NextTime - pblk_next->NextTime) < 0)) {
+                    pblk_next = pblk;
+                }
+            }
+        }
+        if (pblk_next == (MBM_SCAN_BLK *)0) {
+            break;
+        }
+
+        MBM_ScanBlkRd(pblk_next);
+
+        now                  = MB_OS_TimeGet();
+        pblk_next->NextTime += pblk_next->Period;
+        if ((CPU_INT32S)(now - pblk_next->NextTime) >= 0) {     /* See Note #2                                        */
+            pblk_next->NextTime = now + pblk_next->Period;
+        }
+    }
+
+    now     = MB_OS_TimeGet();
+    dly_min = MBM_SCAN_DLY_IDLE;
+    for (i = 0; i < MBM_ScanBlkCtr; i++) {
+        pblk = &MBM_ScanBlkTbl[i];
+        if ((CPU_INT32S)(pblk->NextTime - now) <= 0) {
+            return (0);
+        }
+        dly = pblk->NextTime - now;
+        if (dly < dly_min) {
+            dly_min = dly;
+        }
+    }
+
+    return (dly_min);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_ScanBuild()
+*
+* Description : Sorts the tags and merges them into blocks.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_ScanExec().
+*
+* Note(s)     : (1) Tags are sorted by channel, slave, table and address with an insertion sort.  The scan list
+*                   is rebuilt rarely and is short, so this is cheaper than keeping it sorted as tags are added.
+*
+*               (2) Tags that don't fit in MODBUS_CFG_MBM_SCAN_BLK_MAX blocks are not read, MBM_ScanTagRd()
+*                   returns MODBUS_ERR_FULL for them.
+*********************************************************************************************************
+*/
+
+static  void  MBM_ScanBuild (void)
+{
+    MBM_SCAN_TAG  *ptag;
+    MBM_SCAN_BLK  *pblk;
+    CPU_INT16U     tag_nbr;
+    CPU_INT16U     ix;
+    CPU_INT16U     i;
+    CPU_INT16U     j;
+    CPU_INT32U     now;
+    CPU_SR         cpu_sr;
+
+
+    CPU_CRITICAL_ENTER();
+    tag_nbr       = MBM_ScanTagCtr;
+    MBM_ScanDirty = DEF_FALSE;
+    CPU_CRITICAL_EXIT();
+
+    for (i = 0; i < tag_nbr; i++) {                             /* Sort the tags (see Note #1)                        */
+        ix = i;
+        j  = i;
+        while ((j > 0) &&
+               (MBM_ScanTagGt(&MBM_ScanTagTbl[MBM_ScanTagIxTbl[j - 1]], &MBM_ScanTagTbl[ix]) == DEF_TRUE)) {
+            MBM_ScanTagIxTbl[j] = MBM_ScanTagIxTbl[j - 1];
+            j--;
+        }
+        MBM_ScanTagIxTbl[j] = ix;
+    }
+
+    now            = MB_OS_TimeGet();
+    pblk           = (MBM_SCAN_BLK *)0;
+    MBM_ScanBlkCtr = 0;
+    for (i = 0; i < tag_nbr; i++) {                             /* Merge the sorted tags into blocks                  */
+        ptag = &MBM_ScanTagTbl[MBM_ScanTagIxTbl[i]];
+        if ((pblk != (MBM_SCAN_BLK *)0) &&
+            (MBM_ScanMerge(pblk, ptag) == DEF_TRUE)) {
+            continue;
+        }
+        if (MBM_ScanBlkCtr >= MODBUS_CFG_MBM_SCAN_BLK_MAX) {    /* See Note #2                                        */
+            for (j = i; j < tag_nbr; j++) {
+                ptag = &MBM_ScanTagTbl[MBM_ScanTagIxTbl[j]];
+                CPU_CRITICAL_ENTER();
+                ptag->Err = MODBUS_ERR_FULL;
+                CPU_CRITICAL_EXIT();
+            }
+            break;
+        }
+        pblk            = &MBM_ScanBlkTbl[MBM_ScanBlkCtr];
+        pblk->ChPtr     = ptag->ChPtr;
+        pblk->SlaveAddr = ptag->SlaveAddr;
+        pblk->FC        = ptag->FC;
+        pblk->StartAddr = ptag->Addr;
+        pblk->NbrPoints = 1;
+        pblk->Period    = ptag->Period;
+        pblk->NextTime  = now;                                  /* Read new blocks right away                         */
+        pblk->TagFirst  = i;
+        pblk->TagNbr    = 1;
+        MBM_ScanBlkCtr++;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_ScanTagGt()
+*
+* Description : Compares two tags in scan order.
+*
+* Argument(s) : ptag1        Is a pointer to the first tag.
+*
+*               ptag2        Is a pointer to the second tag.
+*
+* Return(s)   : DEF_TRUE     If 'ptag1' is read after 'ptag2'.
+*               DEF_FALSE    Otherwise.
+*
+* Caller(s)   : MBM_ScanBuild().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_BOOLEAN  MBM_ScanTagGt (MBM_SCAN_TAG  *ptag1,
+                                    MBM_SCAN_TAG  *ptag2)
+{
+    if (ptag1->ChPtr->Ch != ptag2->ChPtr->Ch) {
+        return ((ptag1->ChPtr->Ch > ptag2->ChPtr->Ch) ? DEF_TRUE : DEF_FALSE);
+    }
+    if (ptag1->SlaveAddr != ptag2->SlaveAddr) {
+        return ((ptag1->SlaveAddr > ptag2->SlaveAddr) ? DEF_TRUE : DEF_FALSE);
+    }
+    if (ptag1->FC != ptag2->FC) {
+        return ((ptag1->FC > ptag2->FC) ? DEF_TRUE : DEF_FALSE);
+    }
+    return ((ptag1->Addr > ptag2->Addr) ? DEF_TRUE : DEF_FALSE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_ScanMerge()
+*
+* Description : Extends a block to cover a tag, if the tag is close enough.
+*
+* Argument(s) : pblk         Is a pointer to the block.
+*
+*               ptag         Is a pointer to the tag.  Its address is not lower than the block's first address.
+*
+* Return(s)   : DEF_TRUE     If the tag was merged into the block.
+*               DEF_FALSE    If the tag needs a block of its own.
+*
+* Caller(s)   : MBM_ScanBuild().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_BOOLEAN  MBM_ScanMerge (MBM_SCAN_BLK  *pblk,
+                                    MBM_SCAN_TAG  *ptag)
+{
+    CPU_INT32U  end;
+    CPU_INT32U  gap_max;
+    CPU_INT32U  nbr_max;
+
+
+    if ((pblk->ChPtr     != ptag->ChPtr    ) ||
+        (pblk->SlaveAddr != ptag->SlaveAddr) ||
+        (pblk->FC        != ptag->FC       )) {
+        return (DEF_FALSE);
+    }
+
+    if ((pblk->FC == MODBUS_FC01_COIL_RD) ||
+        (pblk->FC == MODBUS_FC02_DI_RD  )) {
+        gap_max = MODBUS_CFG_MBM_SCAN_GAP_BIT;
+    } else {
+        gap_max = MODBUS_CFG_MBM_SCAN_GAP_REG;
+    }
+    nbr_max = MBM_NbrMax(pblk->ChPtr, pblk->FC);                /* See Note #2 at the top of this file                */
+
+    end = (CPU_INT32U)pblk->StartAddr + pblk->NbrPoints;       /* First point past the block                         */
+    if ((CPU_INT32U)ptag->Addr > end + gap_max) {
+        return (DEF_FALSE);
+    }
+    if (((CPU_INT32U)ptag->Addr - pblk->StartAddr + 1) > nbr_max) {
+        return (DEF_FALSE);
+    }
+
+    if ((CPU_INT32U)ptag->Addr >= end) {
+        pblk->NbrPoints = ptag->Addr - pblk->StartAddr + 1;
+    }
+    if (ptag->Period < pblk->Period) {
+        pblk->Period = ptag->Period;
+    }
+    pblk->TagNbr++;
+
+    return (DEF_TRUE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            MBM_ScanBlkRd()
+*
+* Description : Reads a block and updates its tags.
+*
+* Argument(s) : pblk         Is a pointer to the block.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_ScanExec().
+*
+* Note(s)     : (1) On error, the tags keep their last good value and time stamp, only .Err is updated.
+*********************************************************************************************************
+*/
+
+static  void  MBM_ScanBlkRd (MBM_SCAN_BLK  *pblk)
+{
+    MBM_SCAN_TAG  *ptag;
+    CPU_INT16U     err;
+    CPU_INT16U     ix;
+    CPU_INT16U     val;
+    CPU_INT16U     i;
+    CPU_INT32U     ts;
+    CPU_SR         cpu_sr;
+
+
+    switch (pblk->FC) {
+#if (MODBUS_CFG_FC01_EN == DEF_ENABLED)
+        case MODBUS_FC01_COIL_RD:
+             err = MBM_FC01_CoilRd(pblk->ChPtr,
+                                   pblk->SlaveAddr,
+                                   pblk->StartAddr,
+                                   &MBM_ScanBitBuf[0],
+                                   pblk->NbrPoints);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC02_EN == DEF_ENABLED)
+        case MODBUS_FC02_DI_RD:
+             err = MBM_FC02_DIRd(pblk->ChPtr,
+                                 pblk->SlaveAddr,
+                                 pblk->StartAddr,
+                                 &MBM_ScanBitBuf[0],
+                                 pblk->NbrPoints);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC03_EN == DEF_ENABLED)
+        case MODBUS_FC03_HOLDING_REG_RD:
+             err = MBM_FC03_HoldingRegRd(pblk->ChPtr,
+                                         pblk->SlaveAddr,
+                                         pblk->StartAddr,
+                                         &MBM_ScanRegBuf[0],
+                                         pblk->NbrPoints);
+             break;
+#endif
+
+#if (MODBUS_CFG_FC04_EN == DEF_ENABLED)
+        case MODBUS_FC04_IN_REG_RD:
+             err = MBM_FC04_InRegRd(pblk->ChPtr,
+                                    pblk->SlaveAddr,
+                                    pblk->StartAddr,
+                                    &MBM_ScanRegBuf[0],
+                                    pblk->NbrPoints);
+             break;
+#endif
+
+        default:
+             err = MODBUS_ERR_FC;
+             break;
+    }
+
+    ts = MB_OS_TimeGet();
+    for (i = pblk->TagFirst; i < (pblk->TagFirst + pblk->TagNbr); i++) {
+        ptag = &MBM_ScanTagTbl[MBM_ScanTagIxTbl[i]];
+        ix   = ptag->Addr - pblk->StartAddr;                    /* Position of the tag in the block                   */
+        if ((pblk->FC == MODBUS_FC01_COIL_RD) ||
+            (pblk->FC == MODBUS_FC02_DI_RD  )) {
+            val = (MBM_ScanBitBuf[ix / 8] >> (ix % 8)) & 0x01;
+        } else {
+            val =  MBM_ScanRegBuf[ix];
+        }
+        CPU_CRITICAL_ENTER();
+        ptag->Err = err;
+        if (err == MODBUS_ERR_NONE) {                           /* See Note #1                                        */
+            ptag->Val = val;
+            ptag->Ts  = ts;
+        }
+        CPU_CRITICAL_EXIT();
+    }
+}
+
+#endif
@@ -0,0 +1,616 @@
+/*
+*********************************************************************************************************
+*                                              uC/Modbus
+*                                       The Embedded Modbus Stack
+*
+*                    Copyright 2003-2020 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                    uC/MODBUS MASTER PER-SLAVE TRACKING
+*
+* Filename : mbm_slave.c
+* Version  : V2.14.00
+*********************************************************************************************************
+* Note(s)  : (1) Each master channel keeps a table of the slaves it talks to (see MODBUS_CFG_MBM_SLAVE_MAX).
+*                An entry is taken the first time a request is sent to a slave.  When the table is full,
+*                the other slaves are not tracked and use the channel's timeout.
+*
+*            (2) The response timeout (RTO) of a slave is derived from its round-trip times as in TCP
+*                (RFC 6298), in kernel ticks:
+*
+*                    first reply:  SRTT   = RTT
+*                                  RTTVAR = RTT / 2
+*
+*                    next replies: RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - RTT|
+*                                  SRTT   = 7/8 SRTT   + 1/8 RTT
+*
+*                                  RTO    = SRTT + max(1, 4 RTTVAR)
+*
+*                SRTT and RTTVAR are kept scaled by 8 and 4 so the estimator runs in integer arithmetic.
+*                RTO is bounded by MODBUS_CFG_MBM_RTO_MIN and the channel's timeout (MB_MasterTimeoutSet()).
+*
+*            (3) A request that times out doubles the slave's RTO, so a slave that slowed down is not timed
+*                out forever.  The RTO grows up to MBM_SLAVE_BACKOFF_MAX times the computed RTO only, so a
+*                dead slave keeps costing a fraction of the channel's timeout.  The next reply restores the
+*                computed RTO.  The time of a request that timed out is not used as a sample (Karn's
+*                algorithm).
+*
+*            (4) A slave that misses MODBUS_CFG_MBM_OFFLINE_CNT requests in a row goes through the states:
+*
+*                    ONLINE --(timeout)--> SUSPECT --(MODBUS_CFG_MBM_OFFLINE_CNT timeouts)--> OFFLINE
+*                       ^                     |                                                |
+*                       +------(reply)--------+---------------(reply to a probe)---------------+
+*
+*                Requests to an OFFLINE slave fail at once with MODBUS_ERR_SLAVE_OFFLINE, without using the
+*                bus, until its probe time.  The next request is then sent as a probe, with the channel's
+*                full timeout.  Each probe that fails doubles the delay to the next one, from
+*                MODBUS_CFG_MBM_BACKOFF_MIN up to MODBUS_CFG_MBM_BACKOFF_MAX ticks.  Callers such as the scan
+*                list (see mbm_scan.c) thus skip dead slaves and leave the bus to responsive ones.
+*
+*            (5) The table of a channel is only accessed with the channel locked (see MB_OS_ChLock()).
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define    MBM_SLAVE_MODULE
+#include  "mb.h"
+
+
+#if (MODBUS_CFG_MBM_RTO_EN    == DEF_ENABLED) || \
+    (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  MBM_SLAVE_BACKOFF_MAX                      8u          /* Max. RTO after timeouts, x the computed RTO        */
+
+
+/*
+*********************************************************************************************************
+*                                           LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  MODBUS_MBM_SLAVE  *MBM_SlaveGet         (MODBUS_CH         *pch,
+                                                 CPU_INT08U         slave_addr,
+                                                 CPU_BOOLEAN        alloc);
+
+#if (MODBUS_CFG_MBM_RTO_EN == DEF_ENABLED)
+static  CPU_INT32U         MBM_SlaveRTO_Calc    (MODBUS_CH         *pch,
+                                                 MODBUS_MBM_SLAVE  *pslave);
+#endif
+
+#if (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+static  void               MBM_SlaveStateUpdate (MODBUS_MBM_SLAVE  *pslave,
+                                                 CPU_INT16U         err);
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                           MBM_SlaveInit()
+*
+* Description : Clears the table of slaves of a channel.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MB_Init().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  MBM_SlaveInit (MODBUS_CH  *pch)
+{
+    MODBUS_MBM_SLAVE  *pslave;
+    CPU_INT08U         i;
+
+
+    pslave = &pch->MBM_SlaveTbl[0];
+    for (i = 0; i < MODBUS_CFG_MBM_SLAVE_MAX; i++) {
+        pslave->SlaveAddr = 0;
+        pslave++;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MBM_SlaveTxStart()
+*
+* Description : Prepares a request to a slave: decides whether it is sent and sets its response timeout.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel.
+*
+*               slave_addr   Is the node address of the slave.
+*
+* Return(s)   : MODBUS_ERR_NONE           If the request can be sent, 'pch->RxTimeoutCur' holds its timeout.
+*               MODBUS_ERR_SLAVE_OFFLINE  If the slave is offline and not due for a probe.
+*
+* Caller(s)   : MBM_TxRxAttempt().
+*
+* Note(s)     : (1) Broadcast requests, untracked slaves and channels without a timeout (0 waits forever)
+*                   use the channel's timeout.
+*********************************************************************************************************
+*/
+
+CPU_INT16U  MBM_SlaveTxStart (MODBUS_CH   *pch,
+                              CPU_INT08U   slave_addr)
+{
+    MODBUS_MBM_SLAVE  *pslave;
+
+
+    pch->RxTimeoutCur = pch->RxTimeout;
+
+    if (slave_addr == 0) {                                      /* See Note #1                                        */
+        return (MODBUS_ERR_NONE);
+    }
+
+    pslave = MBM_SlaveGet(pch, slave_addr, DEF_TRUE);
+    if (pslave == (MODBUS_MBM_SLAVE *)0) {
+        return (MODBUS_ERR_NONE);
+    }
+
+#if (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+    if (pslave->State == MODBUS_MBM_SLAVE_STATE_OFFLINE) {      /* See Note #4 of this module                         */
+        if ((CPU_INT32S)(MB_OS_TimeGet() - pslave->ProbeTime) < 0) {
+            return (MODBUS_ERR_SLAVE_OFFLINE);
+        }
+        return (MODBUS_ERR_NONE);                               /* Probe with the channel's timeout                   */
+    }
+#endif
+
+#if (MODBUS_CFG_MBM_RTO_EN == DEF_ENABLED)
+    if (pch->RxTimeout != 0) {
+        if (pslave->RTO > pch->RxTimeout) {                     /* The channel's timeout may have been lowered        */
+            pslave->RTO = pch->RxTimeout;
+        }
+        pch->RxTimeoutCur = pslave->RTO;
+    }
+#endif
+
+    return (MODBUS_ERR_NONE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MBM_SlaveRxDone()
+*
+* Description : Updates a slave's round-trip time with the outcome of a request.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel.
+*
+*               slave_addr   Is the node address of the slave.
+*
+*               err          Is the result of MB_OS_RxWait().
+*
+*               rtt          Is the time from sending the request to receiving the reply, in ticks, or
+*                            MODBUS_MBM_RTT_NONE if it isn't a valid sample (see Note #1).
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_TxRxAttempt().
+*
+* Note(s)     : (1) The reply to a retried request may answer an earlier attempt.  It proves the slave is
+*                   alive but its round-trip time is ambiguous (Karn's algorithm).
+*********************************************************************************************************
+*/
+
+void  MBM_SlaveRxDone (MODBUS_CH   *pch,
+                       CPU_INT08U   slave_addr,
+                       CPU_INT16U   err,
+                       CPU_INT32U   rtt)
+{
+    MODBUS_MBM_SLAVE  *pslave;
+#if (MODBUS_CFG_MBM_RTO_EN == DEF_ENABLED)
+    CPU_INT32S         delta;
+    CPU_INT32U         rto_max;
+#endif
+
+
+    if (slave_addr == 0) {
+        return;
+    }
+
+    pslave = MBM_SlaveGet(pch, slave_addr, DEF_FALSE);
+    if (pslave == (MODBUS_MBM_SLAVE *)0) {
+        return;
+    }
+
+#if (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+    MBM_SlaveStateUpdate(pslave, err);
+#endif
+
+#if (MODBUS_CFG_MBM_RTO_EN == DEF_ENABLED)
+    if (pch->RxTimeout == 0) {
+        return;
+    }
+
+    switch (err) {
+        case MODBUS_ERR_NONE:
+             if (rtt == MODBUS_MBM_RTT_NONE) {                  /* See Note #1                                        */
+                 break;
+             }
+             if (pslave->SRTT == 0) {                           /* First sample (see Note #2 of this module)          */
+                 pslave->SRTT    = rtt << 3;
+                 pslave->RTTVAR  = rtt << 1;
+             } else {
+                 delta           = (CPU_INT32S)rtt - (CPU_INT32S)(pslave->SRTT >> 3);
+                 pslave->SRTT    = (CPU_INT32U)((CPU_INT32S)pslave->SRTT + delta);
+                 if (delta < 0) {
+                     delta = -delta;
+                 }
+                 pslave->RTTVAR  = (CPU_INT32U)((CPU_INT32S)pslave->RTTVAR + delta - (CPU_INT32S)(pslave->RTTVAR >> 2));
+             }
+             if (pslave->SRTT == 0) {                           /* Reply within the same tick                         */
+                 pslave->SRTT = 1;
+             }
+             pslave->RTO = MBM_SlaveRTO_Calc(pch, pslave);
+             break;
+
+        case MODBUS_ERR_TIMED_OUT:                              /* See Note #3 of this module                         */
+             if (pslave->SRTT == 0) {                           /* Never answered, keep the channel's timeout         */
+                 break;
+             }
+             rto_max = MBM_SlaveRTO_Calc(pch, pslave);
+             if (rto_max < (pch->RxTimeout / MBM_SLAVE_BACKOFF_MAX)) {
+                 rto_max *= MBM_SLAVE_BACKOFF_MAX;
+             } else {
+                 rto_max  = pch->RxTimeout;
+             }
+             if (pslave->RTO < (rto_max / 2)) {
+                 pslave->RTO *= 2;
+             } else {
+                 pslave->RTO  = rto_max;
+             }
+             break;
+
+        default:
+             break;
+    }
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                          MBM_SlaveRTT_Get()
+*
+* Description : Returns the round-trip time measured for a slave.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel.
+*
+*               slave_addr   Is the node address of the slave.
+*
+*               psrtt        Is a pointer to where the smoothed round-trip time is returned, in ticks.
+*
+*               prto         Is a pointer to where the response timeout of the next request is returned, in
+*                            ticks.
+*
+* Return(s)   : MODBUS_ERR_NONE          If the slave is tracked.
+*               MODBUS_ERR_NULLPTR       If 'pch', 'psrtt' or 'prto' is a NULL pointer.
+*               MODBUS_ERR_NOT_MASTER    If the channel is not a master.
+*               MODBUS_ERR_NO_DATA       If the slave never answered or is not tracked.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_RTO_EN == DEF_ENABLED)
+CPU_INT16U  MBM_SlaveRTT_Get (MODBUS_CH   *pch,
+                              CPU_INT08U   slave_addr,
+                              CPU_INT32U  *psrtt,
+                              CPU_INT32U  *prto)
+{
+    MODBUS_MBM_SLAVE  *pslave;
+    CPU_INT16U         err;
+
+
+    if ((pch   == (MODBUS_CH  *)0) ||
+        (psrtt == (CPU_INT32U *)0) ||
+        (prto  == (CPU_INT32U *)0)) {
+        return (MODBUS_ERR_NULLPTR);
+    }
+
+    if (pch->MasterSlave != MODBUS_MASTER) {
+        return (MODBUS_ERR_NOT_MASTER);
+    }
+
+    MB_OS_ChLock(pch, &err);                                    /* See Note #5 of this module                         */
+    if (err != MODBUS_ERR_NONE) {
+        return (err);
+    }
+
+    pslave = MBM_SlaveGet(pch, slave_addr, DEF_FALSE);
+    if ((pslave       == (MODBUS_MBM_SLAVE *)0) ||
+        (pslave->SRTT == 0)) {
+        err    = MODBUS_ERR_NO_DATA;
+    } else {
+        *psrtt = pslave->SRTT >> 3;
+        *prto  = pslave->RTO;
+    }
+
+    MB_OS_ChUnlock(pch);
+
+    return (err);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          MBM_SlaveStateGet()
+*
+* Description : Returns the health of a slave.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel.
+*
+*               slave_addr   Is the node address of the slave.
+*
+* Return(s)   : MODBUS_MBM_SLAVE_STATE_ONLINE     If the slave answered the last request.
+*               MODBUS_MBM_SLAVE_STATE_SUSPECT    If the slave missed the last request(s).
+*               MODBUS_MBM_SLAVE_STATE_OFFLINE    If the slave is skipped (see Note #4 of this module).
+*               MODBUS_MBM_SLAVE_STATE_UNKNOWN    If the slave is not tracked or was never addressed.
+*
+* Caller(s)   : Application.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+CPU_INT08U  MBM_SlaveStateGet (MODBUS_CH   *pch,
+                               CPU_INT08U   slave_addr)
+{
+    MODBUS_MBM_SLAVE  *pslave;
+    CPU_INT08U         state;
+    CPU_INT16U         err;
+
+
+    if (pch == (MODBUS_CH *)0) {
+        return (MODBUS_MBM_SLAVE_STATE_UNKNOWN);
+    }
+
+    MB_OS_ChLock(pch, &err);                                    /* See Note #5 of this module                         */
+    if (err != MODBUS_ERR_NONE) {
+        return (MODBUS_MBM_SLAVE_STATE_UNKNOWN);
+    }
+
+    pslave = MBM_SlaveGet(pch, slave_addr, DEF_FALSE);
+    if (pslave == (MODBUS_MBM_SLAVE *)0) {
+        state = MODBUS_MBM_SLAVE_STATE_UNKNOWN;
+    } else {
+        state = pslave->State;
+    }
+
+    MB_OS_ChUnlock(pch);
+
+    return (state);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           MBM_SlaveGet()
+*
+* Description : Finds the entry of a slave in the channel's table.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel.
+*
+*               slave_addr   Is the node address of the slave.
+*
+*               alloc        DEF_TRUE to take a free entry if the slave is not in the table yet.
+*
+* Return(s)   : A pointer to the entry, or NULL if the slave is not tracked.
+*
+* Caller(s)   : MBM_SlaveTxStart(),
+*               MBM_SlaveRxDone(),
+*               MBM_SlaveRTT_Get(),
+*               MBM_SlaveStateGet().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  MODBUS_MBM_SLAVE  *MBM_SlaveGet (MODBUS_CH    *pch,
+                                         CPU_INT08U    slave_addr,
+                                         CPU_BOOLEAN   alloc)
+{
+    MODBUS_MBM_SLAVE  *pslave;
+    MODBUS_MBM_SLAVE  *pfree;
+    CPU_INT08U         i;
+
+
+    pfree  = (MODBUS_MBM_SLAVE *)0;
+    pslave = &pch->MBM_SlaveTbl[0];
+    for (i = 0; i < MODBUS_CFG_MBM_SLAVE_MAX; i++) {
+        if (pslave->SlaveAddr == slave_addr) {
+            return (pslave);
+        }
+        if ((pslave->SlaveAddr == 0) &&
+            (pfree == (MODBUS_MBM_SLAVE *)0)) {
+            pfree = pslave;
+        }
+        pslave++;
+    }
+
+    if ((alloc != DEF_TRUE) ||
+        (pfree == (MODBUS_MBM_SLAVE *)0)) {
+        return ((MODBUS_MBM_SLAVE *)0);
+    }
+
+    pfree->SlaveAddr = slave_addr;
+#if (MODBUS_CFG_MBM_RTO_EN == DEF_ENABLED)
+    pfree->SRTT      = 0;
+    pfree->RTTVAR    = 0;
+    pfree->RTO       = pch->RxTimeout;                          /* No sample yet, wait as long as the channel allows  */
+#endif
+#if (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+    pfree->State     = MODBUS_MBM_SLAVE_STATE_UNKNOWN;
+    pfree->FailCtr   = 0;
+    pfree->Backoff   = MODBUS_CFG_MBM_BACKOFF_MIN;
+    pfree->ProbeTime = 0;
+#endif
+
+    return (pfree);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         MBM_SlaveRTO_Calc()
+*
+* Description : Computes a slave's response timeout from its round-trip time.
+*
+* Argument(s) : pch          Is a pointer to the Modbus channel.
+*
+*               pslave       Is a pointer to the slave's entry.
+*
+* Return(s)   : The response timeout, in ticks.
+*
+* Caller(s)   : MBM_SlaveRxDone().
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_RTO_EN == DEF_ENABLED)
+static  CPU_INT32U  MBM_SlaveRTO_Calc (MODBUS_CH         *pch,
+                                       MODBUS_MBM_SLAVE  *pslave)
+{
+    CPU_INT32U  rto;
+    CPU_INT32U  var;
+
+
+    var = pslave->RTTVAR;                                       /* 4 x RTTVAR                                         */
+    if (var < 1) {
+        var = 1;
+    }
+    rto = (pslave->SRTT >> 3) + var;
+
+    if (rto < MODBUS_CFG_MBM_RTO_MIN) {
+        rto = MODBUS_CFG_MBM_RTO_MIN;
+    }
+    if (rto > pch->RxTimeout) {
+        rto = pch->RxTimeout;
+    }
+
+    return (rto);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        MBM_SlaveStateUpdate()
+*
+* Description : Updates the health of a slave with the outcome of a request.
+*
+* Argument(s) : pslave       Is a pointer to the slave's entry.
+*
+*               err          Is the result of MB_OS_RxWait().
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBM_SlaveRxDone().
+*
+* Note(s)     : (1) Only a missing reply counts as a failure.  A garbled reply or an exception response still
+*                   shows that the slave is alive.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_MBM_HEALTH_EN == DEF_ENABLED)
+static  void  MBM_SlaveStateUpdate (MODBUS_MBM_SLAVE  *pslave,
+                                    CPU_INT16U         err)
+{
+    if (err != MODBUS_ERR_TIMED_OUT) {                          /* See Note #1                                        */
+        if (err == MODBUS_ERR_NONE) {
+            pslave->State   = MODBUS_MBM_SLAVE_STATE_ONLINE;
+            pslave->FailCtr = 0;
+            pslave->Backoff = MODBUS_CFG_MBM_BACKOFF_MIN;
+        }
+        return;
+    }
+
+    if (pslave->FailCtr < 0xFFFF) {
+        pslave->FailCtr++;
+    }
+
+    if (pslave->State == MODBUS_MBM_SLAVE_STATE_OFFLINE) {      /* Probe failed, back off                             */
+        if (pslave->Backoff < (MODBUS_CFG_MBM_BACKOFF_MAX / 2)) {
+            pslave->Backoff *= 2;
+        } else {
+            pslave->Backoff  = MODBUS_CFG_MBM_BACKOFF_MAX;
+        }
+    } else if (pslave->FailCtr >= MODBUS_CFG_MBM_OFFLINE_CNT) {
+        pslave->State   = MODBUS_MBM_SLAVE_STATE_OFFLINE;
+        pslave->Backoff = MODBUS_CFG_MBM_BACKOFF_MIN;
+    } else {
+        pslave->State   = MODBUS_MBM_SLAVE_STATE_SUSPECT;
+        return;
+    }
+    pslave->ProbeTime = MB_OS_TimeGet() + pslave->Backoff;
+}
+#endif
+
+#endif
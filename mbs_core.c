@@ -62,6 +62,79 @@
 *********************************************************************************************************
 */
 
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+MODBUS_DATA_MODEL  const  MBS_DataModelDflt = {                  /* Data model of the channel's primary node address         */
+#if (MODBUS_CFG_FC01_EN == DEF_ENABLED)
+    MB_CoilRd,
+#else
+    0,
+#endif
+#if (MODBUS_CFG_FC05_EN == DEF_ENABLED) || \
+    (MODBUS_CFG_FC15_EN == DEF_ENABLED)
+    MB_CoilWr,
+#else
+    0,
+#endif
+#if (MODBUS_CFG_FC02_EN == DEF_ENABLED)
+    MB_DIRd,
+#else
+    0,
+#endif
+#if (MODBUS_CFG_FC04_EN == DEF_ENABLED)
+    MB_InRegRd,
+#else
+    0,
+#endif
+#if (MODBUS_CFG_FC04_EN == DEF_ENABLED) && \
+    (MODBUS_CFG_FP_EN   == DEF_ENABLED)
+    MB_InRegRdFP,
+#else
+    0,
+#endif
+#if (MODBUS_CFG_FC03_EN == DEF_ENABLED)
+    MB_HoldingRegRd,
+#else
+    0,
+#endif
+#if (MODBUS_CFG_FC03_EN == DEF_ENABLED) && \
+    (MODBUS_CFG_FP_EN   == DEF_ENABLED)
+    MB_HoldingRegRdFP,
+#else
+    0,
+#endif
+#if (MODBUS_CFG_FC06_EN == DEF_ENABLED) || \
+    (MODBUS_CFG_FC16_EN == DEF_ENABLED)
+    MB_HoldingRegWr,
+#else
+    0,
+#endif
+#if ((MODBUS_CFG_FC06_EN == DEF_ENABLED) || \
+     (MODBUS_CFG_FC16_EN == DEF_ENABLED)) && \
+     (MODBUS_CFG_FP_EN   == DEF_ENABLED)
+    MB_HoldingRegWrFP,
+#else
+    0,
+#endif
+#if (MODBUS_CFG_FC20_EN == DEF_ENABLED)
+    MB_FileRd,
+#else
+    0,
+#endif
+#if (MODBUS_CFG_FC21_EN == DEF_ENABLED)
+    MB_FileWr,
+#else
+    0,
+#endif
+#if (MODBUS_CFG_WR_NOTIFY_EN == DEF_ENABLED)
+    MB_WrNotify,
+#endif
+#if (MODBUS_CFG_IMG_EN == DEF_ENABLED)
+    0,                                                           /* Images of the default data model are in MODBUS_CH        */
+    0,
+#endif
+};
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -73,6 +146,10 @@
 /*
 *********************************************************************************************************
 *                                           LOCAL  MACRO'S
+*
+* Note(s) : (1) When MODBUS_CFG_MULTI_ADDR_EN is DEF_ENABLED, the application data is accessed through the
+*               data model of the node address found in the request (see MBS_FCxx_Handler()).  Otherwise
+*               the functions in mb_data.c are called directly.
 *********************************************************************************************************
 */
 
@@ -132,6 +209,57 @@
 #define  MBS_TX_FRAME_DATA      (pch->TxFrameData[2])
 #define  MBS_TX_FRAME_NBYTES    (pch->TxFrameNDataBytes)
 
+                                                                 /* Access to the application data (see Note #1)             */
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+#define  MBS_COIL_RD(coil, perr)                                (pch->DataModelPtr->CoilRd((coil), (perr)))
+#define  MBS_COIL_WR(coil, val, perr)                           (pch->DataModelPtr->CoilWr((coil), (val), (perr)))
+#define  MBS_DI_RD(di, perr)                                    (pch->DataModelPtr->DIRd((di), (perr)))
+#define  MBS_IN_REG_RD(reg, perr)                               (pch->DataModelPtr->InRegRd((reg), (perr)))
+#define  MBS_IN_REG_RD_FP(reg, perr)                            (pch->DataModelPtr->InRegRdFP((reg), (perr)))
+#define  MBS_HOLDING_REG_RD(reg, perr)                          (pch->DataModelPtr->HoldingRegRd((reg), (perr)))
+#define  MBS_HOLDING_REG_RD_FP(reg, perr)                       (pch->DataModelPtr->HoldingRegRdFP((reg), (perr)))
+#define  MBS_HOLDING_REG_WR(reg, val, perr)                     (pch->DataModelPtr->HoldingRegWr((reg), (val), (perr)))
+#define  MBS_HOLDING_REG_WR_FP(reg, val, perr)                  (pch->DataModelPtr->HoldingRegWrFP((reg), (val), (perr)))
+#define  MBS_FILE_RD(file, rec, ix, len, perr)                  (pch->DataModelPtr->FileRd((file), (rec), (ix), (len), (perr)))
+#define  MBS_FILE_WR(file, rec, ix, len, val, perr)             (pch->DataModelPtr->FileWr((file), (rec), (ix), (len), (val), (perr)))
+#else
+#define  MBS_COIL_RD(coil, perr)                                (MB_CoilRd((coil), (perr)))
+#define  MBS_COIL_WR(coil, val, perr)                           (MB_CoilWr((coil), (val), (perr)))
+#define  MBS_DI_RD(di, perr)                                    (MB_DIRd((di), (perr)))
+#define  MBS_IN_REG_RD(reg, perr)                               (MB_InRegRd((reg), (perr)))
+#define  MBS_IN_REG_RD_FP(reg, perr)                            (MB_InRegRdFP((reg), (perr)))
+#define  MBS_HOLDING_REG_RD(reg, perr)                          (MB_HoldingRegRd((reg), (perr)))
+#define  MBS_HOLDING_REG_RD_FP(reg, perr)                       (MB_HoldingRegRdFP((reg), (perr)))
+#define  MBS_HOLDING_REG_WR(reg, val, perr)                     (MB_HoldingRegWr((reg), (val), (perr)))
+#define  MBS_HOLDING_REG_WR_FP(reg, val, perr)                  (MB_HoldingRegWrFP((reg), (val), (perr)))
+#define  MBS_FILE_RD(file, rec, ix, len, perr)                  (MB_FileRd((file), (rec), (ix), (len), (perr)))
+#define  MBS_FILE_WR(file, rec, ix, len, val, perr)             (MB_FileWr((file), (rec), (ix), (len), (val), (perr)))
+#endif
+
+#if (MODBUS_CFG_WR_NOTIFY_EN == DEF_ENABLED)                     /* Write notification, once per request                     */
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+#define  MBS_WR_NOTIFY(fc, start, nbr)                          do { if (pch->DataModelPtr->WrNotify != 0) { \
+                                                                         pch->DataModelPtr->WrNotify((fc), (start), (nbr)); \
+                                                                     } } while (0)
+#else
+#define  MBS_WR_NOTIFY(fc, start, nbr)                          MB_WrNotify((fc), (start), (nbr))
+#endif
+#else
+#define  MBS_WR_NOTIFY(fc, start, nbr)
+#endif
+
+#if (MODBUS_CFG_IMG_EN == DEF_ENABLED)                           /* Register images (see MB_HoldingRegImgSet())              */
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+#define  MBS_HOLDING_REG_IMG           ((pch->DataModelPtr == &MBS_DataModelDflt) ? pch->HoldingRegImgPtr \
+                                                                                 : pch->DataModelPtr->HoldingRegImgPtr)
+#define  MBS_IN_REG_IMG                ((pch->DataModelPtr == &MBS_DataModelDflt) ? pch->InRegImgPtr \
+                                                                                 : pch->DataModelPtr->InRegImgPtr)
+#else
+#define  MBS_HOLDING_REG_IMG            (pch->HoldingRegImgPtr)
+#define  MBS_IN_REG_IMG                 (pch->InRegImgPtr)
+#endif
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -144,6 +272,10 @@
 static  void         MBS_ErrRespSet               (MODBUS_CH   *pch,
                                                    CPU_INT08U   errcode);
 
+#if     (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+static  CPU_BOOLEAN  MBS_DataModelChk             (MODBUS_CH   *pch);
+#endif
+
 #if     (MODBUS_CFG_FC01_EN == DEF_ENABLED)
 static  CPU_BOOLEAN  MBS_FC01_CoilRd              (MODBUS_CH   *pch);
 #endif
@@ -196,6 +328,10 @@ static  void         MBS_ASCII_Task               (MODBUS_CH   *pch);
 static  void         MBS_RTU_Task                 (MODBUS_CH   *pch);
 #endif
 
+#if     (MODBUS_CFG_TCP_EN   == DEF_ENABLED)
+static  void         MBS_TCP_Task                 (MODBUS_CH   *pch);
+#endif
+
 #endif
 
 
@@ -241,6 +377,143 @@ static  void  MBS_ErrRespSet (MODBUS_CH  *pch,
 }
 #endif
 
+
+/*
+*********************************************************************************************************
+*                                          MBS_DataModelChk()
+*
+* Description : This function determines whether the data model selected for the request provides the
+*               functions needed by the requested function code.
+*
+* Argument(s) : pch      Is a pointer to the Modbus channel's data structure.
+*
+* Return(s)   : DEF_TRUE      If the function code can be processed
+*               DEF_FALSE     If not, the request must be answered with an 'Illegal Function' exception
+*
+* Caller(s)   : MBS_FCxx_Handler().
+*
+* Note(s)     : (1) A register function is only needed when the request reaches its registers: the integer
+*                   function when the range starts below MODBUS_CFG_FP_START_IX, the floating-point function
+*                   when it ends at or above it.  A data model with integer registers only doesn't need the
+*                   floating-point functions.
+*
+*               (2) The histogram registers are answered by MBS_FC04_InRegRd() itself, from the channel's
+*                   histograms, whatever the data model.  An FC04 read within them needs no function.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN       == DEF_ENABLED) && \
+    (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+static  CPU_BOOLEAN  MBS_DataModelChk (MODBUS_CH  *pch)
+{
+    MODBUS_DATA_MODEL const  *pmodel;
+    CPU_BOOLEAN               ok;
+#if (MODBUS_CFG_FP_EN == DEF_ENABLED)
+    CPU_BOOLEAN               int_used;
+    CPU_BOOLEAN               fp_used;
+    CPU_INT32U                reg_last;
+#endif
+
+
+    pmodel = pch->DataModelPtr;
+#if (MODBUS_CFG_FP_EN == DEF_ENABLED)
+    reg_last = MBS_RX_DATA_START;                                /* Registers requested (see Note #1)                        */
+    if ((MBS_RX_FRAME_FC     != MODBUS_FC06_HOLDING_REG_WR) &&
+        (MBS_RX_DATA_POINTS  >  0)) {
+        reg_last += MBS_RX_DATA_POINTS - 1;
+    }
+    int_used = (MBS_RX_DATA_START <  MODBUS_CFG_FP_START_IX) ? DEF_TRUE : DEF_FALSE;
+    fp_used  = (reg_last          >= MODBUS_CFG_FP_START_IX) ? DEF_TRUE : DEF_FALSE;
+#endif
+    switch (MBS_RX_FRAME_FC) {
+        case MODBUS_FC01_COIL_RD:
+             ok = (pmodel->CoilRd != 0) ? DEF_TRUE : DEF_FALSE;
+             break;
+
+        case MODBUS_FC02_DI_RD:
+             ok = (pmodel->DIRd   != 0) ? DEF_TRUE : DEF_FALSE;
+             break;
+
+        case MODBUS_FC03_HOLDING_REG_RD:
+#if (MODBUS_CFG_FP_EN == DEF_ENABLED)
+             ok = DEF_TRUE;
+             if ((int_used == DEF_TRUE) &&
+                 (pmodel->HoldingRegRd   == 0)) {
+                 ok = DEF_FALSE;
+             }
+             if ((fp_used  == DEF_TRUE) &&
+                 (pmodel->HoldingRegRdFP == 0)) {
+                 ok = DEF_FALSE;
+             }
+#else
+             ok = (pmodel->HoldingRegRd != 0) ? DEF_TRUE : DEF_FALSE;
+#endif
+             break;
+
+        case MODBUS_FC04_IN_REG_RD:
+#if (MODBUS_CFG_HIST_REG_EN == DEF_ENABLED)
+             if ((MBS_RX_DATA_POINTS >  0) &&                    /* See Note #2                                              */
+                 (MBS_RX_DATA_POINTS <= 125) &&
+                 (MBS_RX_DATA_START  >= MODBUS_CFG_HIST_REG_START) &&
+                 (((CPU_INT32U)MBS_RX_DATA_START + MBS_RX_DATA_POINTS) <=
+                  ((CPU_INT32U)MODBUS_CFG_HIST_REG_START + MODBUS_HIST_REG_NBR))) {
+                 ok = DEF_TRUE;
+                 break;
+             }
+#endif
+#if (MODBUS_CFG_FP_EN == DEF_ENABLED)
+             ok = DEF_TRUE;
+             if ((int_used == DEF_TRUE) &&
+                 (pmodel->InRegRd   == 0)) {
+                 ok = DEF_FALSE;
+             }
+             if ((fp_used  == DEF_TRUE) &&
+                 (pmodel->InRegRdFP == 0)) {
+                 ok = DEF_FALSE;
+             }
+#else
+             ok = (pmodel->InRegRd != 0) ? DEF_TRUE : DEF_FALSE;
+#endif
+             break;
+
+        case MODBUS_FC05_COIL_WR:
+        case MODBUS_FC15_COIL_WR_MULTIPLE:
+             ok = (pmodel->CoilWr != 0) ? DEF_TRUE : DEF_FALSE;
+             break;
+
+        case MODBUS_FC06_HOLDING_REG_WR:
+        case MODBUS_FC16_HOLDING_REG_WR_MULTIPLE:
+#if (MODBUS_CFG_FP_EN == DEF_ENABLED)
+             ok = DEF_TRUE;
+             if ((int_used == DEF_TRUE) &&
+                 (pmodel->HoldingRegWr   == 0)) {
+                 ok = DEF_FALSE;
+             }
+             if ((fp_used  == DEF_TRUE) &&
+                 (pmodel->HoldingRegWrFP == 0)) {
+                 ok = DEF_FALSE;
+             }
+#else
+             ok = (pmodel->HoldingRegWr != 0) ? DEF_TRUE : DEF_FALSE;
+#endif
+             break;
+
+        case MODBUS_FC20_FILE_RD:
+             ok = (pmodel->FileRd != 0) ? DEF_TRUE : DEF_FALSE;
+             break;
+
+        case MODBUS_FC21_FILE_WR:
+             ok = (pmodel->FileWr != 0) ? DEF_TRUE : DEF_FALSE;
+             break;
+
+        default:                                                 /* Other FCs don't access the application data              */
+             ok = DEF_TRUE;
+             break;
+    }
+    return (ok);
+}
+#endif
+
 /*
 *********************************************************************************************************
 *                                           MBS_FCxx_Handler()
@@ -254,9 +527,12 @@ static  void  MBS_ErrRespSet (MODBUS_CH  *pch,
 * Return(s)   : none.
 *
 * Caller(s)   : MBS_ASCII_Task(),
-*               MBS_RTU_Task().
+*               MBS_RTU_Task(),
+*               MBS_TCP_Task().
 *
-* Note(s)     : none.
+* Note(s)     : (1) When MODBUS_CFG_MULTI_ADDR_EN is DEF_ENABLED, the request is served by the data model
+*                   mapped onto its node address.  Broadcasts are served by the default data model.  A
+*                   function code the data model can't process is answered like an unimplemented one.
 *********************************************************************************************************
 */
 
@@ -264,15 +540,33 @@ static  void  MBS_ErrRespSet (MODBUS_CH  *pch,
 CPU_BOOLEAN  MBS_FCxx_Handler (MODBUS_CH  *pch)
 {
     CPU_BOOLEAN  send_reply;
+    CPU_INT08U   fc;
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+    CPU_INT08U   model_ix;
+#endif
 
 
+#if (MODBUS_CFG_HIST_EN == DEF_ENABLED)
+    MB_HistFcStart(pch);                                     /* Timestamp the start of processing (see mb_hist.c)        */
+#endif
     send_reply = DEF_FALSE;
-    if ((MBS_RX_FRAME_ADDR == pch->NodeAddr) ||              /* Proper node address? (i.e. Is this message for us?)      */
+    if ((MB_NodeAddrChk(pch, MBS_RX_FRAME_ADDR) == DEF_TRUE) || /* Proper node address? (i.e. Is this message for us?)   */
         (MBS_RX_FRAME_ADDR == 0)) {                          /* ... or a 'broadcast' address?                            */
 #if (MODBUS_CFG_FC08_EN == DEF_ENABLED)
         pch->StatSlaveMsgCtr++;
 #endif
-        switch (MBS_RX_FRAME_FC) {                           /* Handle the function requested in the frame.              */
+        fc = MBS_RX_FRAME_FC;
+#if (MODBUS_CFG_MULTI_ADDR_EN == DEF_ENABLED)
+        model_ix = pch->NodeAddrTbl[MBS_RX_FRAME_ADDR];      /* Select the data model of the node (see Note #1)          */
+        if (model_ix == 0) {                                 /* ... broadcasts use the default data model                */
+            model_ix = 1;
+        }
+        pch->DataModelPtr = pch->DataModelTbl[model_ix - 1];
+        if (MBS_DataModelChk(pch) == DEF_FALSE) {            /* Data model can't process the FC, handle as illegal FC    */
+            fc = 0;
+        }
+#endif
+        switch (fc) {                                        /* Handle the function requested in the frame.              */
 #if (MODBUS_CFG_FC01_EN == DEF_ENABLED)
             case MODBUS_FC01_COIL_RD:
                  send_reply = MBS_FC01_CoilRd(pch);
@@ -448,8 +742,8 @@ static  CPU_BOOLEAN  MBS_FC01_CoilRd (MODBUS_CH  *pch)
     *presp++ = MBS_RX_FRAME_FC;
     *presp++ = (CPU_INT08U)nbr_bytes;                            /* Set number of data bytes in response message.            */
     while (ix < nbr_coils) {                                     /* Loop through each COIL requested.                        */
-        coil_val = MB_CoilRd(coil,                               /* Get the current value of the coil                        */
-                             &err);
+        coil_val = MBS_COIL_RD(coil,                             /* Get the current value of the coil                        */
+                               &err);
         switch (err) {
             case MODBUS_ERR_NONE:
                  if (coil_val == MODBUS_COIL_ON) {               /* Only set data response bit if COIL is on.                */
@@ -550,8 +844,8 @@ static  CPU_BOOLEAN  MBS_FC02_DIRd (MODBUS_CH  *pch)
     *presp++ =  MBS_RX_FRAME_FC;
     *presp++ = (CPU_INT08U)nbr_bytes;                            /* Set number of data bytes in response message.            */
     while (ix < nbr_di) {                                        /* Loop through each DI requested.                          */
-        di_val = MB_DIRd(di,                                     /* Get the current value of the DI                          */
-                         &err);
+        di_val = MBS_DI_RD(di,                                   /* Get the current value of the DI                          */
+                           &err);
         switch (err) {
             case MODBUS_ERR_NONE:
                  if (di_val == MODBUS_COIL_ON) {                 /* Only set data response bit if DI is on.                  */
@@ -627,6 +921,9 @@ static  CPU_BOOLEAN  MBS_FC03_HoldingRegRd (MODBUS_CH  *pch)
     CPU_INT16U   nbr_regs;
     CPU_INT16U   nbr_bytes;
     CPU_INT16U   reg_val_16;
+#if (MODBUS_CFG_IMG_EN == DEF_ENABLED)
+    MODBUS_IMG  *pimg;
+#endif
 #if (MODBUS_CFG_FP_EN == DEF_ENABLED)
     CPU_INT08U   ix;
     CPU_FP32     reg_val_fp;
@@ -671,10 +968,36 @@ static  CPU_BOOLEAN  MBS_FC03_HoldingRegRd (MODBUS_CH  *pch)
     *presp++              =  MBS_RX_FRAME_ADDR;
     *presp++              =  MBS_RX_FRAME_FC;
     *presp++              = (CPU_INT08U)nbr_bytes;               /* Set number of data bytes in response message             */
+#if (MODBUS_CFG_IMG_EN == DEF_ENABLED)
+    pimg = MBS_HOLDING_REG_IMG;
+    if ((pimg != (MODBUS_IMG *)0) &&                             /* Answer from the register image if it holds them all,     */
+        (((CPU_INT32U)reg + nbr_regs) <=                         /* ... and none of them is a FP register                    */
+          MODBUS_CFG_FP_START_IX)) {
+        err = MB_ImgRdFrame(pimg,
+                            reg,
+                            presp,
+                            nbr_regs);
+        switch (err) {
+            case MODBUS_ERR_NONE:
+                 pch->Err = MODBUS_ERR_NONE;
+                 return (DEF_TRUE);
+
+            case MODBUS_ERR_BUSY:                                /* Image kept changing while being copied                   */
+                 pch->Err = MODBUS_ERR_FC03_05;
+                 MBS_ErrRespSet(pch,
+                                MODBUS_ERR_SLAVE_DEVICE_BUSY);
+                 return (DEF_TRUE);
+
+            case MODBUS_ERR_RANGE:                               /* Not all registers in the image, read them one by one     */
+            default:
+                 break;
+        }
+    }
+#endif
     while (nbr_regs > 0) {                                       /* Loop through each register requested.                    */
         if (reg < MODBUS_CFG_FP_START_IX) {                      /* See if we want an integer register                       */
-            reg_val_16 = MB_HoldingRegRd(reg,                    /* Yes, get its value                                       */
-                                         &err);
+            reg_val_16 = MBS_HOLDING_REG_RD(reg,                 /* Yes, get its value                                       */
+                                            &err);
             switch (err) {
                 case MODBUS_ERR_NONE:
                      *presp++ = (CPU_INT08U)((reg_val_16 >> 8) & 0x00FF); /*      Get MSB first.                             */
@@ -690,8 +1013,8 @@ static  CPU_BOOLEAN  MBS_FC03_HoldingRegRd (MODBUS_CH  *pch)
             }
         } else {
 #if (MODBUS_CFG_FP_EN == DEF_ENABLED)
-            reg_val_fp = MB_HoldingRegRdFP(reg,                  /* No,  get the value of the FP register                    */
-                                           &err);
+            reg_val_fp = MBS_HOLDING_REG_RD_FP(reg,              /* No,  get the value of the FP register                    */
+                                               &err);
             switch (err) {
                 case MODBUS_ERR_NONE:
                      pfp = (CPU_INT08U *)&reg_val_fp;            /* Point to the FP register                                 */
@@ -754,6 +1077,9 @@ static  CPU_BOOLEAN  MBS_FC03_HoldingRegRd (MODBUS_CH  *pch)
 *                  <Data HI register value>       0x00
 *                  <Data LO register value>       0x0A
 *                  <Error Check (LRC or CRC)>     0x??
+*
+*               3) With MODBUS_CFG_HIST_REG_EN, a request for the input registers holding the turnaround
+*                  histograms of the channel is answered by MB_HistRdFrame() (see mb_hist.c).
 *********************************************************************************************************
 */
 
@@ -767,6 +1093,9 @@ static  CPU_BOOLEAN  MBS_FC04_InRegRd (MODBUS_CH  *pch)
     CPU_INT16U   nbr_regs;
     CPU_INT16U   nbr_bytes;
     CPU_INT16U   reg_val_16;
+#if (MODBUS_CFG_IMG_EN == DEF_ENABLED)
+    MODBUS_IMG  *pimg;
+#endif
 #if (MODBUS_CFG_FP_EN == DEF_ENABLED)
     CPU_INT08U   ix;
     CPU_FP32     reg_val_fp;
@@ -779,6 +1108,24 @@ static  CPU_BOOLEAN  MBS_FC04_InRegRd (MODBUS_CH  *pch)
     }
     reg       = MBS_RX_DATA_START;
     nbr_regs  = MBS_RX_DATA_POINTS;
+#if (MODBUS_CFG_HIST_REG_EN == DEF_ENABLED)
+    if ((nbr_regs >  0) &&
+        (nbr_regs <= 125)) {                                     /* See Note #3                                              */
+        err = MB_HistRdFrame(pch,
+                             reg,
+                             &pch->TxFrameData[3],
+                             nbr_regs);
+        if (err == MODBUS_ERR_NONE) {
+            nbr_bytes              = nbr_regs * sizeof(CPU_INT16U);
+            pch->TxFrameNDataBytes = nbr_bytes + 1;
+            MBS_TX_FRAME_ADDR      = MBS_RX_FRAME_ADDR;
+            MBS_TX_FRAME_FC        = MBS_RX_FRAME_FC;
+            pch->TxFrameData[2]    = (CPU_INT08U)nbr_bytes;
+            pch->Err               = MODBUS_ERR_NONE;
+            return (DEF_TRUE);
+        }
+    }
+#endif
 #if (MODBUS_CFG_FP_EN == DEF_ENABLED)
     if (reg < MODBUS_CFG_FP_START_IX) {                          /* See if we want integer registers                         */
         if (nbr_regs == 0 || nbr_regs > 125) {                   /* Make sure we don't exceed the allowed limit per request  */
@@ -811,10 +1158,36 @@ static  CPU_BOOLEAN  MBS_FC04_InRegRd (MODBUS_CH  *pch)
     *presp++              =  MBS_RX_FRAME_ADDR;                  /* Prepare response packet                                  */
     *presp++              =  MBS_RX_FRAME_FC;
     *presp++              = (CPU_INT08U)nbr_bytes;               /* Set number of data bytes in response message             */
+#if (MODBUS_CFG_IMG_EN == DEF_ENABLED)
+    pimg = MBS_IN_REG_IMG;
+    if ((pimg != (MODBUS_IMG *)0) &&                             /* Answer from the register image if it holds them all,     */
+        (((CPU_INT32U)reg + nbr_regs) <=                         /* ... and none of them is a FP register                    */
+          MODBUS_CFG_FP_START_IX)) {
+        err = MB_ImgRdFrame(pimg,
+                            reg,
+                            presp,
+                            nbr_regs);
+        switch (err) {
+            case MODBUS_ERR_NONE:
+                 pch->Err = MODBUS_ERR_NONE;
+                 return (DEF_TRUE);
+
+            case MODBUS_ERR_BUSY:                                /* Image kept changing while being copied                   */
+                 pch->Err = MODBUS_ERR_FC04_05;
+                 MBS_ErrRespSet(pch,
+                                MODBUS_ERR_SLAVE_DEVICE_BUSY);
+                 return (DEF_TRUE);
+
+            case MODBUS_ERR_RANGE:                               /* Not all registers in the image, read them one by one     */
+            default:
+                 break;
+        }
+    }
+#endif
     while (nbr_regs > 0) {                                       /* Loop through each register requested.                    */
         if (reg < MODBUS_CFG_FP_START_IX) {                      /* See if we want an integer register                       */
-            reg_val_16 = MB_InRegRd(reg,                         /* Yes, get its value                                       */
-                                    &err);
+            reg_val_16 = MBS_IN_REG_RD(reg,                      /* Yes, get its value                                       */
+                                       &err);
             switch (err) {
                 case MODBUS_ERR_NONE:
                      *presp++ = (CPU_INT08U)((reg_val_16 >> 8) & 0x00FF); /*      Get MSB first.                             */
@@ -830,8 +1203,8 @@ static  CPU_BOOLEAN  MBS_FC04_InRegRd (MODBUS_CH  *pch)
             }
         } else {
 #if (MODBUS_CFG_FP_EN == DEF_ENABLED)
-            reg_val_fp = MB_InRegRdFP(reg,                       /* No,  get the value of the FP register                    */
-                                      &err);
+            reg_val_fp = MBS_IN_REG_RD_FP(reg,                   /* No,  get the value of the FP register                    */
+                                          &err);
             switch (err) {
                 case MODBUS_ERR_NONE:
                      pfp = (CPU_INT08U *)&reg_val_fp;            /* Point to the FP register                                 */
@@ -924,9 +1297,9 @@ static  CPU_BOOLEAN  MBS_FC05_CoilWr (MODBUS_CH  *pch)
         } else {
             coil_val = 1;                                        /* No,  Turn coil ON                                        */
         }
-        MB_CoilWr(coil,                                          /* Force coil                                               */
-                  coil_val,
-                  &err);
+        MBS_COIL_WR(coil,                                        /* Force coil                                               */
+                    coil_val,
+                    &err);
     } else {
         pch->Err = MODBUS_ERR_FC05_02;
         MBS_ErrRespSet(pch,                                      /* Writes are not enabled                                   */
@@ -945,6 +1318,7 @@ static  CPU_BOOLEAN  MBS_FC05_CoilWr (MODBUS_CH  *pch)
         case MODBUS_ERR_NONE:                                    /* We simply echoe back with the command received           */
              pch->Err = MODBUS_ERR_NONE;
              pch->WrCtr++;
+             MBS_WR_NOTIFY(MODBUS_FC05_COIL_WR, coil, 1);
              break;
 
         case MODBUS_ERR_RANGE:
@@ -1016,9 +1390,9 @@ static  CPU_BOOLEAN  MBS_FC06_HoldingRegWr (MODBUS_CH *pch)
 #if (MODBUS_CFG_FP_EN == DEF_ENABLED)
     if (reg < MODBUS_CFG_FP_START_IX) {
         reg_val_16 = MBS_RX_DATA_REG;
-        MB_HoldingRegWr(reg,                                     /* Write to integer register                                */
-                        reg_val_16,
-                        &err);
+        MBS_HOLDING_REG_WR(reg,                                  /* Write to integer register                                */
+                           reg_val_16,
+                           &err);
     } else {
         prx_data = &pch->RxFrameData[4];                         /* Point to data in the received frame.                     */
         pfp      = (CPU_INT08U *)&reg_val_fp;
@@ -1032,15 +1406,15 @@ static  CPU_BOOLEAN  MBS_FC06_HoldingRegWr (MODBUS_CH *pch)
             *pfp++ = *prx_data--;
         }
 #endif
-        MB_HoldingRegWrFP(reg,                                   /* Write to floating point register                         */
-                          reg_val_fp,
-                          &err);
+        MBS_HOLDING_REG_WR_FP(reg,                               /* Write to floating point register                         */
+                              reg_val_fp,
+                              &err);
     }
 #else
     reg_val_16 = MBS_RX_DATA_REG;
-    MB_HoldingRegWr(reg,                                         /* Write to integer register                                */
-                    reg_val_16,
-                    &err);
+    MBS_HOLDING_REG_WR(reg,                                      /* Write to integer register                                */
+                       reg_val_16,
+                       &err);
 #endif
     pch->TxFrameNDataBytes = 4;
     MBS_TX_FRAME_ADDR      = MBS_RX_FRAME_ADDR;                  /* Prepare response packet (duplicate Rx frame)             */
@@ -1059,6 +1433,7 @@ static  CPU_BOOLEAN  MBS_FC06_HoldingRegWr (MODBUS_CH *pch)
         case MODBUS_ERR_NONE:                                    /* Reply with echoe of command received                     */
              pch->Err = MODBUS_ERR_NONE;
              pch->WrCtr++;
+             MBS_WR_NOTIFY(MODBUS_FC06_HOLDING_REG_WR, reg, 1);
              break;
 
         case MODBUS_ERR_RANGE:
@@ -1234,15 +1609,18 @@ static  CPU_BOOLEAN  MBS_FC15_CoilWrMultiple (MODBUS_CH  *pch)
                 } else {
                     coil_val = MODBUS_COIL_OFF;
                 }
-                MB_CoilWr(coil + ix,
-                          coil_val,
-                          &err);
+                MBS_COIL_WR(coil + ix,
+                            coil_val,
+                            &err);
                 switch (err) {
                     case MODBUS_ERR_NONE:
                          break;                                  /* Continue with the next coil if no error                  */
 
                     case MODBUS_ERR_RANGE:
                     default:
+                         if (ix > 0) {                           /* Notify the coils written before the error                */
+                             MBS_WR_NOTIFY(MODBUS_FC15_COIL_WR_MULTIPLE, coil, ix);
+                         }
                          pch->Err = MODBUS_ERR_FC15_01;
                          MBS_ErrRespSet(pch,
                                         MODBUS_ERR_ILLEGAL_DATA_ADDR);
@@ -1265,6 +1643,7 @@ static  CPU_BOOLEAN  MBS_FC15_CoilWrMultiple (MODBUS_CH  *pch)
         MBS_TX_DATA_POINTS_H   = MBS_RX_DATA_POINTS_H;
         MBS_TX_DATA_POINTS_L   = MBS_RX_DATA_POINTS_L;
         pch->Err               = MODBUS_ERR_NONE;
+        MBS_WR_NOTIFY(MODBUS_FC15_COIL_WR_MULTIPLE, coil, nbr_coils);
     } else {
         pch->Err               = MODBUS_ERR_FC15_03;              /* Number of bytes incorrect for number of COILS.           */
         MBS_ErrRespSet(pch,
@@ -1383,9 +1762,9 @@ static  CPU_BOOLEAN  MBS_FC16_HoldingRegWrMultiple (MODBUS_CH *pch)
         if (reg < MODBUS_CFG_FP_START_IX) {
             reg_val_16  = ((CPU_INT16U)*prx_data++) << 8;        /* Get MSB first.                                           */
             reg_val_16 +=  (CPU_INT16U)*prx_data++;              /* Add in the LSB.                                          */
-            MB_HoldingRegWr(reg,
-                            reg_val_16,
-                            &err);
+            MBS_HOLDING_REG_WR(reg,
+                               reg_val_16,
+                               &err);
         } else {
             pfp = (CPU_INT08U *)&reg_val_fp;
   #if CPU_CFG_ENDIAN_TYPE == CPU_ENDIAN_TYPE_BIG
@@ -1398,16 +1777,16 @@ static  CPU_BOOLEAN  MBS_FC16_HoldingRegWrMultiple (MODBUS_CH *pch)
                 *pfp--   = *prx_data++;
             }
   #endif
-            MB_HoldingRegWrFP(reg,
-                              reg_val_fp,
-                              &err);
+            MBS_HOLDING_REG_WR_FP(reg,
+                                  reg_val_fp,
+                                  &err);
         }
 #else
         reg_val_16  = ((CPU_INT16U)*prx_data++) << 8;            /* Get MSB first.                                           */
         reg_val_16 +=  (CPU_INT16U)*prx_data++;                  /* Add in the LSB.                                          */
-        MB_HoldingRegWr(reg,
-                        reg_val_16,
-                        &err);
+        MBS_HOLDING_REG_WR(reg,
+                           reg_val_16,
+                           &err);
 #endif
 
         switch (err) {                                           /* See if any errors in writing the data                    */
@@ -1419,6 +1798,11 @@ static  CPU_BOOLEAN  MBS_FC16_HoldingRegWrMultiple (MODBUS_CH *pch)
 
             case MODBUS_ERR_RANGE:
             default:
+                 if (reg != MBS_RX_DATA_START) {                 /* Notify the registers written before the error            */
+                     MBS_WR_NOTIFY(MODBUS_FC16_HOLDING_REG_WR_MULTIPLE,
+                                   MBS_RX_DATA_START,
+                                   reg - MBS_RX_DATA_START);
+                 }
                  pch->Err = MODBUS_ERR_FC16_03;
                  MBS_ErrRespSet(pch,
                                 MODBUS_ERR_ILLEGAL_DATA_ADDR);
@@ -1432,6 +1816,7 @@ static  CPU_BOOLEAN  MBS_FC16_HoldingRegWrMultiple (MODBUS_CH *pch)
     MBS_TX_DATA_START_L    = MBS_RX_DATA_START_L;
     MBS_TX_DATA_POINTS_H   = MBS_RX_DATA_POINTS_H;
     MBS_TX_DATA_POINTS_L   = MBS_RX_DATA_POINTS_L;
+    MBS_WR_NOTIFY(MODBUS_FC16_HOLDING_REG_WR_MULTIPLE, MBS_RX_DATA_START, MBS_RX_DATA_POINTS);
     return (DEF_TRUE);                                           /* Tell caller that we need to send a response              */
 }
 #endif
@@ -1518,11 +1903,11 @@ static  CPU_BOOLEAN  MBS_FC20_FileRd (MODBUS_CH  *pch)
         *presp++               = 6;                                          /* Reference type is ALWAYS 6.                              */
         ix                     = 0;                                          /* Initialize the index into the record                     */
         while (record_len > 0) {
-            reg_val = MB_FileRd(file_nbr,                                    /* Get one value from the file                              */
-                                record_nbr,
-                                ix,
-                                record_len,
-                                &err);
+            reg_val = MBS_FILE_RD(file_nbr,                                  /* Get one value from the file                              */
+                                  record_nbr,
+                                  ix,
+                                  record_len,
+                                  &err);
             switch (err) {
                 case MODBUS_ERR_NONE:
                      *presp++ = (CPU_INT08U)(reg_val >> 8);                  /* Store high byte of record data                           */
@@ -1657,12 +2042,12 @@ static  CPU_BOOLEAN  MBS_FC21_FileWr (MODBUS_CH  *pch)
         while (record_len > 0) {
             reg_val  = ((CPU_INT16U)*prx_data++ << 8) & 0xFF00;            /* Get data to write to file                                */
             reg_val |=  (CPU_INT16U)*prx_data++ & 0x00FF;
-            MB_FileWr(file_nbr,                                            /* Write one value to the file                              */
-                      record_nbr,
-                      ix,
-                      record_len,
-                      reg_val,
-                      &err);
+            MBS_FILE_WR(file_nbr,                                          /* Write one value to the file                              */
+                        record_nbr,
+                        ix,
+                        record_len,
+                        reg_val,
+                        &err);
             switch (err) {
                 case MODBUS_ERR_NONE:
                      pch->WrCtr++;
@@ -1742,7 +2127,7 @@ void  MBS_StatInit (MODBUS_CH  *pch)
 *********************************************************************************************************
 *                                           MBS_RxTask()
 *
-* Description : Handle either Modbus ASCII or Modbus RTU received packets.
+* Description : Handle Modbus ASCII, Modbus RTU or Modbus TCP received packets.
 *
 * Argument(s) : ch       Specifies the Modbus channel that needs servicing.
 *
@@ -1769,6 +2154,12 @@ void  MBS_RxTask (MODBUS_CH *pch)
             MBS_RTU_Task(pch);
         }
 #endif
+
+#if (MODBUS_CFG_TCP_EN == DEF_ENABLED)
+        if (pch->Mode == MODBUS_MODE_TCP) {
+            MBS_TCP_Task(pch);
+        }
+#endif
     }
 }
 #endif
@@ -1785,7 +2176,8 @@ void  MBS_RxTask (MODBUS_CH *pch)
 *
 * Caller(s)   : MBS_RxTask().
 *
-* Note(s)     : none.
+* Note(s)     : (1) The Rx buffer is emptied before the reply is sent: the master may send its next request as
+*                   soon as it has the reply, before this function would return.
 *********************************************************************************************************
 */
 
@@ -1798,6 +2190,7 @@ static  void  MBS_ASCII_Task (MODBUS_CH  *pch)
     CPU_BOOLEAN  send_reply;
 
 
+    send_reply = DEF_FALSE;
 #if (MODBUS_CFG_FC08_EN == DEF_ENABLED)
     pch->StatMsgCtr++;
 #endif
@@ -1812,13 +2205,11 @@ static  void  MBS_ASCII_Task (MODBUS_CH  *pch)
 #endif
             } else {
                 send_reply = MBS_FCxx_Handler(pch);       /* Execute received command and formulate a response               */
-                if (send_reply == DEF_TRUE) {
-                    MB_ASCII_Tx(pch);                     /* Send back reply.                                                */
-                } else {
 #if (MODBUS_CFG_FC08_EN == DEF_ENABLED)
+                if (send_reply == DEF_FALSE) {
                     pch->StatNoRespCtr++;
-#endif
                 }
+#endif
             }
         } else {
 #if (MODBUS_CFG_FC08_EN == DEF_ENABLED)
@@ -1826,8 +2217,11 @@ static  void  MBS_ASCII_Task (MODBUS_CH  *pch)
 #endif
         }
     }
-    pch->RxBufByteCtr = 0;
+    pch->RxBufByteCtr = 0;                                /* See Note #1                                                     */
     pch->RxBufPtr     = &pch->RxBuf[0];
+    if (send_reply == DEF_TRUE) {
+        MB_ASCII_Tx(pch);                                 /* Send back reply.                                                */
+    }
 }
 #endif
 
@@ -1844,7 +2238,7 @@ static  void  MBS_ASCII_Task (MODBUS_CH  *pch)
 *
 * Caller(s)   : MBS_RTU_Task().
 *
-* Note(s)     : none.
+* Note(s)     : (1) The Rx buffer is emptied before the reply is sent (see MBS_ASCII_Task() Note #1).
 *********************************************************************************************************
 */
 
@@ -1857,7 +2251,7 @@ static  void  MBS_RTU_Task (MODBUS_CH  *pch)
     CPU_BOOLEAN  send_reply;
 
 
-
+    send_reply = DEF_FALSE;
 #if (MODBUS_CFG_FC08_EN == DEF_ENABLED)
     pch->StatMsgCtr++;
 #endif
@@ -1872,14 +2266,66 @@ static  void  MBS_RTU_Task (MODBUS_CH  *pch)
 #endif
             } else {
                 send_reply = MBS_FCxx_Handler(pch);    /* Execute received command and formulate a response               */
-                if (send_reply == DEF_TRUE) {
-                    MB_RTU_Tx(pch);                    /* Send back reply.                                                */
-                } else {
 #if (MODBUS_CFG_FC08_EN == DEF_ENABLED)
+                if (send_reply == DEF_FALSE) {
                     pch->StatNoRespCtr++;
-#endif
                 }
+#endif
+            }
+        }
+    }
+    pch->RxBufByteCtr = 0;                             /* See Note #1                                                     */
+    pch->RxBufPtr     = &pch->RxBuf[0];
+    if (send_reply == DEF_TRUE) {
+        MB_RTU_Tx(pch);                                /* Send back reply.                                                */
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            MBS_TCP_Task()
+*
+* Description : This function processes a packet received on the Modbus channel assuming that it's a
+*               Modbus/TCP (MBAP) packet.
+*
+* Argument(s) : pch      Is a pointer to the Modbus channel's data structure.
+*
+* Return(s)   : none.
+*
+* Caller(s)   : MBS_RxTask().
+*
+* Note(s)     : (1) TCP guarantees the integrity of the stream, a Modbus/TCP frame carries no CRC.
+*********************************************************************************************************
+*/
+
+#if (MODBUS_CFG_SLAVE_EN == DEF_ENABLED) && \
+    (MODBUS_CFG_TCP_EN   == DEF_ENABLED)
+static  void  MBS_TCP_Task (MODBUS_CH  *pch)
+{
+    CPU_BOOLEAN  ok;
+    CPU_BOOLEAN  send_reply;
+
+
+#if (MODBUS_CFG_FC08_EN == DEF_ENABLED)
+    pch->StatMsgCtr++;
+#endif
+    if (pch->RxBufByteCtr >= MODBUS_TCP_MIN_MSG_SIZE) {
+        ok = MB_TCP_Rx(pch);                           /* Extract received command from .RxBuf[] & move to .RxFrameData[] */
+        if (ok == DEF_TRUE) {                          /* See Note #1.                                                    */
+            send_reply = MBS_FCxx_Handler(pch);        /* Execute received command and formulate a response               */
+            if (send_reply == DEF_TRUE) {
+                MB_TCP_Tx(pch);                        /* Send back reply.                                                */
+            } else {
+#if (MODBUS_CFG_FC08_EN == DEF_ENABLED)
+                pch->StatNoRespCtr++;
+#endif
             }
+        } else {
+#if (MODBUS_CFG_FC08_EN == DEF_ENABLED)
+            pch->StatNoRespCtr++;
+#endif
         }
     }
     pch->RxBufByteCtr = 0;